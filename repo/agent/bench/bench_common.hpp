@@ -0,0 +1,46 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Benchmark Helpers
+ */
+
+#ifndef NYMPH_BENCH_COMMON_HPP
+#define NYMPH_BENCH_COMMON_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace nymph {
+namespace bench {
+
+/* Monotonic time in nanoseconds */
+inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Keep the compiler from discarding a computed value */
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/* Print one result line: name, iterations, ns/op and an optional rate */
+inline void report(const std::string& name, uint64_t iterations, uint64_t elapsed_ns,
+                   double bytes = 0.0) {
+    double ns_per_op = iterations ? static_cast<double>(elapsed_ns) / iterations : 0.0;
+    if (bytes > 0.0) {
+        double mb_per_s = (bytes / (1024.0 * 1024.0)) / (elapsed_ns / 1e9);
+        std::printf("%-48s %10llu iters %12.1f ns/op %10.1f MB/s\n", name.c_str(),
+                    static_cast<unsigned long long>(iterations), ns_per_op, mb_per_s);
+    } else {
+        std::printf("%-48s %10llu iters %12.1f ns/op\n", name.c_str(),
+                    static_cast<unsigned long long>(iterations), ns_per_op);
+    }
+}
+
+} // namespace bench
+} // namespace nymph
+
+#endif // NYMPH_BENCH_COMMON_HPP
@@ -0,0 +1,239 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 HTTP Parser Benchmark and Fuzz Harness
+ *
+ * Measures parse throughput of net::HttpParser on a small request corpus,
+ * one-shot and fed in small fragments, next to the old copy-and-find
+ * parser. With --fuzz N it also checks that random fragmentation never
+ * changes the parse result and that mutated input never crashes.
+ *
+ * Usage: bench_http_parser [--iterations N] [--fuzz N]
+ */
+
+#include "http_parser.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using nymph::net::HttpParser;
+using nymph::net::ParseResult;
+using namespace nymph::bench;
+
+namespace {
+
+struct Sample {
+    std::string name;
+    std::string wire;
+};
+
+std::string make_post(const std::string& path, const std::string& body) {
+    return "POST " + path + " HTTP/1.1\r\nHost: nymph\r\nContent-Type: application/json\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+std::string make_chunked(const std::string& path, const std::string& body, size_t chunk) {
+    std::string wire = "POST " + path + " HTTP/1.1\r\nHost: nymph\r\n"
+                       "Transfer-Encoding: chunked\r\n\r\n";
+    char size_line[32];
+    for (size_t off = 0; off < body.size(); off += chunk) {
+        size_t n = std::min(chunk, body.size() - off);
+        std::snprintf(size_line, sizeof(size_line), "%zx\r\n", n);
+        wire += size_line;
+        wire.append(body, off, n);
+        wire += "\r\n";
+    }
+    wire += "0\r\n\r\n";
+    return wire;
+}
+
+std::vector<Sample> make_corpus() {
+    std::string prompt(64 * 1024, 'a');
+    std::string manifest(256 * 1024, 'm');
+    return {
+        {"GET /status", "GET /status HTTP/1.1\r\nHost: nymph\r\nUser-Agent: fleet-agent/1.0\r\n"
+                        "Accept: */*\r\n\r\n"},
+        {"POST /kv/pin", make_post("/kv/pin", "{\"region\":\"chat_ctx\",\"size_kb\":256}")},
+        {"POST /infer 64KB", make_post("/infer", "{\"model\":\"llm-7b-int4\",\"input\":\"" +
+                                       prompt + "\"}")},
+        {"POST /vault/update chunked 256KB", make_chunked("/vault/update", manifest, 4096)},
+    };
+}
+
+/* The pre-parser approach: copy, then search the copy repeatedly */
+size_t legacy_parse(const std::string& wire) {
+    std::string request(wire);
+    std::string method, path, body;
+    size_t first_line_end = request.find("\r\n");
+    std::string first_line = request.substr(0, first_line_end);
+    size_t space1 = first_line.find(' ');
+    size_t space2 = first_line.find(' ', space1 + 1);
+    method = first_line.substr(0, space1);
+    path = first_line.substr(space1 + 1, space2 - space1 - 1);
+    size_t body_start = request.find("\r\n\r\n");
+    if (body_start != std::string::npos) body = request.substr(body_start + 4);
+    return method.size() + path.size() + body.size();
+}
+
+struct Parsed {
+    ParseResult result;
+    std::string method;
+    std::string path;
+    std::string body;
+    size_t consumed;
+};
+
+Parsed parse_fragmented(const std::string& wire, const std::vector<size_t>& cuts) {
+    HttpParser parser;
+    std::string buffer;
+    Parsed parsed{ParseResult::INCOMPLETE, "", "", "", 0};
+    size_t fed = 0;
+    for (size_t cut : cuts) {
+        buffer.append(wire, fed, cut - fed);
+        fed = cut;
+        parsed.result = parser.parse(buffer, 0);
+        if (parsed.result != ParseResult::INCOMPLETE) break;
+    }
+    if (parsed.result == ParseResult::INCOMPLETE && fed < wire.size()) {
+        buffer.append(wire, fed, std::string::npos);
+        parsed.result = parser.parse(buffer, 0);
+    }
+    if (parsed.result == ParseResult::COMPLETE) {
+        nymph::api::APIRequest req;
+        parser.fill_request(buffer, req);
+        parsed.method = std::string(req.method);
+        parsed.path = std::string(req.path);
+        parsed.body = std::string(req.body);
+        parsed.consumed = parser.consumed();
+    }
+    return parsed;
+}
+
+void run_throughput(const std::vector<Sample>& corpus, uint64_t iterations) {
+    std::cout << "== Parse throughput ==" << std::endl;
+    for (const auto& sample : corpus) {
+        uint64_t n = std::max<uint64_t>(10, iterations * 1024 / (sample.wire.size() + 1024));
+
+        // One-shot: whole request already buffered
+        {
+            HttpParser parser;
+            std::string buffer = sample.wire;
+            bool chunked = sample.wire.find("chunked") != std::string::npos;
+            uint64_t start = now_ns();
+            for (uint64_t i = 0; i < n; i++) {
+                if (chunked) {
+                    buffer = sample.wire;   // De-chunking rewrites the buffer
+                }
+                parser.reset();
+                ParseResult r = parser.parse(buffer, 0);
+                nymph::api::APIRequest req;
+                parser.fill_request(buffer, req);
+                do_not_optimize(r);
+                do_not_optimize(req.body.size());
+            }
+            report(sample.name + " one-shot", n, now_ns() - start,
+                   static_cast<double>(sample.wire.size()) * n);
+        }
+
+        // Fragmented: 1460-byte segments, re-parsed after each append
+        {
+            HttpParser parser;
+            std::string buffer;
+            uint64_t start = now_ns();
+            for (uint64_t i = 0; i < n; i++) {
+                buffer.clear();
+                parser.reset();
+                ParseResult r = ParseResult::INCOMPLETE;
+                for (size_t off = 0; off < sample.wire.size() && r == ParseResult::INCOMPLETE;
+                     off += 1460) {
+                    buffer.append(sample.wire, off, 1460);
+                    r = parser.parse(buffer, 0);
+                }
+                do_not_optimize(r);
+            }
+            report(sample.name + " 1460B segments", n, now_ns() - start,
+                   static_cast<double>(sample.wire.size()) * n);
+        }
+
+        // Legacy copy-and-find parser
+        {
+            uint64_t start = now_ns();
+            for (uint64_t i = 0; i < n; i++) {
+                do_not_optimize(legacy_parse(sample.wire));
+            }
+            report(sample.name + " legacy", n, now_ns() - start,
+                   static_cast<double>(sample.wire.size()) * n);
+        }
+    }
+}
+
+int run_fuzz(const std::vector<Sample>& corpus, uint64_t rounds) {
+    std::cout << "== Fuzz (" << rounds << " rounds) ==" << std::endl;
+    std::mt19937_64 rng(0x4e594d5048ULL);
+    uint64_t failures = 0;
+    uint64_t mutated_rejects = 0;
+
+    for (uint64_t round = 0; round < rounds; round++) {
+        const Sample& sample = corpus[round % corpus.size()];
+        const std::string& wire = sample.wire;
+
+        // Random fragmentation must not change the result
+        std::vector<size_t> cuts;
+        size_t pos = 0;
+        while (pos < wire.size()) {
+            pos += 1 + rng() % 64;
+            cuts.push_back(std::min(pos, wire.size()));
+        }
+        Parsed whole = parse_fragmented(wire, {wire.size()});
+        Parsed pieces = parse_fragmented(wire, cuts);
+        if (whole.result != ParseResult::COMPLETE || pieces.result != ParseResult::COMPLETE ||
+            whole.method != pieces.method || whole.path != pieces.path ||
+            whole.body != pieces.body || whole.consumed != wire.size()) {
+            std::cerr << "fragmentation mismatch on " << sample.name << std::endl;
+            failures++;
+        }
+
+        // Random byte mutations must never crash or over-consume
+        std::string mutated = wire.substr(0, std::min<size_t>(wire.size(), 2048));
+        int flips = 1 + static_cast<int>(rng() % 8);
+        for (int f = 0; f < flips; f++) {
+            mutated[rng() % mutated.size()] = static_cast<char>(rng() & 0xff);
+        }
+        Parsed fuzzed = parse_fragmented(mutated, {mutated.size()});
+        if (fuzzed.result == ParseResult::ERROR) {
+            mutated_rejects++;
+        } else if (fuzzed.result == ParseResult::COMPLETE && fuzzed.consumed > mutated.size()) {
+            std::cerr << "over-consumed mutated input" << std::endl;
+            failures++;
+        }
+    }
+
+    std::cout << "mutated inputs rejected: " << mutated_rejects << "/" << rounds << std::endl;
+    std::cout << "failures: " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = 200000;
+    uint64_t fuzz_rounds = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--fuzz") == 0 && i + 1 < argc) {
+            fuzz_rounds = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+
+    std::vector<Sample> corpus = make_corpus();
+    run_throughput(corpus, iterations);
+    if (fuzz_rounds > 0) {
+        return run_fuzz(corpus, fuzz_rounds);
+    }
+    return 0;
+}
@@ -0,0 +1,211 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Inference Batching Benchmark
+ *
+ * Starts the HTTP server with one worker loop on 127.0.0.1 and has C
+ * closed-loop clients (default 16), each on its own keep-alive
+ * connection, send R /infer requests (default 50) for one model back to
+ * back. Runs once with batching off (--infer-batch 1) and once with the
+ * given batch settings, each in a fresh child process so the global
+ * scheduler starts from its configuration. Reports throughput, p50/p99
+ * latency and the mean batch size.
+ *
+ * The handler returns at once and the response follows when the batch has
+ * run, so a single worker loop keeps every client's request in the queue
+ * and batches fill. The stub runtime models one device (runs are
+ * serialized; a batch costs its slowest request plus 5% per extra
+ * request), so the numbers show the queueing effect, not a real
+ * accelerator's batch speedup.
+ *
+ * Usage: bench_infer_batch [--clients N] [--requests N] [--max-batch N] [--delay-us N] [--port N]
+ */
+
+#include "ai_batch.hpp"
+#include "http_server.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "nymph_api.hpp"
+#include "bench_common.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace nymph::bench;
+namespace ai = nymph::ai;
+
+namespace {
+
+int connect_to(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Read one Content-Length response; false if the connection failed or it is not a 200 */
+bool read_response(int fd) {
+    std::string in;
+    char chunk[16384];
+    while (true) {
+        ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+        if (got <= 0) {
+            return false;
+        }
+        in.append(chunk, static_cast<size_t>(got));
+        size_t head_end = in.find("\r\n\r\n");
+        if (head_end == std::string::npos) {
+            continue;
+        }
+        size_t length_at = in.find("Content-Length: ");
+        if (length_at != std::string::npos &&
+            in.size() >= head_end + 4 + std::strtoull(in.c_str() + length_at + 16, nullptr, 10)) {
+            return in.compare(0, 12, "HTTP/1.1 200") == 0;
+        }
+    }
+}
+
+/* Every client sends requests back to back; returns wall time */
+uint64_t run_clients(uint16_t port, unsigned clients, uint64_t requests,
+                     nymph::metrics::Histogram& latency_ns, std::atomic<uint64_t>& failed) {
+    const std::string body = "{\"model\":\"llm-7b-int4\",\"profile\":\"edge-llm-fast\","
+                             "\"input\":\"Summarize the thermal log of the last hour.\"}";
+    const std::string request = "POST /infer HTTP/1.1\r\nHost: bench\r\nContent-Length: " +
+                                std::to_string(body.size()) + "\r\n\r\n" + body;
+    std::vector<std::thread> workers;
+    uint64_t start = now_ns();
+    for (unsigned c = 0; c < clients; c++) {
+        workers.emplace_back([&] {
+            int fd = connect_to(port);
+            if (fd < 0) {
+                failed.fetch_add(requests);
+                return;
+            }
+            for (uint64_t i = 0; i < requests; i++) {
+                uint64_t sent = now_ns();
+                if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size()) ||
+                    !read_response(fd)) {
+                    failed.fetch_add(requests - i);
+                    break;
+                }
+                latency_ns.record(now_ns() - sent);
+            }
+            close(fd);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return now_ns() - start;
+}
+
+/* One configuration against a fresh server; runs in its own process */
+int run_config(const char* name, const ai::BatchConfig& config, uint16_t port, unsigned clients, uint64_t requests) {
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+    ai::get_inference_scheduler().configure(config);
+
+    nymph::net::ServerConfig server_config;
+    server_config.host = "127.0.0.1";
+    server_config.port = port;
+    server_config.workers = 1;
+    nymph::net::HttpServer server(server_config, [](nymph::api::APIRequest& req) {
+        return nymph::api::api_infer(req);
+    });
+    if (!server.start()) {
+        std::fprintf(stderr, "Failed to start the server on port %u\n", port);
+        return 1;
+    }
+
+    nymph::metrics::Histogram latency_ns;
+    std::atomic<uint64_t> failed{0};
+    uint64_t elapsed = run_clients(port, clients, requests, latency_ns, failed);
+    nymph::metrics::Histogram::Snapshot latency = latency_ns.snapshot();
+    std::printf("%-24s %8.1f req/s   p50 %7.2f ms   p99 %7.2f ms", name,
+                (clients * requests - failed.load()) / (elapsed / 1e9),
+                latency.quantile(0.50) / 1e6, latency.quantile(0.99) / 1e6);
+    if (failed.load() > 0) {
+        std::printf("   %llu failed", static_cast<unsigned long long>(failed.load()));
+    }
+    std::printf("\n");
+    for (const ai::BatchQueueStats& queue : ai::get_inference_scheduler().get_stats()) {
+        std::printf("  %llu batches, mean size %.2f, queue delay p99 %.2f ms\n",
+                    static_cast<unsigned long long>(queue.batches),
+                    queue.batches ? static_cast<double>(queue.requests) / queue.batches : 0.0,
+                    queue.queue_delay_ns.quantile(0.99) / 1e6);
+    }
+    std::fflush(stdout);
+
+    server.stop();
+    ai::get_inference_scheduler().shutdown();
+    return failed.load() > 0 ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned clients = 16;
+    uint64_t requests = 50;
+    uint16_t port = 18472;
+    ai::BatchConfig config;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            clients = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--requests") == 0 && i + 1 < argc) {
+            requests = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--max-batch") == 0 && i + 1 < argc) {
+            config.max_batch = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--delay-us") == 0 && i + 1 < argc) {
+            config.max_delay_us = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = static_cast<uint16_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+    }
+    if (clients == 0) clients = 1;
+    if (requests == 0) requests = 1;
+    signal(SIGPIPE, SIG_IGN);
+    std::printf("%u clients x %llu requests, one worker loop, max batch %zu, max delay %u us\n", clients,
+                static_cast<unsigned long long>(requests), config.max_batch, config.max_delay_us);
+    std::fflush(stdout);
+
+    ai::BatchConfig unbatched = config;
+    unbatched.max_batch = 1;
+    struct {
+        const char* name;
+        ai::BatchConfig config;
+    } runs[] = {{"batching off", unbatched}, {"batching on", config}};
+
+    // Nothing global exists yet in this process; each child builds its own
+    int status = 0;
+    for (const auto& run : runs) {
+        pid_t child = fork();
+        if (child < 0) {
+            std::perror("fork");
+            return 1;
+        }
+        if (child == 0) {
+            _exit(run_config(run.name, run.config, port, clients, requests));
+        }
+        int child_status = 0;
+        waitpid(child, &child_status, 0);
+        if (!WIFEXITED(child_status) || WEXITSTATUS(child_status) != 0) {
+            status = 1;
+        }
+    }
+    return status;
+}
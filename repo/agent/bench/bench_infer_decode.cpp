@@ -0,0 +1,218 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Iteration-Level Batching Benchmark
+ *
+ * C closed-loop clients (default 32) each send R chat requests (default
+ * 20) whose prompts differ, so their generations end at different
+ * lengths (up to 64 tokens). The same stub decode steps are batched two
+ * ways, at most B sequences each (default 8):
+ *
+ *   request-level    a batch runs until its longest sequence ends; the
+ *                    others wait with it and nobody joins meanwhile
+ *   iteration-level  the scheduler's ITERATION mode; sequences join and
+ *                    leave between steps, KV held in cache regions
+ *
+ * Reports requests/s, tokens/s and p50/p99 latency for both, plus time
+ * to first token for the iteration-level run. The stub does not charge
+ * for the finished rows a request-level batch keeps, so its numbers are
+ * a lower bound on the difference.
+ *
+ * Usage: bench_infer_decode [--clients N] [--requests N] [--max-batch N]
+ */
+
+#include "ai_batch.hpp"
+#include "kvpin.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "bench_common.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nymph::bench;
+namespace ai = nymph::ai;
+
+namespace {
+
+/* Request-level batching of the stub's decode steps */
+class RequestBatcher {
+public:
+    RequestBatcher(ai::ONNXRuntime& runtime, size_t max_batch)
+        : runtime_(runtime), max_batch_(max_batch), stopping_(false), thread_([this] { loop(); }) {
+    }
+
+    ~RequestBatcher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_.notify_one();
+        thread_.join();
+    }
+
+    /* Tokens generated for request */
+    uint32_t run(const ai::InferenceRequest& request) {
+        Job job;
+        job.request = &request;
+        std::future<uint32_t> tokens = job.tokens.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(&job);
+        }
+        ready_.notify_one();
+        return tokens.get();
+    }
+
+private:
+    struct Job {
+        const ai::InferenceRequest* request;
+        std::promise<uint32_t> tokens;
+    };
+
+    void loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            size_t count = std::min(queue_.size(), max_batch_);
+            std::vector<Job*> jobs(queue_.begin(), queue_.begin() + count);
+            queue_.erase(queue_.begin(), queue_.begin() + count);
+            lock.unlock();
+
+            std::vector<ai::GenerationSequence> sequences(count);
+            std::vector<ai::GenerationSequence*> step;
+            for (size_t i = 0; i < count; i++) {
+                sequences[i].request = jobs[i]->request;
+                sequences[i].prompt_tokens = ai::count_prompt_tokens(*jobs[i]->request);
+                sequences[i].max_tokens = ai::kDefaultMaxTokens;
+                step.push_back(&sequences[i]);
+            }
+            auto unfinished = [&sequences] {
+                return std::any_of(sequences.begin(), sequences.end(),
+                                   [](const ai::GenerationSequence& sequence) { return !sequence.finished; });
+            };
+            while (unfinished()) {
+                runtime_.run_decode_step(step);
+            }
+            for (size_t i = 0; i < count; i++) {
+                jobs[i]->tokens.set_value(sequences[i].generated);
+            }
+            lock.lock();
+        }
+    }
+
+    ai::ONNXRuntime& runtime_;
+    size_t max_batch_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<Job*> queue_;
+    bool stopping_;
+    std::thread thread_;
+};
+
+/* Every client sends its requests back to back; returns wall time */
+template <typename Generate>
+uint64_t run_clients(unsigned clients, uint64_t requests, nymph::metrics::Histogram& latency_ns,
+                     std::atomic<uint64_t>& tokens, Generate generate) {
+    std::vector<std::thread> workers;
+    uint64_t start = now_ns();
+    for (unsigned c = 0; c < clients; c++) {
+        workers.emplace_back([&, c] {
+            ai::InferenceRequest request;
+            request.model_name = "llm-7b-int4";
+            request.profile = "edge-llm-fast";
+            for (uint64_t i = 0; i < requests; i++) {
+                request.input_text = "Chat turn " + std::to_string(c * requests + i) +
+                                     ": summarize the thermal log of the last hour.";
+                uint64_t sent = now_ns();
+                tokens.fetch_add(generate(request), std::memory_order_relaxed);
+                latency_ns.record(now_ns() - sent);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return now_ns() - start;
+}
+
+void print_run(const char* name, uint64_t total, uint64_t tokens, uint64_t elapsed_ns,
+               const nymph::metrics::Histogram& latency_ns) {
+    nymph::metrics::Histogram::Snapshot snapshot = latency_ns.snapshot();
+    double seconds = elapsed_ns / 1e9;
+    std::printf("%-20s %8.1f req/s %9.1f tok/s   p50 %7.2f ms   p99 %7.2f ms\n", name, total / seconds,
+                tokens / seconds, snapshot.quantile(0.50) / 1e6, snapshot.quantile(0.99) / 1e6);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned clients = 32;
+    uint64_t requests = 20;
+    ai::BatchConfig config;
+    config.mode = ai::BatchMode::ITERATION;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            clients = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--requests") == 0 && i + 1 < argc) {
+            requests = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--max-batch") == 0 && i + 1 < argc) {
+            config.max_batch = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+    if (clients == 0) clients = 1;
+    if (requests == 0) requests = 1;
+    if (config.max_batch < 2) config.max_batch = 2;
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    ai::ONNXRuntime runtime;
+    runtime.initialize();
+    uint64_t total = clients * requests;
+    std::printf("%u clients x %llu requests, batches of %zu\n", clients,
+                static_cast<unsigned long long>(requests), config.max_batch);
+
+    {
+        RequestBatcher batcher(runtime, config.max_batch);
+        nymph::metrics::Histogram latency_ns;
+        std::atomic<uint64_t> tokens{0};
+        uint64_t elapsed = run_clients(clients, requests, latency_ns, tokens,
+                                       [&](const ai::InferenceRequest& request) { return batcher.run(request); });
+        print_run("request-level", total, tokens.load(), elapsed, latency_ns);
+    }
+
+    nymph::kv::KVCacheManager kv_cache;
+    kv_cache.initialize();
+    ai::InferenceScheduler scheduler(runtime, kv_cache);
+    scheduler.configure(config);
+    nymph::metrics::Histogram latency_ns;
+    nymph::metrics::Histogram first_token_ns;
+    std::atomic<uint64_t> tokens{0};
+    uint64_t elapsed = run_clients(clients, requests, latency_ns, tokens, [&](const ai::InferenceRequest& request) {
+        ai::InferenceResult result = scheduler.run(request);
+        first_token_ns.record(static_cast<uint64_t>(result.metrics["first_token_ms"] * 1e6));
+        return static_cast<uint32_t>(result.metrics["output_tokens"]);
+    });
+    print_run("iteration-level", total, tokens.load(), elapsed, latency_ns);
+    nymph::metrics::Histogram::Snapshot first_token = first_token_ns.snapshot();
+    for (const ai::BatchQueueStats& queue : scheduler.get_stats()) {
+        std::printf("  %llu steps, mean batch %.2f, first token p50 %.2f ms p99 %.2f ms\n",
+                    static_cast<unsigned long long>(queue.batches),
+                    queue.batch_size.count ? static_cast<double>(queue.batch_size.sum) / queue.batch_size.count : 0.0,
+                    first_token.quantile(0.50) / 1e6, first_token.quantile(0.99) / 1e6);
+    }
+    nymph::kv::KVCacheStats kv_stats = kv_cache.get_stats();
+    std::printf("  KV left after the run: %llu pinned regions, %llu KB used\n",
+                static_cast<unsigned long long>(kv_stats.pinned_regions),
+                static_cast<unsigned long long>(kv_stats.used_size_kb));
+    return 0;
+}
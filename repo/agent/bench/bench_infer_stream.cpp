@@ -0,0 +1,200 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Streaming Inference Benchmark
+ *
+ * Starts the HTTP server with one worker loop on 127.0.0.1 and has C
+ * clients (default 16), each on its own keep-alive connection, send R
+ * /infer requests (default 10) back to back, first as plain requests and
+ * then with "stream": true. The scheduler runs in ITERATION mode.
+ *
+ * Neither holds the worker loop, so all clients decode in one batch. A
+ * plain request's first bytes arrive with its last token, as one
+ * response; a streamed request sees its first token after one step.
+ * Reports time to first byte of output (first token event, or the whole
+ * response), full latency and tokens/s.
+ *
+ * Usage: bench_infer_stream [--clients N] [--requests N] [--max-tokens N] [--port N]
+ */
+
+#include "ai_batch.hpp"
+#include "http_server.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "nymph_api.hpp"
+#include "bench_common.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace nymph::bench;
+namespace ai = nymph::ai;
+
+namespace {
+
+int connect_to(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Read one response; false if the connection failed. Sets first_ns when output first arrives */
+bool read_response(int fd, bool streamed, uint64_t& first_ns) {
+    std::string in;
+    char chunk[16384];
+    first_ns = 0;
+    while (true) {
+        ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+        if (got <= 0) {
+            return false;
+        }
+        in.append(chunk, static_cast<size_t>(got));
+        size_t head_end = in.find("\r\n\r\n");
+        if (head_end == std::string::npos) {
+            continue;
+        }
+        if (streamed) {
+            if (first_ns == 0 && in.find("event: token", head_end) != std::string::npos) {
+                first_ns = now_ns();
+            }
+            if (in.size() >= 5 && in.compare(in.size() - 5, 5, "0\r\n\r\n") == 0) {
+                return true;
+            }
+            continue;
+        }
+        size_t length_at = in.find("Content-Length: ");
+        if (length_at != std::string::npos &&
+            in.size() >= head_end + 4 + std::strtoull(in.c_str() + length_at + 16, nullptr, 10)) {
+            first_ns = now_ns();
+            return true;
+        }
+    }
+}
+
+/* Every client sends its requests back to back; returns wall time */
+uint64_t run_clients(uint16_t port, unsigned clients, uint64_t requests, uint32_t max_tokens, bool streamed,
+                     nymph::metrics::Histogram& first_ns, nymph::metrics::Histogram& latency_ns,
+                     std::atomic<uint64_t>& failed) {
+    std::vector<std::thread> workers;
+    uint64_t start = now_ns();
+    for (unsigned c = 0; c < clients; c++) {
+        workers.emplace_back([&, c] {
+            int fd = connect_to(port);
+            if (fd < 0) {
+                failed.fetch_add(requests);
+                return;
+            }
+            for (uint64_t i = 0; i < requests; i++) {
+                std::string body = "{\"model\":\"llm-7b-int4\",\"profile\":\"edge-llm-fast\",\"input\":\"Turn " +
+                                   std::to_string(c * requests + i) + ": summarize the thermal log.\"" +
+                                   ",\"max_tokens\":" + std::to_string(max_tokens) +
+                                   (streamed ? ",\"stream\":true}" : "}");
+                std::string request = "POST /infer HTTP/1.1\r\nHost: bench\r\nContent-Length: " +
+                                      std::to_string(body.size()) + "\r\n\r\n" + body;
+                uint64_t sent = now_ns();
+                uint64_t first = 0;
+                if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size()) ||
+                    !read_response(fd, streamed, first)) {
+                    failed.fetch_add(requests - i);
+                    break;
+                }
+                first_ns.record(first - sent);
+                latency_ns.record(now_ns() - sent);
+            }
+            close(fd);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return now_ns() - start;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned clients = 16;
+    uint64_t requests = 10;
+    uint32_t max_tokens = 32;
+    uint16_t port = 18471;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            clients = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--requests") == 0 && i + 1 < argc) {
+            requests = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--max-tokens") == 0 && i + 1 < argc) {
+            max_tokens = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = static_cast<uint16_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+    }
+    if (clients == 0) clients = 1;
+    if (requests == 0) requests = 1;
+    if (max_tokens == 0) max_tokens = 1;
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+    signal(SIGPIPE, SIG_IGN);
+
+    ai::BatchConfig config;
+    config.mode = ai::BatchMode::ITERATION;
+    config.max_batch = clients;
+    ai::get_inference_scheduler().configure(config);
+
+    nymph::net::ServerConfig server_config;
+    server_config.host = "127.0.0.1";
+    server_config.port = port;
+    server_config.workers = 1;
+    nymph::net::HttpServer server(server_config, [](nymph::api::APIRequest& req) {
+        return nymph::api::api_infer(req);
+    });
+    if (!server.start()) {
+        std::fprintf(stderr, "Failed to start the server on port %u\n", port);
+        return 1;
+    }
+    std::printf("%u clients x %llu requests, one worker loop, up to %u tokens each\n", clients,
+                static_cast<unsigned long long>(requests), max_tokens);
+
+    const bool modes[] = {false, true};
+    for (bool streamed : modes) {
+        nymph::metrics::Histogram first_ns;
+        nymph::metrics::Histogram latency_ns;
+        std::atomic<uint64_t> failed{0};
+        uint64_t tokens_before = 0;
+        for (const ai::BatchQueueStats& queue : ai::get_inference_scheduler().get_stats()) {
+            tokens_before += queue.tokens;
+        }
+        uint64_t elapsed = run_clients(port, clients, requests, max_tokens, streamed, first_ns, latency_ns, failed);
+        uint64_t tokens = 0;
+        for (const ai::BatchQueueStats& queue : ai::get_inference_scheduler().get_stats()) {
+            tokens += queue.tokens;
+        }
+        nymph::metrics::Histogram::Snapshot first = first_ns.snapshot();
+        nymph::metrics::Histogram::Snapshot latency = latency_ns.snapshot();
+        std::printf("%-10s first output p50 %7.2f ms p99 %7.2f ms   latency p50 %7.2f ms p99 %7.2f ms   %8.1f tok/s",
+                    streamed ? "streamed" : "plain", first.quantile(0.50) / 1e6, first.quantile(0.99) / 1e6,
+                    latency.quantile(0.50) / 1e6, latency.quantile(0.99) / 1e6,
+                    (tokens - tokens_before) / (elapsed / 1e9));
+        if (failed.load() > 0) {
+            std::printf("   %llu failed", static_cast<unsigned long long>(failed.load()));
+        }
+        std::printf("\n");
+    }
+
+    server.stop();
+    ai::get_inference_scheduler().shutdown();
+    return 0;
+}
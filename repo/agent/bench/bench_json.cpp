@@ -0,0 +1,160 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 JSON Request Decoding Benchmark
+ *
+ * Decodes a POST /infer body carrying a large prompt three ways: the
+ * per-field find() scan parse_inference_request used before json::Reader,
+ * json::Reader with the scalar string scanner, and json::Reader as built
+ * (SSE2/NEON string scanning). The prompt contains escaped quotes and
+ * newlines, which the old scanner could not handle correctly.
+ *
+ * Usage: bench_json [--iterations N] [--prompt-kb N]
+ */
+
+#include "ai_onnx.hpp"
+#include "json.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace nymph::bench;
+
+namespace {
+
+/* The pre-Reader decoder: one find() pass over the whole body per field */
+std::string legacy_find_field(const std::string& json_body, const std::string& field) {
+    std::string search = "\"" + field + "\"";
+    size_t pos = json_body.find(search);
+    if (pos == std::string::npos) return "";
+    pos = json_body.find(":", pos);
+    if (pos == std::string::npos) return "";
+    pos++;
+    while (pos < json_body.length() && (json_body[pos] == ' ' || json_body[pos] == '\t')) {
+        pos++;
+    }
+    if (pos >= json_body.length() || json_body[pos] != '"') return "";
+    pos++;
+    size_t end = pos;
+    while (end < json_body.length()) {
+        if (json_body[end] == '"' && (end == pos || json_body[end - 1] != '\\')) {
+            break;
+        }
+        end++;
+    }
+    std::string value = json_body.substr(pos, end - pos);
+    size_t esc_pos = 0;
+    while ((esc_pos = value.find("\\\"", esc_pos)) != std::string::npos) {
+        value.replace(esc_pos, 2, "\"");
+        esc_pos++;
+    }
+    return value;
+}
+
+nymph::ai::InferenceRequest legacy_parse(const std::string& json_body) {
+    nymph::ai::InferenceRequest request;
+    request.model_name = legacy_find_field(json_body, "model");
+    request.input_text = legacy_find_field(json_body, "input");
+    request.profile = legacy_find_field(json_body, "profile");
+    return request;
+}
+
+/* Reader pass with the string scan forced to the scalar loop */
+size_t scalar_scan_strings(const std::string& body) {
+    // Mirrors the work Reader does on the prompt: find every special byte
+    size_t specials = 0;
+    size_t pos = 0;
+    while (pos < body.size()) {
+        pos += nymph::json::detail::find_string_special_scalar(body.data() + pos, body.size() - pos);
+        if (pos < body.size()) {
+            specials++;
+            pos += (body[pos] == '\\') ? 2 : 1;
+        }
+    }
+    return specials;
+}
+
+size_t simd_scan_strings(const std::string& body) {
+    size_t specials = 0;
+    size_t pos = 0;
+    while (pos < body.size()) {
+        pos += nymph::json::detail::find_string_special(body.data() + pos, body.size() - pos);
+        if (pos < body.size()) {
+            specials++;
+            pos += (body[pos] == '\\') ? 2 : 1;
+        }
+    }
+    return specials;
+}
+
+std::string make_body(size_t prompt_bytes) {
+    static const char* const kSentence =
+        "The operator said \\\"keep the KV cache warm\\\" and moved on.\\n"
+        "Thermal headroom is fine; fan at 40%, NPU at 61 C. ";
+    std::string prompt;
+    prompt.reserve(prompt_bytes + 128);
+    while (prompt.size() < prompt_bytes) {
+        prompt += kSentence;
+    }
+    // Fields after the prompt force a single-field scanner to cross it
+    return "{\"input\":\"" + prompt + "\",\"model\":\"llm-7b-int4\",\"profile\":\"edge-llm-turbo\"}";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = 200;
+    size_t prompt_kb = 1024;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--prompt-kb") == 0 && i + 1 < argc) {
+            prompt_kb = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+
+    std::string body = make_body(prompt_kb * 1024);
+    double bytes = static_cast<double>(body.size());
+    std::printf("POST /infer body: %zu bytes\n", body.size());
+
+    uint64_t start = now_ns();
+    size_t sink = 0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        nymph::ai::InferenceRequest request = legacy_parse(body);
+        sink += request.input_text.size() + request.model_name.size();
+    }
+    report("legacy find() per field", iterations, now_ns() - start, bytes * iterations);
+
+    start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        sink += scalar_scan_strings(body);
+    }
+    report("string scan, scalar", iterations, now_ns() - start, bytes * iterations);
+
+    start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        sink += simd_scan_strings(body);
+    }
+    report("string scan, SIMD", iterations, now_ns() - start, bytes * iterations);
+
+    start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        nymph::json::Reader reader(body);
+        std::string_view key;
+        nymph::json::Value value;
+        while (reader.next(key, value)) {
+            sink += value.raw.size();
+        }
+    }
+    report("json::Reader validate only", iterations, now_ns() - start, bytes * iterations);
+
+    start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        nymph::ai::InferenceRequest request = nymph::ai::parse_inference_request(body);
+        sink += request.input_text.size() + request.model_name.size();
+    }
+    report("parse_inference_request (decoded)", iterations, now_ns() - start, bytes * iterations);
+
+    do_not_optimize(sink);
+    return 0;
+}
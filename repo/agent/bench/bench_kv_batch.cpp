@@ -0,0 +1,165 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Batch Benchmark
+ *
+ * A scheduler wave: pin W regions (default 32), access each, unpin each.
+ * Runs the wave as 3W separate manager calls and as one apply_batch, from
+ * 1 to N threads (disjoint regions per thread). Then times the pins of a
+ * wave as the agent serves them, W /kv/pin requests against one /kv/batch
+ * request, each parsed off the wire, handled and serialized; socket round
+ * trips would add to the per-request side.
+ *
+ * Usage: bench_kv_batch [--wave N] [--waves N] [--threads N]
+ */
+
+#include "kvpin.hpp"
+#include "nymph_api.hpp"
+#include "http_parser.hpp"
+#include "http_server.hpp"
+#include "logger.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nymph::bench;
+namespace kv = nymph::kv;
+
+namespace {
+
+kv::KVOp make_op(kv::KVOpType type, const std::string& region) {
+    kv::KVOp op;
+    op.type = type;
+    op.pin.region = region;
+    op.pin.size_kb = 64;
+    op.pin.force = false;
+    op.pin.priority = 0;
+    op.is_read = true;
+    op.offset_kb = kv::KVCacheManager::kWholeRegion;
+    return op;
+}
+
+/* Every thread runs waves over its own regions; returns wall time */
+template <typename Wave>
+uint64_t run_threads(unsigned threads, uint64_t waves, Wave wave) {
+    std::vector<std::thread> workers;
+    uint64_t start = now_ns();
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (uint64_t i = 0; i < waves; i++) {
+                wave(t);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return now_ns() - start;
+}
+
+std::string wire(const std::string& path, const std::string& body) {
+    return "POST " + path + " HTTP/1.1\r\nHost: nymph\r\nContent-Type: application/json\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+/* Server-side cost of one request: parse, handle, serialize */
+size_t serve(const std::string& request, nymph::api::APIResponse (*handler)(const nymph::api::APIRequest&)) {
+    std::string buffer = request;
+    nymph::net::HttpParser parser;
+    parser.parse(buffer, 0);
+    nymph::api::APIRequest req;
+    parser.fill_request(buffer, req);
+    return nymph::net::build_response(handler(req), true).size();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t wave_size = 32;
+    uint64_t waves = 20000;
+    unsigned max_threads = 8;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--wave") == 0 && i + 1 < argc) {
+            wave_size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--waves") == 0 && i + 1 < argc) {
+            waves = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+    }
+    if (wave_size == 0) wave_size = 1;
+    if (max_threads == 0) max_threads = 1;
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    // Regions stay resident across waves: the steady state is re-pin hits
+    kv::KVCacheManager manager;
+    manager.initialize(max_threads * wave_size * 64 + 1024);
+    std::vector<std::vector<std::string>> names(max_threads);
+    std::vector<std::vector<kv::KVOp>> batches(max_threads);
+    for (unsigned t = 0; t < max_threads; t++) {
+        for (uint64_t id = 0; id < wave_size; id++) {
+            names[t].push_back("t" + std::to_string(t) + "-ctx-" + std::to_string(id));
+        }
+        for (kv::KVOpType type : {kv::KVOpType::PIN, kv::KVOpType::ACCESS, kv::KVOpType::UNPIN}) {
+            for (const std::string& name : names[t]) {
+                batches[t].push_back(make_op(type, name));
+            }
+        }
+    }
+    std::printf("waves of %llu regions, 3 ops each\n", static_cast<unsigned long long>(wave_size));
+
+    auto single_calls = [&](unsigned t) {
+        for (const kv::KVOp& op : batches[t]) {
+            switch (op.type) {
+                case kv::KVOpType::PIN:
+                    do_not_optimize(manager.pin_region(op.pin).success);
+                    break;
+                case kv::KVOpType::ACCESS:
+                    do_not_optimize(manager.access_region(op.pin.region));
+                    break;
+                default:
+                    do_not_optimize(manager.unpin_region(op.pin.region));
+                    break;
+            }
+        }
+    };
+    auto one_batch = [&](unsigned t) {
+        do_not_optimize(manager.apply_batch(batches[t], false).success);
+    };
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        uint64_t ops = threads * waves * batches[0].size();
+        std::string suffix = " (" + std::to_string(threads) + " threads)";
+        report("per-op calls" + suffix, ops, run_threads(threads, waves, single_calls));
+        report("apply_batch" + suffix, ops, run_threads(threads, waves, one_batch));
+    }
+
+    // The same pins as the agent serves them: parse the request off the
+    // wire, run the handler and build the response, per request
+    kv::get_kv_cache_manager().initialize(wave_size * 64 + 1024);
+    std::vector<std::string> pin_requests;
+    std::string batch_body = "{\"ops\":[";
+    for (const std::string& name : names[0]) {
+        pin_requests.push_back(wire("/kv/pin", "{\"region\":\"" + name + "\",\"size_kb\":64}"));
+        if (pin_requests.size() > 1) batch_body += ",";
+        batch_body += "{\"op\":\"pin\",\"region\":\"" + name + "\",\"size_kb\":64}";
+    }
+    batch_body += "]}";
+    std::string batch_request = wire("/kv/batch", batch_body);
+    uint64_t api_waves = waves / 4 + 1;
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < api_waves; i++) {
+        for (const std::string& request : pin_requests) {
+            do_not_optimize(serve(request, nymph::api::api_kvpin));
+        }
+    }
+    report("POST /kv/pin per region", api_waves * wave_size, now_ns() - start);
+    start = now_ns();
+    for (uint64_t i = 0; i < api_waves; i++) {
+        do_not_optimize(serve(batch_request, nymph::api::api_kv_batch));
+    }
+    report("POST /kv/batch per wave", api_waves * wave_size, now_ns() - start);
+    return 0;
+}
@@ -0,0 +1,138 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Region Index Benchmark
+ *
+ * Builds N regions (default 100k) two ways: the std::map<std::string,
+ * region> the manager used before, with counters inside each node, and
+ * RegionIndex over interned slots with the counters in RegionCounters
+ * columns. Times random name lookups and a get_stats style counter sum
+ * over every region in each.
+ *
+ * Usage: bench_kv_index [--regions N] [--lookups N]
+ */
+
+#include "kv_index.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace nymph::bench;
+namespace kv = nymph::kv;
+
+namespace {
+
+/* The old map value: name copy, cold metadata and counters side by side */
+struct LegacyRegion {
+    std::string name;
+    uint64_t size_kb = 0;
+    uint64_t base_address = 0;
+    std::vector<uint32_t> blocks;
+    bool is_pinned = false;
+    uint64_t access_count = 0;
+    uint64_t hit_count = 0;
+    uint64_t miss_count = 0;
+    uint64_t last_access_time = 0;
+};
+
+std::string region_name(uint64_t id) {
+    return "ctx-" + std::to_string(id);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t regions = 100000;
+    uint64_t lookups = 2000000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--regions") == 0 && i + 1 < argc) {
+            regions = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--lookups") == 0 && i + 1 < argc) {
+            lookups = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+    if (regions == 0) regions = 1;
+
+    std::vector<std::string> names;
+    names.reserve(regions);
+    for (uint64_t id = 0; id < regions; id++) {
+        names.push_back(region_name(id));
+    }
+    std::vector<uint32_t> order(lookups);
+    std::mt19937_64 rng(42);
+    for (uint32_t& id : order) {
+        id = static_cast<uint32_t>(rng() % regions);
+    }
+    const int scans = 100;
+    std::printf("%llu regions\n", static_cast<unsigned long long>(regions));
+
+    {
+        std::map<std::string, LegacyRegion> map;
+        for (uint64_t id = 0; id < regions; id++) {
+            LegacyRegion& region = map[names[id]];
+            region.name = names[id];
+            region.access_count = id;
+        }
+
+        uint64_t found = 0;
+        uint64_t start = now_ns();
+        for (uint32_t id : order) {
+            auto it = map.find(names[id]);
+            if (it != map.end()) {
+                it->second.access_count++;
+                found++;
+            }
+        }
+        report("std::map lookup + count", lookups, now_ns() - start);
+        do_not_optimize(found);
+
+        uint64_t total = 0;
+        start = now_ns();
+        for (int scan = 0; scan < scans; scan++) {
+            for (const auto& pair : map) {
+                total += pair.second.access_count;
+            }
+        }
+        report("std::map counter scan (per region)", regions * scans, now_ns() - start);
+        do_not_optimize(total);
+    }
+
+    {
+        kv::RegionIndex index;
+        kv::RegionCounters counters;
+        std::vector<std::string> slot_names;
+        counters.reserve(regions);
+        for (uint64_t id = 0; id < regions; id++) {
+            uint32_t slot = static_cast<uint32_t>(slot_names.size());
+            slot_names.push_back(names[id]);
+            index.insert(kv::region_hash(names[id]), slot);
+            counters.at(kv::RegionCounters::ACCESSES, slot).store(id, std::memory_order_relaxed);
+        }
+        auto name_of = [&](uint32_t slot) -> std::string_view { return slot_names[slot]; };
+
+        uint64_t found = 0;
+        uint64_t start = now_ns();
+        for (uint32_t id : order) {
+            const std::string& name = names[id];
+            uint32_t slot = index.find(name, kv::region_hash(name), name_of);
+            if (slot != kv::RegionIndex::kNoSlot) {
+                counters.at(kv::RegionCounters::ACCESSES, slot).fetch_add(1, std::memory_order_relaxed);
+                found++;
+            }
+        }
+        report("RegionIndex lookup + count", lookups, now_ns() - start);
+        do_not_optimize(found);
+
+        uint64_t total = 0;
+        start = now_ns();
+        for (int scan = 0; scan < scans; scan++) {
+            total += counters.sum(kv::RegionCounters::ACCESSES, regions);
+        }
+        report("RegionCounters column sum (per region)", regions * scans, now_ns() - start);
+        do_not_optimize(total);
+    }
+    return 0;
+}
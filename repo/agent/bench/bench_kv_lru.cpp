@@ -0,0 +1,186 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Eviction Benchmark
+ *
+ * Fills the KV cache with N one-block regions (default 100k), unpins
+ * most of them, then replays a mix of accesses, unpins and forced pins
+ * of new regions, each of which has to evict. Runs the mix against the
+ * sort-on-evict scheme evict_lru used before the intrusive LRU list
+ * (rebuilt here on the same map) and against KVCacheManager itself.
+ *
+ * Usage: bench_kv_lru [--regions N] [--ops N] [--legacy-ops N]
+ */
+
+#include "kvpin.hpp"
+#include "logger.hpp"
+#include "bench_common.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace nymph::bench;
+namespace kv = nymph::kv;
+
+namespace {
+
+/* The pre-list manager: regions in a map, eviction sorts all unpinned ones */
+class LegacyCache {
+public:
+    explicit LegacyCache(uint64_t capacity_kb) : capacity_kb_(capacity_kb), used_kb_(0), clock_(0) {}
+
+    bool pin(const std::string& name, uint64_t size_kb) {
+        auto it = regions_.find(name);
+        if (it != regions_.end()) {
+            it->second.pinned = true;
+            it->second.last_access = ++clock_;
+            return true;
+        }
+        if (used_kb_ + size_kb > capacity_kb_ &&
+            evict(used_kb_ + size_kb - capacity_kb_) < used_kb_ + size_kb - capacity_kb_) {
+            return false;
+        }
+        Region& region = regions_[name];
+        region.size_kb = size_kb;
+        region.pinned = true;
+        region.last_access = ++clock_;
+        used_kb_ += size_kb;
+        return true;
+    }
+
+    void unpin(const std::string& name) {
+        auto it = regions_.find(name);
+        if (it != regions_.end()) it->second.pinned = false;
+    }
+
+    bool access(const std::string& name) {
+        auto it = regions_.find(name);
+        if (it == regions_.end()) return false;
+        it->second.last_access = ++clock_;
+        return true;
+    }
+
+private:
+    struct Region {
+        uint64_t size_kb;
+        bool pinned;
+        uint64_t last_access;
+    };
+    std::map<std::string, Region> regions_;
+    uint64_t capacity_kb_;
+    uint64_t used_kb_;
+    uint64_t clock_;
+
+    uint64_t evict(uint64_t required_kb) {
+        std::vector<std::pair<std::string, uint64_t>> candidates;
+        for (const auto& pair : regions_) {
+            if (!pair.second.pinned) {
+                candidates.push_back({pair.first, pair.second.last_access});
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const auto& a, const auto& b) { return a.second < b.second; });
+        uint64_t freed = 0;
+        for (const auto& candidate : candidates) {
+            if (freed >= required_kb) break;
+            auto it = regions_.find(candidate.first);
+            freed += it->second.size_kb;
+            used_kb_ -= it->second.size_kb;
+            regions_.erase(it);
+        }
+        return freed;
+    }
+};
+
+std::string region_name(uint64_t id) {
+    return "ctx-" + std::to_string(id);
+}
+
+/* Prefill, then the mixed phase; returns ns spent in the mixed phase */
+template <typename Pin, typename Unpin, typename Access>
+uint64_t run_mix(uint64_t regions, uint64_t ops, Pin pin, Unpin unpin, Access access) {
+    const uint64_t block_kb = kv::BlockAllocator::kBlockSizeKB;
+    std::mt19937_64 rng(42);
+    for (uint64_t id = 0; id < regions; id++) {
+        pin(region_name(id), block_kb);
+        if (rng() % 10 != 0) {
+            unpin(region_name(id));     // ~10% stay pinned
+        }
+    }
+
+    uint64_t next_id = regions;
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < ops; i++) {
+        uint64_t roll = rng() % 100;
+        // Recent ids are hotter: pick from the newest `regions` ids
+        uint64_t id = next_id - 1 - rng() % regions;
+        if (roll < 60) {
+            access(region_name(id));
+        } else if (roll < 80) {
+            unpin(region_name(id));
+        } else {
+            pin(region_name(next_id++), block_kb);    // Cache is full: evicts
+        }
+    }
+    return now_ns() - start;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t regions = 100000;
+    uint64_t ops = 1000000;
+    uint64_t legacy_ops = 2000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--regions") == 0 && i + 1 < argc) {
+            regions = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            ops = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--legacy-ops") == 0 && i + 1 < argc) {
+            legacy_ops = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+    if (regions == 0) regions = 1;
+
+    // Eviction logs at INFO; keep the logger out of the measurement
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    const uint64_t capacity_kb = regions * kv::BlockAllocator::kBlockSizeKB;
+    std::printf("%llu regions, 60%% access / 20%% unpin / 20%% forced pin\n",
+                static_cast<unsigned long long>(regions));
+
+    {
+        LegacyCache cache(capacity_kb);
+        uint64_t elapsed = run_mix(regions, legacy_ops,
+            [&](const std::string& name, uint64_t kb) { return cache.pin(name, kb); },
+            [&](const std::string& name) { cache.unpin(name); },
+            [&](const std::string& name) { return cache.access(name); });
+        report("sort-on-evict map", legacy_ops, elapsed);
+    }
+
+    {
+        kv::KVCacheManager manager;
+        manager.initialize(capacity_kb);
+        uint64_t elapsed = run_mix(regions, ops,
+            [&](const std::string& name, uint64_t kb) {
+                kv::KVPinRequest request;
+                request.region = name;
+                request.size_kb = kb;
+                request.force = true;
+                request.priority = 0;
+                return manager.pin_region(request).success;
+            },
+            [&](const std::string& name) { manager.unpin_region(name); },
+            [&](const std::string& name) { return manager.access_region(name); });
+        report("KVCacheManager, intrusive LRU", ops, elapsed);
+
+        kv::KVCacheGauges gauges = manager.get_gauges();
+        std::printf("  evictions %llu, regions resident %llu\n",
+                    static_cast<unsigned long long>(gauges.evictions),
+                    static_cast<unsigned long long>(gauges.regions));
+    }
+    return 0;
+}
@@ -0,0 +1,305 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Eviction Policy Replay
+ *
+ * Replays a KV access trace against KVCacheManager once per eviction
+ * policy and compares hit rates. A trace is a text file, one operation
+ * per line ('#' starts a comment):
+ *
+ *   pin <region> <size_kb> <priority>
+ *   access <region>
+ *   unpin <region>
+ *
+ * A pin or access of a region seen before counts as a hit when all of
+ * the region is still resident and as a miss when any page was spilled
+ * or the region evicted; a missed
+ * access re-admits the region (forced pin, then unpin) the way a server
+ * would recompute the context. First pins are compulsory misses and are
+ * not counted.
+ *
+ * Without --trace a synthetic chat workload is generated: Zipf-popular
+ * sessions of mixed size, a few high-priority system prompts, and
+ * one-off large scans that pollute recency. --save writes it out so a
+ * run can be repeated or edited.
+ *
+ * --spill FILE adds the NVMe spill tier, a file of --spill-mb MB, so
+ * evicted pages can be read back instead of recomputed.
+ *
+ * Usage: bench_kv_replay [--trace FILE] [--save FILE] [--cache-mb N]
+ *                        [--events N] [--sessions N]
+ *                        [--spill FILE] [--spill-mb N]
+ */
+
+#include "kvpin.hpp"
+#include "logger.hpp"
+#include "bench_common.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace nymph::bench;
+namespace kv = nymph::kv;
+
+namespace {
+
+enum class Op { PIN, ACCESS, UNPIN };
+
+struct TraceEvent {
+    Op op;
+    std::string region;
+    uint64_t size_kb;
+    int priority;
+};
+
+bool load_trace(const std::string& path, std::vector<TraceEvent>& trace) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream fields(line);
+        std::string op;
+        TraceEvent event;
+        event.size_kb = 0;
+        event.priority = 0;
+        if (!(fields >> op >> event.region)) {
+            continue;
+        }
+        if (op == "pin") {
+            event.op = Op::PIN;
+            fields >> event.size_kb >> event.priority;
+        } else if (op == "access") {
+            event.op = Op::ACCESS;
+        } else if (op == "unpin") {
+            event.op = Op::UNPIN;
+        } else {
+            continue;
+        }
+        trace.push_back(event);
+    }
+    return true;
+}
+
+bool save_trace(const std::string& path, const std::vector<TraceEvent>& trace) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "# NYMPH KV trace: pin <region> <size_kb> <priority> | access <region> | unpin <region>\n";
+    for (const TraceEvent& event : trace) {
+        switch (event.op) {
+            case Op::PIN:
+                out << "pin " << event.region << " " << event.size_kb << " " << event.priority << "\n";
+                break;
+            case Op::ACCESS:
+                out << "access " << event.region << "\n";
+                break;
+            case Op::UNPIN:
+                out << "unpin " << event.region << "\n";
+                break;
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+std::vector<TraceEvent> synthesize(uint64_t events, uint64_t sessions) {
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    // Zipf(0.9) over sessions via the inverse CDF table
+    std::vector<double> cdf(sessions);
+    double total = 0.0;
+    for (uint64_t i = 0; i < sessions; i++) {
+        total += 1.0 / std::pow(static_cast<double>(i + 1), 0.9);
+        cdf[i] = total;
+    }
+
+    struct Session {
+        uint64_t size_kb;
+        int priority;
+    };
+    std::vector<Session> info(sessions);
+    std::lognormal_distribution<double> size_kb(std::log(192.0), 0.9);
+    for (uint64_t i = 0; i < sessions; i++) {
+        info[i].size_kb = std::min<uint64_t>(4096, std::max<uint64_t>(16, static_cast<uint64_t>(size_kb(rng))));
+        info[i].priority = (i % 50 == 0) ? 3 : 0;     // System prompts
+    }
+
+    std::vector<TraceEvent> trace;
+    uint64_t scans = 0;
+    while (trace.size() < events) {
+        if (unit(rng) < 0.08) {
+            // One-off long document: large, used once
+            std::string name = "scan-" + std::to_string(scans++);
+            trace.push_back({Op::PIN, name, 2048 + rng() % 4096, 0});
+            trace.push_back({Op::ACCESS, name, 0, 0});
+            trace.push_back({Op::UNPIN, name, 0, 0});
+            continue;
+        }
+        double pick = unit(rng) * total;
+        uint64_t id = static_cast<uint64_t>(std::lower_bound(cdf.begin(), cdf.end(), pick) - cdf.begin());
+        if (id >= sessions) id = sessions - 1;
+        std::string name = "chat-" + std::to_string(id);
+        trace.push_back({Op::PIN, name, info[id].size_kb, info[id].priority});
+        uint64_t turns = 1 + rng() % 3;
+        for (uint64_t t = 0; t < turns; t++) {
+            trace.push_back({Op::ACCESS, name, 0, 0});
+        }
+        trace.push_back({Op::UNPIN, name, 0, 0});
+    }
+    return trace;
+}
+
+struct ReplayResult {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t failed;        // Pins that could not be placed at all
+    uint64_t evictions;
+    uint64_t elapsed_ns;
+};
+
+ReplayResult replay(const std::vector<TraceEvent>& trace, uint64_t cache_kb, kv::EvictionPolicy policy,
+                    const std::string& spill_path, uint64_t spill_kb) {
+    kv::KVCacheManager manager;
+    manager.initialize(cache_kb, policy);
+    if (!spill_path.empty() && !manager.enable_spill(spill_path, spill_kb)) {
+        std::fprintf(stderr, "Cannot set up spill file %s\n", spill_path.c_str());
+        std::exit(1);
+    }
+
+    // Size and priority of every region seen, for re-admission
+    std::unordered_map<std::string, kv::KVPinRequest> seen;
+    ReplayResult result = {0, 0, 0, 0, 0};
+    kv::KVRegion region;
+
+    auto admit = [&](const kv::KVPinRequest& request) {
+        if (!manager.pin_region(request).success) {
+            result.failed++;
+            return false;
+        }
+        return true;
+    };
+
+    uint64_t start = now_ns();
+    for (const TraceEvent& event : trace) {
+        switch (event.op) {
+            case Op::PIN: {
+                kv::KVPinRequest request;
+                request.region = event.region;
+                request.size_kb = event.size_kb;
+                request.force = true;
+                request.priority = event.priority;
+                auto it = seen.find(event.region);
+                if (it != seen.end()) {
+                    bool resident = manager.get_region(event.region, region) &&
+                                    region.blocks.size() == region.pages;
+                    if (resident) result.hits++;
+                    else result.misses++;
+                    it->second = request;
+                } else {
+                    seen.emplace(event.region, request);
+                }
+                admit(request);
+                break;
+            }
+            case Op::ACCESS: {
+                if (manager.access_region(event.region)) {
+                    result.hits++;
+                    break;
+                }
+                result.misses++;
+                auto it = seen.find(event.region);
+                if (it != seen.end() && admit(it->second)) {
+                    manager.unpin_region(event.region);
+                }
+                break;
+            }
+            case Op::UNPIN:
+                manager.unpin_region(event.region);
+                break;
+        }
+    }
+    result.elapsed_ns = now_ns() - start;
+    result.evictions = manager.get_gauges().evictions;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string trace_path;
+    std::string save_path;
+    uint64_t cache_mb = 64;
+    std::string spill_path;
+    uint64_t spill_mb = 256;
+    uint64_t events = 400000;
+    uint64_t sessions = 20000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--cache-mb") == 0 && i + 1 < argc) {
+            cache_mb = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--spill") == 0 && i + 1 < argc) {
+            spill_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--spill-mb") == 0 && i + 1 < argc) {
+            spill_mb = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+            events = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) {
+            sessions = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+    if (sessions == 0) sessions = 1;
+
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    std::vector<TraceEvent> trace;
+    if (!trace_path.empty()) {
+        if (!load_trace(trace_path, trace)) {
+            std::fprintf(stderr, "Cannot read trace %s\n", trace_path.c_str());
+            return 1;
+        }
+        std::printf("Trace %s: %zu events\n", trace_path.c_str(), trace.size());
+    } else {
+        trace = synthesize(events, sessions);
+        std::printf("Synthetic trace: %zu events over %llu sessions\n", trace.size(),
+                    static_cast<unsigned long long>(sessions));
+    }
+    if (!save_path.empty() && !save_trace(save_path, trace)) {
+        std::fprintf(stderr, "Cannot write trace %s\n", save_path.c_str());
+        return 1;
+    }
+
+    std::printf("Cache %llu MB", static_cast<unsigned long long>(cache_mb));
+    if (!spill_path.empty()) {
+        std::printf(", spill file %llu MB", static_cast<unsigned long long>(spill_mb));
+    }
+    std::printf("\n\n");
+    std::printf("%-14s %10s %10s %10s %10s %10s %12s\n",
+                "policy", "hit rate", "hits", "misses", "evictions", "failed", "ns/event");
+    for (kv::EvictionPolicy policy : {kv::EvictionPolicy::LRU, kv::EvictionPolicy::LFU,
+                                      kv::EvictionPolicy::PRIORITY_LRU, kv::EvictionPolicy::GDSF}) {
+        ReplayResult r = replay(trace, cache_mb * 1024, policy, spill_path, spill_mb * 1024);
+        uint64_t lookups = r.hits + r.misses;
+        std::printf("%-14s %9.2f%% %10llu %10llu %10llu %10llu %12.1f\n",
+                    kv::eviction_policy_to_string(policy).c_str(),
+                    lookups ? 100.0 * r.hits / lookups : 0.0,
+                    static_cast<unsigned long long>(r.hits),
+                    static_cast<unsigned long long>(r.misses),
+                    static_cast<unsigned long long>(r.evictions),
+                    static_cast<unsigned long long>(r.failed),
+                    trace.empty() ? 0.0 : static_cast<double>(r.elapsed_ns) / trace.size());
+    }
+    return 0;
+}
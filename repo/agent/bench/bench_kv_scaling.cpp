@@ -0,0 +1,174 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Cache Concurrency Scaling Benchmark
+ *
+ * Read-mostly KV traffic from 1 to N threads: accesses and region
+ * lookups over a fixed set of regions, with an occasional full stats
+ * read. Runs against KVCacheManager (sharded, read-locked accesses) and
+ * against the single-mutex scheme it replaced, rebuilt here on a plain
+ * map. Reported ns/op is wall time over all threads' operations, so
+ * perfect scaling halves it each time the thread count doubles.
+ *
+ * Usage: bench_kv_scaling [--regions N] [--ops N] [--threads N]
+ *        (--ops is per thread)
+ */
+
+#include "kvpin.hpp"
+#include "logger.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nymph::bench;
+namespace kv = nymph::kv;
+
+namespace {
+
+/* Baseline: every call takes one manager-wide mutex */
+class GlobalLockCache {
+public:
+    void pin(const std::string& name, uint64_t size_kb) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        kv::KVRegion& region = regions_[name];
+        region.name = name;
+        region.size_kb = size_kb;
+        region.is_pinned = true;
+        region.access_count = 1;
+        region.hit_count = 1;
+        region.miss_count = 0;
+    }
+
+    bool access(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = regions_.find(name);
+        if (it == regions_.end()) return false;
+        it->second.access_count++;
+        it->second.hit_count++;
+        return true;
+    }
+
+    bool get(const std::string& name, kv::KVRegion& region) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = regions_.find(name);
+        if (it == regions_.end()) return false;
+        region = it->second;
+        return true;
+    }
+
+    uint64_t stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t accesses = 0;
+        for (const auto& pair : regions_) {
+            accesses += pair.second.access_count;
+        }
+        return accesses;
+    }
+
+private:
+    std::map<std::string, kv::KVRegion> regions_;
+    mutable std::mutex mutex_;
+};
+
+/* Every thread runs ops operations: 90% access, 10% lookup, a stats read every 4096 */
+template <typename Access, typename Get, typename Stats>
+uint64_t run_threads(unsigned threads, uint64_t ops, const std::vector<std::string>& names,
+                     Access access, Get get, Stats stats) {
+    std::vector<std::thread> workers;
+    uint64_t start = now_ns();
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            uint64_t state = 0x9E3779B97F4A7C15ull * (t + 1);
+            kv::KVRegion region;
+            for (uint64_t i = 0; i < ops; i++) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                const std::string& name = names[state % names.size()];
+                if ((i & 4095) == 4095) {
+                    do_not_optimize(stats());
+                } else if (state % 10 == 0) {
+                    do_not_optimize(get(name, region));
+                } else {
+                    do_not_optimize(access(name));
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return now_ns() - start;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t regions = 10000;
+    uint64_t ops = 500000;
+    unsigned max_threads = std::thread::hardware_concurrency();
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--regions") == 0 && i + 1 < argc) {
+            regions = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            ops = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+    }
+    if (regions == 0) regions = 1;
+    if (max_threads == 0) max_threads = 1;
+
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    std::vector<std::string> names;
+    names.reserve(regions);
+    for (uint64_t id = 0; id < regions; id++) {
+        names.push_back("ctx-" + std::to_string(id));
+    }
+
+    const uint64_t block_kb = kv::BlockAllocator::kBlockSizeKB;
+    kv::KVCacheManager manager;
+    manager.initialize(regions * block_kb);
+    GlobalLockCache locked;
+    for (uint64_t id = 0; id < regions; id++) {
+        kv::KVPinRequest request;
+        request.region = names[id];
+        request.size_kb = block_kb;
+        request.force = false;
+        request.priority = 0;
+        manager.pin_region(request);
+        locked.pin(names[id], block_kb);
+        if (id % 2 == 0) {
+            manager.unpin_region(names[id]);    // Half take the unpinned path
+        }
+    }
+
+    std::printf("%llu regions, %llu ops per thread, 90%% access / 10%% lookup, stats every 4096\n",
+                static_cast<unsigned long long>(regions), static_cast<unsigned long long>(ops));
+
+    std::vector<unsigned> counts;
+    for (unsigned n = 1; n < max_threads; n *= 2) {
+        counts.push_back(n);
+    }
+    counts.push_back(max_threads);
+
+    for (unsigned n : counts) {
+        uint64_t elapsed = run_threads(n, ops, names,
+            [&](const std::string& name) { return manager.access_region(name); },
+            [&](const std::string& name, kv::KVRegion& region) { return manager.get_region(name, region); },
+            [&]() { return manager.get_stats().total_accesses; });
+        report("sharded KVCacheManager, " + std::to_string(n) + " threads", n * ops, elapsed);
+
+        elapsed = run_threads(n, ops, names,
+            [&](const std::string& name) { return locked.access(name); },
+            [&](const std::string& name, kv::KVRegion& region) { return locked.get(name, region); },
+            [&]() { return locked.stats(); });
+        report("global mutex map, " + std::to_string(n) + " threads", n * ops, elapsed);
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Snapshot Benchmark
+ *
+ * Pins N regions (default 20000; every fourth left unpinned, every
+ * eighth opening with a shared prompt), saves a snapshot and restores it
+ * into a fresh manager, as a restarted daemon would. Reports save and
+ * restore time, snapshot size, and the hit rate of one access per region
+ * right after the restart, cold and restored. --budget-ms bounds the
+ * restore as --kv-restore-ms does.
+ *
+ * Usage: bench_kv_snapshot [--regions N] [--region-kb N] [--budget-ms N] [--path FILE]
+ */
+
+#include "kvpin.hpp"
+#include "logger.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace nymph::bench;
+namespace kv = nymph::kv;
+
+namespace {
+
+double first_pass_hit_rate(kv::KVCacheManager& manager, const std::vector<std::string>& names) {
+    uint64_t hits = 0;
+    for (const std::string& name : names) {
+        hits += manager.access_region(name) ? 1 : 0;
+    }
+    return static_cast<double>(hits) / names.size();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t regions = 20000;
+    uint64_t region_kb = 256;
+    uint64_t budget_ms = 10000;
+    std::string path = "/tmp/bench_kv_snapshot.bin";
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--regions") == 0 && i + 1 < argc) {
+            regions = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--region-kb") == 0 && i + 1 < argc) {
+            region_kb = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--budget-ms") == 0 && i + 1 < argc) {
+            budget_ms = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--path") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        }
+    }
+    if (regions == 0) regions = 1;
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    std::vector<uint64_t> prompt_pages(4);
+    for (size_t page = 0; page < prompt_pages.size(); page++) {
+        prompt_pages[page] = 0x9e3779b97f4a7c15ULL * (page + 1);
+    }
+    std::vector<std::string> names;
+    for (uint64_t id = 0; id < regions; id++) {
+        names.push_back("ctx-" + std::to_string(id));
+    }
+    uint64_t cache_kb = regions * region_kb + 1024;
+    std::printf("%llu regions of %llu KB\n", static_cast<unsigned long long>(regions),
+                static_cast<unsigned long long>(region_kb));
+
+    {
+        kv::KVCacheManager before;
+        before.initialize(cache_kb);
+        kv::KVPinRequest request;
+        request.size_kb = region_kb;
+        request.force = false;
+        request.priority = 0;
+        for (uint64_t id = 0; id < regions; id++) {
+            request.region = names[id];
+            request.prefix_pages.clear();
+            if (id % 8 == 0) {
+                request.prefix_pages = prompt_pages;
+            }
+            before.pin_region(request);
+            if (id % 4 == 0) {
+                before.unpin_region(names[id]);
+            }
+        }
+        uint64_t start = now_ns();
+        if (!before.save_snapshot(path)) {
+            std::fprintf(stderr, "failed to save %s\n", path.c_str());
+            return 1;
+        }
+        report("save_snapshot", regions, now_ns() - start);
+    }
+    struct stat info;
+    if (::stat(path.c_str(), &info) == 0) {
+        std::printf("  snapshot %lld bytes, %.1f per region\n", static_cast<long long>(info.st_size),
+                    static_cast<double>(info.st_size) / regions);
+    }
+
+    {
+        kv::KVCacheManager cold;
+        cold.initialize(cache_kb);
+        std::printf("  first pass after a cold restart: hit rate %.3f\n", first_pass_hit_rate(cold, names));
+    }
+
+    kv::KVCacheManager warm;
+    warm.initialize(cache_kb);
+    uint64_t start = now_ns();
+    warm.restore_snapshot(path, budget_ms);
+    warm.wait_restore();
+    report("restore_snapshot", regions, now_ns() - start);
+    kv::KVCacheStats stats = warm.get_stats();
+    std::printf("  restored %llu pinned regions, %llu KB used, %llu shared blocks\n",
+                static_cast<unsigned long long>(stats.pinned_regions),
+                static_cast<unsigned long long>(stats.used_size_kb),
+                static_cast<unsigned long long>(stats.shared_blocks));
+    std::printf("  first pass after a restored restart: hit rate %.3f\n", first_pass_hit_rate(warm, names));
+    ::unlink(path.c_str());
+    return 0;
+}
@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Logging Cost Benchmark
+ *
+ * Replays the log calls made while serving one POST /kv/pin (handler,
+ * KV manager and timing middleware) at three runtime levels, once with
+ * eagerly concatenated std::string messages and once through the
+ * NYMPH_LOG_* macros. Both variants log at the same levels, so the gap is
+ * the cost of building messages that are filtered out or copied twice.
+ *
+ * Log output goes to /dev/null while the enabled cases run; the ring
+ * overflows there, so those rows are the producer-side cost per request.
+ *
+ * Usage: bench_logging [--iterations N]
+ */
+
+#include "logger.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace nymph::bench;
+namespace log = nymph::log;
+
+namespace {
+
+struct PinCall {
+    std::string method;
+    std::string path;
+    std::string region;
+    uint64_t size_kb;
+    double hit_rate;
+    int status;
+    long elapsed_us;
+};
+
+/* The call sites as they were: messages built before the level check */
+void eager_kv_pin(const PinCall& c) {
+    log::debug("POST /kv/pin");
+    log::info("KV pin request - region: " + c.region + ", size_kb: " + std::to_string(c.size_kb));
+    log::debug("Pinning KV region: " + c.region + " (" + std::to_string(c.size_kb) + " KB)");
+    log::debug("Region pinned successfully, hit_rate: " + std::to_string(c.hit_rate));
+    log::debug(c.method + " " + c.path + " -> " + std::to_string(c.status) + " in " +
+               std::to_string(c.elapsed_us) + " us");
+}
+
+/* The same calls through the macros */
+void lazy_kv_pin(const PinCall& c) {
+    NYMPH_LOG_DEBUG("POST /kv/pin");
+    NYMPH_LOG_INFO("KV pin request - region: {}, size_kb: {}", c.region, c.size_kb);
+    NYMPH_LOG_DEBUG("Pinning KV region: {} ({} KB)", c.region, c.size_kb);
+    NYMPH_LOG_DEBUG("Region pinned successfully, hit_rate: {:.4f}", c.hit_rate);
+    NYMPH_LOG_DEBUG("{} {} -> {} in {} us", c.method, c.path, c.status, c.elapsed_us);
+}
+
+void run_level(const char* label, log::Level level, const PinCall& call, uint64_t iterations) {
+    log::Logger& logger = log::Logger::instance();
+    logger.set_level(level);
+
+    // Keep enabled output off the terminal
+    std::fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDOUT_FILENO);
+
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        eager_kv_pin(call);
+    }
+    uint64_t eager_ns = now_ns() - start;
+    logger.flush();
+
+    start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        lazy_kv_pin(call);
+    }
+    uint64_t lazy_ns = now_ns() - start;
+    logger.flush();
+
+    std::fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    close(devnull);
+
+    report(std::string("kv/pin logging, level ") + label + ", eager strings", iterations, eager_ns);
+    report(std::string("kv/pin logging, level ") + label + ", NYMPH_LOG_*", iterations, lazy_ns);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = 1000000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+
+    PinCall call{"POST", "/kv/pin", "chat_ctx_session_0042", 256, 0.8731, 200, 17};
+
+    run_level("WARN ", log::Level::WARN, call, iterations);
+    run_level("INFO ", log::Level::INFO, call, iterations / 10);
+    run_level("DEBUG", log::Level::DEBUG, call, iterations / 10);
+
+    log::LoggerStats stats = log::Logger::instance().get_stats();
+    std::printf("records written %llu, dropped %llu (ring full)\n",
+                static_cast<unsigned long long>(stats.written),
+                static_cast<unsigned long long>(stats.dropped));
+    return 0;
+}
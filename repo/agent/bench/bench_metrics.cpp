@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Metrics Recording Benchmark
+ *
+ * Cost of recording one request latency from N threads at once: the
+ * sharded histogram against a single mutex-protected histogram, which is
+ * what a naive per-route stats struct would do. Also times a scrape.
+ *
+ * Usage: bench_metrics [--iterations N] [--threads N]
+ */
+
+#include "metrics.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace nymph::bench;
+
+namespace {
+
+/* Baseline: one lock around one bucket array */
+struct LockedHistogram {
+    std::mutex mutex;
+    std::vector<uint64_t> counts;
+    uint64_t sum = 0;
+
+    LockedHistogram() : counts(nymph::metrics::Histogram::kBuckets, 0) {}
+
+    void record(uint64_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        counts[nymph::metrics::Histogram::bucket_index(value)]++;
+        sum += value;
+    }
+};
+
+template <typename Record>
+uint64_t run_threads(unsigned threads, uint64_t iterations, Record record) {
+    std::vector<std::thread> workers;
+    uint64_t start = now_ns();
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&record, iterations, t] {
+            // Latencies spread over ~1 us .. ~1 ms
+            uint64_t value = 1000 + t;
+            for (uint64_t i = 0; i < iterations; i++) {
+                record(value);
+                value = (value * 7 + 13) % 1000000;
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return now_ns() - start;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = 2000000;
+    unsigned threads = std::thread::hardware_concurrency();
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+    }
+    if (threads == 0) threads = 1;
+
+    for (unsigned n : {1u, threads}) {
+        nymph::metrics::Histogram sharded;
+        uint64_t elapsed = run_threads(n, iterations, [&sharded](uint64_t v) { sharded.record(v); });
+        report("sharded histogram, " + std::to_string(n) + " threads", n * iterations, elapsed);
+
+        LockedHistogram locked;
+        elapsed = run_threads(n, iterations, [&locked](uint64_t v) { locked.record(v); });
+        report("mutex histogram, " + std::to_string(n) + " threads", n * iterations, elapsed);
+
+        nymph::metrics::Counter counter;
+        elapsed = run_threads(n, iterations, [&counter](uint64_t) { counter.add(); });
+        report("sharded counter, " + std::to_string(n) + " threads", n * iterations, elapsed);
+        do_not_optimize(counter.value());
+
+        uint64_t start = now_ns();
+        nymph::metrics::Histogram::Snapshot snap = sharded.snapshot();
+        uint64_t p99 = snap.quantile(0.99);
+        report("snapshot + p99", 1, now_ns() - start);
+        do_not_optimize(p99);
+    }
+    return 0;
+}
@@ -0,0 +1,188 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Model Registry Benchmark
+ *
+ * Writes K model files of S MB each (default 8 x 64 MB) and registers
+ * them, then sends R requests (default 4000) to Zipf(1.0)-popular models
+ * through ModelRegistry::acquire(), as the runtime does per run. Runs
+ * once with no budget, so every model stays loaded after its first use,
+ * and once per budget given by --fit (default 3 and 1: room for that many
+ * models, plus half a model of slack).
+ *
+ * Reports the hit rate, loads and unloads, acquire latency for hits and
+ * for loads, and the peak of the registry's resident bytes and of the
+ * process's resident set growth, which should stay near the budget. There
+ * is no loader, so a load maps the file and reads its pages in; the files
+ * stay in the page cache between loads, so load times are a lower bound
+ * on a cold start.
+ *
+ * Usage: bench_model_registry [--models N] [--model-mb N] [--requests N] [--fit N]... [--dir PATH]
+ */
+
+#include "ai_models.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "bench_common.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace nymph::bench;
+namespace ai = nymph::ai;
+
+namespace {
+
+uint64_t resident_set_bytes() {
+    std::FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr) {
+        return 0;
+    }
+    unsigned long long size_pages = 0;
+    unsigned long long resident_pages = 0;
+    int fields = std::fscanf(statm, "%llu %llu", &size_pages, &resident_pages);
+    std::fclose(statm);
+    return fields == 2 ? resident_pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+bool write_model(const std::string& path, uint64_t bytes, uint32_t seed) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::vector<uint32_t> block(256 * 1024);
+    std::mt19937 gen(seed);
+    uint64_t written = 0;
+    while (written < bytes) {
+        for (uint32_t& word : block) {
+            word = gen();
+        }
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(bytes - written, block.size() * sizeof(uint32_t)));
+        if (std::fwrite(block.data(), 1, chunk, file) != chunk) {
+            std::fclose(file);
+            return false;
+        }
+        written += chunk;
+    }
+    return std::fclose(file) == 0;
+}
+
+double megabytes(uint64_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+/* One run of the request sequence against a fresh registry */
+void run(const std::vector<std::string>& paths, const std::vector<size_t>& sequence, uint64_t budget_bytes,
+         const char* label) {
+    ai::ModelRegistry registry;
+    registry.set_budget(budget_bytes);
+    for (size_t i = 0; i < paths.size(); i++) {
+        registry.add("model-" + std::to_string(i), paths[i]);
+    }
+
+    nymph::metrics::Histogram hit_ns;
+    nymph::metrics::Histogram load_ns;
+    uint64_t hits = 0;
+    uint64_t peak_resident = 0;
+    uint64_t rss_base = resident_set_bytes();
+    uint64_t peak_rss = rss_base;
+    for (size_t model : sequence) {
+        uint64_t loads_before = registry.get_stats().loads;
+        uint64_t start = now_ns();
+        std::shared_ptr<ai::LoadedModel> lease = registry.acquire("model-" + std::to_string(model));
+        uint64_t elapsed = now_ns() - start;
+        do_not_optimize(lease);
+        lease.reset();
+        ai::ModelRegistryStats stats = registry.get_stats();
+        if (stats.loads == loads_before) {
+            hits++;
+            hit_ns.record(elapsed);
+        } else {
+            load_ns.record(elapsed);
+        }
+        peak_resident = std::max(peak_resident, stats.resident_bytes);
+        peak_rss = std::max(peak_rss, resident_set_bytes());
+    }
+
+    ai::ModelRegistryStats stats = registry.get_stats();
+    nymph::metrics::Histogram::Snapshot hit = hit_ns.snapshot();
+    nymph::metrics::Histogram::Snapshot load = load_ns.snapshot();
+    std::printf("%-16s hit rate %5.1f%%  loads %5llu  unloads %5llu   hit p50 %6.2f us   load p50 %7.2f ms p99 %7.2f ms"
+                "   peak resident %7.1f MB  RSS growth %7.1f MB\n",
+                label, 100.0 * hits / sequence.size(), static_cast<unsigned long long>(stats.loads),
+                static_cast<unsigned long long>(stats.unloads), hit.quantile(0.50) / 1e3,
+                load.quantile(0.50) / 1e6, load.quantile(0.99) / 1e6, megabytes(peak_resident),
+                megabytes(peak_rss - rss_base));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t models = 8;
+    uint64_t model_mb = 64;
+    uint64_t requests = 4000;
+    std::vector<uint64_t> fits;
+    std::string dir = "/tmp";
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--models") == 0 && i + 1 < argc) {
+            models = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--model-mb") == 0 && i + 1 < argc) {
+            model_mb = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--requests") == 0 && i + 1 < argc) {
+            requests = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--fit") == 0 && i + 1 < argc) {
+            fits.push_back(std::strtoull(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        }
+    }
+    if (models == 0) models = 1;
+    if (model_mb == 0) model_mb = 1;
+    if (requests == 0) requests = 1;
+    if (fits.empty()) fits = {3, 1};
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    std::vector<std::string> paths;
+    for (uint64_t i = 0; i < models; i++) {
+        paths.push_back(dir + "/bench_model_" + std::to_string(getpid()) + "_" + std::to_string(i) + ".bin");
+        if (!write_model(paths.back(), model_mb * 1024 * 1024, static_cast<uint32_t>(i))) {
+            std::fprintf(stderr, "Failed to write %s\n", paths.back().c_str());
+            for (const std::string& path : paths) {
+                unlink(path.c_str());
+            }
+            return 1;
+        }
+    }
+
+    // Zipf(1.0) over models via the inverse CDF table
+    std::vector<double> cdf(models);
+    double total = 0.0;
+    for (uint64_t i = 0; i < models; i++) {
+        total += 1.0 / static_cast<double>(i + 1);
+        cdf[i] = total;
+    }
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> uniform(0.0, total);
+    std::vector<size_t> sequence;
+    for (uint64_t i = 0; i < requests; i++) {
+        sequence.push_back(std::lower_bound(cdf.begin(), cdf.end(), uniform(gen)) - cdf.begin());
+    }
+
+    std::printf("%llu models x %llu MB, %llu Zipf requests\n", static_cast<unsigned long long>(models),
+                static_cast<unsigned long long>(model_mb), static_cast<unsigned long long>(requests));
+    run(paths, sequence, 0, "no budget");
+    for (uint64_t fit : fits) {
+        uint64_t budget = fit * model_mb * 1024 * 1024 + model_mb * 512 * 1024;
+        std::string label = "budget " + std::to_string(static_cast<unsigned long long>(megabytes(budget))) + " MB";
+        run(paths, sequence, budget, label.c_str());
+    }
+
+    for (const std::string& path : paths) {
+        unlink(path.c_str());
+    }
+    return 0;
+}
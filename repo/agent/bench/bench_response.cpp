@@ -0,0 +1,147 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Response Serialization Benchmark
+ *
+ * Formats a POST /kv/pin result and frames it as an HTTP response two
+ * ways: the std::stringstream formatter and stringstream build_response
+ * the server used before json::Writer, and the current path, which
+ * formats with json::Writer and appends the head and body to a reused
+ * connection buffer. Also times /infer results with a large output,
+ * where the body is queued as its own segment instead of being copied.
+ *
+ * Usage: bench_response [--iterations N] [--output-kb N]
+ */
+
+#include "ai_onnx.hpp"
+#include "http_server.hpp"
+#include "kvpin.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+using namespace nymph::bench;
+
+namespace {
+
+/* The pre-Writer formatter */
+std::string legacy_format_kvpin(const nymph::kv::KVPinResult& result) {
+    std::stringstream json;
+    json << std::fixed << std::setprecision(4);
+    json << "{";
+    json << "\"hit_rate\":" << result.hit_rate;
+    json << ",\"region\":\"" << result.region_name << "\"";
+    json << ",\"size_kb\":" << result.region_size_kb;
+    json << ",\"stats\":{";
+    bool first = true;
+    for (const auto& pair : result.stats) {
+        if (!first) json << ",";
+        json << "\"" << pair.first << "\":" << pair.second;
+        first = false;
+    }
+    json << "}}";
+    return json.str();
+}
+
+/* The pre-Writer response framing: a second stream copying the body */
+std::string legacy_build_response(const nymph::api::APIResponse& resp, bool keep_alive) {
+    std::stringstream http;
+    http << "HTTP/1.1 " << resp.status_code << " "
+         << nymph::net::status_reason(resp.status_code) << "\r\n";
+    http << "Content-Type: " << resp.content_type << "\r\n";
+    http << "Content-Length: " << resp.body.length() << "\r\n";
+    http << "Access-Control-Allow-Origin: *\r\n";
+    http << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n";
+    http << "\r\n";
+    http << resp.body;
+    return http.str();
+}
+
+nymph::kv::KVPinResult make_kvpin_result() {
+    nymph::kv::KVPinResult result;
+    result.success = true;
+    result.hit_rate = 0.8154;
+    result.region_size_kb = 256;
+    result.region_name = "session-42";
+    result.stats["base_address"] = 1048576.0;
+    result.stats["new_region"] = 1.0;
+    result.stats["total_free_kb"] = 1048320.0;
+    result.stats["total_used_kb"] = 256.0;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = 500000;
+    size_t output_kb = 64;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--output-kb") == 0 && i + 1 < argc) {
+            output_kb = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+
+    nymph::kv::KVPinResult kvpin = make_kvpin_result();
+    size_t sink = 0;
+
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        nymph::api::APIResponse resp(200, "application/json", legacy_format_kvpin(kvpin));
+        std::string wire = legacy_build_response(resp, true);
+        sink += wire.size();
+    }
+    report("kv/pin: stringstream format + framing", iterations, now_ns() - start);
+
+    // The connection buffer keeps its capacity across responses
+    std::string connection_buffer;
+    start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        nymph::api::APIResponse resp(200, "application/json", nymph::kv::format_kvpin_result(kvpin));
+        connection_buffer.clear();
+        nymph::net::append_response_head(connection_buffer, resp, true);
+        connection_buffer += resp.body;
+        sink += connection_buffer.size();
+    }
+    report("kv/pin: json::Writer + head into reused buffer", iterations, now_ns() - start);
+
+    nymph::ai::InferenceResult inference;
+    inference.success = true;
+    inference.latency_ms = 12.345;
+    inference.energy_wh = 0.0062;
+    inference.output.assign(output_kb * 1024, 'x');
+    for (size_t i = 64; i < inference.output.size(); i += 64) {
+        inference.output[i] = '\n';
+    }
+    inference.metrics["first_token_ms"] = 3.7;
+    inference.metrics["tokens_per_s"] = 810.0;
+
+    uint64_t large_iterations = iterations / 100 + 1;
+    double bytes = static_cast<double>(inference.output.size()) * large_iterations;
+
+    start = now_ns();
+    for (uint64_t i = 0; i < large_iterations; i++) {
+        nymph::api::APIResponse resp(200, "application/json", nymph::ai::format_inference_result(inference));
+        std::string wire = legacy_build_response(resp, true);
+        sink += wire.size();
+    }
+    report("infer " + std::to_string(output_kb) + " KB: Writer + stringstream framing",
+           large_iterations, now_ns() - start, bytes);
+
+    start = now_ns();
+    for (uint64_t i = 0; i < large_iterations; i++) {
+        nymph::api::APIResponse resp(200, "application/json", nymph::ai::format_inference_result(inference));
+        connection_buffer.clear();
+        nymph::net::append_response_head(connection_buffer, resp, true);
+        std::string segment = std::move(resp.body);   // What the server queues for sendmsg()
+        sink += connection_buffer.size() + segment.size();
+    }
+    report("infer " + std::to_string(output_kb) + " KB: Writer + head, body as segment",
+           large_iterations, now_ns() - start, bytes);
+
+    do_not_optimize(sink);
+    return 0;
+}
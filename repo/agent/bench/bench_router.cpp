@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Router Dispatch Benchmark
+ *
+ * Compares route lookup in net::Router (trie over the real route table)
+ * with the string-compare if/else chain it replaced. Handlers are not
+ * invoked; only the cost of finding them is measured.
+ *
+ * Usage: bench_router [--iterations N]
+ */
+
+#include "router.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace nymph::bench;
+using nymph::net::Method;
+
+namespace {
+
+struct Probe {
+    std::string method;
+    std::string path;
+};
+
+/* The pre-router dispatch: compare path and method branch by branch */
+int legacy_route(const std::string& method, const std::string& path) {
+    if (path == "/status" && method == "GET") {
+        return 0;
+    } else if (path == "/fabric/verify" && method == "GET") {
+        return 1;
+    } else if (path == "/infer" && method == "POST") {
+        return 2;
+    } else if (path == "/kv/pin" && method == "POST") {
+        return 3;
+    } else if (path == "/squantum/run" && method == "POST") {
+        return 4;
+    } else if (path == "/thermal/schedule" && method == "POST") {
+        return 5;
+    } else if (path == "/capsule/run" && method == "POST") {
+        return 6;
+    } else if (path == "/vault/update" && method == "POST") {
+        return 7;
+    } else if (path == "/ota/rollback" && method == "POST") {
+        return 8;
+    }
+    return -1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = 2000000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+
+    nymph::net::Router router;
+    nymph::api::register_routes(router);
+
+    std::vector<Probe> probes = {
+        {"GET", "/status"},
+        {"POST", "/kv/pin"},
+        {"POST", "/infer"},
+        {"POST", "/ota/rollback"},
+        {"GET", "/kv/region/chat_ctx"},
+        {"GET", "/no/such/path"},
+    };
+
+    std::vector<std::pair<std::string_view, std::string_view>> params;
+    for (const auto& probe : probes) {
+        Method method = nymph::net::method_from_string(probe.method);
+        bool path_matched = false;
+
+        uint64_t start = now_ns();
+        for (uint64_t i = 0; i < iterations; i++) {
+            const nymph::net::Route* route = router.find(method, probe.path, params, path_matched);
+            do_not_optimize(route);
+        }
+        report("router " + probe.method + " " + probe.path, iterations, now_ns() - start);
+
+        start = now_ns();
+        for (uint64_t i = 0; i < iterations; i++) {
+            do_not_optimize(legacy_route(probe.method, probe.path));
+        }
+        report("if/else " + probe.method + " " + probe.path, iterations, now_ns() - start);
+    }
+
+    // 404 path: the old chain also built a std::stringstream error body
+    nymph::api::APIRequest req;
+    req.method = "GET";
+    req.path = "/no/such/path";
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < iterations / 10; i++) {
+        nymph::api::APIResponse resp = router.dispatch(req);
+        do_not_optimize(resp.status_code);
+    }
+    report("router dispatch 404", iterations / 10, now_ns() - start);
+
+    return 0;
+}
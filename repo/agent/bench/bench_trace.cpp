@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Trace Span Overhead Benchmark
+ *
+ * Cost of one NYMPH_TRACE_SCOPE with tracing switched off and on, and of
+ * exporting a full ring as Chrome JSON.
+ *
+ * Usage: bench_trace [--iterations N]
+ */
+
+#include "trace.hpp"
+#include "bench_common.hpp"
+#include <cstdlib>
+#include <cstring>
+
+using namespace nymph::bench;
+
+namespace {
+
+__attribute__((noinline)) int traced_work(int value) {
+    NYMPH_TRACE_SCOPE("bench.span");
+    do_not_optimize(value);
+    return value + 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = 10000000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::strtoull(argv[++i], nullptr, 10);
+        }
+    }
+
+    int value = 0;
+    nymph::trace::set_enabled(false);
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        value = traced_work(value);
+    }
+    report("span, tracing disabled", iterations, now_ns() - start);
+
+    nymph::trace::set_enabled(true);
+    start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        value = traced_work(value);
+    }
+    report("span, tracing enabled", iterations, now_ns() - start);
+    nymph::trace::set_enabled(false);
+
+    start = now_ns();
+    std::string json = nymph::trace::export_chrome_json(0);
+    report("export full ring (" + std::to_string(json.size() / 1024) + " KB JSON)", 1,
+           now_ns() - start);
+    do_not_optimize(value);
+    return 0;
+}
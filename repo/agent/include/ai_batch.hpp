@@ -0,0 +1,208 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Inference Batching Scheduler
+ *
+ * Sits between the /infer handler and ONNXRuntime. Requests queue per
+ * model_name; one dispatcher thread per model takes up to max_batch of
+ * them and runs them as one batch, fanning the results back to the
+ * callers blocked in run(). A batch goes out as soon as it is full, or
+ * when its oldest request has waited max_delay_us. While the device is
+ * busy with one batch, the next fills up behind it, so under load batches
+ * grow without anyone waiting out the delay.
+ *
+ * In ITERATION mode a model's dispatcher instead runs a continuous
+ * decode loop (ONNXRuntime::run_decode_step). Waiting sequences join the
+ * running batch between steps, up to max_batch, without waiting for each
+ * other; a sequence that finishes returns to its caller and frees its
+ * place at once. Each running sequence holds its KV in a pinned region
+ * of the KV cache, reserved at join for prompt plus max_tokens and
+ * evicted when it ends. A sequence the cache has no room for waits until
+ * a running one ends; if none is running it fails.
+ *
+ * A caller of run() blocks its thread until its batch has run, so those
+ * batches only form when requests arrive concurrently. stream() does not
+ * block: the dispatcher hands each token to a TokenSink as its step ends
+ * (ITERATION), or the whole output when the batch ends (REQUEST), so one
+ * worker loop can keep many requests running. Inference always runs on a
+ * dispatcher, also with max_batch 1 (batches of one), never on the caller's
+ * thread.
+ *
+ * Model names come from clients, so a queue (and its thread) is only
+ * created for a model the runtime serves (ONNXRuntime::has_model); other
+ * requests fail without being queued. A dispatcher that has had nothing
+ * to do for kQueueIdleTimeout retires, and its queue is reclaimed the next
+ * time a queue is created.
+ *
+ * A model's counters outlive its queue: they sit in a list that only
+ * grows, so a recreated queue carries on counting and get_stats() reads
+ * them without taking queues_mutex_.
+ */
+
+#ifndef NYMPH_AI_BATCH_HPP
+#define NYMPH_AI_BATCH_HPP
+
+#include "ai_onnx.hpp"
+#include "metrics.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nymph {
+namespace kv {
+class KVCacheManager;
+}
+
+namespace ai {
+
+enum class BatchMode {
+    REQUEST,                        // Whole requests per run
+    ITERATION                       // Sequences join and leave between decode steps
+};
+
+/* Parse "request" or "iteration"; false (mode untouched) otherwise */
+bool batch_mode_from_string(const std::string& name, BatchMode& mode);
+const char* batch_mode_to_string(BatchMode mode);
+
+struct BatchConfig {
+    BatchMode mode = BatchMode::REQUEST;
+    size_t max_batch = 8;           // Requests per run or sequences per step; 1 turns batching off
+    uint32_t max_delay_us = 2000;   // REQUEST: longest the oldest request waits for a full batch
+    uint64_t kv_kb_per_token = 16;  // ITERATION: KV a sequence reserves per token
+};
+
+/* Receives a streamed request's output on the dispatcher thread; must not block */
+class TokenSink {
+public:
+    virtual ~TokenSink() = default;
+
+    /* Text added by token index, since_enqueue_ms after the request queued;
+     * false cancels the request */
+    virtual bool on_token(const std::string& text, uint32_t index, double since_enqueue_ms) = 0;
+
+    /* Called last, once */
+    virtual void on_done(const InferenceResult& result) = 0;
+};
+
+/* One model queue's counters */
+struct BatchQueueStats {
+    std::string model;
+    uint64_t batches;                           // ITERATION: decode steps
+    uint64_t requests;
+    uint64_t tokens;                            // ITERATION: tokens generated
+    uint64_t depth;                             // Requests waiting now
+    uint64_t running;                           // ITERATION: sequences in the batch now
+    metrics::Histogram::Snapshot queue_delay_ns;
+    metrics::Histogram::Snapshot batch_size;
+    metrics::Histogram::Snapshot first_token_ns;    // Queued to first token out
+};
+
+class InferenceScheduler {
+public:
+    /* Requests for models beyond this many fail */
+    static const size_t kMaxQueues = 64;
+
+    /* A dispatcher idle this long retires */
+    static constexpr std::chrono::seconds kQueueIdleTimeout{30};
+
+    InferenceScheduler(ONNXRuntime& runtime, kv::KVCacheManager& kv_cache);
+    ~InferenceScheduler();
+
+    InferenceScheduler(const InferenceScheduler&) = delete;
+    InferenceScheduler& operator=(const InferenceScheduler&) = delete;
+
+    /* Set before the first run() */
+    void configure(const BatchConfig& config);
+    const BatchConfig& config() const { return config_; }
+
+    /* Queue request and block until its batch has run */
+    InferenceResult run(const InferenceRequest& request);
+
+    /* Queue request and return; its output goes to sink. If it cannot be
+     * queued (unknown model, kMaxQueues, shut down), sink->on_done() gets
+     * the failure before this returns */
+    void stream(InferenceRequest request, std::shared_ptr<TokenSink> sink);
+
+    /* Per-model counters, in model order; takes no lock */
+    std::vector<BatchQueueStats> get_stats() const;
+
+    /* Run what is queued and stop the dispatchers */
+    void shutdown();
+
+private:
+    struct Pending;
+    struct Sequence;
+
+    /* A model's counters; never freed before the scheduler, so they
+     * survive queue retirement and are read without a lock */
+    struct QueueCounters {
+        std::string model;
+        metrics::Counter batches;
+        metrics::Counter requests;
+        metrics::Counter tokens;
+        metrics::Histogram queue_delay_ns;
+        metrics::Histogram batch_size;
+        metrics::Histogram first_token_ns;
+        std::atomic<uint64_t> depth{0};
+        std::atomic<uint64_t> running{0};
+        QueueCounters* next = nullptr;  // Set before the entry is published
+    };
+
+    struct ModelQueue {
+        std::string model;
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<Pending*> pending;
+        bool stopping = false;
+        bool retired = false;           // Dispatcher left after kQueueIdleTimeout idle
+        std::thread dispatcher;
+        QueueCounters* counters = nullptr;
+    };
+
+    /* Queue pending on its model's queue, created with its dispatcher on
+     * first use; false for a model the runtime does not serve, past
+     * kMaxQueues, or once shut down */
+    bool submit(Pending* pending);
+    /* Queue pending, or false if queue is stopping or retired */
+    bool enqueue(ModelQueue& queue, Pending* pending);
+    /* Join and drop retired queues; caller holds queues_mutex_ exclusively */
+    void reap_retired();
+    /* model's counters, added to the list on first use; caller holds queues_mutex_ exclusively */
+    QueueCounters& counters_for(const std::string& model);
+    /* Wait for work on an idle queue; false (queue retired) after kQueueIdleTimeout */
+    bool wait_for_work(ModelQueue& queue, std::unique_lock<std::mutex>& lock);
+    /* Hand pending its result: to the promise, or to the sink (and free it) */
+    static void deliver(Pending* pending, InferenceResult result);
+    void dispatch_loop(ModelQueue& queue);
+    void decode_loop(ModelQueue& queue);
+
+    /* ITERATION: KV region of a joining sequence, and its release */
+    bool reserve_kv(Sequence& sequence);
+    void release_kv(const Sequence& sequence);
+
+    ONNXRuntime& runtime_;
+    kv::KVCacheManager& kv_cache_;
+    BatchConfig config_;
+    std::atomic<uint64_t> next_sequence_;
+
+    mutable std::shared_mutex queues_mutex_;
+    std::map<std::string, std::unique_ptr<ModelQueue>> queues_;
+    bool stopped_;
+    std::atomic<QueueCounters*> counters_;      // Newest first; only grows
+};
+
+/* Global scheduler over get_onnx_runtime() and the global KV cache */
+InferenceScheduler& get_inference_scheduler();
+
+} // namespace ai
+} // namespace nymph
+
+#endif // NYMPH_AI_BATCH_HPP
@@ -0,0 +1,216 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Model Registry
+ *
+ * Models named at startup are only registered: the registry checks the
+ * file and records its size. The first request for a model maps the file
+ * read-only and hands the bytes to the runtime's loader (ONNX Runtime
+ * builds create the session from them; without a loader the pages are
+ * just read in). The mapping lives as long as the loaded model, since a
+ * session may use its initializers in place.
+ *
+ * A loaded model is charged its resident bytes: how much the process's
+ * resident set grew while it loaded, and at least its file size (just
+ * the file size without a loader). Allocations other threads make during
+ * a load are charged to it too, so the figure is an upper bound. Before
+ * a load would take the total past the memory budget, the least recently
+ * used models are unloaded; after the load, again if the model came out
+ * larger than its file. A model that alone exceeds the budget still
+ * loads. Runs hold their model through a shared_ptr, so an unloaded
+ * model's memory returns when its last run ends, while the budget counts
+ * it as freed at once.
+ *
+ * Loads run one at a time, so each one's resident growth is its own.
+ * Requests for loaded models do not wait for a load in progress.
+ *
+ * Every load, unload and budget change also publishes the affected
+ * figures as atomics (get_gauges()), so a metrics scrape never waits on
+ * the registry lock.
+ */
+
+#ifndef NYMPH_AI_MODELS_HPP
+#define NYMPH_AI_MODELS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace nymph {
+namespace ai {
+
+/* Runtime state built from a model's bytes, e.g. an ONNX Runtime session */
+class ModelSession {
+public:
+    virtual ~ModelSession() = default;
+};
+
+/* A loaded model, kept by the registry and by the runs using it */
+struct LoadedModel {
+    const unsigned char* data = nullptr;        // The mapped file
+    size_t size = 0;
+    std::unique_ptr<ModelSession> session;      // Null without a loader
+
+    LoadedModel() = default;
+    ~LoadedModel();                             // Session first, then the mapping
+
+    LoadedModel(const LoadedModel&) = delete;
+    LoadedModel& operator=(const LoadedModel&) = delete;
+};
+
+enum class ModelState {
+    UNLOADED,                   // Registered; loads on first use
+    LOADED,
+    FAILED                      // Last load failed; the next use retries
+};
+
+const char* model_state_to_string(ModelState state);
+
+struct ModelInfo {
+    std::string name;
+    std::string path;
+    ModelState state;
+    uint64_t file_bytes;
+    uint64_t resident_bytes;    // Charged against the budget; 0 unless loaded
+    uint64_t loads;
+    uint64_t unloads;
+    uint64_t uses;              // Runs and decode steps that used it
+    double idle_s;              // Since the last use; 0 if never used
+};
+
+struct ModelRegistryStats {
+    uint64_t budget_bytes;      // 0 = unlimited
+    uint64_t resident_bytes;
+    uint64_t models;
+    uint64_t loaded;
+    uint64_t loads;
+    uint64_t unloads;
+    uint64_t load_failures;
+};
+
+/* One model's figures as of its last load or unload */
+struct ModelGauge {
+    std::string name;
+    uint64_t resident_bytes;
+    bool loaded;
+    uint64_t loads;
+    uint64_t unloads;
+};
+
+/* Registry figures readable without any lock (for /metrics) */
+struct ModelRegistryGauges {
+    uint64_t budget_bytes;
+    uint64_t resident_bytes;
+    uint64_t load_failures;
+    std::vector<ModelGauge> models;     // In name order
+};
+
+class ModelRegistry {
+public:
+    /* Session state from a model's mapped bytes; null, with error set, on failure */
+    using Loader = std::function<std::unique_ptr<ModelSession>(const std::string& name, const unsigned char* data,
+                                                               size_t size, std::string& error)>;
+
+    ModelRegistry();
+    ~ModelRegistry();
+
+    ModelRegistry(const ModelRegistry&) = delete;
+    ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+    /* Set before the first acquire() */
+    void set_loader(Loader loader);
+
+    /* Unloads down to the new budget at once; 0 = unlimited */
+    void set_budget(uint64_t budget_bytes);
+
+    /* Register name as the model file at path; false if the file cannot be used */
+    bool add(const std::string& name, const std::string& path);
+    bool contains(const std::string& name) const;
+
+    /*
+     * The loaded model, loading it first (and unloading others) if needed.
+     * Null if name is not registered or its load failed; registered, if
+     * given, tells the two apart.
+     */
+    std::shared_ptr<LoadedModel> acquire(const std::string& name, bool* registered = nullptr);
+
+    /* Unload name now; false if it was not loaded */
+    bool unload(const std::string& name);
+
+    /* In name order */
+    std::vector<ModelInfo> list() const;
+    bool info(const std::string& name, ModelInfo& out) const;
+    ModelRegistryStats get_stats() const;
+    ModelRegistryGauges get_gauges() const;
+
+private:
+    /* A model's published figures; one per name, freed with the registry */
+    struct Published {
+        std::string name;
+        std::atomic<uint64_t> resident_bytes{0};
+        std::atomic<bool> loaded{false};
+        std::atomic<uint64_t> loads{0};
+        std::atomic<uint64_t> unloads{0};
+        Published* next = nullptr;      // Set before the entry is published
+    };
+
+    struct Entry {
+        std::string name;
+        std::string path;
+        uint64_t file_bytes = 0;
+        ModelState state = ModelState::UNLOADED;
+        std::shared_ptr<LoadedModel> model;
+        uint64_t resident_bytes = 0;
+        bool loading = false;
+        std::list<Entry*>::iterator lru;        // Valid while loaded
+        std::chrono::steady_clock::time_point last_used;
+        uint64_t loads = 0;
+        uint64_t unloads = 0;
+        uint64_t uses = 0;
+        Published* published = nullptr;
+    };
+
+    /* Unload the least recently used models, other than keep, until incoming more bytes fit */
+    void make_room(uint64_t incoming, const Entry* keep);
+    void unload_entry(Entry& entry);
+    void touch(Entry& entry);
+    ModelInfo describe(const Entry& entry, std::chrono::steady_clock::time_point now) const;
+    /* Store entry's figures and the totals for get_gauges(); caller holds mutex_ */
+    void publish(const Entry& entry);
+    void publish_totals();
+
+    /* Map path and run the loader; caller holds load_mutex_, not mutex_ */
+    std::shared_ptr<LoadedModel> load(const std::string& name, const std::string& path, std::string& error);
+
+    Loader loader_;
+    uint64_t budget_bytes_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable load_done_;
+    std::map<std::string, Entry> entries_;
+    std::list<Entry*> lru_;                     // Loaded models, most recently used first
+    uint64_t resident_bytes_;
+    uint64_t loads_;
+    uint64_t unloads_;
+    uint64_t load_failures_;
+
+    std::atomic<Published*> published_;         // Newest first; only grows
+    std::atomic<uint64_t> published_budget_;
+    std::atomic<uint64_t> published_resident_;
+    std::atomic<uint64_t> published_failures_;
+
+    std::mutex load_mutex_;                     // One load at a time
+};
+
+} // namespace ai
+} // namespace nymph
+
+#endif // NYMPH_AI_MODELS_HPP
@@ -3,15 +3,54 @@
  * NYMPH 1.1 ONNX Runtime Interface
  * 
  * Provides AI inference using ONNX Runtime (or stub implementation)
+ *
+ * The stub models one accelerator: runs execute one at a time, and a
+ * batch costs its slowest request plus a small share per extra request,
+ * as a batched kernel launch would (see ai_batch.hpp for the scheduler
+ * that forms batches).
+ *
+ * Generation can also be driven one decode iteration at a time
+ * (run_decode_step), so sequences can join and leave a running batch
+ * between tokens. The stub prefills a sequence in the step it joins,
+ * then emits one token per step for every sequence; a step costs one
+ * token of the slowest profile plus the same per-sequence share, and the
+ * joining prompts' prefill. Each sequence ends at a length derived from
+ * its prompt, like greedy decoding reaching EOS, or at max_tokens.
+ *
+ * Models given to load_model() are registered in a ModelRegistry (see
+ * ai_models.hpp), which maps and loads each one on first use and unloads
+ * the least recently used ones past the memory budget. Next to them the
+ * stub serves a fixed catalogue (llm-7b-int4, the default model of a
+ * request, llm-13b-int4 and vision-resnet50), as well as registered
+ * models in builds without ONNX Runtime (their files are still mapped and
+ * accounted for). Other names are unknown (has_model).
+ *
+ * Built with NYMPH_WITH_ONNXRUNTIME (CMake option of the same name), a
+ * registered model runs on ONNX Runtime. Each load creates one
+ * Ort::Session from the mapped bytes, reused by every request until the
+ * model is unloaded, with its input and output buffers preallocated and
+ * bound through an IoBinding. The model contract is a byte-level language
+ * model: one int64 input of token ids [batch, sequence] and one float
+ * output of next-token scores [batch, vocabulary]. Token ids are the
+ * prompt's bytes, and id 0 is EOS. Decoding is greedy and re-runs the
+ * whole sequence for every token (no past_key_values yet). A run_batch
+ * batch decodes in lockstep. Each step, there or in run_decode_step,
+ * stacks its sequences into one [rows, length] run per input length. The
+ * contract has no attention mask, so sequences of other lengths cannot
+ * share a run without the model seeing their padding.
  */
 
 #ifndef NYMPH_AI_ONNX_HPP
 #define NYMPH_AI_ONNX_HPP
 
+#include "ai_models.hpp"
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <memory>
+#include <mutex>
 
 namespace nymph {
 namespace ai {
@@ -22,8 +61,14 @@ struct InferenceRequest {
     std::string input_text;       // Input text/data
     std::string profile;          // e.g., "edge-llm-turbo"
     std::map<std::string, std::string> options;  // Additional options
+    uint32_t max_tokens = 0;      // Tokens to generate at most, 0 = kDefaultMaxTokens
+    bool stream = false;          // Send tokens as they are generated
 };
 
+/* Generation length when a request does not set max_tokens, and the most it may ask for */
+const uint32_t kDefaultMaxTokens = 64;
+const uint32_t kMaxTokensLimit = 4096;
+
 /* Inference result structure */
 struct InferenceResult {
     bool success;
@@ -34,6 +79,33 @@ struct InferenceResult {
     std::map<std::string, double> metrics;  // Additional metrics (tokens/s, etc.)
 };
 
+/* One sequence of an iteration-level batch */
+struct GenerationSequence {
+    const InferenceRequest* request = nullptr;
+    uint32_t prompt_tokens = 0;
+    uint32_t max_tokens = 0;
+    uint32_t generated = 0;     // Tokens emitted so far
+    std::string text;           // Detokenized output so far; each step appends
+    std::vector<int64_t> token_ids;     // ONNX Runtime: prompt and generated ids
+    bool prefilled = false;     // Prompt has been run
+    bool finished = false;      // EOS or max_tokens reached
+    double energy_wh = 0.0;     // Share of the steps it took part in
+    uint64_t backend_state = 0; // Owned by the runtime (stub: EOS position; ONNX Runtime: prompt ids)
+};
+
+/* Prompt length in tokens (stub: about four characters per token) */
+uint32_t count_prompt_tokens(const InferenceRequest& request);
+
+/* ONNX Runtime session settings; applies to sessions created after configure() */
+struct RuntimeConfig {
+    int intra_op_threads = 0;           // Threads within one operator, 0 = one per core
+    int inter_op_threads = 0;           // Operators run in parallel when > 1, else in sequence
+    size_t max_input_tokens = 2048;     // Input buffer per model; longer inputs keep their tail
+};
+
+/* ONNX Runtime environment and sessions; defined only in builds with it */
+struct OrtBackend;
+
 /* ONNX Runtime Interface */
 class ONNXRuntime {
 public:
@@ -43,18 +115,42 @@ public:
     /* Initialize the runtime */
     bool initialize(const std::string& model_path = "");
 
-    /* Load a model */
+    /* Set before the first request */
+    void configure(const RuntimeConfig& config);
+
+    /* Register a model; it loads on first use. Register before serving */
     bool load_model(const std::string& model_name, const std::string& model_path);
 
+    /* Registered models, their load state and the memory budget */
+    ModelRegistry& models() { return models_; }
+    const ModelRegistry& models() const { return models_; }
+
     /* Run inference */
     InferenceResult run_inference(const InferenceRequest& request);
 
+    /* Run requests as one batch; one result per request, in order */
+    std::vector<InferenceResult> run_batch(const std::vector<const InferenceRequest*>& requests);
+
+    /*
+     * One decode iteration over batch: prefill the sequences not yet
+     * prefilled, then emit one token for each unfinished sequence. Sets
+     * finished on the ones that end. Returns the step time in ms, or a
+     * negative value if the runtime is not initialized.
+     */
+    double run_decode_step(const std::vector<GenerationSequence*>& batch);
+
+    /* Output of a finished sequence */
+    InferenceResult finish_sequence(const GenerationSequence& sequence);
+
     /* Check if runtime is initialized */
     bool is_initialized() const { return initialized_; }
 
-    /* Get available models */
+    /* Registered models, then the stub catalogue */
     std::vector<std::string> list_models() const;
 
+    /* Whether model_name is one of list_models(): registered or in the stub catalogue */
+    bool has_model(const std::string& model_name) const;
+
     /* Get model info */
     std::map<std::string, std::string> get_model_info(const std::string& model_name) const;
 
@@ -64,17 +160,28 @@ public:
 private:
     bool initialized_;
     std::string execution_provider_;
-    std::map<std::string, std::string> loaded_models_;  // model_name -> model_path
+    std::mutex device_mutex_;   // Held for the length of a run
+    RuntimeConfig config_;
+    std::unique_ptr<OrtBackend> backend_;   // Null without ONNX Runtime
+    ModelRegistry models_;                  // After backend_: sessions go before the environment
     
     /* Stub mode: simulate inference */
     InferenceResult run_inference_stub(const InferenceRequest& request);
+    std::vector<InferenceResult> run_batch_stub(const std::vector<const InferenceRequest*>& requests);
+    double run_decode_step_stub(const std::vector<GenerationSequence*>& batch);
     
-    /* Real mode: call ONNX Runtime (when implemented) */
-    InferenceResult run_inference_real(const InferenceRequest& request);
+    /* Real mode: greedy generation on the loaded model's ONNX Runtime session */
+    InferenceResult run_inference_real(const InferenceRequest& request, LoadedModel& model);
+    std::vector<InferenceResult> run_batch_real(const std::vector<const InferenceRequest*>& requests,
+                                                LoadedModel& model);
+    double run_decode_step_real(const std::vector<GenerationSequence*>& batch, LoadedModel& model);
 };
 
+/* Global runtime, initialized on first use */
+ONNXRuntime& get_onnx_runtime();
+
 /* Helper function to parse inference request from JSON */
-InferenceRequest parse_inference_request(const std::string& json_body);
+InferenceRequest parse_inference_request(std::string_view json_body);
 
 /* Helper function to format inference result as JSON */
 std::string format_inference_result(const InferenceResult& result);
@@ -40,6 +40,15 @@ struct FabricStatus {
     uint32_t active_descriptors;
 };
 
+/* Process-wide fabric counters, readable without touching the device */
+struct FabricCounters {
+    uint64_t submitted_descriptors;  // DMA descriptors accepted
+    uint64_t submitted_bytes;        // Sum of accepted descriptor lengths
+    uint64_t failed_submissions;     // Descriptors the driver rejected
+    uint64_t device_dma_bytes;       // dma_bytes from the last status read
+    bool device_present;             // Last status came from the driver, not the stub
+};
+
 /* ZLTA-2 Fabric Interface */
 class ZLTA2Fabric {
 public:
@@ -70,6 +79,9 @@ private:
 /* Helper function to get fabric verification status (for /fabric/verify endpoint) */
 FabricStatus get_fabric_verify_status();
 
+/* Get fabric counters (for /metrics) */
+FabricCounters get_fabric_counters();
+
 } // namespace fabric
 } // namespace nymph
 
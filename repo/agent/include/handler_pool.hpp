@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Handler Pool
+ *
+ * Fixed set of threads that run request handlers which may block (file
+ * I/O, attestation, firmware writes), so they never hold up a worker
+ * event loop. The queue is bounded: when it is full submit() refuses the
+ * job and the caller answers 503 instead of queueing without limit.
+ */
+
+#ifndef NYMPH_HANDLER_POOL_HPP
+#define NYMPH_HANDLER_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nymph {
+namespace net {
+
+class HandlerPool {
+public:
+    /* threads == 0 means one per core */
+    explicit HandlerPool(unsigned threads, size_t max_queued = 1024);
+    ~HandlerPool();
+
+    HandlerPool(const HandlerPool&) = delete;
+    HandlerPool& operator=(const HandlerPool&) = delete;
+
+    /* Queue job for a pool thread; false when the queue is full or stopped */
+    bool submit(std::function<void()> job);
+
+    /* Run what is queued, then join the threads; later submits fail */
+    void stop();
+
+    unsigned threads() const { return static_cast<unsigned>(threads_.size()); }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> jobs_;
+    size_t max_queued_;
+    bool stopping_;
+    std::vector<std::thread> threads_;
+
+    void run();
+};
+
+} // namespace net
+} // namespace nymph
+
+#endif // NYMPH_HANDLER_POOL_HPP
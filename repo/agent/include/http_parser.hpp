@@ -0,0 +1,123 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Incremental HTTP/1.1 Request Parser
+ *
+ * Resumable state machine over a per-connection receive buffer. The parser
+ * never copies request data: method, target, headers and body are handed
+ * out as std::string_view slices into the connection buffer. Chunked
+ * bodies are de-chunked in place so the body is still one contiguous view.
+ */
+
+#ifndef NYMPH_HTTP_PARSER_HPP
+#define NYMPH_HTTP_PARSER_HPP
+
+#include "nymph_api.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace nymph {
+namespace net {
+
+/* Parser states */
+enum class ParseState {
+    REQUEST_LINE,   // Waiting for "METHOD target HTTP/1.x"
+    HEADERS,        // Reading header fields
+    BODY,           // Reading a Content-Length body
+    CHUNK_SIZE,     // Reading a chunk-size line
+    CHUNK_DATA,     // Reading chunk payload
+    CHUNK_END,      // Reading the CRLF after chunk payload
+    TRAILERS,       // Reading trailer fields after the last chunk
+    COMPLETE,       // Request fully parsed
+    ERROR           // Malformed or oversized request
+};
+
+/* Result of a parse() call */
+enum class ParseResult {
+    INCOMPLETE,     // Need more bytes
+    COMPLETE,       // One request is ready
+    ERROR           // Request rejected, see error_status()
+};
+
+/* Incremental request parser (one per connection) */
+class HttpParser {
+public:
+    explicit HttpParser(size_t max_body_bytes = 8 * 1024 * 1024,
+                        size_t max_header_bytes = 64 * 1024);
+
+    /*
+     * Parse the request that starts at buffer[start]. Call again with the
+     * same start offset (or the shifted one, if the consumed prefix was
+     * erased) after appending more bytes; parsing resumes where it stopped.
+     * Header names are lower-cased and chunked bodies compacted in place.
+     */
+    ParseResult parse(std::string& buffer, size_t start);
+
+    /*
+     * Point req at the parsed request. The views stay valid until the
+     * buffer is modified or the parser is reset.
+     */
+    void fill_request(const std::string& buffer, api::APIRequest& req) const;
+
+    /* Bytes of the buffer taken by the completed request, framing included */
+    size_t consumed() const { return pos_; }
+
+    /* Prepare for the next request on the connection */
+    void reset();
+
+    /* Current state */
+    ParseState state() const { return state_; }
+
+    /* Headers have been parsed (body may still be pending) */
+    bool headers_complete() const;
+
+    /* Client sent "Expect: 100-continue" */
+    bool expects_continue() const { return expect_continue_; }
+
+    /* HTTP status to answer with when parse() returned ERROR */
+    int error_status() const { return error_status_; }
+
+private:
+    /* Slice of the request, relative to its start offset */
+    struct Span {
+        size_t offset;
+        size_t length;
+    };
+
+    size_t max_body_bytes_;
+    size_t max_header_bytes_;
+
+    ParseState state_;
+    size_t start_;              // Request offset in the connection buffer
+    size_t pos_;                // Next unparsed byte (relative to start_)
+    size_t scan_;               // Bytes already searched for a line end
+    size_t content_length_;
+    size_t chunk_remaining_;
+    size_t body_start_;
+    size_t body_length_;
+    size_t trailers_start_;     // Past the chunk framing, which stays behind the body
+    bool chunked_;
+    bool has_content_length_;
+    bool has_transfer_encoding_;
+    bool expect_continue_;
+    int error_status_;
+
+    Span method_;
+    Span target_;
+    Span version_;
+    std::vector<std::pair<Span, Span>> headers_;
+
+    /* Internal helpers */
+    bool next_line(const char* base, size_t avail, Span& line);
+    bool parse_request_line(const char* base, const Span& line);
+    bool parse_header_line(char* base, const Span& line);
+    bool parse_chunk_size(const char* base, const Span& line);
+    ParseResult fail(int status);
+};
+
+} // namespace net
+} // namespace nymph
+
+#endif // NYMPH_HTTP_PARSER_HPP
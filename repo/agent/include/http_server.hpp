@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 HTTP Server
+ *
+ * Edge-triggered epoll reactor with a fixed pool of worker loops.
+ * Each worker owns its own SO_REUSEPORT listener, so the kernel shards
+ * incoming connections across cores without a shared accept queue.
+ */
+
+#ifndef NYMPH_HTTP_SERVER_HPP
+#define NYMPH_HTTP_SERVER_HPP
+
+#include "nymph_api.hpp"
+#include "http_parser.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+namespace nymph {
+namespace net {
+
+/* Server configuration */
+struct ServerConfig {
+    std::string host;           // Bind address
+    uint16_t port;              // Listen port
+    unsigned workers;           // Worker loops (0 = one per core)
+    int backlog;                // listen() backlog per worker socket
+    size_t max_request_bytes;   // Largest accepted request (headers + body)
+    uint32_t idle_timeout_ms;   // Close keep-alive connections idle this long
+    uint32_t max_requests_per_connection;  // Close after this many requests
+
+    ServerConfig()
+        : host("0.0.0.0"), port(8443), workers(0), backlog(1024)
+        , max_request_bytes(8 * 1024 * 1024), idle_timeout_ms(5000)
+        , max_requests_per_connection(1000) {}
+};
+
+/* Connection and request counters (shared by all workers) */
+struct ServerStats {
+    uint64_t accepted_connections;  // Total connections accepted
+    uint64_t active_connections;    // Currently open connections
+    unsigned workers;               // Running worker loops
+    uint64_t requests;              // Requests parsed and dispatched
+    uint64_t parse_errors;          // Malformed or oversized requests rejected
+    uint64_t responses[6];          // Responses by status class (see metrics::status_class)
+};
+
+/* Request handler invoked by the worker loops (may fill req.params) */
+using RequestHandler = std::function<api::APIResponse(api::APIRequest&)>;
+
+/* Epoll-based HTTP server */
+class HttpServer {
+public:
+    HttpServer(const ServerConfig& config, RequestHandler handler);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    /* Bind listeners and start worker loops */
+    bool start();
+
+    /* Stop worker loops and close all sockets */
+    void stop();
+
+    /* Get connection counters */
+    ServerStats get_stats() const;
+
+    /* Check if running */
+    bool is_running() const { return running_; }
+
+private:
+    struct Worker;
+
+    ServerConfig config_;
+    RequestHandler handler_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> running_;
+
+    /* Internal helpers */
+    int create_listener() const;
+    void run_worker(Worker& worker);
+};
+
+/* Counters of the running server (for /status and /metrics) */
+ServerStats get_server_stats();
+
+/* HTTP helpers */
+const char* status_reason(int status_code);
+
+/* Append status line and headers (through the blank line) for api_resp */
+void append_response_head(std::string& out, const api::APIResponse& api_resp, bool keep_alive);
+
+/* Head and body in one string; the server itself queues them separately */
+std::string build_response(const api::APIResponse& api_resp, bool keep_alive = false);
+
+} // namespace net
+} // namespace nymph
+
+#endif // NYMPH_HTTP_SERVER_HPP
@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Intrusive Doubly-Linked List
+ *
+ * Elements derive from ListHook and carry their own links, so linking,
+ * unlinking and moving an element are O(1) and never allocate. An
+ * element can be in at most one list per hook tag at a time. The list
+ * does not own its elements; unlink them before they are destroyed.
+ */
+
+#ifndef NYMPH_INTRUSIVE_LIST_HPP
+#define NYMPH_INTRUSIVE_LIST_HPP
+
+#include <cstddef>
+
+namespace nymph {
+
+/* Links embedded in an element; Tag distinguishes several hooks on one type */
+template <typename Tag = void>
+struct ListHook {
+    ListHook* prev = nullptr;
+    ListHook* next = nullptr;
+
+    bool linked() const { return next != nullptr; }
+};
+
+/* Circular list with a sentinel; T must derive from ListHook<Tag> */
+template <typename T, typename Tag = void>
+class IntrusiveList {
+public:
+    using Hook = ListHook<Tag>;
+
+    IntrusiveList() : size_(0) {
+        head_.prev = &head_;
+        head_.next = &head_;
+    }
+
+    ~IntrusiveList() { clear(); }
+
+    IntrusiveList(const IntrusiveList&) = delete;
+    IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    /* First / last element, or nullptr when empty */
+    T* front() const { return empty() ? nullptr : owner(head_.next); }
+    T* back() const { return empty() ? nullptr : owner(head_.prev); }
+
+    /* Element after item, or nullptr at the end */
+    T* next(const T& item) const {
+        const Hook* hook = static_cast<const Hook*>(&item);
+        return hook->next == &head_ ? nullptr : owner(hook->next);
+    }
+
+    void push_back(T& item) { insert_before(&head_, item); }
+    void push_front(T& item) { insert_before(head_.next, item); }
+
+    /* Unlink item; it must be in this list */
+    void remove(T& item) {
+        Hook* hook = static_cast<Hook*>(&item);
+        hook->prev->next = hook->next;
+        hook->next->prev = hook->prev;
+        hook->prev = nullptr;
+        hook->next = nullptr;
+        size_--;
+    }
+
+    /* Move an element of this list to the back */
+    void move_to_back(T& item) {
+        remove(item);
+        push_back(item);
+    }
+
+    /* Unlink every element */
+    void clear() {
+        Hook* hook = head_.next;
+        while (hook != &head_) {
+            Hook* next = hook->next;
+            hook->prev = nullptr;
+            hook->next = nullptr;
+            hook = next;
+        }
+        head_.prev = &head_;
+        head_.next = &head_;
+        size_ = 0;
+    }
+
+private:
+    Hook head_;
+    size_t size_;
+
+    static T* owner(Hook* hook) { return static_cast<T*>(hook); }
+
+    void insert_before(Hook* position, T& item) {
+        Hook* hook = static_cast<Hook*>(&item);
+        hook->prev = position->prev;
+        hook->next = position;
+        position->prev->next = hook;
+        position->prev = hook;
+        size_++;
+    }
+};
+
+} // namespace nymph
+
+#endif // NYMPH_INTRUSIVE_LIST_HPP
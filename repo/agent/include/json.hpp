@@ -0,0 +1,213 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 JSON Reader and Writer
+ *
+ * Single-pass, on-demand reader for request bodies. Reader walks the
+ * members of one object left to right; each value is validated and
+ * skipped in the same pass but only decoded when the caller asks for it,
+ * so a decoder that wants three fields of a 1 MB body touches every byte
+ * once. Strings are scanned 16 bytes at a time (SSE2 or NEON, with a
+ * scalar fallback) for the next quote, backslash or control byte.
+ *
+ * Values are views into the document; it must outlive them.
+ *
+ * Writer is the response-side counterpart: it appends compact JSON to a
+ * caller-owned string (typically a reused per-connection buffer) with
+ * no intermediate streams, and formats numbers with std::to_chars, so
+ * output never depends on the global locale.
+ */
+
+#ifndef NYMPH_JSON_HPP
+#define NYMPH_JSON_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace nymph {
+namespace json {
+
+/* Malformed document; offset is the byte where parsing stopped */
+class ParseError : public std::runtime_error {
+public:
+    ParseError(const std::string& message, size_t offset)
+        : std::runtime_error(message + " at offset " + std::to_string(offset)), offset_(offset) {}
+
+    size_t offset() const { return offset_; }
+
+private:
+    size_t offset_;
+};
+
+/* JSON value types */
+enum class Type {
+    NUL,
+    BOOL,
+    NUMBER,
+    STRING,
+    OBJECT,
+    ARRAY
+};
+
+/* One validated but undecoded value */
+struct Value {
+    Type type;
+    std::string_view raw;       // Exact text; strings include their quotes
+    bool escaped;               // String contains backslash escapes
+
+    Value() : type(Type::NUL), escaped(false) {}
+
+    /* Decoded string; empty for non-strings */
+    std::string as_string() const;
+
+    /* String contents without copying; only valid when !escaped */
+    std::string_view as_view() const;
+
+    /* Conversions return fallback on a type mismatch or out-of-range number */
+    bool as_bool(bool fallback) const;
+    double as_double(double fallback) const;
+    int64_t as_int(int64_t fallback) const;
+    uint64_t as_uint(uint64_t fallback) const;
+
+    /* Elements of an array of unsigned integers; false (out untouched) otherwise */
+    bool as_uint_array(std::vector<uint64_t>& out) const;
+};
+
+/*
+ * Member-by-member reader over one object. An empty (or all-whitespace)
+ * document reads as {}. Throws ParseError on malformed input, including
+ * trailing bytes after the object.
+ */
+class Reader {
+public:
+    explicit Reader(std::string_view document);
+
+    /* Advance to the next member; false after the last one */
+    bool next(std::string_view& key, Value& value);
+
+private:
+    friend class ArrayReader;
+
+    Reader(std::string_view document, char open);
+
+    std::string_view doc_;
+    size_t pos_;
+    bool first_;                // No member read yet
+    bool done_;                 // Closing brace consumed
+    std::string key_scratch_;   // Decoded key when it had escapes
+
+    /* Internal helpers */
+    void skip_whitespace();
+    Value parse_value(int depth);
+    Value parse_string();
+    Value parse_number();
+    Value parse_literal(const char* text, Type type);
+    Value parse_container(int depth);
+    [[noreturn]] void fail(const char* message) const;
+};
+
+/*
+ * Element-by-element reader over an array value, which Reader has already
+ * validated; anything other than an array reads as []. Elements are views
+ * into the same document.
+ */
+class ArrayReader {
+public:
+    explicit ArrayReader(const Value& array);
+
+    /* Advance to the next element; false after the last one */
+    bool next(Value& element);
+
+private:
+    Reader reader_;
+};
+
+/*
+ * Streaming writer into out. Commas and colons are inserted automatically;
+ * callers alternate key() and a value inside objects. Nesting deeper than
+ * 64 levels is not supported.
+ */
+class Writer {
+public:
+    explicit Writer(std::string& out) : out_(out), depth_(0), has_member_(0), after_key_(false) {}
+
+    Writer& begin_object();
+    Writer& end_object();
+    Writer& begin_array();
+    Writer& end_array();
+
+    /* Member name; the next call writes its value */
+    Writer& key(std::string_view name);
+
+    Writer& string(std::string_view text);
+    Writer& boolean(bool flag);
+    Writer& null();
+
+    /* Any integer type except bool */
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, Writer&>::type
+    integer(T number) {
+        separate();
+        append_integer(static_cast<typename std::conditional<std::is_signed<T>::value,
+                                                             int64_t, uint64_t>::type>(number));
+        return *this;
+    }
+
+    /* Fixed notation with precision decimals; NaN and infinities become null */
+    Writer& number(double number, int precision);
+
+    /* Pre-rendered JSON value, copied verbatim */
+    Writer& raw(std::string_view json);
+
+    /* Convenience: key() followed by a value */
+    template <typename T>
+    Writer& member(std::string_view name, const T& value) {
+        key(name);
+        return write(value);
+    }
+    Writer& member(std::string_view name, double value, int precision) {
+        key(name);
+        return number(value, precision);
+    }
+
+private:
+    std::string& out_;
+    int depth_;
+    uint64_t has_member_;       // Bit d set once depth d+1 has its first element
+    bool after_key_;            // Next value follows a key, no comma
+
+    void separate();
+    void append_integer(int64_t number);
+    void append_integer(uint64_t number);
+
+    Writer& write(std::string_view text) { return string(text); }
+    Writer& write(const std::string& text) { return string(text); }
+    Writer& write(const char* text) { return string(text); }
+    Writer& write(bool flag) { return boolean(flag); }
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, Writer&>::type
+    write(T number) { return integer(number); }
+};
+
+/* Append text as a quoted, escaped JSON string */
+void append_escaped(std::string& out, std::string_view text);
+
+namespace detail {
+
+/* Offset of the first '"', '\\' or byte < 0x20 in [data, data + size), or size */
+size_t find_string_special(const char* data, size_t size);
+size_t find_string_special_scalar(const char* data, size_t size);
+
+/* Decode the body of a string literal (without quotes), appending to out */
+bool unescape(std::string_view body, std::string& out);
+
+} // namespace detail
+
+} // namespace json
+} // namespace nymph
+
+#endif // NYMPH_JSON_HPP
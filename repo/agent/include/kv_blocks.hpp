@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Paged KV Block Allocator
+ *
+ * The KV cache arena is carved into fixed 16 KiB blocks tracked by a free
+ * bitmap. A region owns a block table (a list of block ids) rather than
+ * one contiguous range, so space released by eviction is reusable by any
+ * later region regardless of size. Allocation is first-fit from the lowest
+ * free block, which keeps live blocks packed toward the start of the arena
+ * and new regions contiguous whenever a long enough run exists.
+ *
+ * Not thread-safe; KVCacheManager serializes access.
+ */
+
+#ifndef NYMPH_KV_BLOCKS_HPP
+#define NYMPH_KV_BLOCKS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nymph {
+namespace kv {
+
+/* Free-space layout of the arena */
+struct BlockFragmentation {
+    uint64_t free_extents;          // Maximal runs of free blocks
+    uint64_t largest_free_extent;   // Blocks in the longest free run
+    double external;                // 1 - largest_free_extent / free blocks (0 when packed)
+};
+
+class BlockAllocator {
+public:
+    static constexpr uint64_t kBlockSizeKB = 16;
+    static constexpr uint64_t kBlockSizeBytes = kBlockSizeKB * 1024;
+
+    BlockAllocator();
+
+    /* Reset to total_blocks free blocks starting at base_address */
+    void reset(uint64_t total_blocks, uint64_t base_address);
+
+    /* Blocks needed to hold size_kb */
+    static uint64_t blocks_for(uint64_t size_kb) {
+        return (size_kb + kBlockSizeKB - 1) / kBlockSizeKB;
+    }
+
+    /* Append count block ids to table; all or nothing */
+    bool allocate(uint64_t count, std::vector<uint32_t>& table);
+
+    /* Take one given block; false if it is in use or past the end */
+    bool claim(uint32_t block);
+
+    /* Return every block in table to the free pool */
+    void release(const std::vector<uint32_t>& table);
+
+    /* Address of a block in the arena */
+    uint64_t block_address(uint32_t block) const {
+        return base_address_ + static_cast<uint64_t>(block) * kBlockSizeBytes;
+    }
+
+    uint64_t total_blocks() const { return total_blocks_; }
+    uint64_t free_blocks() const { return free_blocks_; }
+    uint64_t used_blocks() const { return total_blocks_ - free_blocks_; }
+
+    /* Walks the bitmap: O(total_blocks / 64) */
+    BlockFragmentation fragmentation() const;
+
+    /* Contiguous runs in a block table (1 for a contiguous region) */
+    static uint64_t extent_count(const std::vector<uint32_t>& table);
+
+private:
+    std::vector<uint64_t> free_bits_;   // Bit set = block free
+    uint64_t total_blocks_;
+    uint64_t free_blocks_;
+    uint64_t base_address_;
+    size_t first_free_word_;            // No free bit below this word
+};
+
+} // namespace kv
+} // namespace nymph
+
+#endif // NYMPH_KV_BLOCKS_HPP
@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Eviction Policies
+ *
+ * EvictionQueue orders the evictable (unpinned) KV regions and names the
+ * next victim. Policies, lowest score evicted first:
+ *
+ *   lru           last use
+ *   lfu           hit_count, ties broken by last use
+ *   priority-lru  last use, pushed kPriorityTicks uses later per priority level
+ *   gdsf          Greedy-Dual-Size-Frequency: L + (hit_count + 1) * weight / blocks,
+ *                 where weight = 1 + priority (priority <= 0 counts as 0) and L
+ *                 is the score of the last victim, so regions that were
+ *                 valuable long ago age out
+ *
+ * "Use" is a per-shard logical clock the caller stamps on every pin,
+ * access and unpin. LRU keeps the O(1) intrusive list; the scored
+ * policies keep a std::multimap ordered by (score, use), O(log n) per
+ * update.
+ *
+ * Accesses only read-lock a shard, so they cannot reorder the queue.
+ * Instead each node remembers the use it was queued with, and the caller
+ * re-queues a stale victim (one used since) before evicting anything:
+ * lazy promotion, as in CLOCK. Not thread-safe; the caller holds the
+ * shard's write lock.
+ */
+
+#ifndef NYMPH_KV_EVICTION_HPP
+#define NYMPH_KV_EVICTION_HPP
+
+#include "intrusive_list.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace nymph {
+namespace kv {
+
+/* Victim selection policy */
+enum class EvictionPolicy {
+    LRU,
+    LFU,
+    PRIORITY_LRU,
+    GDSF
+};
+
+std::string eviction_policy_to_string(EvictionPolicy policy);
+
+/* False for an unknown name (policy left unchanged) */
+bool eviction_policy_from_string(std::string_view name, EvictionPolicy& policy);
+
+/* What a policy scores a region on */
+struct EvictionInput {
+    uint64_t use;               // Logical time of the last pin/access/unpin
+    uint64_t hits;              // Region hit_count
+    uint64_t blocks;            // Blocks owned
+    int priority;               // From the last pin
+};
+
+/* Queue position, embedded in each region entry */
+struct EvictionNode : ListHook<> {
+    using Key = std::pair<double, uint64_t>;    // (score, use)
+    using Index = std::multimap<Key, EvictionNode*>;
+
+    Index::iterator position;   // Valid while queued under a scored policy
+    uint64_t queued_use = 0;    // EvictionInput::use when (re)queued
+    bool queued = false;
+};
+
+class EvictionQueue {
+public:
+    /* Logical uses a priority level is worth under PRIORITY_LRU */
+    static constexpr uint64_t kPriorityTicks = 4096;
+
+    EvictionQueue();
+
+    /* Switch policy; the caller re-inserts the evictable regions */
+    void reset(EvictionPolicy policy);
+    EvictionPolicy policy() const { return policy_; }
+
+    /* Region became evictable */
+    void insert(EvictionNode& node, const EvictionInput& input);
+
+    /* Re-queue an evictable region with fresh stats */
+    void touch(EvictionNode& node, const EvictionInput& input);
+
+    /* Region is no longer evictable (pinned or erased) */
+    void remove(EvictionNode& node);
+
+    /* Next victim, or nullptr; remove() it before erasing */
+    EvictionNode* victim() const;
+
+    /* Note that node is being evicted (GDSF ages the queue by its score) */
+    void on_evict(const EvictionNode& node);
+
+    size_t size() const;
+
+private:
+    EvictionPolicy policy_;
+    IntrusiveList<EvictionNode> list_;      // LRU
+    EvictionNode::Index index_;             // Scored policies
+    double inflation_;                      // GDSF "L"
+
+    double score(const EvictionInput& input) const;
+};
+
+} // namespace kv
+} // namespace nymph
+
+#endif // NYMPH_KV_EVICTION_HPP
@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Region Index
+ *
+ * A region is interned once into a numbered slot; everything else refers
+ * to it by slot id. RegionIndex maps names to slots with a flat
+ * open-addressing table: linear probing over 8-byte buckets holding 32
+ * bits of the name's hash and the slot, so a lookup is usually one cache
+ * line plus one name compare on a hash match. Erasure shifts the probe
+ * run back instead of leaving tombstones. The table doubles at 70% load.
+ *
+ * RegionCounters keeps the per-access counters of every slot as parallel
+ * columns (struct of arrays), apart from the cold region metadata:
+ * summing one counter over a shard reads one contiguous array. HISTORY
+ * is a 64-bit shift register of the latest hits and misses, so a
+ * region's recent hit rate costs one popcount rather than a time series.
+ *
+ * Neither is thread-safe for writers. Counters are atomics so holders of
+ * a shard's read lock may bump them; growth needs the write lock.
+ */
+
+#ifndef NYMPH_KV_INDEX_HPP
+#define NYMPH_KV_INDEX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace nymph {
+namespace kv {
+
+/*
+ * 64-bit hash of a region name, the same on every target; shards use the
+ * low bits, RegionIndex the high
+ */
+uint64_t region_hash(std::string_view name);
+
+class RegionIndex {
+public:
+    static constexpr uint32_t kNoSlot = UINT32_MAX;
+
+    RegionIndex();
+
+    /* Slot of name, or kNoSlot; name_of(slot) gives a slot's name */
+    template <typename NameOf>
+    uint32_t find(std::string_view name, uint64_t hash, const NameOf& name_of) const {
+        if (buckets_.empty()) {
+            return kNoSlot;
+        }
+        uint32_t tag = tag_of(hash);
+        for (size_t i = tag & mask_;; i = (i + 1) & mask_) {
+            const Bucket& bucket = buckets_[i];
+            if (bucket.slot == kNoSlot) {
+                return kNoSlot;
+            }
+            if (bucket.tag == tag && name_of(bucket.slot) == name) {
+                return bucket.slot;
+            }
+        }
+    }
+
+    /* Add a slot whose name is not in the index yet */
+    void insert(uint64_t hash, uint32_t slot);
+
+    /* Remove a slot added with the same hash */
+    void erase(uint64_t hash, uint32_t slot);
+
+    void clear();
+    size_t size() const { return size_; }
+
+private:
+    struct Bucket {
+        uint32_t tag;
+        uint32_t slot;          // kNoSlot when empty
+    };
+
+    std::vector<Bucket> buckets_;
+    size_t mask_;
+    size_t size_;
+
+    static uint32_t tag_of(uint64_t hash) { return static_cast<uint32_t>(hash >> 32); }
+    void grow();
+};
+
+class RegionCounters {
+public:
+    enum Column {
+        ACCESSES,
+        HITS,
+        MISSES,
+        LAST_ACCESS_TIME,
+        LAST_USE,               // Shard use clock at the last pin/access/unpin
+        HISTORY,                // Last kWindow accesses, newest in bit 0, 1 = hit
+        kColumns
+    };
+
+    /* Accesses the sliding-window hit rate covers */
+    static constexpr uint32_t kWindow = 64;
+
+    RegionCounters();
+
+    /* Make room for slots [0, slots); copies existing values */
+    void reserve(size_t slots);
+    size_t capacity() const { return capacity_; }
+
+    std::atomic<uint64_t>& at(Column column, uint32_t slot) { return columns_[column][slot]; }
+    uint64_t load(Column column, uint32_t slot) const {
+        return columns_[column][slot].load(std::memory_order_relaxed);
+    }
+
+    /* Zero every column of a slot */
+    void reset(uint32_t slot);
+
+    /* Count one access of a slot; safe under a read lock */
+    void record(uint32_t slot, bool hit, uint64_t now);
+
+    /* Hit rate over the slot's last kWindow accesses (0 before any) */
+    double window_hit_rate(uint32_t slot) const;
+
+    /* Column total over slots [0, slots); free slots hold zeros */
+    uint64_t sum(Column column, size_t slots) const;
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> columns_[kColumns];
+    size_t capacity_;
+};
+
+} // namespace kv
+} // namespace nymph
+
+#endif // NYMPH_KV_INDEX_HPP
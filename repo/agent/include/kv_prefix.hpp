@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Prefix Tree
+ *
+ * Radix tree over whole KV pages for prefix sharing. Each edge is keyed
+ * by the hash of one page's token prefix and each node owns one block,
+ * read-only and shared by every region whose leading pages follow that
+ * path. A node counts the regions referencing it; regions reference
+ * every node from the root down to their deepest shared page, so a node
+ * outlives its children and is freed, block and all, with its last
+ * reference.
+ *
+ * Not thread-safe; KVCacheManager guards it with its arena lock.
+ */
+
+#ifndef NYMPH_KV_PREFIX_HPP
+#define NYMPH_KV_PREFIX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace nymph {
+namespace kv {
+
+class PrefixTree {
+public:
+    struct Node {
+        uint64_t key = 0;           // Page hash on the edge from parent
+        uint32_t block = 0;
+        uint32_t refs = 0;          // Regions sharing this page
+        Node* parent = nullptr;
+        std::unordered_map<uint64_t, std::unique_ptr<Node>> children;
+    };
+
+    PrefixTree();
+
+    PrefixTree(const PrefixTree&) = delete;
+    PrefixTree& operator=(const PrefixTree&) = delete;
+
+    /* Leading pages of keys[0, count) already in the tree */
+    size_t match(const std::vector<uint64_t>& keys, size_t count) const;
+
+    /*
+     * Reference the path for keys[0, count), appending its blocks to
+     * blocks. Missing nodes take their block from the back of spare; the
+     * walk stops early when spare runs out. Returns the deepest node
+     * referenced (nullptr for none) and sets acquired to its depth.
+     */
+    Node* acquire(const std::vector<uint64_t>& keys, size_t count, std::vector<uint32_t>& spare,
+                  std::vector<uint32_t>& blocks, size_t& acquired);
+
+    /*
+     * Drop one reference from node and its levels - 1 nearest ancestors,
+     * appending blocks of nodes left unreferenced to freed. Returns the
+     * new deepest node (nullptr at the root).
+     */
+    Node* release(Node* node, size_t levels, std::vector<uint32_t>& freed);
+
+    /* Forget every node; their blocks are the caller's to reclaim */
+    void clear();
+
+    uint64_t blocks() const { return nodes_; }
+    uint64_t references() const { return references_; }
+
+    /* Region pages served by a block someone else already holds */
+    uint64_t shared_savings() const { return references_ - nodes_; }
+
+private:
+    Node root_;
+    uint64_t nodes_;
+    uint64_t references_;
+};
+
+} // namespace kv
+} // namespace nymph
+
+#endif // NYMPH_KV_PREFIX_HPP
@@ -0,0 +1,99 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Snapshot File
+ *
+ * Binary image of the KV cache's regions so a restarted daemon comes back
+ * warm. A fixed header names the arena layout the block tables refer to;
+ * one record per region follows, hottest first, each 8-byte aligned and
+ * carrying its own checksum:
+ *
+ *   header   magic, version, block size, arena blocks, spill slots,
+ *            region count, record bytes
+ *   record   length, checksum, sizes, pin state, counters, then the
+ *            name, the shared pages' prefix hashes, the block table and
+ *            the spill slots
+ *
+ * Payloads are not copied. The block arena is address-only (stub mode),
+ * so device memory keeps a page as long as its block id does; spilled
+ * pages stay in the spill file, which the daemon reopens without
+ * truncating. Restoring a region therefore means claiming the same block
+ * and slot ids again.
+ *
+ * Both directions go through a file mapping. The writer sizes the file
+ * first, fills the mapping and renames it over the old snapshot, so a
+ * crash mid-write leaves the previous one intact. The reader decodes one
+ * record at a time, so only the part of the file actually restored is
+ * paged in.
+ */
+
+#ifndef NYMPH_KV_SNAPSHOT_HPP
+#define NYMPH_KV_SNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nymph {
+namespace kv {
+
+/* One region as a snapshot stores it */
+struct SnapshotRegion {
+    std::string name;
+    uint64_t size_kb = 0;
+    uint64_t pages = 0;
+    bool pinned = false;
+    int priority = 0;
+    uint64_t accesses = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t history = 0;               // RegionCounters::HISTORY bits
+    std::vector<uint64_t> prefix_keys;  // Page hash of each shared leading block
+    std::vector<uint32_t> blocks;       // Resident pages, in region order
+    std::vector<uint32_t> spill_slots;  // Pages after them in the spill file
+};
+
+/* Arena the block tables of a snapshot refer to */
+struct SnapshotLayout {
+    uint64_t block_size_kb = 0;
+    uint64_t total_blocks = 0;
+    uint64_t spill_slots = 0;           // Spill file slots, 0 without a tier
+};
+
+/* Write regions to path, replacing any previous snapshot; false on error */
+bool write_snapshot(const std::string& path, const SnapshotLayout& layout,
+                    const std::vector<SnapshotRegion>& regions);
+
+class SnapshotReader {
+public:
+    SnapshotReader();
+    ~SnapshotReader();
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    /* Map path and check its header; false if missing or not a snapshot */
+    bool open(const std::string& path);
+    void close();
+
+    const SnapshotLayout& layout() const { return layout_; }
+    uint64_t region_count() const { return region_count_; }
+
+    /* Decode the next region; false at the end or at a damaged record */
+    bool next(SnapshotRegion& region);
+
+private:
+    int fd_;
+    const unsigned char* base_;
+    size_t length_;             // Mapped bytes
+    size_t end_;                // End of the records
+    size_t offset_;             // Next record
+    uint64_t remaining_;        // Records not decoded yet
+    uint64_t region_count_;
+    SnapshotLayout layout_;
+};
+
+} // namespace kv
+} // namespace nymph
+
+#endif // NYMPH_KV_SNAPSHOT_HPP
@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Spill File
+ *
+ * Second KV tier on NVMe: a file of 16 KiB slots, one per spilled page,
+ * mapped MAP_SHARED so writeback and readback are memory copies and the
+ * kernel pages the data to and from the drive. Slots are handed out with
+ * the same bitmap allocator as the block arena.
+ *
+ * The block arena is address-only (stub mode), so a written page carries
+ * a header naming the region hash and page index in place of KV data;
+ * read_page checks it, which makes a readback touch the drive.
+ *
+ * Slot allocation is not thread-safe; KVCacheManager serializes it under
+ * its arena lock. Pages of distinct slots may be read and written
+ * concurrently.
+ */
+
+#ifndef NYMPH_KV_SPILL_HPP
+#define NYMPH_KV_SPILL_HPP
+
+#include "kv_blocks.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nymph {
+namespace kv {
+
+class SpillFile {
+public:
+    static constexpr uint64_t kSlotSizeKB = BlockAllocator::kBlockSizeKB;
+
+    SpillFile();
+    ~SpillFile();
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    /*
+     * Create (or truncate) path at capacity_kb and map it; false on error.
+     * With keep_contents an existing file is only resized, so slots named
+     * by a KV snapshot still hold their pages.
+     */
+    bool open(const std::string& path, uint64_t capacity_kb, bool keep_contents = false);
+    void close();
+    bool is_open() const { return base_ != nullptr; }
+    const std::string& path() const { return path_; }
+
+    /* Append count slot ids to slots; all or nothing */
+    bool allocate(uint64_t count, std::vector<uint32_t>& slots);
+    bool claim(uint32_t slot);  // Take one given slot if free
+    void release(const std::vector<uint32_t>& slots);
+    void reset();
+
+    uint64_t total_slots() const { return slots_.total_blocks(); }
+    uint64_t used_slots() const { return slots_.used_blocks(); }
+    uint64_t free_slots() const { return slots_.free_blocks(); }
+
+    /* Write one page of a region to a slot */
+    void write_page(uint32_t slot, uint64_t region_hash, uint64_t page);
+
+    /* Read a slot back; false if it does not hold that page */
+    bool read_page(uint32_t slot, uint64_t region_hash, uint64_t page) const;
+
+    /* Ask the kernel to start reading slots in ahead of read_page */
+    void will_need(const std::vector<uint32_t>& slots) const;
+
+private:
+    struct PageHeader {
+        uint64_t magic;
+        uint64_t region_hash;
+        uint64_t page;
+    };
+
+    std::string path_;
+    int fd_;
+    unsigned char* base_;
+    size_t length_;
+    BlockAllocator slots_;
+
+    unsigned char* slot_data(uint32_t slot) const {
+        return base_ + static_cast<size_t>(slot) * BlockAllocator::kBlockSizeBytes;
+    }
+};
+
+} // namespace kv
+} // namespace nymph
+
+#endif // NYMPH_KV_SPILL_HPP
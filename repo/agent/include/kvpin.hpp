@@ -3,17 +3,72 @@
  * NYMPH 1.1 KV-Pinning Interface
  * 
  * Hot KV cache management for LLMs with Paged-KV and Multi-Query Attention support
+ *
+ * Region memory comes from a paged arena (see kv_blocks.hpp): sizes are
+ * rounded up to whole 16 KiB blocks and eviction returns a region's
+ * blocks for reuse. Which unpinned region is evicted first is decided by
+ * a pluggable policy (see kv_eviction.hpp).
+ *
+ * A region needs one block per page. Its resident pages are a prefix of
+ * the region, backed by blocks; eviction spills pages from the tail of
+ * the victim, and a region whose last page is spilled is dropped. Pinning
+ * a partly spilled region faults its spilled pages back in. An access is
+ * a hit when the pages it touches are resident; hit rates are computed
+ * from those counts.
+ *
+ * With a spill tier (enable_spill, see kv_spill.hpp), spilled pages are
+ * written to a file on NVMe and follow the resident ones in the region,
+ * so a region whose pages all went to the file is kept, not dropped.
+ * Pins may then spill cold regions without force; force is only needed
+ * to drop regions once the file is full. An access that lands on a page
+ * in the file queues an asynchronous readback, and prefetch_region does
+ * the same ahead of use. Readback runs on a small thread pool.
+ *
+ * Regions may share leading pages (see kv_prefix.hpp): a pin names the
+ * token-prefix hash of each leading page, and pages already in the
+ * prefix tree reuse its blocks instead of allocating. Shared pages stay
+ * resident while any region holds them and are never spilled. A write
+ * into a shared page copies it and every later shared page of that
+ * region, whose KV depends on it, into private blocks.
+ *
+ * The regions can be saved to a snapshot file and restored by the next
+ * daemon (see kv_snapshot.hpp). Restore runs in the background, hottest
+ * regions first, for a bounded time, and claims the same blocks and
+ * spill slots again, so restored pages count as resident.
+ *
+ * Regions are spread over kShards shards by name hash, each with its own
+ * reader/writer lock, open-addressing name index (see kv_index.hpp) and
+ * eviction queue. access_region, get_region and
+ * the stats readers take only shard read locks; region counters are
+ * atomics, so accesses to any region proceed in parallel. Pin, unpin and
+ * eviction write-lock one shard at a time, and the block arena has its
+ * own short lock. Eviction takes victims from the shards round-robin, so
+ * the policy order is exact within a shard and approximate across them.
  */
 
 #ifndef NYMPH_KVPIN_HPP
 #define NYMPH_KVPIN_HPP
 
+#include "kv_blocks.hpp"
+#include "kv_eviction.hpp"
+#include "kv_index.hpp"
+#include "kv_prefix.hpp"
+#include "kv_snapshot.hpp"
+#include "kv_spill.hpp"
+#include "metrics.hpp"
 #include <string>
+#include <string_view>
+#include <deque>
 #include <map>
+#include <unordered_set>
 #include <vector>
 #include <cstdint>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
 
 namespace nymph {
 namespace kv {
@@ -21,14 +76,20 @@ namespace kv {
 /* KV Region configuration */
 struct KVRegion {
     std::string name;           // Region name (e.g., "chat_ctx", "model_cache")
-    uint64_t size_kb;           // Size in kilobytes
-    uint64_t base_address;      // Base address in KV cache memory
+    uint64_t size_kb;           // Size in kilobytes (as requested)
+    uint64_t base_address;      // Address of the first block
+    uint64_t pages;             // Blocks the whole region needs
+    std::vector<uint32_t> blocks;  // Block table of the resident pages, in region order
+    std::vector<uint32_t> spill_slots;  // Spill file slots of the pages after them
+    uint64_t shared_pages;      // Leading blocks shared through the prefix tree
     bool is_pinned;             // Whether region is currently pinned
     uint64_t access_count;      // Number of accesses
     uint64_t hit_count;         // Number of cache hits
     uint64_t miss_count;        // Number of cache misses
     uint64_t last_access_time;  // Timestamp of last access
     uint64_t pin_time;          // Timestamp when pinned
+    int priority;               // From the last pin (higher = keep longer)
+    double window_hit_rate;     // Over the last RegionCounters::kWindow accesses
 };
 
 /* KV Pin request */
@@ -37,6 +98,8 @@ struct KVPinRequest {
     uint64_t size_kb;           // Size in KB
     bool force;                 // Force eviction if needed
     int priority;               // Priority (higher = more important)
+    std::string eviction_policy;  // Switch the cache's policy first (empty = keep)
+    std::vector<uint64_t> prefix_pages;  // Token-prefix hash of each leading page to share
 };
 
 /* KV Pin result */
@@ -49,6 +112,42 @@ struct KVPinResult {
     std::map<std::string, double> stats;  // Additional statistics
 };
 
+/* Operations a batch can carry */
+enum class KVOpType {
+    PIN,
+    UNPIN,
+    ACCESS,
+    EVICT                       // Drop an unpinned region and free its pages
+};
+
+/* One operation of a batch */
+struct KVOp {
+    KVOpType type;
+    KVPinRequest pin;           // PIN: the whole request; other ops use pin.region (and ACCESS pin.force)
+    bool is_read;               // ACCESS
+    uint64_t offset_kb;         // ACCESS: page offset, or KVCacheManager::kWholeRegion
+};
+
+/* Outcome of one batch operation */
+struct KVOpResult {
+    bool success;
+    bool hit;                   // PIN and ACCESS: every page touched was resident
+    std::string error_message;
+    KVPinResult pin;            // PIN only
+};
+
+/* Batch of operations applied together */
+struct KVBatchRequest {
+    std::vector<KVOp> ops;
+    bool atomic;                // All or nothing
+};
+
+struct KVBatchResult {
+    bool success;               // Every op succeeded; atomic: nothing applied otherwise
+    std::string error_message;  // Why an atomic batch was not applied
+    std::vector<KVOpResult> results;  // One per op, in order
+};
+
 /* KV Cache statistics */
 struct KVCacheStats {
     uint64_t total_size_kb;     // Total cache size
@@ -60,16 +159,76 @@ struct KVCacheStats {
     uint64_t total_hits;        // Total hits
     uint64_t total_misses;      // Total misses
     std::vector<std::string> pinned_region_names;  // Names of pinned regions
+
+    /* Paged arena layout */
+    uint64_t block_size_kb;     // Allocation unit
+    uint64_t total_blocks;      // Blocks in the arena
+    uint64_t free_blocks;       // Blocks not owned by any region
+    uint64_t free_extents;      // Runs of contiguous free blocks
+    uint64_t largest_free_extent_kb;  // Longest free run
+    double fragmentation;       // External: 1 - largest free run / free space
+    uint64_t internal_waste_kb; // Block rounding: allocated minus requested
+    uint64_t split_regions;     // Regions whose blocks are not contiguous
+    uint64_t spilled_regions;   // Regions with some pages spilled
+    uint64_t spilled_kb;        // Their spilled pages, as whole blocks
+
+    /* Spill tier (zero when disabled) */
+    uint64_t spill_total_kb;    // Spill file capacity
+    uint64_t spill_used_kb;     // Pages held in the spill file
+
+    /* Prefix sharing */
+    uint64_t shared_blocks;     // Blocks in the prefix tree
+    uint64_t dedup_saved_kb;    // Region pages served by another region's block
+
+    EvictionPolicy eviction_policy;  // Active victim selection policy
+    uint64_t evictable_regions;      // Unpinned regions queued for eviction
+};
+
+/* Cache counters readable without any lock (for /metrics) */
+struct KVCacheGauges {
+    uint64_t total_size_kb;     // Total cache size
+    uint64_t used_size_kb;      // Currently used
+    uint64_t regions;           // Regions resident (pinned or not)
+    uint64_t pinned_regions;    // Regions currently pinned
+    uint64_t accesses;          // Accesses since start (survives eviction)
+    uint64_t hits;              // Hits since start
+    uint64_t misses;            // Misses since start
+    uint64_t evictions;         // Regions evicted since start
+    uint64_t spilled_blocks;    // Pages spilled since start (drops under pressure included)
+    uint64_t spill_used_kb;     // Pages held in the spill file
+    uint64_t readback_blocks;   // Pages read back from the spill file since start
+    uint64_t dedup_saved_kb;    // Region pages served by another region's block
+    uint64_t cow_blocks;        // Shared pages copied on write since start
 };
 
 /* KV Cache Region Manager */
 class KVCacheManager {
 public:
+    /* Region map shards; a power of two */
+    static const size_t kShards = 16;
+
+    /* Threads reading spilled pages back */
+    static const size_t kReadbackThreads = 2;
+
     KVCacheManager();
     ~KVCacheManager();
 
     /* Initialize the cache manager */
-    bool initialize(uint64_t total_cache_size_kb = 1024 * 1024);  // Default 1GB
+    bool initialize(uint64_t total_cache_size_kb = 1024 * 1024,   // Default 1GB
+                    EvictionPolicy policy = EvictionPolicy::LRU);
+
+    /*
+     * Add a spill tier backed by a file of capacity_kb at path (created or
+     * truncated) and start the readback threads. Call once, after
+     * initialize; false if the file cannot be set up. keep_contents
+     * leaves an existing file's pages for restore_snapshot.
+     */
+    bool enable_spill(const std::string& path, uint64_t capacity_kb, bool keep_contents = false);
+    bool spill_enabled() const { return spill_enabled_.load(std::memory_order_acquire); }
+
+    /* Change the eviction policy; re-scores the unpinned regions, O(n log n) */
+    void set_eviction_policy(EvictionPolicy policy);
+    EvictionPolicy get_eviction_policy() const;
 
     /* Pin a region in the KV cache */
     KVPinResult pin_region(const KVPinRequest& request);
@@ -77,49 +236,230 @@ public:
     /* Unpin a region */
     bool unpin_region(const std::string& region_name);
 
-    /* Access a region (updates hit/miss stats) */
-    bool access_region(const std::string& region_name, bool is_read = true);
+    /* Most operations apply_batch takes */
+    static const size_t kMaxBatchOps = 1024;
+
+    /*
+     * Apply ops, each region's in batch order. Without atomic, the ops are
+     * grouped by shard and each group runs under its shard's write lock,
+     * so ops on regions in different shards may apply out of batch order.
+     * Blocks for the pins are reserved up front; when the arena is short
+     * the locks are dropped once to evict (as a pin would) and retaken.
+     * With atomic, every shard touched is locked for the whole batch, the
+     * batch is validated against the locked state first and either every
+     * op applies or none does; it reserves every page of a new region,
+     * shared prefix or not, and a block for every shared page a write
+     * will copy, which is copied under the locks, so nothing can fail
+     * after validation. An eviction policy switch in an atomic batch
+     * happens only once it has applied. Evictions made to find room are
+     * not undone. Without atomic, copy-on-write for writes to shared
+     * pages runs after the locks are released and may fail on its own.
+     */
+    KVBatchResult apply_batch(const std::vector<KVOp>& ops, bool atomic);
+
+    /* access_region offset that touches every page of the region */
+    static constexpr uint64_t kWholeRegion = UINT64_MAX;
+
+    /*
+     * Access the page holding offset_kb, or the whole region. Returns
+     * true on a hit: every page touched is resident. An unknown region
+     * counts as a cache miss; an offset past the region is not counted.
+     * A write to a shared page copies it first (not under the read lock),
+     * finding room by spilling as a pin does, or by dropping regions with
+     * force; false when that fails.
+     */
+    bool access_region(const std::string& region_name, bool is_read = true,
+                       uint64_t offset_kb = kWholeRegion, bool force = false);
+
+    /*
+     * Queue the region's spilled pages for readback and return at once.
+     * False for an unknown region or without a spill tier; true otherwise,
+     * including when there is nothing to read.
+     */
+    bool prefetch_region(const std::string& region_name);
 
     /* Get region info */
     bool get_region(const std::string& region_name, KVRegion& region) const;
 
-    /* Get cache statistics */
+    /*
+     * Get cache statistics. Shards are read-locked one after another, so
+     * writers are never stopped globally and the totals are a sum of
+     * per-shard snapshots rather than one instant.
+     */
     KVCacheStats get_stats() const;
 
-    /* List all regions */
+    /* Get cache counters without taking any lock */
+    KVCacheGauges get_gauges() const;
+
+    /* List all regions (per-shard snapshots, like get_stats) */
     std::vector<KVRegion> list_regions() const;
 
-    /* Evict LRU regions to free space */
-    uint64_t evict_lru(uint64_t required_kb);
+    /*
+     * Spill pages of unpinned regions until required_kb is freed, one
+     * victim per shard per round; returns KB freed (whole blocks). Without
+     * allow_drop, only pages the spill file can take are freed. Must not
+     * be called with a shard lock held.
+     */
+    uint64_t evict(uint64_t required_kb, bool allow_drop = true);
 
     /* Clear all regions */
     void clear();
 
+    /*
+     * Write every region to a snapshot at path, pinned regions first and
+     * then by last access. Shards are read-locked one after another, as in
+     * get_stats; the file is written with no lock held. False on error.
+     */
+    bool save_snapshot(const std::string& path) const;
+
+    /*
+     * Restore the regions of the snapshot at path on a background thread
+     * and return at once. Regions whose records are not reached within
+     * budget_ms are left out, as are pages whose blocks or spill slots are
+     * taken by then. Regions pinned meanwhile keep their new state. Call
+     * after initialize and enable_spill; false without a valid snapshot
+     * or while another restore runs.
+     */
+    bool restore_snapshot(const std::string& path, uint64_t budget_ms);
+
+    /* Wait for a restore_snapshot in progress */
+    void wait_restore();
+
     /* Check if initialized */
-    bool is_initialized() const { return initialized_; }
+    bool is_initialized() const { return initialized_.load(std::memory_order_acquire); }
 
 private:
-    bool initialized_;
+    /*
+     * Cold region metadata plus its eviction queue position, kept in the
+     * shard's slot array. Only the write lock changes it. The per-access
+     * counters of the same slot live in Shard::counters; region's counter
+     * fields are unused here and filled in by Shard::snapshot().
+     */
+    struct ColdTag {};
+
+    struct RegionEntry : EvictionNode, ListHook<ColdTag> {
+        KVRegion region;
+        uint64_t hash = 0;      // region_hash(region.name)
+        PrefixTree::Node* prefix = nullptr;  // Deepest shared page
+        uint32_t slot = 0;
+        bool live = false;
+    };
+
+    /* Only unpinned regions are queued, so eviction never scans the slots */
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        RegionIndex index;                  // Name -> slot
+        std::deque<RegionEntry> entries;    // By slot; a deque never moves them
+        std::vector<uint32_t> free_slots;
+        RegionCounters counters;            // Hot counters by slot
+        EvictionQueue eviction;             // Declared after entries: unlinks before they go
+        IntrusiveList<RegionEntry, ColdTag> cold;  // Pages all in the spill file, oldest first
+        std::atomic<uint64_t> use_clock{0};
+
+        uint32_t find(std::string_view name, uint64_t hash) const;
+        uint32_t add(const std::string& name, uint64_t hash);   // Slot for a new region
+        void remove(uint32_t slot);
+        void clear();
+        void stamp_use(uint32_t slot);
+        void settle(uint32_t slot);     // Queue or park the region after a change
+        KVRegion snapshot(uint32_t slot) const;
+        EvictionInput eviction_input(uint32_t slot) const;
+    };
+
+    std::atomic<bool> initialized_;
     uint64_t total_size_kb_;
-    uint64_t used_size_kb_;
-    uint64_t next_base_address_;
-    
-    std::map<std::string, KVRegion> regions_;
-    mutable std::mutex mutex_;
+    Shard shards_[kShards];
+    std::atomic<size_t> evict_cursor_;      // Shard the next eviction round starts at
+    std::atomic<EvictionPolicy> policy_;
+    std::mutex policy_mutex_;               // Serializes policy switches
+
+    /* Block arena; arena_mutex_ nests inside shard locks, never around them */
+    mutable std::mutex arena_mutex_;
+    BlockAllocator blocks_;
+    uint64_t requested_kb_;     // Resident part of region sizes as requested
+    uint64_t arena_generation_; // Bumped by clear(); blocks from an older arena are void
+    SpillFile spill_;           // Slot bitmap guarded by arena_mutex_ too; pages by slot owner
+    PrefixTree prefixes_;       // Guarded by arena_mutex_
+    std::atomic<bool> spill_enabled_;
+
+    /* Readback queue: region names, each queued at most once */
+    std::mutex readback_mutex_;             // Nests inside shard locks
+    std::condition_variable readback_cv_;
+    std::deque<std::string> readback_queue_;
+    std::unordered_set<std::string> readback_pending_;
+    std::vector<std::thread> readback_threads_;
+    bool readback_stop_;
+
+    /* Snapshot restore */
+    std::thread restore_thread_;
+    std::atomic<bool> restore_stop_;
+
+    /* Counters readable without a lock */
+    struct AtomicGauges {
+        std::atomic<uint64_t> total_size_kb{0};
+        std::atomic<uint64_t> used_size_kb{0};  // Whole blocks owned by regions
+        std::atomic<uint64_t> regions{0};
+        std::atomic<uint64_t> pinned_regions{0};
+        metrics::Counter accesses;              // Sharded: bumped on every access
+        metrics::Counter hits;
+        metrics::Counter misses;
+        std::atomic<uint64_t> evictions{0};
+        std::atomic<uint64_t> spilled_blocks{0};
+        std::atomic<uint64_t> spill_used_kb{0};
+        std::atomic<uint64_t> readback_blocks{0};
+        std::atomic<uint64_t> dedup_saved_kb{0};
+        std::atomic<uint64_t> cow_blocks{0};
+    };
+    AtomicGauges gauges_;
 
     /* Internal helpers */
     uint64_t get_current_time() const;
-    bool allocate_space(uint64_t size_kb, uint64_t& base_address);
-    void update_hit_stats(const std::string& region_name, bool is_hit);
+    Shard& shard_of(uint64_t hash) { return shards_[hash & (kShards - 1)]; }
+    const Shard& shard_of(uint64_t hash) const { return shards_[hash & (kShards - 1)]; }
+    bool allocate_space(uint64_t block_count, std::vector<uint32_t>& blocks, uint64_t& generation);
+    bool make_room(uint64_t block_count, bool allow_drop, std::vector<uint32_t>& blocks,
+                   uint64_t& generation, std::string& error);
+    uint64_t attach_blocks(Shard& shard, uint32_t slot, std::vector<uint32_t>& blocks);  // Caller write-locks shard
+    bool reserve_spill(Shard& shard, uint64_t count, std::vector<uint32_t>& slots);  // Caller write-locks shard
+    uint64_t drop_region(Shard& shard, uint32_t slot);                 // Caller write-locks shard; blocks freed
+    bool copy_on_write(const std::string& region_name, uint64_t hash, uint64_t first_page,
+                       bool allow_drop, std::string& error);
+    void unshare_pages(Shard& shard, uint32_t slot, uint64_t first_page,
+                       std::vector<uint32_t>& blocks);     // Caller write-locks shard, holds arena_mutex_
+    void queue_readback(const std::string& region_name);
+    void readback_loop();
+    void read_back(const std::string& region_name);
+    uint64_t free_size_kb();
+    void apply_eviction_policy(Shard& shard, EvictionPolicy policy);  // Caller write-locks shard
+    void pin_existing(Shard& shard, uint32_t slot, const KVPinRequest& request, bool hit,
+                      KVPinResult& result);                             // Caller write-locks shard
+    uint64_t pin_fault_blocks(const Shard& shard, uint32_t slot, const KVPinRequest& request);  // Caller locks shard
+    void commit_pin(Shard& shard, uint64_t hash, const KVPinRequest& request,
+                    std::vector<uint32_t>& blocks, KVPinResult& result);  // Caller write-locks shard
+    void unpin_slot(Shard& shard, uint32_t slot);                      // Caller write-locks shard
+    bool record_access(Shard& shard, uint32_t slot, bool is_read, uint64_t offset_kb,
+                       uint64_t& copy_from);                            // Caller locks shard
+    struct BatchWork;
+    bool apply_group(BatchWork& work, const std::vector<uint32_t>& group, uint32_t shard_mask);
+    bool evict_one(Shard& shard, uint64_t wanted_kb, bool allow_drop,
+                   uint64_t& freed_kb);                                 // Caller write-locks shard
+    void count_access(bool is_hit);
+    void restore_loop(std::unique_ptr<SnapshotReader> reader, uint64_t budget_ms);
+    bool restore_region(const SnapshotRegion& saved, uint64_t hash, bool with_spill,
+                        uint64_t use);                                  // Takes the shard lock
 };
 
 /* Global KV Cache Manager instance */
 KVCacheManager& get_kv_cache_manager();
 
 /* Helper functions for API integration */
-KVPinRequest parse_kvpin_request(const std::string& json_body);
+KVPinRequest parse_kvpin_request(std::string_view json_body);
 std::string format_kvpin_result(const KVPinResult& result);
 
+/* False with error set for an unknown op or too many ops */
+bool parse_kv_batch_request(std::string_view json_body, KVBatchRequest& request, std::string& error);
+std::string format_kv_batch_result(const KVBatchRequest& request, const KVBatchResult& result);
+
 } // namespace kv
 } // namespace nymph
 
@@ -1,18 +1,37 @@
 /* SPDX-License-Identifier: MIT */
 /*
  * NYMPH 1.1 Logging Infrastructure
+ *
+ * Producers copy each message into a slot of a bounded ring and return; no
+ * lock is taken on the logging path. A background thread drains the ring,
+ * prefixes timestamps and levels, and writes whole batches to stdout and
+ * the log file. When the ring is full the record is dropped and counted.
+ *
+ * Hot paths should log through the NYMPH_LOG_* macros, which take a
+ * "{}"-style format string, evaluate nothing when the level is disabled,
+ * and format straight into the ring slot. Levels below NYMPH_LOG_MIN_LEVEL
+ * (0 = DEBUG .. 3 = ERROR, set by CMake) are compiled out entirely.
  */
 
 #ifndef NYMPH_LOGGER_HPP
 #define NYMPH_LOGGER_HPP
 
 #include <string>
-#include <iostream>
-#include <fstream>
+#include <string_view>
+#include <type_traits>
+#include <charconv>
+#include <atomic>
+#include <thread>
 #include <mutex>
-#include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <condition_variable>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+#ifndef NYMPH_LOG_MIN_LEVEL
+#define NYMPH_LOG_MIN_LEVEL 0
+#endif
 
 namespace nymph {
 namespace log {
@@ -24,72 +43,229 @@ enum class Level {
     ERROR
 };
 
-class Logger {
+namespace detail {
+
+/* Bounded output buffer; excess output is cut and flagged */
+class FormatBuffer {
 public:
-    static Logger& instance() {
-        static Logger logger;
-        return logger;
+    FormatBuffer(char* data, size_t capacity)
+        : data_(data), capacity_(capacity), size_(0), truncated_(false) {}
+
+    void append(const char* text, size_t length) {
+        size_t room = capacity_ - size_;
+        if (length > room) {
+            length = room;
+            truncated_ = true;
+        }
+        std::char_traits<char>::copy(data_ + size_, text, length);
+        size_ += length;
     }
 
-    void set_level(Level level) {
-        level_ = level;
+    void append(std::string_view text) { append(text.data(), text.size()); }
+
+    size_t size() const { return size_; }
+    bool truncated() const { return truncated_; }
+
+private:
+    char* data_;
+    size_t capacity_;
+    size_t size_;
+    bool truncated_;
+};
+
+/* Precision from a "{:.Nf}" spec, or -1 for the default */
+inline int spec_precision(std::string_view spec) {
+    if (spec.size() >= 3 && spec[0] == ':' && spec[1] == '.') {
+        int precision = 0;
+        for (size_t i = 2; i < spec.size() && spec[i] >= '0' && spec[i] <= '9'; i++) {
+            precision = precision * 10 + (spec[i] - '0');
+        }
+        return precision;
     }
+    return -1;
+}
+
+void format_double(FormatBuffer& out, double value, int precision);
 
-    void set_log_file(const std::string& filename) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (log_file_.is_open()) {
-            log_file_.close();
+template <typename T>
+void format_value(FormatBuffer& out, std::string_view spec, const T& value) {
+    using U = typename std::decay<T>::type;
+    if constexpr (std::is_same<U, bool>::value) {
+        out.append(value ? std::string_view("true") : std::string_view("false"));
+    } else if constexpr (std::is_same<U, char>::value) {
+        out.append(&value, 1);
+    } else if constexpr (std::is_integral<U>::value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, static_cast<size_t>(result.ptr - digits));
+    } else if constexpr (std::is_enum<U>::value) {
+        format_value(out, spec, static_cast<typename std::underlying_type<U>::type>(value));
+    } else if constexpr (std::is_floating_point<U>::value) {
+        format_double(out, static_cast<double>(value), spec_precision(spec));
+    } else if constexpr (std::is_pointer<U>::value &&
+                         !std::is_convertible<U, const char*>::value) {
+        format_value(out, spec, reinterpret_cast<uintptr_t>(value));
+    } else {
+        if constexpr (std::is_convertible<U, const char*>::value) {
+            if (value == nullptr) {
+                out.append(std::string_view("(null)"));
+                return;
+            }
         }
-        log_file_.open(filename, std::ios::app);
+        out.append(std::string_view(value));
     }
+}
 
-    void log(Level level, const std::string& message) {
-        if (level < level_) {
+/* Copy literal text, turning "{{" and "}}" into braces */
+inline void format_literal(FormatBuffer& out, std::string_view text) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t brace = text.find_first_of("{}", pos);
+        if (brace == std::string_view::npos || brace + 1 >= text.size() ||
+            text[brace + 1] != text[brace]) {
+            out.append(text.substr(pos));
             return;
         }
+        out.append(text.substr(pos, brace + 1 - pos));
+        pos = brace + 2;
+    }
+}
+
+inline void format_to(FormatBuffer& out, std::string_view fmt) {
+    format_literal(out, fmt);
+}
 
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()) % 1000;
-
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-        ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
-        
-        std::string level_str;
-        switch (level) {
-            case Level::DEBUG: level_str = "DEBUG"; break;
-            case Level::INFO:  level_str = "INFO "; break;
-            case Level::WARN:  level_str = "WARN "; break;
-            case Level::ERROR: level_str = "ERROR"; break;
+template <typename T, typename... Rest>
+void format_to(FormatBuffer& out, std::string_view fmt, const T& value, const Rest&... rest) {
+    // Find the next "{...}" that is not an escaped "{{"
+    size_t open = 0;
+    while (true) {
+        open = fmt.find('{', open);
+        if (open == std::string_view::npos) {
+            format_literal(out, fmt);   // Surplus arguments are ignored
+            return;
+        }
+        if (open + 1 < fmt.size() && fmt[open + 1] == '{') {
+            open += 2;
+            continue;
         }
+        break;
+    }
+    size_t close = fmt.find('}', open);
+    if (close == std::string_view::npos) {
+        format_literal(out, fmt);
+        return;
+    }
 
-        std::string log_line = "[" + ss.str() + "] [" + level_str + "] " + message;
+    format_literal(out, fmt.substr(0, open));
+    format_value(out, fmt.substr(open + 1, close - open - 1), value);
+    format_to(out, fmt.substr(close + 1), rest...);
+}
 
-        // Output to console
-        std::cout << log_line << std::endl;
+} // namespace detail
 
-        // Output to file if open
-        if (log_file_.is_open()) {
-            log_file_ << log_line << std::endl;
-            log_file_.flush();
-        }
+/* Format into a std::string, e.g. format("{} KB", size_kb) */
+template <typename... Args>
+std::string format(std::string_view fmt, const Args&... args) {
+    char text[1024];
+    detail::FormatBuffer out(text, sizeof(text));
+    detail::format_to(out, fmt, args...);
+    return std::string(text, out.size());
+}
+
+/* Logger counters */
+struct LoggerStats {
+    uint64_t enqueued;      // Records accepted into the ring
+    uint64_t written;       // Records written by the background thread
+    uint64_t dropped;       // Records lost because the ring was full
+    uint64_t truncated;     // Records cut to fit a slot
+};
+
+class Logger {
+public:
+    /* Ring geometry: 4096 slots of 512 bytes */
+    static constexpr size_t kQueueSlots = 4096;
+    static constexpr size_t kMaxMessageBytes = 512 - 32;
+
+    static Logger& instance();
+
+    void set_level(Level level) {
+        level_.store(level, std::memory_order_relaxed);
     }
 
-private:
-    Logger() : level_(Level::INFO) {}
-    ~Logger() {
-        if (log_file_.is_open()) {
-            log_file_.close();
+    Level level() const {
+        return level_.load(std::memory_order_relaxed);
+    }
+
+    bool enabled(Level level) const {
+        return level >= level_.load(std::memory_order_relaxed);
+    }
+
+    /* Also append log lines to filename */
+    void set_log_file(const std::string& filename);
+
+    /* Enqueue one record; never blocks */
+    void log(Level level, const std::string& message);
+
+    /* Enqueue one record formatted in place from a "{}" format string */
+    template <typename... Args>
+    void logf(Level level, std::string_view fmt, const Args&... args) {
+        if (!enabled(level)) {
+            return;
+        }
+        Slot* slot = claim();
+        if (slot == nullptr) {
+            return;
         }
+        detail::FormatBuffer out(slot->text, kMaxMessageBytes);
+        detail::format_to(out, fmt, args...);
+        publish(slot, level, out.size(), out.truncated());
     }
 
-    Level level_;
-    std::mutex mutex_;
-    std::ofstream log_file_;
+    /* Block until everything enqueued so far has been written */
+    void flush();
+
+    /* Counters */
+    LoggerStats get_stats() const;
+
+private:
+    Logger();
+    ~Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        uint64_t position;
+        Level level;
+        uint32_t length;
+        int64_t timestamp_ms;
+        char text[kMaxMessageBytes];
+    };
+
+    std::atomic<Level> level_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<uint64_t> head_;        // Next slot producers claim
+    alignas(64) uint64_t tail_;                     // Next slot the writer reads
+    alignas(64) std::atomic<uint64_t> written_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> truncated_;
+    std::atomic<bool> writer_waiting_;
+    std::atomic<bool> running_;
+
+    // Writer-side state; producers never take these
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::mutex file_mutex_;
+    std::FILE* log_file_;
+    std::thread writer_;
+
+    /* Internal helpers */
+    Slot* claim();
+    void publish(Slot* slot, Level level, size_t length, bool truncated);
+    void writer_loop();
+    size_t drain(std::string& batch);
+    void write_batch(const std::string& batch);
 };
 
 inline void debug(const std::string& message) {
@@ -111,5 +287,41 @@ inline void error(const std::string& message) {
 } // namespace log
 } // namespace nymph
 
-#endif // NYMPH_LOGGER_HPP
+/* Log with a "{}" format string; arguments are not evaluated when filtered */
+#define NYMPH_LOG_AT(level, ...)                                               \
+    do {                                                                       \
+        ::nymph::log::Logger& nymph_logger_ = ::nymph::log::Logger::instance();\
+        if (nymph_logger_.enabled(level)) {                                    \
+            nymph_logger_.logf(level, __VA_ARGS__);                            \
+        }                                                                      \
+    } while (0)
+
+/* Compiled-out call: still type-checked, never evaluated */
+#define NYMPH_LOG_DISABLED(level, ...)                                         \
+    do {                                                                       \
+        if (false) {                                                           \
+            NYMPH_LOG_AT(level, __VA_ARGS__);                                  \
+        }                                                                      \
+    } while (0)
+
+#if NYMPH_LOG_MIN_LEVEL <= 0
+#define NYMPH_LOG_DEBUG(...) NYMPH_LOG_AT(::nymph::log::Level::DEBUG, __VA_ARGS__)
+#else
+#define NYMPH_LOG_DEBUG(...) NYMPH_LOG_DISABLED(::nymph::log::Level::DEBUG, __VA_ARGS__)
+#endif
+
+#if NYMPH_LOG_MIN_LEVEL <= 1
+#define NYMPH_LOG_INFO(...) NYMPH_LOG_AT(::nymph::log::Level::INFO, __VA_ARGS__)
+#else
+#define NYMPH_LOG_INFO(...) NYMPH_LOG_DISABLED(::nymph::log::Level::INFO, __VA_ARGS__)
+#endif
 
+#if NYMPH_LOG_MIN_LEVEL <= 2
+#define NYMPH_LOG_WARN(...) NYMPH_LOG_AT(::nymph::log::Level::WARN, __VA_ARGS__)
+#else
+#define NYMPH_LOG_WARN(...) NYMPH_LOG_DISABLED(::nymph::log::Level::WARN, __VA_ARGS__)
+#endif
+
+#define NYMPH_LOG_ERROR(...) NYMPH_LOG_AT(::nymph::log::Level::ERROR, __VA_ARGS__)
+
+#endif // NYMPH_LOGGER_HPP
@@ -0,0 +1,153 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Metrics
+ *
+ * Counters and latency histograms that request threads update without
+ * locks. Every metric is split into shards, each on its own cache line, and
+ * a thread always writes the same shard; readers sum the shards. Histograms
+ * are HDR-style log-linear: 16 linear sub-buckets per power of two, so any
+ * recorded value is known to within ~6%.
+ *
+ * Output is rendered in the Prometheus text exposition format.
+ */
+
+#ifndef NYMPH_METRICS_HPP
+#define NYMPH_METRICS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace nymph {
+namespace metrics {
+
+/* Shards per metric; threads beyond this share shards */
+const size_t kShards = 16;
+
+/* Shard owned by the calling thread */
+size_t thread_shard();
+
+/* Monotonic counter */
+class Counter {
+public:
+    void add(uint64_t n = 1) {
+        cells_[thread_shard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> value{0};
+    };
+    Cell cells_[kShards];
+};
+
+/* Log-linear histogram of non-negative integer values (nanoseconds here) */
+class Histogram {
+public:
+    static const unsigned kSubBucketBits = 4;
+    static const uint64_t kSubBuckets = 1u << kSubBucketBits;
+    static const unsigned kMaxExponent = 42;     // ~73 minutes in ns
+    static const size_t kBuckets = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+    /* Point-in-time sum over all shards */
+    struct Snapshot {
+        std::vector<uint64_t> counts;
+        uint64_t count;
+        uint64_t sum;
+        uint64_t max;
+
+        /* Smallest bucket upper bound covering fraction q of values */
+        uint64_t quantile(double q) const;
+
+        /* Values known to be <= bound */
+        uint64_t count_at_most(uint64_t bound) const;
+    };
+
+    Histogram();
+
+    void record(uint64_t value);
+    Snapshot snapshot() const;
+
+    /* Bucket geometry */
+    static size_t bucket_index(uint64_t value);
+    static uint64_t bucket_lowest(size_t index);
+    static uint64_t bucket_highest(size_t index);
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> counts[kBuckets];
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+
+        Shard();
+    };
+    std::unique_ptr<Shard[]> shards_;
+};
+
+/* Index into a per-status-class counter array: 1..5 for 1xx..5xx, else 0 */
+inline size_t status_class(int status_code) {
+    return (status_code >= 100 && status_code < 600) ? static_cast<size_t>(status_code / 100) : 0;
+}
+
+/* Per-route request metrics, fed by net::metrics_middleware */
+struct RouteMetrics {
+    std::string route;              // Route label, e.g. "POST /infer"
+    Histogram latency_ns;           // Handler latency
+    Counter responses[6];           // By status class: index 1..5 = 1xx..5xx, 0 = other
+};
+
+/* Per-route metrics storage; entries are created at startup and never move */
+class Registry {
+public:
+    /* Metrics for route, created on first use */
+    RouteMetrics& route(const std::string& label);
+
+    /* All routes, in creation order */
+    std::vector<const RouteMetrics*> routes() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::deque<RouteMetrics> routes_;
+};
+
+Registry& get_metrics_registry();
+
+/* Prometheus text exposition writer */
+class TextWriter {
+public:
+    /* Start a metric family: "# HELP" and "# TYPE" lines */
+    void family(const std::string& name, const char* type, const char* help);
+
+    /* One sample; labels is pre-rendered ("route=\"/x\""), or empty */
+    void sample(const std::string& name, const std::string& labels, double value);
+    void sample(const std::string& name, const std::string& labels, uint64_t value);
+
+    /* Histogram _bucket/_sum/_count samples; ns values exported as seconds */
+    void latency(const std::string& name, const std::string& labels,
+                 const Histogram::Snapshot& snapshot);
+
+    /* Summary quantile samples (p50/p90/p99/p999) from the fine buckets */
+    void quantiles(const std::string& name, const std::string& labels,
+                   const Histogram::Snapshot& snapshot);
+
+    std::string str() const { return out_.str(); }
+
+private:
+    std::ostringstream out_;
+};
+
+/* Escape a label value for the exposition format */
+std::string label_value(const std::string& value);
+
+} // namespace metrics
+} // namespace nymph
+
+#endif // NYMPH_METRICS_HPP
@@ -9,28 +9,121 @@
 #define NYMPH_API_HPP
 
 #include <string>
+#include <string_view>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace nymph {
+
+namespace net {
+class Router;
+}
+
 namespace api {
 
+/*
+ * Body produced after the handler has returned, e.g. generated tokens.
+ * Any thread may write() and close(); the worker loop that owns the
+ * connection is woken to send what was written, with chunked transfer
+ * encoding, so no thread waits on the client. Once the client is gone,
+ * write() returns false and the producer should stop.
+ */
+class ResponseStream {
+public:
+    /* Queue bytes for the client; false once the client has gone */
+    bool write(std::string_view data);
+
+    /* End the body; later writes are dropped */
+    void close();
+
+    /* Server side: notify is called (under the stream's lock) when there is something to take */
+    void attach(std::function<void()> notify);
+
+    /* Server side: move out what was written; done once closed and drained */
+    std::string take(bool& done);
+
+    /* Server side: the connection closed; stop notifying */
+    void cancel();
+
+private:
+    std::mutex mutex_;
+    std::string pending_;
+    bool closed_ = false;
+    bool cancelled_ = false;
+    bool notified_ = false;     // A wakeup is outstanding; take() clears it
+    std::function<void()> notify_;
+
+    void wake();                // Caller holds mutex_
+};
+
+class DeferredResponse;
+
 /* Response structure for API handlers */
 struct APIResponse {
     int status_code;
     std::string content_type;
     std::string body;
+    std::shared_ptr<ResponseStream> stream;    // Set: body follows through the stream
+    std::shared_ptr<DeferredResponse> deferred; // Set: the whole response follows later
     
-    APIResponse(int code = 200, const std::string& type = "application/json", const std::string& b = "")
-        : status_code(code), content_type(type), body(b) {}
+    // Body is taken by value so formatted JSON can be moved in without a copy
+    APIResponse(int code = 200, std::string type = "application/json", std::string b = std::string())
+        : status_code(code), content_type(std::move(type)), body(std::move(b)) {}
+};
+
+/*
+ * Response completed after the handler has returned, e.g. by a pool
+ * thread or the inference scheduler. Any thread may complete() it once;
+ * the worker loop that owns the connection is woken to send it, and holds
+ * back requests pipelined behind it until then. The completed response
+ * may itself carry a stream.
+ */
+class DeferredResponse {
+public:
+    /* Deliver the response; later calls are dropped. False once the client has gone */
+    bool complete(APIResponse response);
+
+    /* Run hook on the response as it completes (at once if it has); for middleware */
+    void then(std::function<void(APIResponse&)> hook);
+
+    /* The client has gone; the producer may give up */
+    bool cancelled();
+
+    /* Server side: notify is called (under the response's lock) once it is complete */
+    void attach(std::function<void()> notify);
+
+    /* Server side: move out the response; false until it is complete */
+    bool take(APIResponse& response);
+
+    /* Server side: the connection closed; stop notifying */
+    void cancel();
+
+private:
+    std::mutex mutex_;
+    APIResponse response_;
+    bool completed_ = false;
+    bool taken_ = false;
+    bool cancelled_ = false;
+    std::vector<std::function<void(APIResponse&)>> hooks_;
+    std::function<void()> notify_;
 };
 
-/* Request structure */
+/*
+ * Request structure. The views point into the connection's receive buffer
+ * and are only valid for the duration of the handler call.
+ */
 struct APIRequest {
-    std::string method;
-    std::string path;
-    std::string body;
-    std::map<std::string, std::string> headers;
-    std::map<std::string, std::string> params;
+    std::string_view method;
+    std::string_view path;      // Target without the query string
+    std::string_view query;     // Text after '?', empty if none
+    std::string_view version;
+    std::string_view body;
+    std::map<std::string_view, std::string_view> headers;  // Names lower-cased
+    std::map<std::string_view, std::string_view> params;  // Route {param} values
 };
 
 /* API Handler Functions */
@@ -44,9 +137,21 @@ APIResponse api_fabric_verify(const APIRequest& req);
 /* POST /infer - AI inference */
 APIResponse api_infer(const APIRequest& req);
 
+/* GET /models - Registered models, their load state and memory */
+APIResponse api_models(const APIRequest& req);
+
 /* POST /kv/pin - KV cache pinning */
 APIResponse api_kvpin(const APIRequest& req);
 
+/* POST /kv/batch - Several KV pins, unpins, accesses and evictions at once */
+APIResponse api_kv_batch(const APIRequest& req);
+
+/* GET /kv/region/{name} - KV region info */
+APIResponse api_kv_region(const APIRequest& req);
+
+/* POST /kv/region/{name}/prefetch - Read a spilled region back ahead of use */
+APIResponse api_kv_prefetch(const APIRequest& req);
+
 /* POST /squantum/run - Quantum-inspired optimization */
 APIResponse api_squantum_run(const APIRequest& req);
 
@@ -62,6 +167,18 @@ APIResponse api_vault_update(const APIRequest& req);
 /* POST /ota/rollback - OTA rollback */
 APIResponse api_ota_rollback(const APIRequest& req);
 
+/* GET /debug/trace - Chrome/Perfetto trace dump, ?seconds=N or ?enable=0|1 */
+APIResponse api_debug_trace(const APIRequest& req);
+
+/* GET /metrics - Prometheus text exposition */
+APIResponse api_metrics(const APIRequest& req);
+
+/* Value of key in a query string ("a=1&b=2"); empty if absent */
+std::string_view query_param(std::string_view query, std::string_view key);
+
+/* Register all endpoints above on a router, marking those that may block; after KV spill setup */
+void register_routes(net::Router& router);
+
 } // namespace api
 } // namespace nymph
 
@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Request Router
+ *
+ * Routes are registered once at startup into a trie keyed by path segment.
+ * A segment written as {name} matches any single segment and is exposed to
+ * the handler through APIRequest::params. Middleware wraps handlers; the
+ * chain for each route is composed at registration time, so dispatch is a
+ * trie walk plus one call.
+ *
+ * Routes marked blocking run their handler on a HandlerPool instead of
+ * the worker loop. Their middleware (auth, metrics) still runs on the
+ * worker, so a rejected request never takes a pool slot. The innermost
+ * link of the chain copies the request, queues the handler and returns a
+ * deferred response that the pool thread completes, or 503 when the pool's
+ * queue is full; either passes back out through the middleware. Without a
+ * pool the handler runs inline.
+ */
+
+#ifndef NYMPH_ROUTER_HPP
+#define NYMPH_ROUTER_HPP
+
+#include "nymph_api.hpp"
+#include "handler_pool.hpp"
+#include "metrics.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <cstdint>
+
+namespace nymph {
+namespace net {
+
+/* HTTP methods known to the router */
+enum class Method {
+    GET,
+    POST,
+    PUT,
+    DELETE,
+    PATCH,
+    HEAD,
+    OPTIONS,
+    UNKNOWN
+};
+
+const size_t kMethodCount = static_cast<size_t>(Method::UNKNOWN);
+
+/* Method name conversions */
+Method method_from_string(std::string_view name);
+const char* method_to_string(Method method);
+
+/* Route handler */
+using Handler = std::function<api::APIResponse(const api::APIRequest&)>;
+
+/* Middleware: may inspect the request, short-circuit, or call next(req) */
+using Middleware = std::function<api::APIResponse(const api::APIRequest&, const Handler& next)>;
+
+/* Registered route */
+struct Route {
+    Method method;
+    std::string pattern;                // e.g. "/kv/region/{name}"
+    std::string label;                  // e.g. "GET /kv/region/{name}", names trace spans
+    std::vector<std::string> param_names;
+    Handler handler;                    // Handler as registered
+    std::vector<Middleware> middleware; // Route-specific middleware
+    Handler chain;                      // Global + route middleware + handler (offloaded if blocking)
+    bool blocking = false;              // May block: the handler runs on the handler pool
+};
+
+/* Trie-backed router */
+class Router {
+public:
+    Router();
+
+    // Composed chains point back at the router
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
+
+    /* Register a route; patterns may contain {param} segments */
+    Router& add(Method method, std::string_view pattern, Handler handler,
+                std::vector<Middleware> middleware = {});
+
+    /* Add middleware that wraps every route (outermost first) */
+    Router& use(Middleware middleware);
+
+    /* Add middleware to an already registered route; false if not found */
+    bool attach(Method method, std::string_view pattern, Middleware middleware);
+
+    /* Mark a registered route as blocking; false if not found */
+    bool set_blocking(Method method, std::string_view pattern);
+
+    /* Pool that runs blocking handlers; must outlive dispatching. Null = run inline */
+    void set_pool(HandlerPool* pool) { pool_ = pool; }
+
+    /*
+     * Find the route for method + path. On a match, params receives the
+     * {param} values as views into path. path_matched is set when the path
+     * exists under some other method.
+     */
+    const Route* find(Method method, std::string_view path,
+                      std::vector<std::pair<std::string_view, std::string_view>>& params,
+                      bool& path_matched) const;
+
+    /* Route a request: 404 for unknown paths, 405 for unknown methods */
+    api::APIResponse dispatch(api::APIRequest& req) const;
+
+    /* All registered routes, in registration order */
+    std::vector<const Route*> routes() const;
+
+private:
+    struct Node {
+        std::vector<std::pair<std::string, uint32_t>> children;  // Static segments
+        uint32_t param_child;                                    // {param} segment
+        int32_t routes[kMethodCount];                            // Route index per method
+
+        Node();
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<std::unique_ptr<Route>> routes_;
+    std::vector<Middleware> global_middleware_;
+    HandlerPool* pool_ = nullptr;
+
+    /* Internal helpers */
+    void compose(Route& route) const;
+    api::APIResponse offload(const Route& route, const api::APIRequest& req) const;
+    static const uint32_t kNoChild = 0xFFFFFFFFu;
+};
+
+/* Middleware that logs method, path, status and handler time at DEBUG */
+Middleware timing_middleware();
+
+/* Middleware that records handler latency and status class into metrics */
+Middleware metrics_middleware(metrics::RouteMetrics& metrics);
+
+/* Middleware that requires "Authorization: Bearer <token>" (401 otherwise) */
+Middleware bearer_auth_middleware(const std::string& token);
+
+} // namespace net
+} // namespace nymph
+
+#endif // NYMPH_ROUTER_HPP
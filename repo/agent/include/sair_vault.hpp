@@ -16,6 +16,7 @@
 #define NYMPH_SAIR_VAULT_HPP
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 #include <cstdint>
@@ -135,6 +136,8 @@ private:
     mutable std::mutex mutex_;
 
     /* Internal helpers */
+    AttestationResult attest_locked(const std::string& artifact_path, ArtifactType type,
+                                    const std::string& expected_hash);   // Caller holds mutex_
     std::string compute_hash(const std::string& filepath) const;
     std::string read_board_id() const;
     bool check_manifest(const std::string& artifact_id, 
@@ -185,10 +188,10 @@ SAIRManager& get_sair_manager();
 VaultManager& get_vault_manager();
 
 /* Helper functions for API integration */
-CapsuleRunRequest parse_capsule_request(const std::string& json_body);
+CapsuleRunRequest parse_capsule_request(std::string_view json_body);
 std::string format_capsule_result(const CapsuleRunResult& result);
 
-OTAUpdateRequest parse_update_request(const std::string& json_body);
+OTAUpdateRequest parse_update_request(std::string_view json_body);
 std::string format_update_result(const OTAUpdateResult& result);
 
 std::string format_rollback_result(const OTARollbackResult& result);
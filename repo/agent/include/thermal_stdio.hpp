@@ -11,11 +11,13 @@
 #define NYMPH_THERMAL_STDIO_HPP
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 #include <cstdint>
 #include <memory>
 #include <mutex>
+#include <atomic>
 
 namespace nymph {
 namespace thermal {
@@ -29,6 +31,8 @@ enum class ThermalZone {
     AMBIENT     // Board ambient
 };
 
+const size_t kThermalZoneCount = 5;
+
 /* Thermal policy modes */
 enum class ThermalPolicy {
     PASSIVE,        // Reduce performance to lower temp
@@ -109,6 +113,21 @@ struct ThermalStats {
     std::vector<double> temp_history;  // Recent temperature readings
 };
 
+/* Latest readings, readable without the manager lock (for /metrics and /status) */
+struct ThermalGauges {
+    bool valid;                 // False until the manager is initialized
+    double hottest_temp_c;      // Hottest zone
+    double target_temp_c;
+    double max_temp_c;
+    double zone_temp_c[kThermalZoneCount];  // Indexed by ThermalZone
+    double power_w;             // Sum over PMBus rails
+    uint8_t fan_pwm;
+    uint16_t fan_rpm;
+    uint64_t throttle_count;
+    uint64_t throttle_time_ms;
+    uint64_t sample_count;
+};
+
 /* Thermal Manager (TAITO/TAPIM) */
 class ThermalManager {
 public:
@@ -142,6 +161,9 @@ public:
     /* Get thermal statistics */
     ThermalStats get_stats() const;
 
+    /* Get latest readings without taking the manager lock */
+    ThermalGauges get_gauges() const;
+
     /* TAITO: Predict thermal trajectory */
     double predict_temperature(uint64_t time_ahead_ms) const;
 
@@ -174,6 +196,22 @@ private:
     
     // Thread safety
     mutable std::mutex mutex_;
+
+    // Mirrors of the readings, written under mutex_ and read without it
+    struct AtomicGauges {
+        std::atomic<bool> valid{false};
+        std::atomic<double> hottest_temp_c{0.0};
+        std::atomic<double> target_temp_c{0.0};
+        std::atomic<double> max_temp_c{0.0};
+        std::atomic<double> zone_temp_c[kThermalZoneCount];
+        std::atomic<double> power_w{0.0};
+        std::atomic<uint8_t> fan_pwm{0};
+        std::atomic<uint16_t> fan_rpm{0};
+        std::atomic<uint64_t> throttle_count{0};
+        std::atomic<uint64_t> throttle_time_ms{0};
+        std::atomic<uint64_t> sample_count{0};
+    };
+    AtomicGauges gauges_;
     
     // Internal helpers
     uint64_t get_current_time() const;
@@ -182,15 +220,20 @@ private:
     void update_stats(double temp);
     std::string thermal_zone_name(ThermalZone zone) const;
     ThermalZone thermal_zone_from_name(const std::string& name) const;
+    double hottest_temp() const;
+    void publish_gauges();      // Caller holds mutex_
 };
 
 /* Global Thermal Manager instance */
 ThermalManager& get_thermal_manager();
 
 /* Helper functions for API integration */
-ThermalScheduleRequest parse_thermal_request(const std::string& json_body);
+ThermalScheduleRequest parse_thermal_request(std::string_view json_body);
 std::string format_thermal_result(const ThermalScheduleResult& result);
 
+/* Zone display name ("SoC", "VRM", ...) */
+const char* zone_to_string(ThermalZone zone);
+
 /* Policy name conversions */
 std::string policy_to_string(ThermalPolicy policy);
 ThermalPolicy policy_from_string(const std::string& name);
@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 In-Process Request Tracing
+ *
+ * Scoped spans are recorded into a fixed ring per thread; the ring keeps
+ * the most recent events and is read out on demand as Chrome trace-event
+ * JSON, which Perfetto and chrome://tracing load directly. A thread that
+ * exits hands its ring to the next new thread. Tracing is off by default;
+ * a disabled span costs one relaxed atomic load.
+ *
+ * Span names and categories must be string literals (or otherwise live for
+ * the whole process): only the pointers are stored.
+ */
+
+#ifndef NYMPH_TRACE_HPP
+#define NYMPH_TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+namespace nymph {
+namespace trace {
+
+namespace detail {
+extern std::atomic<bool> g_enabled;
+uint64_t now_ns();
+void record(const char* name, const char* category, uint64_t start_ns, uint64_t end_ns);
+} // namespace detail
+
+/* Events kept per thread before the oldest are overwritten */
+const size_t kEventsPerThread = 16384;
+
+/* Runtime switch */
+inline bool enabled() {
+    return detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+void set_enabled(bool enabled);
+
+/* Label the calling thread in trace output (e.g. "http-worker-0") */
+void set_thread_name(const std::string& name);
+
+/*
+ * Chrome trace-event JSON of every span that ended within the last
+ * window_ms milliseconds (0 = everything still in the rings).
+ */
+std::string export_chrome_json(uint64_t window_ms);
+
+/* Counters */
+struct TraceStats {
+    bool enabled;
+    uint64_t recorded;      // Spans recorded since start
+    uint64_t threads;       // Live threads holding a ring
+    uint64_t rings;         // Rings allocated; exited threads' rings are reused
+};
+
+TraceStats get_trace_stats();
+
+/* RAII span: records [construction, destruction) when tracing is on */
+class Span {
+public:
+    explicit Span(const char* name, const char* category = "nymph")
+        : name_(name), category_(category), start_ns_(0) {
+        if (enabled()) {
+            start_ns_ = detail::now_ns();
+        }
+    }
+
+    ~Span() {
+        if (start_ns_ != 0) {
+            detail::record(name_, category_, start_ns_, detail::now_ns());
+        }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* name_;
+    const char* category_;
+    uint64_t start_ns_;
+};
+
+/* Lock mutex, recording the time spent waiting as a span */
+template <typename Mutex>
+std::unique_lock<Mutex> timed_lock(Mutex& mutex, const char* name) {
+    if (!enabled()) {
+        return std::unique_lock<Mutex>(mutex);
+    }
+    Span span(name, "lock");
+    return std::unique_lock<Mutex>(mutex);
+}
+
+/* Shared (reader) counterpart of timed_lock */
+template <typename Mutex>
+std::shared_lock<Mutex> timed_shared_lock(Mutex& mutex, const char* name) {
+    if (!enabled()) {
+        return std::shared_lock<Mutex>(mutex);
+    }
+    Span span(name, "lock");
+    return std::shared_lock<Mutex>(mutex);
+}
+
+} // namespace trace
+} // namespace nymph
+
+#define NYMPH_TRACE_CONCAT_INNER(a, b) a##b
+#define NYMPH_TRACE_CONCAT(a, b) NYMPH_TRACE_CONCAT_INNER(a, b)
+
+/* Trace the rest of the enclosing scope */
+#define NYMPH_TRACE_SCOPE(...) \
+    ::nymph::trace::Span NYMPH_TRACE_CONCAT(nymph_trace_span_, __LINE__)(__VA_ARGS__)
+
+#endif // NYMPH_TRACE_HPP
@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: MIT
+#
+# Writes tiny-next-byte.onnx, the model the ONNX Runtime backend is
+# checked with: byte ids in (input_ids, int64 [batch, sequence]), scores
+# for the next byte out (logits, float [batch, 256]). The next byte is
+# always the last one plus one, so greedy decoding of "a" gives "bcd..."
+# and stops at byte 0 (EOS) after 255.
+#
+# Usage: python3 make_tiny_model.py [OUTPUT]   (needs the onnx package)
+
+import sys
+
+import onnx
+from onnx import TensorProto, helper
+
+
+def main():
+    path = sys.argv[1] if len(sys.argv) > 1 else "tiny-next-byte.onnx"
+    const = lambda name, dtype, dims, values: helper.make_tensor(name, dtype, dims, values)
+    nodes = [
+        helper.make_node("Slice", ["input_ids", "starts", "ends", "axes"], ["last"]),
+        helper.make_node("Add", ["last", "one"], ["next_raw"]),
+        helper.make_node("Mod", ["next_raw", "vocab"], ["next"]),
+        helper.make_node("OneHot", ["next", "depth", "on_off"], ["hot"], axis=-1),
+        helper.make_node("Reshape", ["hot", "logits_shape"], ["logits"]),
+    ]
+    graph = helper.make_graph(
+        nodes,
+        "tiny_next_byte",
+        [helper.make_tensor_value_info("input_ids", TensorProto.INT64, ["batch", "sequence"])],
+        [helper.make_tensor_value_info("logits", TensorProto.FLOAT, ["batch", 256])],
+        initializer=[
+            const("starts", TensorProto.INT64, [1], [-1]),
+            const("ends", TensorProto.INT64, [1], [2**62]),
+            const("axes", TensorProto.INT64, [1], [1]),
+            const("one", TensorProto.INT64, [], [1]),
+            const("vocab", TensorProto.INT64, [], [256]),
+            const("depth", TensorProto.INT64, [], [256]),
+            const("on_off", TensorProto.FLOAT, [2], [0.0, 1.0]),
+            const("logits_shape", TensorProto.INT64, [2], [-1, 256]),
+        ],
+    )
+    model = helper.make_model(graph, producer_name="nymph", opset_imports=[helper.make_opsetid("", 13)])
+    model.ir_version = 7
+    onnx.checker.check_model(model)
+    onnx.save(model, path)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,507 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Inference Batching Scheduler Implementation
+ */
+
+#include "ai_batch.hpp"
+#include "kvpin.hpp"
+#include "logger.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <future>
+
+namespace nymph {
+namespace ai {
+
+/* A queued request. run() keeps it on its stack; stream() allocates it
+ * and deliver() frees it */
+struct InferenceScheduler::Pending {
+    const InferenceRequest* request;
+    std::chrono::steady_clock::time_point enqueued;
+    std::promise<InferenceResult> result;           // run()
+    std::shared_ptr<TokenSink> sink;                // stream()
+    InferenceRequest owned;                         // stream(): what request points to
+};
+
+/* A sequence in the ITERATION batch; owned by the decode loop */
+struct InferenceScheduler::Sequence {
+    Pending* pending;
+    GenerationSequence generation;
+    std::string region;                             // KV region, "infer/<model>/<n>"
+    std::chrono::steady_clock::time_point joined;
+    std::chrono::steady_clock::time_point first_token;
+    std::chrono::steady_clock::time_point last_token;
+    double max_gap_ms = 0.0;                        // Longest wait between two tokens
+    size_t sent = 0;                                // Bytes of text given to the sink
+};
+
+bool batch_mode_from_string(const std::string& name, BatchMode& mode) {
+    if (name == "request") {
+        mode = BatchMode::REQUEST;
+    } else if (name == "iteration") {
+        mode = BatchMode::ITERATION;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* batch_mode_to_string(BatchMode mode) {
+    return mode == BatchMode::ITERATION ? "iteration" : "request";
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count() / 1000.0;
+}
+
+static uint64_t elapsed_ns(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+
+static InferenceResult failed_result(const std::string& message) {
+    InferenceResult failed;
+    failed.success = false;
+    failed.latency_ms = 0.0;
+    failed.energy_wh = 0.0;
+    failed.error_message = message;
+    return failed;
+}
+
+InferenceScheduler::InferenceScheduler(ONNXRuntime& runtime, kv::KVCacheManager& kv_cache)
+    : runtime_(runtime), kv_cache_(kv_cache), next_sequence_(0), stopped_(false), counters_(nullptr) {
+}
+
+InferenceScheduler::~InferenceScheduler() {
+    shutdown();
+    QueueCounters* counters = counters_.load(std::memory_order_acquire);
+    while (counters != nullptr) {
+        QueueCounters* next = counters->next;
+        delete counters;
+        counters = next;
+    }
+}
+
+void InferenceScheduler::configure(const BatchConfig& config) {
+    config_ = config;
+    config_.max_batch = std::max<size_t>(1, config_.max_batch);
+}
+
+static InferenceResult unknown_model(const std::string& model) {
+    return failed_result("Unknown model: " + model);
+}
+
+static InferenceResult not_queued(const std::string& model) {
+    return failed_result("No inference queue for model " + model);
+}
+
+InferenceResult InferenceScheduler::run(const InferenceRequest& request) {
+    if (!runtime_.has_model(request.model_name)) {
+        return unknown_model(request.model_name);
+    }
+    Pending pending;
+    pending.request = &request;
+    std::future<InferenceResult> result = pending.result.get_future();
+    if (!submit(&pending)) {
+        return not_queued(request.model_name);
+    }
+    NYMPH_TRACE_SCOPE("infer.queued", "ai");
+    return result.get();
+}
+
+void InferenceScheduler::stream(InferenceRequest request, std::shared_ptr<TokenSink> sink) {
+    if (!runtime_.has_model(request.model_name)) {
+        sink->on_done(unknown_model(request.model_name));
+        return;
+    }
+    std::unique_ptr<Pending> pending = std::make_unique<Pending>();
+    pending->owned = std::move(request);
+    pending->request = &pending->owned;
+    pending->sink = std::move(sink);
+    if (submit(pending.get())) {
+        pending.release();      // The dispatcher delivers and frees it
+        return;
+    }
+    // Never run on the caller's thread: it is usually a worker loop
+    pending->sink->on_done(not_queued(pending->owned.model_name));
+}
+
+bool InferenceScheduler::enqueue(ModelQueue& queue, Pending* pending) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.stopping || queue.retired) {
+        return false;
+    }
+    pending->enqueued = std::chrono::steady_clock::now();
+    queue.pending.push_back(pending);
+    queue.counters->depth.store(queue.pending.size(), std::memory_order_relaxed);
+    // The first request starts the delay; a full batch ends it early
+    if (queue.pending.size() == 1 || queue.pending.size() >= config_.max_batch) {
+        queue.ready.notify_one();
+    }
+    return true;
+}
+
+void InferenceScheduler::deliver(Pending* pending, InferenceResult result) {
+    if (!pending->sink) {
+        pending->result.set_value(std::move(result));
+        return;
+    }
+    pending->sink->on_done(result);
+    delete pending;
+}
+
+bool InferenceScheduler::submit(Pending* pending) {
+    const std::string& model = pending->request->model_name;
+    {
+        std::shared_lock<std::shared_mutex> lock(queues_mutex_);
+        auto it = queues_.find(model);
+        if (it != queues_.end() && enqueue(*it->second, pending)) {
+            return true;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(queues_mutex_);
+    if (stopped_) {
+        return false;
+    }
+    // Also drops this model's queue if that is why enqueue() failed
+    reap_retired();
+    auto it = queues_.find(model);
+    if (it != queues_.end()) {
+        return enqueue(*it->second, pending);
+    }
+    // Model names come from clients; only models we serve get a thread
+    if (queues_.size() >= kMaxQueues || !runtime_.has_model(model)) {
+        return false;
+    }
+    std::unique_ptr<ModelQueue> queue = std::make_unique<ModelQueue>();
+    queue->model = model;
+    queue->counters = &counters_for(model);
+    ModelQueue& created = *queue;
+    queues_.emplace(model, std::move(queue));
+    if (config_.mode == BatchMode::ITERATION) {
+        created.dispatcher = std::thread(&InferenceScheduler::decode_loop, this, std::ref(created));
+    } else {
+        created.dispatcher = std::thread(&InferenceScheduler::dispatch_loop, this, std::ref(created));
+    }
+    NYMPH_LOG_INFO("Inference batching queue for model {} started ({})", model,
+                   batch_mode_to_string(config_.mode));
+    return enqueue(created, pending);
+}
+
+InferenceScheduler::QueueCounters& InferenceScheduler::counters_for(const std::string& model) {
+    QueueCounters* head = counters_.load(std::memory_order_relaxed);
+    for (QueueCounters* counters = head; counters != nullptr; counters = counters->next) {
+        if (counters->model == model) {
+            return *counters;
+        }
+    }
+    // Queues only exist for served models, so the list stays short
+    QueueCounters* counters = new QueueCounters();
+    counters->model = model;
+    counters->next = head;
+    counters_.store(counters, std::memory_order_release);
+    return *counters;
+}
+
+void InferenceScheduler::reap_retired() {
+    for (auto it = queues_.begin(); it != queues_.end();) {
+        ModelQueue& queue = *it->second;
+        bool retired;
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            retired = queue.retired;
+        }
+        if (!retired) {
+            ++it;
+            continue;
+        }
+        // Set just before the dispatcher returns, so this join is short
+        queue.dispatcher.join();
+        NYMPH_LOG_INFO("Inference batching queue for model {} reclaimed after being idle", queue.model);
+        it = queues_.erase(it);
+    }
+}
+
+bool InferenceScheduler::wait_for_work(ModelQueue& queue, std::unique_lock<std::mutex>& lock) {
+    if (queue.ready.wait_for(lock, kQueueIdleTimeout,
+                             [&queue] { return queue.stopping || !queue.pending.empty(); })) {
+        return true;
+    }
+    // Nothing queued or running; enqueue() refuses from now on
+    queue.retired = true;
+    return false;
+}
+
+void InferenceScheduler::dispatch_loop(ModelQueue& queue) {
+    const auto max_delay = std::chrono::microseconds(config_.max_delay_us);
+    std::vector<Pending*> batch;
+    std::vector<const InferenceRequest*> requests;
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    while (true) {
+        if (!wait_for_work(queue, lock) || queue.pending.empty()) {
+            break;
+        }
+        // Wait for a full batch or for the oldest request's deadline
+        auto deadline = queue.pending.front()->enqueued + max_delay;
+        while (!queue.stopping && queue.pending.size() < config_.max_batch) {
+            if (queue.ready.wait_until(lock, deadline) == std::cv_status::timeout) {
+                break;
+            }
+        }
+
+        size_t count = std::min(queue.pending.size(), config_.max_batch);
+        batch.assign(queue.pending.begin(), queue.pending.begin() + count);
+        queue.pending.erase(queue.pending.begin(), queue.pending.begin() + count);
+        queue.counters->depth.store(queue.pending.size(), std::memory_order_relaxed);
+        lock.unlock();
+
+        auto dispatched = std::chrono::steady_clock::now();
+        requests.clear();
+        for (Pending* pending : batch) {
+            requests.push_back(pending->request);
+            queue.counters->queue_delay_ns.record(elapsed_ns(pending->enqueued, dispatched));
+        }
+        queue.counters->batches.add();
+        queue.counters->requests.add(count);
+        queue.counters->batch_size.record(count);
+
+        std::vector<InferenceResult> results;
+        try {
+            results = runtime_.run_batch(requests);
+        } catch (const std::exception& e) {
+            NYMPH_LOG_ERROR("Batch of {} for model {} failed: {}", count, queue.model, e.what());
+        }
+        // The whole output comes at once, so it is also the first token
+        auto done = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++) {
+            Pending* pending = batch[i];
+            if (i >= results.size()) {
+                deliver(pending, failed_result("Batched inference failed"));
+                continue;
+            }
+            InferenceResult& result = results[i];
+            if (result.success) {
+                double first_token_ms = elapsed_ms(pending->enqueued, done);
+                result.metrics["first_token_ms"] = first_token_ms;
+                queue.counters->first_token_ns.record(elapsed_ns(pending->enqueued, done));
+                if (pending->sink) {
+                    pending->sink->on_token(result.output, 0, first_token_ms);
+                }
+            }
+            deliver(pending, std::move(result));
+        }
+        lock.lock();
+    }
+}
+
+bool InferenceScheduler::reserve_kv(Sequence& sequence) {
+    const GenerationSequence& generation = sequence.generation;
+    kv::KVPinRequest pin;
+    pin.region = sequence.region;
+    pin.size_kb = (static_cast<uint64_t>(generation.prompt_tokens) + generation.max_tokens) *
+                  config_.kv_kb_per_token;
+    pin.force = false;
+    pin.priority = 0;
+    return kv_cache_.pin_region(pin).success;
+}
+
+void InferenceScheduler::release_kv(const Sequence& sequence) {
+    std::vector<kv::KVOp> ops(2);
+    ops[0].type = kv::KVOpType::UNPIN;
+    ops[1].type = kv::KVOpType::EVICT;
+    for (kv::KVOp& op : ops) {
+        op.pin.region = sequence.region;
+        op.pin.size_kb = 0;
+        op.pin.force = false;
+        op.pin.priority = 0;
+        op.is_read = true;
+        op.offset_kb = kv::KVCacheManager::kWholeRegion;
+    }
+    kv_cache_.apply_batch(ops, false);
+}
+
+void InferenceScheduler::decode_loop(ModelQueue& queue) {
+    std::vector<std::unique_ptr<Sequence>> running;
+    std::vector<Pending*> joining;
+    std::vector<GenerationSequence*> step;
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    while (true) {
+        if (running.empty()) {
+            if (!wait_for_work(queue, lock) || queue.pending.empty()) {
+                break;
+            }
+        }
+        // Waiting sequences join at this step; nobody waits for a full batch
+        size_t count = std::min(queue.pending.size(), config_.max_batch - running.size());
+        joining.assign(queue.pending.begin(), queue.pending.begin() + count);
+        queue.pending.erase(queue.pending.begin(), queue.pending.begin() + count);
+        queue.counters->depth.store(queue.pending.size(), std::memory_order_relaxed);
+        lock.unlock();
+
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < joining.size(); i++) {
+            Pending* pending = joining[i];
+            std::unique_ptr<Sequence> sequence = std::make_unique<Sequence>();
+            sequence->pending = pending;
+            GenerationSequence& generation = sequence->generation;
+            generation.request = pending->request;
+            generation.prompt_tokens = count_prompt_tokens(*pending->request);
+            generation.max_tokens = pending->request->max_tokens > 0 ? pending->request->max_tokens
+                                                                     : kDefaultMaxTokens;
+            sequence->region = "infer/" + queue.model + "/" + std::to_string(next_sequence_.fetch_add(1));
+            if (!reserve_kv(*sequence)) {
+                if (running.empty()) {
+                    // Nothing of ours will end and free room; don't wait forever
+                    deliver(pending, failed_result("KV cache has no room for the sequence"));
+                    continue;
+                }
+                // Wait for a running sequence to end; keep arrival order
+                lock.lock();
+                queue.pending.insert(queue.pending.begin(), joining.begin() + i, joining.end());
+                queue.counters->depth.store(queue.pending.size(), std::memory_order_relaxed);
+                lock.unlock();
+                break;
+            }
+            sequence->joined = now;
+            queue.counters->queue_delay_ns.record(elapsed_ns(pending->enqueued, now));
+            queue.counters->requests.add();
+            running.push_back(std::move(sequence));
+        }
+        queue.counters->running.store(running.size(), std::memory_order_relaxed);
+        if (running.empty()) {
+            lock.lock();
+            continue;
+        }
+
+        step.clear();
+        for (const std::unique_ptr<Sequence>& sequence : running) {
+            step.push_back(&sequence->generation);
+        }
+        double step_ms = -1.0;
+        try {
+            step_ms = runtime_.run_decode_step(step);
+        } catch (const std::exception& e) {
+            NYMPH_LOG_ERROR("Decode step of {} for model {} failed: {}", step.size(), queue.model, e.what());
+        }
+        queue.counters->batches.add();
+        queue.counters->batch_size.record(step.size());
+
+        now = std::chrono::steady_clock::now();
+        size_t kept = 0;
+        for (size_t i = 0; i < running.size(); i++) {
+            Sequence& sequence = *running[i];
+            GenerationSequence& generation = sequence.generation;
+            if (step_ms < 0.0) {
+                release_kv(sequence);
+                deliver(sequence.pending, failed_result("Decode step failed"));
+                continue;
+            }
+            if (generation.generated == 1) {
+                sequence.first_token = now;
+                queue.counters->first_token_ns.record(elapsed_ns(sequence.pending->enqueued, now));
+            } else {
+                sequence.max_gap_ms = std::max(sequence.max_gap_ms, elapsed_ms(sequence.last_token, now));
+            }
+            sequence.last_token = now;
+            // The new token's keys and values are written into the region
+            kv_cache_.access_region(sequence.region, false,
+                                    (generation.prompt_tokens + generation.generated - 1) * config_.kv_kb_per_token);
+            const std::shared_ptr<TokenSink>& sink = sequence.pending->sink;
+            if (sink && generation.text.size() > sequence.sent) {
+                bool wanted = sink->on_token(generation.text.substr(sequence.sent), generation.generated - 1,
+                                             elapsed_ms(sequence.pending->enqueued, now));
+                sequence.sent = generation.text.size();
+                if (!wanted) {
+                    // The client went away; stop generating for it
+                    release_kv(sequence);
+                    deliver(sequence.pending, failed_result("Stream cancelled"));
+                    continue;
+                }
+            }
+            if (!generation.finished) {
+                running[kept++] = std::move(running[i]);
+                continue;
+            }
+
+            // Finished: its place and its KV go to the next sequence at once
+            release_kv(sequence);
+            InferenceResult result = runtime_.finish_sequence(generation);
+            const Pending& pending = *sequence.pending;
+            result.latency_ms = elapsed_ms(pending.enqueued, now);
+            result.metrics["queue_ms"] = elapsed_ms(pending.enqueued, sequence.joined);
+            result.metrics["first_token_ms"] = elapsed_ms(pending.enqueued, sequence.first_token);
+            double decode_ms = elapsed_ms(sequence.first_token, now);
+            if (generation.generated > 1) {
+                result.metrics["time_per_token_ms"] = decode_ms / (generation.generated - 1);
+                result.metrics["max_token_gap_ms"] = sequence.max_gap_ms;
+            }
+            result.metrics["tokens_per_s"] = generation.generated / (elapsed_ms(sequence.joined, now) / 1000.0);
+            deliver(sequence.pending, std::move(result));
+        }
+        if (step_ms >= 0.0) {
+            queue.counters->tokens.add(step.size());
+        } else {
+            kept = 0;
+        }
+        running.resize(kept);
+        queue.counters->running.store(running.size(), std::memory_order_relaxed);
+        lock.lock();
+    }
+}
+
+std::vector<BatchQueueStats> InferenceScheduler::get_stats() const {
+    std::vector<BatchQueueStats> stats;
+    for (const QueueCounters* counters = counters_.load(std::memory_order_acquire); counters != nullptr;
+         counters = counters->next) {
+        BatchQueueStats queue_stats;
+        queue_stats.model = counters->model;
+        queue_stats.batches = counters->batches.value();
+        queue_stats.requests = counters->requests.value();
+        queue_stats.tokens = counters->tokens.value();
+        queue_stats.depth = counters->depth.load(std::memory_order_relaxed);
+        queue_stats.running = counters->running.load(std::memory_order_relaxed);
+        queue_stats.queue_delay_ns = counters->queue_delay_ns.snapshot();
+        queue_stats.batch_size = counters->batch_size.snapshot();
+        queue_stats.first_token_ns = counters->first_token_ns.snapshot();
+        stats.push_back(std::move(queue_stats));
+    }
+    std::sort(stats.begin(), stats.end(),
+              [](const BatchQueueStats& a, const BatchQueueStats& b) { return a.model < b.model; });
+    return stats;
+}
+
+void InferenceScheduler::shutdown() {
+    std::unique_lock<std::shared_mutex> lock(queues_mutex_);
+    if (stopped_) {
+        return;
+    }
+    stopped_ = true;
+    for (auto& entry : queues_) {
+        ModelQueue& queue = *entry.second;
+        {
+            std::lock_guard<std::mutex> queue_lock(queue.mutex);
+            queue.stopping = true;
+        }
+        queue.ready.notify_one();
+    }
+    for (auto& entry : queues_) {
+        if (entry.second->dispatcher.joinable()) {
+            entry.second->dispatcher.join();
+        }
+    }
+}
+
+/* Global scheduler instance */
+static std::unique_ptr<InferenceScheduler> g_inference_scheduler = nullptr;
+static std::once_flag g_inference_scheduler_once;
+
+InferenceScheduler& get_inference_scheduler() {
+    std::call_once(g_inference_scheduler_once, [] {
+        g_inference_scheduler = std::make_unique<InferenceScheduler>(get_onnx_runtime(),
+                                                                     kv::get_kv_cache_manager());
+    });
+    return *g_inference_scheduler;
+}
+
+} // namespace ai
+} // namespace nymph
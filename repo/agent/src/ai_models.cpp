@@ -0,0 +1,375 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Model Registry Implementation
+ */
+
+#include "ai_models.hpp"
+#include "logger.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nymph {
+namespace ai {
+
+/* Resident set of the process, from /proc/self/statm; 0 if unavailable */
+static uint64_t resident_set_bytes() {
+    std::FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr) {
+        return 0;
+    }
+    unsigned long long size_pages = 0;
+    unsigned long long resident_pages = 0;
+    int fields = std::fscanf(statm, "%llu %llu", &size_pages, &resident_pages);
+    std::fclose(statm);
+    return fields == 2 ? resident_pages * static_cast<uint64_t>(::sysconf(_SC_PAGESIZE)) : 0;
+}
+
+static double megabytes(uint64_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+LoadedModel::~LoadedModel() {
+    session.reset();
+    if (data != nullptr) {
+        ::munmap(const_cast<unsigned char*>(data), size);
+    }
+}
+
+const char* model_state_to_string(ModelState state) {
+    switch (state) {
+        case ModelState::LOADED: return "loaded";
+        case ModelState::FAILED: return "failed";
+        default: return "not_loaded";
+    }
+}
+
+ModelRegistry::ModelRegistry()
+    : budget_bytes_(0), resident_bytes_(0), loads_(0), unloads_(0), load_failures_(0)
+    , published_(nullptr), published_budget_(0), published_resident_(0), published_failures_(0) {
+}
+
+ModelRegistry::~ModelRegistry() {
+    Published* published = published_.load(std::memory_order_acquire);
+    while (published != nullptr) {
+        Published* next = published->next;
+        delete published;
+        published = next;
+    }
+}
+
+void ModelRegistry::set_loader(Loader loader) {
+    loader_ = std::move(loader);
+}
+
+void ModelRegistry::set_budget(uint64_t budget_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_bytes_ = budget_bytes;
+    make_room(0, nullptr);
+    publish_totals();
+}
+
+bool ModelRegistry::add(const std::string& name, const std::string& path) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) {
+        NYMPH_LOG_ERROR("Model {}: cannot stat {}: {}", name, path, std::strerror(errno));
+        return false;
+    }
+    if (!S_ISREG(info.st_mode) || info.st_size == 0) {
+        NYMPH_LOG_ERROR("Model {}: {} is not a non-empty file", name, path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[name];
+    if (entry.model) {
+        unload_entry(entry);
+    }
+    entry.name = name;
+    entry.path = path;
+    entry.file_bytes = static_cast<uint64_t>(info.st_size);
+    entry.state = ModelState::UNLOADED;
+    if (entry.published == nullptr) {
+        entry.published = new Published();
+        entry.published->name = name;
+        entry.published->next = published_.load(std::memory_order_relaxed);
+        published_.store(entry.published, std::memory_order_release);
+    }
+    publish(entry);
+    return true;
+}
+
+bool ModelRegistry::contains(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.find(name) != entries_.end();
+}
+
+std::shared_ptr<LoadedModel> ModelRegistry::acquire(const std::string& name, bool* registered) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    if (registered != nullptr) {
+        *registered = it != entries_.end();
+    }
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+    Entry& entry = it->second;
+
+    // Another request may be loading it already
+    bool waited = false;
+    while (entry.loading) {
+        load_done_.wait(lock);
+        waited = true;
+    }
+    if (entry.model) {
+        touch(entry);
+        return entry.model;
+    }
+    if (waited && entry.state == ModelState::FAILED) {
+        return nullptr;     // That load just failed; don't retry for every waiter
+    }
+    entry.loading = true;
+    std::string path = entry.path;
+    uint64_t file_bytes = entry.file_bytes;
+    lock.unlock();
+
+    NYMPH_TRACE_SCOPE("models.load", "ai");
+    std::unique_lock<std::mutex> load_lock(load_mutex_);
+    {
+        // Make room for at least the file before it is mapped
+        std::lock_guard<std::mutex> room_lock(mutex_);
+        make_room(file_bytes, &entry);
+    }
+    auto started = std::chrono::steady_clock::now();
+    uint64_t resident_before = resident_set_bytes();
+    std::string error;
+    std::shared_ptr<LoadedModel> model = load(name, path, error);
+    uint64_t resident_after = resident_set_bytes();
+    double load_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started).count() / 1000.0;
+    load_lock.unlock();
+
+    lock.lock();
+    entry.loading = false;
+    load_done_.notify_all();
+    if (!model) {
+        entry.state = ModelState::FAILED;
+        load_failures_++;
+        publish_totals();
+        lock.unlock();
+        NYMPH_LOG_ERROR("Model {} failed to load from {}: {}", name, path, error);
+        return nullptr;
+    }
+    uint64_t growth = resident_after > resident_before ? resident_after - resident_before : 0;
+    entry.model = model;
+    entry.state = ModelState::LOADED;
+    // Without a session, the mapping is all there is; with one, what the
+    // runtime built as well (anything else allocated meanwhile too)
+    entry.resident_bytes = model->session ? std::max<uint64_t>(model->size, growth) : model->size;
+    entry.loads++;
+    loads_++;
+    resident_bytes_ += entry.resident_bytes;
+    lru_.push_front(&entry);
+    entry.lru = lru_.begin();
+    touch(entry);
+    // It may have come out larger than its file
+    make_room(0, &entry);
+    publish(entry);
+    uint64_t resident = entry.resident_bytes;
+    uint64_t resident_total = resident_bytes_;
+    uint64_t budget = budget_bytes_;
+    lock.unlock();
+
+    NYMPH_LOG_INFO("Model {} loaded in {:.1f} ms: {:.1f} MB resident, {:.1f} of {:.1f} MB budget in use", name,
+                   load_ms, megabytes(resident), megabytes(resident_total), megabytes(budget));
+    if (budget > 0 && resident > budget) {
+        NYMPH_LOG_WARN("Model {} alone exceeds the {:.1f} MB model budget", name, megabytes(budget));
+    }
+    return model;
+}
+
+std::shared_ptr<LoadedModel> ModelRegistry::load(const std::string& name, const std::string& path,
+                                                 std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = std::string("open: ") + std::strerror(errno);
+        return nullptr;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+        error = "empty or unreadable file";
+        ::close(fd);
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);    // The mapping keeps the file
+    if (mapped == MAP_FAILED) {
+        error = std::string("mmap: ") + std::strerror(errno);
+        return nullptr;
+    }
+
+    std::shared_ptr<LoadedModel> model = std::make_shared<LoadedModel>();
+    model->data = static_cast<const unsigned char*>(mapped);
+    model->size = size;
+    // Loaders parse the whole file front to back
+    ::madvise(mapped, size, MADV_WILLNEED);
+    if (loader_) {
+        model->session = loader_(name, model->data, model->size, error);
+        if (!model->session) {
+            return nullptr;
+        }
+    } else {
+        // No runtime to hand it to; read the pages in as a loader would
+        long page = ::sysconf(_SC_PAGESIZE);
+        unsigned char sum = 0;
+        for (size_t offset = 0; offset < size; offset += static_cast<size_t>(page)) {
+            sum ^= model->data[offset];
+        }
+        volatile unsigned char sink = sum;
+        (void)sink;
+    }
+    return model;
+}
+
+bool ModelRegistry::unload(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    if (it == entries_.end() || !it->second.model) {
+        return false;
+    }
+    unload_entry(it->second);
+    return true;
+}
+
+void ModelRegistry::make_room(uint64_t incoming, const Entry* keep) {
+    if (budget_bytes_ == 0) {
+        return;
+    }
+    while (resident_bytes_ + incoming > budget_bytes_) {
+        Entry* victim = nullptr;
+        for (auto it = lru_.rbegin(); it != lru_.rend(); ++it) {
+            if (*it != keep) {
+                victim = *it;
+                break;
+            }
+        }
+        if (victim == nullptr) {
+            return;
+        }
+        NYMPH_LOG_INFO("Model {} unloaded to stay within the {:.1f} MB model budget", victim->name,
+                       megabytes(budget_bytes_));
+        unload_entry(*victim);
+    }
+}
+
+void ModelRegistry::unload_entry(Entry& entry) {
+    lru_.erase(entry.lru);
+    resident_bytes_ -= entry.resident_bytes;
+    entry.resident_bytes = 0;
+    // Runs still holding it keep it alive until they end
+    entry.model.reset();
+    entry.state = ModelState::UNLOADED;
+    entry.unloads++;
+    unloads_++;
+    publish(entry);
+}
+
+void ModelRegistry::touch(Entry& entry) {
+    lru_.splice(lru_.begin(), lru_, entry.lru);
+    entry.last_used = std::chrono::steady_clock::now();
+    entry.uses++;
+}
+
+void ModelRegistry::publish(const Entry& entry) {
+    Published& published = *entry.published;
+    published.resident_bytes.store(entry.resident_bytes, std::memory_order_relaxed);
+    published.loaded.store(entry.state == ModelState::LOADED, std::memory_order_relaxed);
+    published.loads.store(entry.loads, std::memory_order_relaxed);
+    published.unloads.store(entry.unloads, std::memory_order_relaxed);
+    publish_totals();
+}
+
+void ModelRegistry::publish_totals() {
+    published_budget_.store(budget_bytes_, std::memory_order_relaxed);
+    published_resident_.store(resident_bytes_, std::memory_order_relaxed);
+    published_failures_.store(load_failures_, std::memory_order_relaxed);
+}
+
+ModelInfo ModelRegistry::describe(const Entry& entry, std::chrono::steady_clock::time_point now) const {
+    ModelInfo info;
+    info.name = entry.name;
+    info.path = entry.path;
+    info.state = entry.state;
+    info.file_bytes = entry.file_bytes;
+    info.resident_bytes = entry.resident_bytes;
+    info.loads = entry.loads;
+    info.unloads = entry.unloads;
+    info.uses = entry.uses;
+    info.idle_s = entry.uses > 0
+        ? std::chrono::duration_cast<std::chrono::milliseconds>(now - entry.last_used).count() / 1000.0
+        : 0.0;
+    return info;
+}
+
+std::vector<ModelInfo> ModelRegistry::list() const {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ModelInfo> models;
+    models.reserve(entries_.size());
+    for (const auto& pair : entries_) {
+        models.push_back(describe(pair.second, now));
+    }
+    return models;
+}
+
+bool ModelRegistry::info(const std::string& name, ModelInfo& out) const {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    if (it == entries_.end()) {
+        return false;
+    }
+    out = describe(it->second, now);
+    return true;
+}
+
+ModelRegistryStats ModelRegistry::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ModelRegistryStats stats;
+    stats.budget_bytes = budget_bytes_;
+    stats.resident_bytes = resident_bytes_;
+    stats.models = entries_.size();
+    stats.loaded = lru_.size();
+    stats.loads = loads_;
+    stats.unloads = unloads_;
+    stats.load_failures = load_failures_;
+    return stats;
+}
+
+ModelRegistryGauges ModelRegistry::get_gauges() const {
+    ModelRegistryGauges gauges;
+    gauges.budget_bytes = published_budget_.load(std::memory_order_relaxed);
+    gauges.resident_bytes = published_resident_.load(std::memory_order_relaxed);
+    gauges.load_failures = published_failures_.load(std::memory_order_relaxed);
+    for (const Published* published = published_.load(std::memory_order_acquire); published != nullptr;
+         published = published->next) {
+        gauges.models.push_back(ModelGauge{published->name,
+                                           published->resident_bytes.load(std::memory_order_relaxed),
+                                           published->loaded.load(std::memory_order_relaxed),
+                                           published->loads.load(std::memory_order_relaxed),
+                                           published->unloads.load(std::memory_order_relaxed)});
+    }
+    std::sort(gauges.models.begin(), gauges.models.end(),
+              [](const ModelGauge& a, const ModelGauge& b) { return a.name < b.name; });
+    return gauges;
+}
+
+} // namespace ai
+} // namespace nymph
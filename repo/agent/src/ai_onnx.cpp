@@ -2,50 +2,290 @@
 /*
  * NYMPH 1.1 ONNX Runtime Implementation
  * 
- * Stub implementation - can be swapped for real ONNX Runtime
- * when hardware is available
+ * Stub implementation, plus ONNX Runtime sessions for registered models
+ * in builds with NYMPH_WITH_ONNXRUNTIME
  */
 
 #include "ai_onnx.hpp"
+#include "json.hpp"
 #include "logger.hpp"
+#include "trace.hpp"
 #include <sstream>
 #include <chrono>
 #include <random>
 #include <algorithm>
-#include <iomanip>
+#include <iterator>
 #include <thread>
-#include <cstdio>
+#include <cstring>
 
-// TODO: When real ONNX Runtime is available, include:
-// #include <onnxruntime_cxx_api.h>
+#ifdef NYMPH_WITH_ONNXRUNTIME
+#include <onnxruntime_cxx_api.h>
+#endif
 
 namespace nymph {
 namespace ai {
 
+#ifdef NYMPH_WITH_ONNXRUNTIME
+
+/*
+ * One loaded model. The session serves every request until the registry
+ * unloads it. The id and score buffers are allocated at load and grow to
+ * the largest batch stacked so far; the scores stay bound as the output
+ * until the row count changes, so a run allocates no tensors. Runs of one
+ * model share the binding and buffers, so they take the model's mutex;
+ * the session's thread pools parallelize within a run.
+ */
+struct OrtModel : ModelSession {
+    Ort::Session session;
+    Ort::IoBinding binding;
+    Ort::RunOptions run_options;
+    std::string input_name;
+    std::string output_name;
+    int64_t vocabulary = 0;
+    size_t max_input_tokens = 0;
+    std::vector<int64_t> input_ids;     // Stacked rows of ids, up to max_input_tokens each
+    std::vector<float> scores;          // One row of next-token scores per stacked sequence
+    Ort::Value output{nullptr};         // Over scores, output_rows rows
+    size_t output_rows = 0;
+    std::mutex mutex;
+
+    OrtModel(const Ort::Env& env, const unsigned char* data, size_t size, const Ort::SessionOptions& options)
+        : session(env, data, size, options), binding(session) {}
+};
+
+struct OrtBackend {
+    Ort::Env env{ORT_LOGGING_LEVEL_WARNING, "nymph"};
+    Ort::MemoryInfo cpu = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+};
+
+static const int64_t kEosToken = 0;
+
+/* ORT-format models (.ort) carry this identifier at byte 4 */
+static bool is_ort_format(const unsigned char* data, size_t size) {
+    return size >= 8 && std::memcmp(data + 4, "ORTM", 4) == 0;
+}
+
+/* Bind the output over rows rows of scores, growing them if needed */
+static void bind_rows(OrtModel& model, const Ort::MemoryInfo& cpu, size_t rows) {
+    if (rows == model.output_rows) {
+        return;
+    }
+    size_t count = rows * static_cast<size_t>(model.vocabulary);
+    if (model.scores.size() < count) {
+        model.scores.resize(count);
+    }
+    const int64_t output_shape[2] = {static_cast<int64_t>(rows), model.vocabulary};
+    model.output = Ort::Value::CreateTensor<float>(cpu, model.scores.data(), count, output_shape, 2);
+    model.binding.BindOutput(model.output_name.c_str(), model.output);
+    model.output_rows = rows;
+}
+
+/* Check the model against the contract and bind its output; false with error otherwise */
+static bool bind_model(OrtModel& model, const Ort::MemoryInfo& cpu, size_t max_input_tokens, std::string& error) {
+    Ort::Session& session = model.session;
+    if (session.GetInputCount() != 1 || session.GetOutputCount() != 1) {
+        error = "expected one input and one output";
+        return false;
+    }
+    Ort::AllocatorWithDefaultOptions allocator;
+    model.input_name = session.GetInputNameAllocated(0, allocator).get();
+    model.output_name = session.GetOutputNameAllocated(0, allocator).get();
+
+    Ort::TypeInfo input_type = session.GetInputTypeInfo(0);
+    if (input_type.GetTensorTypeAndShapeInfo().GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64) {
+        error = "input " + model.input_name + " is not int64 token ids";
+        return false;
+    }
+    Ort::TypeInfo output_type = session.GetOutputTypeInfo(0);
+    auto output_info = output_type.GetTensorTypeAndShapeInfo();
+    std::vector<int64_t> shape = output_info.GetShape();
+    if (output_info.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT || shape.size() != 2 || shape[1] <= 0) {
+        error = "output " + model.output_name + " is not float [batch, vocabulary]";
+        return false;
+    }
+
+    model.vocabulary = shape[1];
+    model.max_input_tokens = std::max<size_t>(1, max_input_tokens);
+    model.input_ids.resize(model.max_input_tokens);
+    bind_rows(model, cpu, 1);
+    return true;
+}
+
+/* A session over a model's mapped bytes; null, with error set, if it does not fit the contract */
+static std::unique_ptr<ModelSession> create_model(const OrtBackend& backend, const RuntimeConfig& config,
+                                                  const unsigned char* data, size_t size, std::string& error) {
+    try {
+        Ort::SessionOptions options;
+        options.SetIntraOpNumThreads(config.intra_op_threads);
+        options.SetInterOpNumThreads(config.inter_op_threads);
+        if (config.inter_op_threads > 1) {
+            options.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
+        }
+        options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        if (is_ort_format(data, size)) {
+            // Run from the mapping rather than copying the model and its weights
+            options.AddConfigEntry("session.use_ort_model_bytes_directly", "1");
+            options.AddConfigEntry("session.use_ort_model_bytes_for_initializers", "1");
+        }
+        std::unique_ptr<OrtModel> model = std::make_unique<OrtModel>(backend.env, data, size, options);
+        if (!bind_model(*model, backend.cpu, config.max_input_tokens, error)) {
+            return nullptr;
+        }
+        return model;
+    } catch (const Ort::Exception& e) {
+        error = e.what();
+        return nullptr;
+    }
+}
+
+/* Byte-level ids of the prompt, folded into the vocabulary; an empty prompt starts from EOS */
+static void prefill(const OrtModel& model, GenerationSequence& sequence) {
+    sequence.token_ids.clear();
+    for (unsigned char c : sequence.request->input_text) {
+        sequence.token_ids.push_back(static_cast<int64_t>(c) % model.vocabulary);
+    }
+    if (sequence.token_ids.empty()) {
+        sequence.token_ids.push_back(kEosToken);
+    }
+    sequence.backend_state = sequence.token_ids.size();    // Prompt ids, as the model saw them
+    sequence.prefilled = true;
+}
+
+/* Ids the model sees of a sequence: its tail, up to the input buffer */
+static size_t input_length(const OrtModel& model, const GenerationSequence& sequence) {
+    return std::min(sequence.token_ids.size(), model.max_input_tokens);
+}
+
+/* Append token to sequence and finish it on EOS or max_tokens */
+static void emit_token(GenerationSequence& sequence, int64_t token) {
+    sequence.generated++;
+    if (token == kEosToken) {
+        sequence.finished = true;
+    } else {
+        sequence.token_ids.push_back(token);
+        if (token < 256) {
+            sequence.text += static_cast<char>(token);
+        }
+    }
+    if (sequence.generated >= sequence.max_tokens) {
+        sequence.finished = true;
+    }
+}
+
+/*
+ * Generate one token greedily for every unfinished sequence, prefilling
+ * those that join. Sequences whose inputs are equally long are stacked
+ * into one [rows, length] run: the contract has no attention mask, so a
+ * shorter sequence padded into the row would feed the pad ids to the
+ * model. Caller holds model.mutex.
+ */
+static void decode_step(OrtModel& model, const Ort::MemoryInfo& cpu, const std::vector<GenerationSequence*>& batch) {
+    std::vector<GenerationSequence*> live;
+    for (GenerationSequence* sequence : batch) {
+        if (sequence->finished) {
+            continue;
+        }
+        if (!sequence->prefilled) {
+            prefill(model, *sequence);
+        }
+        live.push_back(sequence);
+    }
+    std::stable_sort(live.begin(), live.end(), [&model](const GenerationSequence* a, const GenerationSequence* b) {
+        return input_length(model, *a) < input_length(model, *b);
+    });
+
+    for (size_t first = 0; first < live.size();) {
+        size_t length = input_length(model, *live[first]);
+        size_t end = first + 1;
+        while (end < live.size() && input_length(model, *live[end]) == length) {
+            end++;
+        }
+        size_t rows = end - first;
+        if (model.input_ids.size() < rows * length) {
+            model.input_ids.resize(rows * length);
+        }
+        for (size_t row = 0; row < rows; row++) {
+            const std::vector<int64_t>& ids = live[first + row]->token_ids;
+            std::copy(ids.end() - length, ids.end(), model.input_ids.begin() + row * length);
+        }
+        bind_rows(model, cpu, rows);
+        const int64_t input_shape[2] = {static_cast<int64_t>(rows), static_cast<int64_t>(length)};
+        // A view of the preallocated ids; only the shape changes between runs
+        Ort::Value input = Ort::Value::CreateTensor<int64_t>(cpu, model.input_ids.data(), rows * length,
+                                                             input_shape, 2);
+        model.binding.BindInput(model.input_name.c_str(), input);
+        model.session.Run(model.run_options, model.binding);
+        model.binding.SynchronizeOutputs();
+
+        for (size_t row = 0; row < rows; row++) {
+            const float* scores = model.scores.data() + row * static_cast<size_t>(model.vocabulary);
+            emit_token(*live[first + row], std::max_element(scores, scores + model.vocabulary) - scores);
+        }
+        first = end;
+    }
+}
+
+#else
+
+struct OrtBackend {};
+
+#endif
+
+/* Global ONNX runtime instance */
+static std::unique_ptr<ONNXRuntime> g_onnx_runtime = nullptr;
+static std::once_flag g_onnx_runtime_once;
+
+ONNXRuntime& get_onnx_runtime() {
+    // Request workers and the batch dispatchers may race to create it
+    std::call_once(g_onnx_runtime_once, [] {
+        g_onnx_runtime = std::make_unique<ONNXRuntime>();
+        g_onnx_runtime->initialize();
+    });
+    return *g_onnx_runtime;
+}
+
 ONNXRuntime::ONNXRuntime() 
     : initialized_(false), execution_provider_("CPU") {
 }
 
 ONNXRuntime::~ONNXRuntime() {
-    // Cleanup if needed
+    // models_ releases the sessions before backend_ goes
 }
 
 bool ONNXRuntime::initialize(const std::string& model_path) {
-    (void)model_path;  // Unused in stub mode
+    (void)model_path;  // Models come through load_model()
     if (initialized_) {
         return true;
     }
 
+#ifdef NYMPH_WITH_ONNXRUNTIME
+    log::info("Initializing ONNX Runtime " + std::string(OrtGetApiBase()->GetVersionString()));
+    try {
+        backend_ = std::make_unique<OrtBackend>();
+    } catch (const Ort::Exception& e) {
+        log::error("Failed to create the ONNX Runtime environment: " + std::string(e.what()));
+        return false;
+    }
+    models_.set_loader([this](const std::string&, const unsigned char* data, size_t size, std::string& error) {
+        return create_model(*backend_, config_, data, size, error);
+    });
+    initialized_ = true;
+    log::info("ONNX Runtime initialized; unregistered models use the stub");
+#else
     log::info("Initializing ONNX Runtime (stub mode)");
     
-    // In stub mode, we just mark as initialized
-    // Real implementation would create Ort::Env and Ort::SessionOptions
+    // Built without ONNX Runtime, so every model runs on the stub
     
     initialized_ = true;
     log::info("ONNX Runtime initialized (stub mode)");
+#endif
     return true;
 }
 
+void ONNXRuntime::configure(const RuntimeConfig& config) {
+    config_ = config;
+}
+
 bool ONNXRuntime::load_model(const std::string& model_name, const std::string& model_path) {
     if (!initialized_) {
         if (!initialize()) {
@@ -53,20 +293,17 @@ bool ONNXRuntime::load_model(const std::string& model_name, const std::string& m
         }
     }
 
-    log::info("Loading model: " + model_name + " from " + model_path);
-    
-    // In stub mode, just track the model
-    // Real implementation would:
-    // 1. Load ONNX model file
-    // 2. Create Ort::Session
-    // 3. Store session for inference
-    
-    loaded_models_[model_name] = model_path;
-    log::info("Model loaded (stub): " + model_name);
+    // Only checked and sized here; the registry loads it on first use
+    if (!models_.add(model_name, model_path)) {
+        log::error("Failed to register model " + model_name + " from " + model_path);
+        return false;
+    }
+    log::info("Model registered: " + model_name + " from " + model_path);
     return true;
 }
 
 InferenceResult ONNXRuntime::run_inference(const InferenceRequest& request) {
+    NYMPH_TRACE_SCOPE("onnx.run_inference", "ai");
     if (!initialized_) {
         InferenceResult result;
         result.success = false;
@@ -74,58 +311,99 @@ InferenceResult ONNXRuntime::run_inference(const InferenceRequest& request) {
         return result;
     }
 
-    // Check if model is loaded (or use default)
-    std::string model_to_use = request.model_name;
-    if (model_to_use.empty()) {
-        model_to_use = "llm-7b-int4";  // Default model
+    // Registered models load here on first use; the lease keeps the model
+    // loaded until the run ends, even if the registry unloads it meanwhile
+    bool registered = false;
+    std::shared_ptr<LoadedModel> model = models_.acquire(request.model_name, &registered);
+    if (registered && !model) {
+        InferenceResult result;
+        result.success = false;
+        result.latency_ms = 0.0;
+        result.energy_wh = 0.0;
+        result.error_message = "Failed to load model " + request.model_name;
+        return result;
     }
-
-    // In stub mode, use stub implementation
-    // Real implementation would check for ONNX Runtime availability
-    bool use_real = false;  // Set to true when ONNX Runtime is linked
-    
-    if (use_real) {
-        return run_inference_real(request);
+    if (model && model->session) {
+        return run_inference_real(request, *model);
     } else {
         return run_inference_stub(request);
     }
 }
 
-InferenceResult ONNXRuntime::run_inference_stub(const InferenceRequest& request) {
-    InferenceResult result;
-    result.success = true;
-    
+std::vector<InferenceResult> ONNXRuntime::run_batch(const std::vector<const InferenceRequest*>& requests) {
+    NYMPH_TRACE_SCOPE("onnx.run_batch", "ai");
+    if (!initialized_) {
+        std::vector<InferenceResult> results(requests.size());
+        for (InferenceResult& result : results) {
+            result.success = false;
+            result.error_message = "ONNX Runtime not initialized";
+        }
+        return results;
+    }
+
+    // The scheduler batches per model, so one request tells the backend
+    bool registered = false;
+    std::shared_ptr<LoadedModel> model;
+    if (!requests.empty()) {
+        model = models_.acquire(requests.front()->model_name, &registered);
+    }
+    if (registered && !model) {
+        std::vector<InferenceResult> results(requests.size());
+        for (InferenceResult& result : results) {
+            result.success = false;
+            result.latency_ms = 0.0;
+            result.energy_wh = 0.0;
+            result.error_message = "Failed to load model " + requests.front()->model_name;
+        }
+        return results;
+    }
+    if (model && model->session) {
+        return run_batch_real(requests, *model);
+    }
+    return run_batch_stub(requests);
+}
+
+/* Modeled latency of a short request under profile */
+static double stub_profile_ms(const std::string& profile) {
+    if (profile == "edge-llm-turbo") {
+        return 80.0;
+    } else if (profile == "edge-llm-fast") {
+        return 40.0;
+    } else if (profile == "edge-llm-quality") {
+        return 150.0;
+    }
+    return 50.0;
+}
+
+/* Modeled latency of one request, before the stub's time scaling */
+static double stub_latency_ms(const InferenceRequest& request) {
     // Simulate inference latency based on input size and profile
     size_t input_size = request.input_text.length();
-    double base_latency_ms = 50.0;
-    
-    // Adjust latency based on profile
-    if (request.profile == "edge-llm-turbo") {
-        base_latency_ms = 80.0;
-    } else if (request.profile == "edge-llm-fast") {
-        base_latency_ms = 40.0;
-    } else if (request.profile == "edge-llm-quality") {
-        base_latency_ms = 150.0;
-    }
+    double base_latency_ms = stub_profile_ms(request.profile);
     
     // Add some variation based on input size
     double size_factor = 1.0 + (input_size / 1000.0) * 0.1;
     double latency_ms = base_latency_ms * size_factor;
     
-    // Add small random variation
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
+    // Add small random variation; runs may come from several threads
+    static thread_local std::mt19937 gen(std::random_device{}());
     std::uniform_real_distribution<> dis(0.9, 1.1);
-    latency_ms *= dis(gen);
-    
-    // Simulate inference time
+    return latency_ms * dis(gen);
+}
+
+/* Occupy the device for a modeled run; returns the time it took in ms */
+static double stub_run(std::mutex& device, double latency_ms) {
+    std::lock_guard<std::mutex> lock(device);
     auto start = std::chrono::high_resolution_clock::now();
     std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int>(latency_ms * 100)));
     auto end = std::chrono::high_resolution_clock::now();
-    
-    auto actual_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    result.latency_ms = actual_duration.count() / 1000.0;
-    
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+/* Stub output and metrics of a request whose run was modeled at latency_ms */
+static void fill_stub_result(const InferenceRequest& request, double latency_ms, InferenceResult& result) {
+    size_t input_size = request.input_text.length();
+
     // Generate stub output (avoid JSON-like content that could break parsing)
     std::stringstream output;
     output << "[STUB-ONNX] Inference result for model: " << request.model_name;
@@ -142,56 +420,338 @@ InferenceResult ONNXRuntime::run_inference_stub(const InferenceRequest& request)
     result.metrics["tokens_per_s"] = 1000.0 / latency_ms * 10.0;  // Stub tokens/s
     result.metrics["first_token_ms"] = latency_ms * 0.3;  // Stub first token latency
     result.metrics["throughput_mbps"] = (input_size / (1024.0 * 1024.0)) / (latency_ms / 1000.0);
+}
+
+/* Cost of each request past the first in a batch, as a share of the slowest */
+static const double kBatchItemShare = 0.05;
+
+/* Modeled cost of one decode token, and of one prompt token in prefill, as shares of the profile latency */
+static const double kTokenShare = 0.1;
+static const double kPrefillTokenShare = 0.002;
+
+uint32_t count_prompt_tokens(const InferenceRequest& request) {
+    return static_cast<uint32_t>(std::max<size_t>(1, (request.input_text.size() + 3) / 4));
+}
+
+/* Words the stub detokenizes to, picked by prompt and position */
+static const char* const kStubVocabulary[] = {
+    "edge", "thermal", "node", "load", "steady", "within", "limits", "the",
+    "cache", "power", "idle", "peak", "window", "stable", "and", "low",
+};
+
+/* Token the stub ends a sequence on: fixed per prompt, as greedy decoding is */
+static uint32_t stub_eos_position(const GenerationSequence& sequence) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : sequence.request->input_text) {
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    uint32_t shortest = std::max<uint32_t>(1, sequence.max_tokens / 4);
+    return shortest + static_cast<uint32_t>(hash % (sequence.max_tokens - shortest + 1));
+}
+
+InferenceResult ONNXRuntime::run_inference_stub(const InferenceRequest& request) {
+    InferenceResult result;
+    result.success = true;
+    double latency_ms = stub_latency_ms(request);
+    result.latency_ms = stub_run(device_mutex_, latency_ms);
+    fill_stub_result(request, latency_ms, result);
     
-    log::info("Inference completed (stub): " + std::to_string(result.latency_ms) + " ms");
+    NYMPH_LOG_DEBUG("Inference completed (stub): {:.3f} ms", result.latency_ms);
     
     return result;
 }
 
-InferenceResult ONNXRuntime::run_inference_real(const InferenceRequest& request) {
-    (void)request;  // Unused until real implementation
-    // TODO: Implement real ONNX Runtime inference
-    // This would:
-    // 1. Get Ort::Session for the model
-    // 2. Prepare input tensors
-    // 3. Run Ort::Session::Run()
-    // 4. Extract output tensors
-    // 5. Format results
-    
+std::vector<InferenceResult> ONNXRuntime::run_batch_stub(const std::vector<const InferenceRequest*>& requests) {
+    std::vector<InferenceResult> results(requests.size());
+    if (requests.empty()) {
+        return results;
+    }
+    // The batch runs as long as its slowest request, plus a little per request
+    double slowest_ms = 0.0;
+    for (const InferenceRequest* request : requests) {
+        slowest_ms = std::max(slowest_ms, stub_latency_ms(*request));
+    }
+    double latency_ms = slowest_ms * (1.0 + kBatchItemShare * (requests.size() - 1));
+    double elapsed_ms = stub_run(device_mutex_, latency_ms);
+
+    for (size_t i = 0; i < requests.size(); i++) {
+        InferenceResult& result = results[i];
+        result.success = true;
+        result.latency_ms = elapsed_ms;
+        fill_stub_result(*requests[i], latency_ms, result);
+        result.energy_wh /= requests.size();    // The run's energy, shared
+        result.metrics["batch_size"] = static_cast<double>(requests.size());
+    }
+    NYMPH_LOG_DEBUG("Batch of {} completed (stub): {:.3f} ms", requests.size(), elapsed_ms);
+    return results;
+}
+
+double ONNXRuntime::run_decode_step(const std::vector<GenerationSequence*>& batch) {
+    NYMPH_TRACE_SCOPE("onnx.decode_step", "ai");
+    if (!initialized_) {
+        return -1.0;
+    }
+
+    // Held for the step only: between steps the model may be unloaded, and
+    // the next step loads it again with the sequences' state intact
+    bool registered = false;
+    std::shared_ptr<LoadedModel> model;
+    if (!batch.empty()) {
+        model = models_.acquire(batch.front()->request->model_name, &registered);
+    }
+    if (registered && !model) {
+        return -1.0;
+    }
+    if (model && model->session) {
+        return run_decode_step_real(batch, *model);
+    }
+    return run_decode_step_stub(batch);
+}
+
+double ONNXRuntime::run_decode_step_stub(const std::vector<GenerationSequence*>& batch) {
+    // The step runs one token of the slowest profile, plus a little per
+    // sequence, plus the prefill of every prompt joining in this step
+    double token_ms = 0.0;
+    uint64_t prefill_tokens = 0;
+    size_t decoding = 0;
+    for (GenerationSequence* sequence : batch) {
+        if (sequence->finished) {
+            continue;
+        }
+        token_ms = std::max(token_ms, stub_profile_ms(sequence->request->profile) * kTokenShare);
+        if (!sequence->prefilled) {
+            prefill_tokens += sequence->prompt_tokens;
+            sequence->backend_state = stub_eos_position(*sequence);
+        }
+        decoding++;
+    }
+    if (decoding == 0) {
+        return 0.0;
+    }
+    double latency_ms = token_ms * (1.0 + kBatchItemShare * (decoding - 1)) +
+                        prefill_tokens * (token_ms / kTokenShare) * kPrefillTokenShare;
+    double elapsed_ms = stub_run(device_mutex_, latency_ms);
+
+    double energy_wh = (latency_ms / 1000.0) * 0.5 / decoding;     // As run_inference_stub, shared
+    for (GenerationSequence* sequence : batch) {
+        if (sequence->finished) {
+            continue;
+        }
+        sequence->prefilled = true;
+        if (sequence->generated > 0) {
+            sequence->text += ' ';
+        }
+        // The EOS position doubles as a per-prompt seed for the words
+        sequence->text += kStubVocabulary[(sequence->backend_state * 7 + sequence->generated) %
+                                          (sizeof(kStubVocabulary) / sizeof(kStubVocabulary[0]))];
+        sequence->generated++;
+        sequence->energy_wh += energy_wh;
+        if (sequence->generated >= sequence->backend_state || sequence->generated >= sequence->max_tokens) {
+            sequence->finished = true;
+        }
+    }
+    return elapsed_ms;
+}
+
+InferenceResult ONNXRuntime::finish_sequence(const GenerationSequence& sequence) {
+    InferenceResult result;
+    result.success = true;
+    result.latency_ms = 0.0;
+    result.energy_wh = sequence.energy_wh;
+
+    // Only ONNX Runtime decoding keeps token ids
+    if (!sequence.token_ids.empty()) {
+        result.output = sequence.text;
+        result.metrics["prompt_tokens"] = static_cast<double>(sequence.backend_state);
+        result.metrics["output_tokens"] = static_cast<double>(sequence.generated);
+        return result;
+    }
+
+    std::stringstream output;
+    output << "[STUB-ONNX] Generation result for model: " << sequence.request->model_name;
+    output << " | Prompt tokens: " << sequence.prompt_tokens;
+    output << " | Generated tokens (simulated): " << sequence.generated;
+    output << " | " << sequence.text;
+    result.output = output.str();
+    result.metrics["prompt_tokens"] = static_cast<double>(sequence.prompt_tokens);
+    result.metrics["output_tokens"] = static_cast<double>(sequence.generated);
+    return result;
+}
+
+InferenceResult ONNXRuntime::run_inference_real(const InferenceRequest& request, LoadedModel& loaded) {
     InferenceResult result;
     result.success = false;
-    result.error_message = "Real ONNX Runtime not yet implemented";
+    result.latency_ms = 0.0;
+    result.energy_wh = 0.0;
+#ifdef NYMPH_WITH_ONNXRUNTIME
+    OrtModel* model = static_cast<OrtModel*>(loaded.session.get());
+    GenerationSequence sequence;
+    sequence.request = &request;
+    sequence.max_tokens = request.max_tokens > 0 ? request.max_tokens : kDefaultMaxTokens;
+
+    auto start = std::chrono::steady_clock::now();
+    double first_token_ms = 0.0;
+    const std::vector<GenerationSequence*> batch{&sequence};
+    try {
+        std::lock_guard<std::mutex> lock(model->mutex);
+        while (!sequence.finished) {
+            decode_step(*model, backend_->cpu, batch);
+            if (sequence.generated == 1) {
+                first_token_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count() / 1000.0;
+            }
+        }
+    } catch (const Ort::Exception& e) {
+        result.error_message = "ONNX Runtime run failed: " + std::string(e.what());
+        return result;
+    }
+    double latency_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count() / 1000.0;
+
+    result = finish_sequence(sequence);
+    result.latency_ms = latency_ms;
+    result.metrics["first_token_ms"] = first_token_ms;
+    if (latency_ms > 0.0) {
+        result.metrics["tokens_per_s"] = sequence.generated / (latency_ms / 1000.0);
+    }
+#else
+    (void)loaded;
+    result.error_message = "Built without ONNX Runtime: " + request.model_name;
+#endif
     return result;
 }
 
+std::vector<InferenceResult> ONNXRuntime::run_batch_real(const std::vector<const InferenceRequest*>& requests,
+                                                         LoadedModel& loaded) {
+    std::vector<InferenceResult> results(requests.size());
+#ifdef NYMPH_WITH_ONNXRUNTIME
+    OrtModel* model = static_cast<OrtModel*>(loaded.session.get());
+    std::vector<GenerationSequence> sequences(requests.size());
+    std::vector<GenerationSequence*> batch;
+    for (size_t i = 0; i < requests.size(); i++) {
+        sequences[i].request = requests[i];
+        sequences[i].max_tokens = requests[i]->max_tokens > 0 ? requests[i]->max_tokens : kDefaultMaxTokens;
+        batch.push_back(&sequences[i]);
+    }
+    auto unfinished = [&sequences]() {
+        return std::any_of(sequences.begin(), sequences.end(),
+                           [](const GenerationSequence& sequence) { return !sequence.finished; });
+    };
+
+    // The requests decode in lockstep, so every step stacks them as
+    // run_decode_step does; each finishes on its own EOS or max_tokens
+    auto start = std::chrono::steady_clock::now();
+    double first_token_ms = 0.0;
+    try {
+        std::lock_guard<std::mutex> lock(model->mutex);
+        decode_step(*model, backend_->cpu, batch);
+        first_token_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count() / 1000.0;
+        while (unfinished()) {
+            decode_step(*model, backend_->cpu, batch);
+        }
+    } catch (const Ort::Exception& e) {
+        for (InferenceResult& result : results) {
+            result.success = false;
+            result.latency_ms = 0.0;
+            result.energy_wh = 0.0;
+            result.error_message = "ONNX Runtime run failed: " + std::string(e.what());
+        }
+        return results;
+    }
+    double latency_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count() / 1000.0;
+
+    for (size_t i = 0; i < sequences.size(); i++) {
+        InferenceResult& result = results[i];
+        result = finish_sequence(sequences[i]);
+        result.latency_ms = latency_ms;
+        result.metrics["first_token_ms"] = first_token_ms;
+        if (latency_ms > 0.0) {
+            result.metrics["tokens_per_s"] = sequences[i].generated / (latency_ms / 1000.0);
+        }
+        result.metrics["batch_size"] = static_cast<double>(requests.size());
+    }
+#else
+    (void)loaded;
+    for (size_t i = 0; i < requests.size(); i++) {
+        results[i].success = false;
+        results[i].latency_ms = 0.0;
+        results[i].energy_wh = 0.0;
+        results[i].error_message = "Built without ONNX Runtime: " + requests[i]->model_name;
+    }
+#endif
+    return results;
+}
+
+double ONNXRuntime::run_decode_step_real(const std::vector<GenerationSequence*>& batch, LoadedModel& loaded) {
+#ifdef NYMPH_WITH_ONNXRUNTIME
+    OrtModel* model = static_cast<OrtModel*>(loaded.session.get());
+    auto start = std::chrono::steady_clock::now();
+    try {
+        std::lock_guard<std::mutex> lock(model->mutex);
+        decode_step(*model, backend_->cpu, batch);
+    } catch (const Ort::Exception& e) {
+        NYMPH_LOG_ERROR("ONNX Runtime decode step failed: {}", e.what());
+        return -1.0;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count() / 1000.0;
+#else
+    (void)batch;
+    (void)loaded;
+    return -1.0;
+#endif
+}
+
+/* Models the stub serves, registered models or not; the first is the default */
+static const char* const kStubModels[] = {"llm-7b-int4", "llm-13b-int4", "vision-resnet50"};
+
 std::vector<std::string> ONNXRuntime::list_models() const {
     std::vector<std::string> models;
-    for (const auto& pair : loaded_models_) {
-        models.push_back(pair.first);
+    for (const ModelInfo& model : models_.list()) {
+        models.push_back(model.name);
     }
     
-    // Add default models if none loaded
-    if (models.empty()) {
-        models.push_back("llm-7b-int4");
-        models.push_back("llm-13b-int4");
-        models.push_back("vision-resnet50");
+    // The stub catalogue, unless a registered model took the name
+    for (const char* name : kStubModels) {
+        if (!models_.contains(name)) {
+            models.push_back(name);
+        }
     }
     
     return models;
 }
 
+bool ONNXRuntime::has_model(const std::string& model_name) const {
+    if (models_.contains(model_name)) {
+        return true;
+    }
+    return std::find(std::begin(kStubModels), std::end(kStubModels), model_name) != std::end(kStubModels);
+}
+
 std::map<std::string, std::string> ONNXRuntime::get_model_info(const std::string& model_name) const {
     std::map<std::string, std::string> info;
     
-    auto it = loaded_models_.find(model_name);
-    if (it != loaded_models_.end()) {
-        info["path"] = it->second;
-        info["status"] = "loaded";
+    ModelInfo model;
+    bool registered = models_.info(model_name, model);
+    if (registered) {
+        info["path"] = model.path;
+        info["status"] = model_state_to_string(model.state);
+        info["file_bytes"] = std::to_string(model.file_bytes);
+        info["resident_bytes"] = std::to_string(model.resident_bytes);
+        info["loads"] = std::to_string(model.loads);
+        info["unloads"] = std::to_string(model.unloads);
+        info["uses"] = std::to_string(model.uses);
     } else {
         info["status"] = "not_loaded";
     }
     
+#ifdef NYMPH_WITH_ONNXRUNTIME
+    info["runtime"] = registered ? "onnxruntime" : "stub";
+#else
     info["runtime"] = "stub";
+#endif
     info["provider"] = execution_provider_;
     
     return info;
@@ -202,77 +762,30 @@ void ONNXRuntime::set_execution_provider(const std::string& provider) {
     log::info("Execution provider set to: " + provider);
 }
 
-InferenceRequest parse_inference_request(const std::string& json_body) {
+InferenceRequest parse_inference_request(std::string_view json_body) {
+    NYMPH_TRACE_SCOPE("json.parse", "json");
     InferenceRequest request;
     
-    // Simple JSON parsing (stub - in production use a proper JSON library)
-    // Look for "model", "input", "profile" fields
-    
-    auto find_field = [&json_body](const std::string& field) -> std::string {
-        std::string search = "\"" + field + "\"";
-        size_t pos = json_body.find(search);
-        if (pos == std::string::npos) return "";
-        
-        pos = json_body.find(":", pos);
-        if (pos == std::string::npos) return "";
-        pos++;
-        
-        // Skip whitespace
-        while (pos < json_body.length() && (json_body[pos] == ' ' || json_body[pos] == '\t')) {
-            pos++;
+    json::Reader reader(json_body);
+    std::string_view key;
+    json::Value value;
+    while (reader.next(key, value)) {
+        if (key == "model") {
+            request.model_name = value.as_string();
+        } else if (key == "input") {
+            request.input_text = value.as_string();
+        } else if (key == "profile") {
+            request.profile = value.as_string();
+        } else if (key == "max_tokens") {
+            request.max_tokens = static_cast<uint32_t>(std::min<uint64_t>(value.as_uint(0), kMaxTokensLimit));
+        } else if (key == "stream") {
+            request.stream = value.as_bool(false);
         }
-        
-        if (pos >= json_body.length()) return "";
-        
-        // Check if string value
-        if (json_body[pos] == '"') {
-            pos++;
-            // Find the closing quote, but handle escaped quotes
-            size_t end = pos;
-            while (end < json_body.length()) {
-                if (json_body[end] == '"' && (end == pos || json_body[end-1] != '\\')) {
-                    break;
-                }
-                end++;
-            }
-            if (end < json_body.length()) {
-                std::string value = json_body.substr(pos, end - pos);
-                // Unescape common escape sequences
-                size_t esc_pos = 0;
-                while ((esc_pos = value.find("\\\"", esc_pos)) != std::string::npos) {
-                    value.replace(esc_pos, 2, "\"");
-                    esc_pos++;
-                }
-                esc_pos = 0;
-                while ((esc_pos = value.find("\\\\", esc_pos)) != std::string::npos) {
-                    value.replace(esc_pos, 2, "\\");
-                    esc_pos++;
-                }
-                return value;
-            }
-        } else {
-            // Number or other value
-            size_t end = pos;
-            while (end < json_body.length() && 
-                   json_body[end] != ',' && 
-                   json_body[end] != '}' && 
-                   json_body[end] != '\n' &&
-                   json_body[end] != ' ') {
-                end++;
-            }
-            return json_body.substr(pos, end - pos);
-        }
-        
-        return "";
-    };
-    
-    request.model_name = find_field("model");
-    request.input_text = find_field("input");
-    request.profile = find_field("profile");
+    }
     
     // Defaults
     if (request.model_name.empty()) {
-        request.model_name = "llm-7b-int4";
+        request.model_name = kStubModels[0];
     }
     if (request.profile.empty()) {
         request.profile = "edge-llm-turbo";
@@ -282,92 +795,31 @@ InferenceRequest parse_inference_request(const std::string& json_body) {
 }
 
 std::string format_inference_result(const InferenceResult& result) {
-    std::stringstream json;
-    json << std::fixed << std::setprecision(2);
-    
-    // Use compact JSON (single line) for better compatibility
-    json << "{";
-    json << "\"latency_ms\":" << result.latency_ms << ",";
-    
-    // Escape output string for JSON (escape all control characters and special chars)
-    std::string escaped_output;
-    escaped_output.reserve(result.output.length() * 2);  // Reserve space for escaped string
-    for (unsigned char c : result.output) {
-        // Escape control characters (0x00-0x1F) and special JSON characters
-        if (c < 0x20) {
-            // Control characters - escape as \uXXXX or common escapes
-            switch (c) {
-                case '\n':
-                    escaped_output += "\\n";
-                    break;
-                case '\r':
-                    escaped_output += "\\r";
-                    break;
-                case '\t':
-                    escaped_output += "\\t";
-                    break;
-                case '\b':
-                    escaped_output += "\\b";
-                    break;
-                case '\f':
-                    escaped_output += "\\f";
-                    break;
-                default:
-                    // Escape other control chars as \uXXXX
-                    char hex[7];
-                    snprintf(hex, sizeof(hex), "\\u%04x", c);
-                    escaped_output += hex;
-                    break;
-            }
-        } else if (c == '"') {
-            escaped_output += "\\\"";
-        } else if (c == '\\') {
-            escaped_output += "\\\\";
-        } else {
-            escaped_output += c;
-        }
-    }
-    
-    json << "\"output\":\"" << escaped_output << "\",";
-    json << "\"energy_wh\":" << result.energy_wh;
-    
-    // Add metrics if present
+    NYMPH_TRACE_SCOPE("json.format", "json");
+    std::string body;
+    body.reserve(result.output.size() + 256);
+    json::Writer json(body);
+
+    // Compact JSON (single line) for better compatibility
+    json.begin_object();
+    json.member("latency_ms", result.latency_ms, 2);
+    json.member("output", result.output);
+    json.member("energy_wh", result.energy_wh, 2);
+
     if (!result.metrics.empty()) {
-        json << ",\"metrics\":{";
-        bool first = true;
+        json.key("metrics").begin_object();
         for (const auto& pair : result.metrics) {
-            if (!first) json << ",";
-            json << "\"" << pair.first << "\":" << pair.second;
-            first = false;
+            json.member(pair.first, pair.second, 2);
         }
-        json << "}";
+        json.end_object();
     }
-    
+
     if (!result.success && !result.error_message.empty()) {
-        // Escape error message too
-        std::string escaped_error;
-        for (unsigned char c : result.error_message) {
-            if (c == '"') escaped_error += "\\\"";
-            else if (c == '\\') escaped_error += "\\\\";
-            else if (c < 0x20) {
-                if (c == '\n') escaped_error += "\\n";
-                else if (c == '\r') escaped_error += "\\r";
-                else if (c == '\t') escaped_error += "\\t";
-                else {
-                    char hex[7];
-                    snprintf(hex, sizeof(hex), "\\u%04x", c);
-                    escaped_error += hex;
-                }
-            } else {
-                escaped_error += c;
-            }
-        }
-        json << ",\"error\":\"" << escaped_error << "\"";
+        json.member("error", result.error_message);
     }
-    
-    json << "}";
-    
-    return json.str();
+
+    json.end_object();
+    return body;
 }
 
 } // namespace ai
@@ -9,6 +9,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <atomic>
 #include <cstring>
 #include <stdexcept>
 
@@ -30,6 +31,13 @@
 namespace nymph {
 namespace fabric {
 
+/* Counters shared by every ZLTA2Fabric instance */
+static std::atomic<uint64_t> g_submitted_descriptors{0};
+static std::atomic<uint64_t> g_submitted_bytes{0};
+static std::atomic<uint64_t> g_failed_submissions{0};
+static std::atomic<uint64_t> g_device_dma_bytes{0};
+static std::atomic<bool> g_device_present{false};
+
 ZLTA2Fabric::ZLTA2Fabric() : device_fd_(-1), initialized_(false) {
     memset(&ring_, 0, sizeof(ring_));
 }
@@ -72,14 +80,19 @@ bool ZLTA2Fabric::initialize(uint32_t ring_size) {
 bool ZLTA2Fabric::submit_dma(const DMADescriptor& desc) {
     if (!initialized_ || device_fd_ < 0) {
         // Stub mode: just return success
+        g_submitted_descriptors.fetch_add(1, std::memory_order_relaxed);
+        g_submitted_bytes.fetch_add(desc.length, std::memory_order_relaxed);
         return true;
     }
 
     DMADescriptor desc_copy = desc;
     if (ioctl(device_fd_, NYMPH_IOC_SUBMIT_DMA, &desc_copy) < 0) {
+        g_failed_submissions.fetch_add(1, std::memory_order_relaxed);
         return false;
     }
 
+    g_submitted_descriptors.fetch_add(1, std::memory_order_relaxed);
+    g_submitted_bytes.fetch_add(desc.length, std::memory_order_relaxed);
     return true;
 }
 
@@ -90,6 +103,7 @@ bool ZLTA2Fabric::get_status(FabricStatus& status) {
         status.ring_hash.resize(32, 0xAA);
         status.ring_size = ring_.ring_size;
         status.active_descriptors = 0;
+        g_device_present.store(false, std::memory_order_relaxed);
         return true;
     }
 
@@ -110,6 +124,8 @@ bool ZLTA2Fabric::get_status(FabricStatus& status) {
     status.ring_size = kernel_status.ring_size;
     status.active_descriptors = kernel_status.active_descriptors;
 
+    g_device_dma_bytes.store(status.dma_bytes, std::memory_order_relaxed);
+    g_device_present.store(true, std::memory_order_relaxed);
     return true;
 }
 
@@ -140,6 +156,15 @@ FabricStatus get_fabric_verify_status() {
     return status;
 }
 
+FabricCounters get_fabric_counters() {
+    FabricCounters counters;
+    counters.submitted_descriptors = g_submitted_descriptors.load(std::memory_order_relaxed);
+    counters.submitted_bytes = g_submitted_bytes.load(std::memory_order_relaxed);
+    counters.failed_submissions = g_failed_submissions.load(std::memory_order_relaxed);
+    counters.device_dma_bytes = g_device_dma_bytes.load(std::memory_order_relaxed);
+    counters.device_present = g_device_present.load(std::memory_order_relaxed);
+    return counters;
+}
+
 } // namespace fabric
 } // namespace nymph
-
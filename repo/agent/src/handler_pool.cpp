@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Handler Pool Implementation
+ */
+
+#include "handler_pool.hpp"
+#include "logger.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <exception>
+#include <string>
+
+namespace nymph {
+namespace net {
+
+HandlerPool::HandlerPool(unsigned threads, size_t max_queued)
+    : max_queued_(std::max<size_t>(1, max_queued)), stopping_(false) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        threads_.emplace_back([this, i]() {
+            trace::set_thread_name("handler-" + std::to_string(i));
+            run();
+        });
+    }
+}
+
+HandlerPool::~HandlerPool() {
+    stop();
+}
+
+bool HandlerPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || jobs_.size() >= max_queued_) {
+            return false;
+        }
+        jobs_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void HandlerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+}
+
+void HandlerPool::run() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;     // Stopping and drained
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        try {
+            job();
+        } catch (const std::exception& e) {
+            NYMPH_LOG_ERROR("Pooled handler failed: {}", e.what());
+        }
+    }
+}
+
+} // namespace net
+} // namespace nymph
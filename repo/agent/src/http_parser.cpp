@@ -0,0 +1,324 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Incremental HTTP/1.1 Request Parser Implementation
+ *
+ * Line-oriented states (request line, headers, chunk sizes, trailers) find
+ * line ends with memchr and remember how far they searched, so feeding a
+ * request one byte at a time stays linear in its length. Each of them is
+ * held to the header size limit while its line is incomplete.
+ *
+ * Framing that proxies could read differently is rejected rather than
+ * guessed at: a repeated Content-Length, a Transfer-Encoding other than
+ * exactly "chunked", or both headers on one request.
+ */
+
+#include "http_parser.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <limits>
+
+namespace nymph {
+namespace net {
+
+namespace {
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) !=
+            std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+} // namespace
+
+HttpParser::HttpParser(size_t max_body_bytes, size_t max_header_bytes)
+    : max_body_bytes_(max_body_bytes), max_header_bytes_(max_header_bytes) {
+    reset();
+}
+
+void HttpParser::reset() {
+    state_ = ParseState::REQUEST_LINE;
+    start_ = 0;
+    pos_ = 0;
+    scan_ = 0;
+    content_length_ = 0;
+    chunk_remaining_ = 0;
+    body_start_ = 0;
+    body_length_ = 0;
+    trailers_start_ = 0;
+    chunked_ = false;
+    has_content_length_ = false;
+    has_transfer_encoding_ = false;
+    expect_continue_ = false;
+    error_status_ = 0;
+    method_ = Span{0, 0};
+    target_ = Span{0, 0};
+    version_ = Span{0, 0};
+    headers_.clear();
+}
+
+bool HttpParser::headers_complete() const {
+    return state_ != ParseState::REQUEST_LINE && state_ != ParseState::HEADERS &&
+           state_ != ParseState::ERROR;
+}
+
+ParseResult HttpParser::fail(int status) {
+    state_ = ParseState::ERROR;
+    error_status_ = status;
+    return ParseResult::ERROR;
+}
+
+bool HttpParser::next_line(const char* base, size_t avail, Span& line) {
+    if (scan_ < pos_) scan_ = pos_;
+    if (scan_ >= avail) return false;
+
+    const void* nl = std::memchr(base + scan_, '\n', avail - scan_);
+    if (nl == nullptr) {
+        scan_ = avail;
+        return false;
+    }
+
+    size_t end = static_cast<size_t>(static_cast<const char*>(nl) - base);
+    size_t length = end - pos_;
+    if (length > 0 && base[end - 1] == '\r') length--;   // Bare LF is tolerated
+
+    line = Span{pos_, length};
+    pos_ = end + 1;
+    scan_ = pos_;
+    return true;
+}
+
+bool HttpParser::parse_request_line(const char* base, const Span& line) {
+    std::string_view text(base + line.offset, line.length);
+
+    size_t sp1 = text.find(' ');
+    if (sp1 == std::string_view::npos || sp1 == 0) return false;
+    size_t sp2 = text.find(' ', sp1 + 1);
+    if (sp2 == std::string_view::npos || sp2 == sp1 + 1) return false;
+
+    std::string_view version = text.substr(sp2 + 1);
+    if (version.substr(0, 5) != "HTTP/") return false;
+
+    method_ = Span{line.offset, sp1};
+    target_ = Span{line.offset + sp1 + 1, sp2 - sp1 - 1};
+    version_ = Span{line.offset + sp2 + 1, version.size()};
+    return true;
+}
+
+bool HttpParser::parse_header_line(char* base, const Span& line) {
+    char* text = base + line.offset;
+    const void* colon_ptr = std::memchr(text, ':', line.length);
+    if (colon_ptr == nullptr) return false;
+
+    size_t colon = static_cast<size_t>(static_cast<const char*>(colon_ptr) - text);
+    if (colon == 0) return false;
+
+    // Lower-case the name in place so lookups need no copies
+    for (size_t i = 0; i < colon; i++) {
+        if (text[i] == ' ' || text[i] == '\t') return false;
+        text[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(text[i])));
+    }
+
+    std::string_view name(text, colon);
+    std::string_view value = trim(std::string_view(text + colon + 1, line.length - colon - 1));
+    size_t value_offset = (value.empty()) ? line.offset + line.length
+                                          : static_cast<size_t>(value.data() - base);
+    headers_.push_back({Span{line.offset, colon}, Span{value_offset, value.size()}});
+
+    if (name == "content-length") {
+        // A second one, even with the same value, could be read either way
+        if (has_content_length_ || value.empty()) return false;
+        has_content_length_ = true;
+        size_t length = 0;
+        for (char c : value) {
+            if (c < '0' || c > '9') return false;
+            if (length > (std::numeric_limits<size_t>::max() - 9) / 10) return false;
+            length = length * 10 + static_cast<size_t>(c - '0');
+        }
+        content_length_ = length;
+    } else if (name == "transfer-encoding") {
+        // Only chunked is decoded; anything else would leave the body unframed
+        if (has_transfer_encoding_ || !iequals(value, "chunked")) return false;
+        has_transfer_encoding_ = true;
+        chunked_ = true;
+    } else if (name == "expect") {
+        expect_continue_ = iequals(value, "100-continue");
+    }
+    return true;
+}
+
+bool HttpParser::parse_chunk_size(const char* base, const Span& line) {
+    std::string_view text(base + line.offset, line.length);
+    size_t ext = text.find(';');
+    if (ext != std::string_view::npos) text = text.substr(0, ext);
+    text = trim(text);
+    if (text.empty() || text.size() > 15) return false;
+
+    size_t size = 0;
+    for (char c : text) {
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return false;
+        size = size * 16 + static_cast<size_t>(digit);
+    }
+    chunk_remaining_ = size;
+    return true;
+}
+
+ParseResult HttpParser::parse(std::string& buffer, size_t start) {
+    if (state_ == ParseState::COMPLETE) return ParseResult::COMPLETE;
+    if (state_ == ParseState::ERROR) return ParseResult::ERROR;
+    if (start > buffer.size()) return ParseResult::INCOMPLETE;
+
+    start_ = start;
+    char* base = &buffer[0] + start;
+    size_t avail = buffer.size() - start;
+    Span line{0, 0};
+
+    while (true) {
+        switch (state_) {
+        case ParseState::REQUEST_LINE:
+            if (!next_line(base, avail, line)) {
+                return (avail > max_header_bytes_) ? fail(431) : ParseResult::INCOMPLETE;
+            }
+            if (line.length == 0) {
+                // Skip stray CRLF left between pipelined requests
+                break;
+            }
+            if (!parse_request_line(base, line)) return fail(400);
+            state_ = ParseState::HEADERS;
+            break;
+
+        case ParseState::HEADERS:
+            if (!next_line(base, avail, line)) {
+                return (avail > max_header_bytes_) ? fail(431) : ParseResult::INCOMPLETE;
+            }
+            if (pos_ > max_header_bytes_) return fail(431);
+            if (line.length > 0) {
+                if (!parse_header_line(base, line)) return fail(400);
+                break;
+            }
+
+            // Blank line: pick body framing
+            body_start_ = pos_;
+            body_length_ = 0;
+            if (chunked_ && has_content_length_) return fail(400);
+            if (chunked_) {
+                state_ = ParseState::CHUNK_SIZE;
+            } else if (content_length_ > 0) {
+                if (content_length_ > max_body_bytes_) return fail(413);
+                state_ = ParseState::BODY;
+            } else {
+                state_ = ParseState::COMPLETE;
+                return ParseResult::COMPLETE;
+            }
+            break;
+
+        case ParseState::BODY:
+            if (avail - body_start_ < content_length_) return ParseResult::INCOMPLETE;
+            body_length_ = content_length_;
+            pos_ = body_start_ + content_length_;
+            state_ = ParseState::COMPLETE;
+            return ParseResult::COMPLETE;
+
+        case ParseState::CHUNK_SIZE:
+            if (!next_line(base, avail, line)) {
+                return (avail - pos_ > max_header_bytes_) ? fail(400) : ParseResult::INCOMPLETE;
+            }
+            if (!parse_chunk_size(base, line)) return fail(400);
+            if (chunk_remaining_ == 0) {
+                trailers_start_ = pos_;
+                state_ = ParseState::TRAILERS;
+            } else {
+                if (body_length_ + chunk_remaining_ > max_body_bytes_) return fail(413);
+                state_ = ParseState::CHUNK_DATA;
+            }
+            break;
+
+        case ParseState::CHUNK_DATA: {
+            // Slide payload down behind the previous chunk to keep the body contiguous
+            size_t take = std::min(chunk_remaining_, avail - pos_);
+            if (take == 0) return ParseResult::INCOMPLETE;
+            size_t dest = body_start_ + body_length_;
+            if (dest != pos_) {
+                std::memmove(base + dest, base + pos_, take);
+            }
+            body_length_ += take;
+            pos_ += take;
+            scan_ = pos_;
+            chunk_remaining_ -= take;
+            if (chunk_remaining_ > 0) return ParseResult::INCOMPLETE;
+            state_ = ParseState::CHUNK_END;
+            break;
+        }
+
+        case ParseState::CHUNK_END:
+            if (!next_line(base, avail, line)) {
+                return (avail - pos_ > max_header_bytes_) ? fail(400) : ParseResult::INCOMPLETE;
+            }
+            if (line.length != 0) return fail(400);
+            state_ = ParseState::CHUNK_SIZE;
+            break;
+
+        case ParseState::TRAILERS:
+            if (!next_line(base, avail, line)) {
+                return (avail - trailers_start_ > max_header_bytes_) ? fail(431) : ParseResult::INCOMPLETE;
+            }
+            if (line.length == 0) {
+                state_ = ParseState::COMPLETE;
+                return ParseResult::COMPLETE;
+            }
+            if (pos_ - trailers_start_ > max_header_bytes_) return fail(431);
+            break;
+
+        case ParseState::COMPLETE:
+            return ParseResult::COMPLETE;
+
+        case ParseState::ERROR:
+            return ParseResult::ERROR;
+        }
+    }
+}
+
+void HttpParser::fill_request(const std::string& buffer, api::APIRequest& req) const {
+    const char* base = buffer.data() + start_;
+    auto view = [base](const Span& span) {
+        return std::string_view(base + span.offset, span.length);
+    };
+
+    req.method = view(method_);
+    req.version = view(version_);
+
+    std::string_view target = view(target_);
+    size_t question = target.find('?');
+    if (question == std::string_view::npos) {
+        req.path = target;
+        req.query = std::string_view();
+    } else {
+        req.path = target.substr(0, question);
+        req.query = target.substr(question + 1);
+    }
+
+    req.headers.clear();
+    for (const auto& header : headers_) {
+        req.headers[view(header.first)] = view(header.second);
+    }
+
+    req.body = std::string_view(base + body_start_, body_length_);
+}
+
+} // namespace net
+} // namespace nymph
@@ -0,0 +1,965 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 HTTP Server Implementation
+ *
+ * One epoll loop per worker thread. Sockets are non-blocking and
+ * registered edge-triggered, so every readiness event drains the socket
+ * until EAGAIN.
+ *
+ * Responses are serialized straight into a per-connection output queue:
+ * status line and headers are appended to a reused buffer, small bodies
+ * follow them in place, and large bodies are moved in as their own
+ * segment. One sendmsg() gathers every pending segment, so a body is
+ * never copied after its handler formatted it.
+ *
+ * A response with a stream (api::ResponseStream) sends its head at once
+ * and its body as the producer writes it: the producer's thread queues a
+ * wakeup on the worker's eventfd, and the worker frames what was written
+ * as chunks. Requests pipelined behind a stream wait until it ends.
+ *
+ * A deferred response (api::DeferredResponse) is sent whole once its
+ * producer completes it, through the same wakeup; requests pipelined
+ * behind it wait as they do behind a stream.
+ */
+
+#include "http_server.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include <unordered_map>
+#include <deque>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <chrono>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+namespace nymph {
+namespace net {
+
+namespace {
+
+const int kMaxEvents = 256;
+const size_t kReadChunk = 16 * 1024;
+const size_t kMaxPendingOutput = 1024 * 1024;  // Stop dispatching pipelined requests past this
+const size_t kHeaderAllowance = 64 * 1024;     // HttpParser's header limit, on top of the body limit
+const size_t kInlineBodyBytes = 4 * 1024;      // Larger bodies become their own output segment
+const size_t kMaxRecycledBuffer = 64 * 1024;   // Larger drained buffers are freed, not reused
+const int kMaxIovecs = 64;                     // Segments gathered per sendmsg()
+
+/* Counters shared by all workers */
+std::atomic<uint64_t> g_accepted_connections{0};
+std::atomic<uint64_t> g_active_connections{0};
+std::atomic<unsigned> g_worker_count{0};
+metrics::Counter g_requests;
+metrics::Counter g_parse_errors;
+metrics::Counter g_responses[6];
+
+/*
+ * Response bytes waiting for the socket, as a queue of segments. Heads
+ * and small bodies are appended to the open tail buffer; a large body is
+ * moved in whole and closes the tail, so the next head starts a new
+ * (recycled) buffer instead of being appended behind it.
+ */
+class OutputQueue {
+public:
+    OutputQueue() : offset_(0), pending_(0), tail_open_(false) {}
+
+    bool empty() const { return pending_ == 0; }
+    size_t pending() const { return pending_; }
+
+    /* Buffer to append to; call commit() with the bytes added */
+    std::string& tail() {
+        if (!tail_open_) {
+            segments_.push_back(std::move(spare_));
+            spare_ = std::string();
+            segments_.back().clear();
+            tail_open_ = true;
+        }
+        return segments_.back();
+    }
+
+    void commit(size_t bytes) { pending_ += bytes; }
+
+    /* Queue body as its own segment without copying it */
+    void push(std::string&& body) {
+        pending_ += body.size();
+        segments_.push_back(std::move(body));
+        tail_open_ = false;
+    }
+
+    /* Gather-write pending segments; false on a socket error */
+    bool flush(int fd) {
+        while (pending_ > 0) {
+            struct iovec iov[kMaxIovecs];
+            int count = 0;
+            size_t skip = offset_;
+            for (auto it = segments_.begin(); it != segments_.end() && count < kMaxIovecs; ++it) {
+                if (it->size() > skip) {
+                    iov[count].iov_base = const_cast<char*>(it->data() + skip);
+                    iov[count].iov_len = it->size() - skip;
+                    count++;
+                }
+                skip = 0;
+            }
+
+            // sendmsg() is writev() with MSG_NOSIGNAL
+            struct msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = static_cast<size_t>(count);
+            ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+            if (n > 0) {
+                consume(static_cast<size_t>(n));
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::deque<std::string> segments_;
+    size_t offset_;             // Bytes of the front segment already written
+    size_t pending_;            // Unwritten bytes across all segments
+    bool tail_open_;            // Back segment accepts appends
+    std::string spare_;         // Drained buffer kept for its capacity
+
+    void consume(size_t written) {
+        pending_ -= written;
+        written += offset_;
+        offset_ = 0;
+        while (!segments_.empty()) {
+            size_t size = segments_.front().size();
+            if (written < size) {
+                offset_ = written;
+                return;
+            }
+            written -= size;
+            if (segments_.size() == 1 && tail_open_) {
+                // Keep the open tail and its capacity in place
+                segments_.front().clear();
+                if (segments_.front().capacity() > kMaxRecycledBuffer) {
+                    segments_.front().shrink_to_fit();
+                }
+                return;
+            }
+            recycle(std::move(segments_.front()));
+            segments_.pop_front();
+        }
+        tail_open_ = false;
+    }
+
+    void recycle(std::string&& buffer) {
+        if (buffer.capacity() > spare_.capacity() && buffer.capacity() <= kMaxRecycledBuffer) {
+            spare_ = std::move(buffer);
+        }
+    }
+};
+
+/* Per-connection state, owned by a single worker loop */
+struct Connection {
+    int fd;                     // -1 once closed
+    std::string in;             // Bytes received
+    size_t in_offset;           // Bytes of in already consumed by requests
+    OutputQueue out;            // Response bytes not yet written
+    HttpParser parser;          // Parser for the request at in_offset
+    uint32_t requests_served;   // Requests answered on this connection
+    bool continue_sent;         // "100 Continue" sent for the current request
+    bool close_after_write;     // Close once out is flushed
+    bool peer_closed;           // Read side reached EOF; the peer may still read (half-close)
+    bool peer_failed;           // Read side failed (reset); nothing more can be sent
+    bool read_paused;           // Input left in the socket while output or input is backlogged
+    std::shared_ptr<api::ResponseStream> stream;   // Body still being produced
+    bool stream_chunked;        // Else the body ends with the connection
+    std::shared_ptr<api::DeferredResponse> deferred;   // Response still being produced
+    bool deferred_keep_alive;   // Keep-alive decided when its request was dispatched
+    std::chrono::steady_clock::time_point last_activity;
+
+    Connection(int socket_fd, size_t max_body_bytes)
+        : fd(socket_fd), in_offset(0), parser(max_body_bytes)
+        , requests_served(0), continue_sent(false)
+        , close_after_write(false), peer_closed(false), peer_failed(false), read_paused(false)
+        , stream_chunked(false)
+        , deferred_keep_alive(false)
+        , last_activity(std::chrono::steady_clock::now()) {}
+};
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) !=
+            std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* HTTP/1.1 defaults to persistent connections, HTTP/1.0 must opt in */
+bool wants_keep_alive(const api::APIRequest& req) {
+    auto it = req.headers.find("connection");
+    if (req.version == "HTTP/1.0") {
+        return it != req.headers.end() && iequals(it->second, "keep-alive");
+    }
+    return it == req.headers.end() || !iequals(it->second, "close");
+}
+
+/* Queue data written to a stream, as one chunk when chunked */
+void queue_stream_data(OutputQueue& out, std::string&& data, bool chunked) {
+    if (!chunked) {
+        out.push(std::move(data));
+        return;
+    }
+    char digits[24];
+    std::string& buffer = out.tail();
+    size_t before = buffer.size();
+    buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), data.size(), 16).ptr);
+    buffer += "\r\n";
+    buffer += data;
+    buffer += "\r\n";
+    out.commit(buffer.size() - before);
+}
+
+/* Queue a full response; resp.body is moved out when it is large */
+void queue_response(OutputQueue& out, api::APIResponse& resp, bool keep_alive) {
+    std::string& buffer = out.tail();
+    size_t before = buffer.size();
+    append_response_head(buffer, resp, keep_alive);
+    if (resp.body.size() <= kInlineBodyBytes) {
+        buffer += resp.body;
+        out.commit(buffer.size() - before);
+    } else {
+        out.commit(buffer.size() - before);
+        out.push(std::move(resp.body));
+    }
+}
+
+} // namespace
+
+const char* status_reason(int status_code) {
+    switch (status_code) {
+        case 100: return "Continue";
+        case 200: return "OK";
+        case 202: return "Accepted";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default:  return "OK";
+    }
+}
+
+/* Worker loop state */
+struct HttpServer::Worker {
+    unsigned id;
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;
+    std::thread thread;
+
+    /* Streams with output to send and completed deferred responses, queued by producer threads */
+    std::mutex ready_mutex;
+    std::vector<const void*> ready;
+
+    explicit Worker(unsigned worker_id)
+        : id(worker_id), listen_fd(-1), epoll_fd(-1), wake_fd(-1) {}
+
+    ~Worker() {
+        if (listen_fd >= 0) close(listen_fd);
+        if (epoll_fd >= 0) close(epoll_fd);
+        if (wake_fd >= 0) close(wake_fd);
+    }
+};
+
+HttpServer::HttpServer(const ServerConfig& config, RequestHandler handler)
+    : config_(config), handler_(std::move(handler)), running_(false) {
+}
+
+HttpServer::~HttpServer() {
+    stop();
+}
+
+int HttpServer::create_listener() const {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        log::error("Failed to create socket: " + std::string(std::strerror(errno)));
+        return -1;
+    }
+
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        log::error("Failed to set SO_REUSEPORT: " + std::string(std::strerror(errno)));
+        close(fd);
+        return -1;
+    }
+
+    struct sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(config_.port);
+    if (inet_pton(AF_INET, config_.host.c_str(), &address.sin_addr) != 1) {
+        address.sin_addr.s_addr = INADDR_ANY;
+    }
+
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0) {
+        log::error("Failed to bind socket to port " + std::to_string(config_.port) +
+                   ": " + std::strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    if (listen(fd, config_.backlog) < 0) {
+        log::error("Failed to listen on socket: " + std::string(std::strerror(errno)));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+bool HttpServer::start() {
+    if (running_) {
+        return true;
+    }
+
+    unsigned count = config_.workers;
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        auto worker = std::make_unique<Worker>(i);
+
+        worker->listen_fd = create_listener();
+        worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        worker->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (worker->listen_fd < 0 || worker->epoll_fd < 0 || worker->wake_fd < 0) {
+            log::error("Failed to set up worker " + std::to_string(i));
+            workers_.clear();
+            return false;
+        }
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.ptr = &worker->listen_fd;
+        epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, worker->listen_fd, &ev);
+
+        ev.events = EPOLLIN;
+        ev.data.ptr = &worker->wake_fd;
+        epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, worker->wake_fd, &ev);
+
+        workers_.push_back(std::move(worker));
+    }
+
+    running_ = true;
+    for (size_t i = 0; i < workers_.size(); i++) {
+        Worker* w = workers_[i].get();
+        w->thread = std::thread([this, w, i]() {
+            trace::set_thread_name("http-worker-" + std::to_string(i));
+            run_worker(*w);
+        });
+    }
+    g_worker_count = count;
+
+    log::info("HTTP server started with " + std::to_string(count) + " worker loop(s)");
+    return true;
+}
+
+void HttpServer::stop() {
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    for (auto& worker : workers_) {
+        uint64_t one = 1;
+        ssize_t ignored = write(worker->wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    workers_.clear();
+    g_worker_count = 0;
+}
+
+ServerStats HttpServer::get_stats() const {
+    return get_server_stats();
+}
+
+void HttpServer::run_worker(Worker& worker) {
+    using Clock = std::chrono::steady_clock;
+
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    // Connection of each stream or deferred response a producer may wake us for
+    std::unordered_map<const void*, Connection*> waiting;
+    // Closed during this batch of events; freed after it, since a later
+    // event of the batch may still carry the pointer
+    std::vector<std::unique_ptr<Connection>> closed;
+    struct epoll_event events[kMaxEvents];
+    char chunk[kReadChunk];
+
+    const auto idle_timeout = std::chrono::milliseconds(config_.idle_timeout_ms);
+    // Unparsed input kept per connection; a single request may be this large
+    const size_t max_buffered_input = config_.max_request_bytes + kHeaderAllowance;
+    const int wait_ms = static_cast<int>(std::min<uint32_t>(1000, std::max<uint32_t>(1, config_.idle_timeout_ms / 4)));
+    Clock::time_point next_sweep = Clock::now() + std::chrono::milliseconds(wait_ms);
+
+    auto close_connection = [&](Connection* conn) {
+        if (conn->stream) {
+            conn->stream->cancel();
+            waiting.erase(conn->stream.get());
+        }
+        if (conn->deferred) {
+            conn->deferred->cancel();
+            waiting.erase(conn->deferred.get());
+        }
+        close(conn->fd);
+        auto it = connections.find(conn->fd);
+        closed.push_back(std::move(it->second));
+        connections.erase(it);
+        conn->fd = -1;
+        g_active_connections--;
+    };
+
+    /* Write as much pending output as the socket accepts; false on error */
+    auto flush_output = [](Connection* conn) -> bool {
+        NYMPH_TRACE_SCOPE("http.write", "http");
+        return conn->out.flush(conn->fd);
+    };
+
+    auto accept_all = [&]() {
+        while (true) {
+            int fd = accept4(worker.listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    log::warn("Failed to accept client connection: " +
+                              std::string(std::strerror(errno)));
+                }
+                return;
+            }
+
+            int opt = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+            auto conn = std::make_unique<Connection>(fd, config_.max_request_bytes);
+            struct epoll_event ev;
+            ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            ev.data.ptr = conn.get();
+            if (epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                close(fd);
+                continue;
+            }
+
+            connections[fd] = std::move(conn);
+            g_accepted_connections++;
+            g_active_connections++;
+        }
+    };
+
+    /* Called by a producer thread: queue token and wake this worker */
+    Worker* owner = &worker;
+    auto waker = [owner](const void* token) {
+        return [owner, token]() {
+            {
+                std::lock_guard<std::mutex> lock(owner->ready_mutex);
+                owner->ready.push_back(token);
+            }
+            uint64_t one = 1;
+            ssize_t ignored = ::write(owner->wake_fd, &one, sizeof(one));
+            (void)ignored;
+        };
+    };
+
+    /* Queue a handler's response, or wait for it if it is deferred */
+    auto respond = [&](Connection* conn, api::APIResponse& resp, bool keep_alive) {
+        if (resp.deferred) {
+            conn->deferred = std::move(resp.deferred);
+            conn->deferred_keep_alive = keep_alive;
+            waiting[conn->deferred.get()] = conn;
+            conn->deferred->attach(waker(conn->deferred.get()));
+            return;
+        }
+
+        g_responses[metrics::status_class(resp.status_code)].add();
+        {
+            NYMPH_TRACE_SCOPE("http.serialize", "http");
+            queue_response(conn->out, resp, keep_alive);
+        }
+        if (resp.stream) {
+            // Chunked on a kept-alive connection, else ended by closing it
+            conn->stream = std::move(resp.stream);
+            conn->stream_chunked = keep_alive;
+            waiting[conn->stream.get()] = conn;
+            conn->stream->attach(waker(conn->stream.get()));
+        }
+        if (!keep_alive) {
+            conn->close_after_write = true;
+        }
+    };
+
+    /*
+     * Answer every complete request buffered on the connection, in order.
+     * Pipelined requests are parsed back-to-back out of the same buffer and
+     * their responses queued behind each other. Returns true when it stopped
+     * early because too much output is pending.
+     */
+    auto dispatch = [&](Connection* conn) -> bool {
+        bool backlogged = false;
+        while (!conn->close_after_write && !conn->stream && !conn->deferred) {
+            if (conn->out.pending() >= kMaxPendingOutput) {
+                backlogged = true;
+                break;
+            }
+            ParseResult result;
+            {
+                NYMPH_TRACE_SCOPE("http.parse", "http");
+                result = conn->parser.parse(conn->in, conn->in_offset);
+            }
+            if (result == ParseResult::INCOMPLETE &&
+                conn->in.size() - conn->in_offset >= max_buffered_input) {
+                // Framing overhead took it past any request we accept
+                g_parse_errors.add();
+                g_responses[metrics::status_class(413)].add();
+                api::APIResponse resp(413, "application/json", "{\"error\": \"Payload Too Large\"}");
+                queue_response(conn->out, resp, false);
+                conn->close_after_write = true;
+                break;
+            }
+            if (result == ParseResult::INCOMPLETE) {
+                if (conn->parser.headers_complete() && conn->parser.expects_continue() &&
+                    !conn->continue_sent) {
+                    static const char kContinue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+                    conn->out.tail().append(kContinue, sizeof(kContinue) - 1);
+                    conn->out.commit(sizeof(kContinue) - 1);
+                    conn->continue_sent = true;
+                }
+                break;
+            }
+            if (result == ParseResult::ERROR) {
+                int status = conn->parser.error_status();
+                g_parse_errors.add();
+                g_responses[metrics::status_class(status)].add();
+                api::APIResponse resp(status, "application/json",
+                    "{\"error\": \"" + std::string(status_reason(status)) + "\"}");
+                queue_response(conn->out, resp, false);
+                conn->close_after_write = true;
+                break;
+            }
+
+            api::APIRequest req;
+            conn->parser.fill_request(conn->in, req);
+            conn->requests_served++;
+            g_requests.add();
+
+            api::APIResponse resp;
+            try {
+                resp = handler_(req);
+            } catch (const std::exception& e) {
+                log::error("Request handler failed: " + std::string(e.what()));
+                resp = api::APIResponse(500, "application/json",
+                                        "{\"error\": \"Internal server error\"}");
+            }
+
+            bool keep_alive = wants_keep_alive(req) &&
+                              conn->requests_served < config_.max_requests_per_connection;
+            respond(conn, resp, keep_alive);
+
+            conn->in_offset += conn->parser.consumed();
+            conn->parser.reset();
+            conn->continue_sent = false;
+        }
+
+        // Drop consumed bytes once per batch rather than once per request
+        if (conn->in_offset == conn->in.size()) {
+            conn->in.clear();
+            conn->in_offset = 0;
+        } else if (conn->in_offset > 0) {
+            conn->in.erase(0, conn->in_offset);
+            conn->in_offset = 0;
+        }
+        return backlogged;
+    };
+
+    /* Move what the producer wrote into the output; ends the stream when it is closed */
+    auto pump_stream = [&](Connection* conn) {
+        bool done = false;
+        std::string data = conn->stream->take(done);
+        if (!data.empty()) {
+            queue_stream_data(conn->out, std::move(data), conn->stream_chunked);
+        }
+        if (done) {
+            if (conn->stream_chunked) {
+                static const char kLastChunk[] = "0\r\n\r\n";
+                conn->out.tail().append(kLastChunk, sizeof(kLastChunk) - 1);
+                conn->out.commit(sizeof(kLastChunk) - 1);
+            }
+            waiting.erase(conn->stream.get());
+            conn->stream.reset();
+        }
+    };
+
+    /* Send a completed deferred response; pipelined requests resume after it */
+    auto finish_deferred = [&](Connection* conn) {
+        api::APIResponse resp;
+        if (!conn->deferred->take(resp)) {
+            return;
+        }
+        waiting.erase(conn->deferred.get());
+        conn->deferred.reset();
+        respond(conn, resp, conn->deferred_keep_alive);
+    };
+
+    /*
+     * Read what the socket holds, unless output or unparsed input is
+     * backlogged: then the rest stays in the socket (so the client is
+     * held back by TCP) until service() resumes reading. Returns true if
+     * anything was read or the peer closed.
+     */
+    auto read_input = [&](Connection* conn) -> bool {
+        bool progress = false;
+        conn->read_paused = false;
+        while (true) {
+            if (conn->out.pending() >= kMaxPendingOutput ||
+                conn->in.size() - conn->in_offset >= max_buffered_input) {
+                conn->read_paused = true;
+                return progress;
+            }
+            ssize_t got = recv(conn->fd, chunk, sizeof(chunk), 0);
+            if (got > 0) {
+                if (!conn->close_after_write) {
+                    conn->in.append(chunk, static_cast<size_t>(got));
+                }
+                progress = true;
+            } else if (got == 0) {
+                conn->peer_closed = true;
+                return true;
+            } else if (errno == EINTR) {
+                continue;
+            } else {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    conn->peer_closed = true;
+                    conn->peer_failed = true;
+                    return true;
+                }
+                return progress;
+            }
+        }
+    };
+
+    /* Dispatch buffered requests and write; closes the connection when it is done */
+    auto service = [&](Connection* conn) {
+        // Also resumes dispatch held back by a full output buffer
+        bool write_failed = false;
+        while (true) {
+            bool backlogged = dispatch(conn);
+            if (!flush_output(conn)) {
+                write_failed = true;
+                break;
+            }
+            // Edge-triggered: no new EPOLLIN comes for input already waiting
+            if (conn->read_paused && read_input(conn)) {
+                continue;
+            }
+            // No EPOLLOUT edge will follow a complete flush, so keep going here
+            if (!backlogged || !conn->out.empty()) {
+                break;
+            }
+        }
+        if (write_failed) {
+            close_connection(conn);
+            return;
+        }
+
+        // A peer that only shut down its write side still gets the responses
+        // to what it sent, a pending deferred or stream included; one that
+        // hung up makes the next write fail instead
+        bool drained = conn->out.empty();
+        bool pending = conn->stream || conn->deferred;
+        if (conn->peer_failed ||
+            (drained && !pending && (conn->peer_closed || conn->close_after_write))) {
+            close_connection(conn);
+        }
+    };
+
+    while (running_) {
+        int n = epoll_wait(worker.epoll_fd, events, kMaxEvents, wait_ms);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            log::error("epoll_wait failed: " + std::string(std::strerror(errno)));
+            break;
+        }
+
+        Clock::time_point now = Clock::now();
+
+        for (int i = 0; i < n; i++) {
+            void* tag = events[i].data.ptr;
+            if (tag == &worker.listen_fd) {
+                accept_all();
+                continue;
+            }
+            if (tag == &worker.wake_fd) {
+                uint64_t value;
+                ssize_t ignored = read(worker.wake_fd, &value, sizeof(value));
+                (void)ignored;
+                std::vector<const void*> ready;
+                {
+                    std::lock_guard<std::mutex> lock(worker.ready_mutex);
+                    ready.swap(worker.ready);
+                }
+                for (const void* token : ready) {
+                    // Gone if its connection closed since it was queued
+                    auto it = waiting.find(token);
+                    if (it == waiting.end()) {
+                        continue;
+                    }
+                    Connection* conn = it->second;
+                    conn->last_activity = now;
+                    if (conn->deferred.get() == token) {
+                        finish_deferred(conn);
+                    } else {
+                        pump_stream(conn);
+                    }
+                    service(conn);
+                }
+                continue;
+            }
+
+            Connection* conn = static_cast<Connection*>(tag);
+            uint32_t ev = events[i].events;
+            if (conn->fd < 0) {
+                continue;   // Closed by an earlier event of this batch
+            }
+
+            if (ev & EPOLLERR) {
+                close_connection(conn);
+                continue;
+            }
+
+            conn->last_activity = now;
+
+            if (ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) {
+                read_input(conn);
+            }
+
+            service(conn);
+        }
+
+        // Close connections that stayed idle past the timeout
+        if (now >= next_sweep) {
+            next_sweep = now + std::chrono::milliseconds(wait_ms);
+            std::vector<Connection*> expired;
+            for (auto& pair : connections) {
+                Connection* conn = pair.second.get();
+                if (conn->out.empty() && !conn->stream && !conn->deferred &&
+                    now - conn->last_activity > idle_timeout) {
+                    expired.push_back(conn);
+                }
+            }
+            for (Connection* conn : expired) {
+                close_connection(conn);
+            }
+        }
+        closed.clear();
+    }
+
+    for (auto& pair : connections) {
+        if (pair.second->stream) {
+            pair.second->stream->cancel();
+        }
+        if (pair.second->deferred) {
+            pair.second->deferred->cancel();
+        }
+        close(pair.first);
+        g_active_connections--;
+    }
+    connections.clear();
+}
+
+ServerStats get_server_stats() {
+    ServerStats stats;
+    stats.accepted_connections = g_accepted_connections.load(std::memory_order_relaxed);
+    stats.active_connections = g_active_connections.load(std::memory_order_relaxed);
+    stats.workers = g_worker_count.load(std::memory_order_relaxed);
+    stats.requests = g_requests.value();
+    stats.parse_errors = g_parse_errors.value();
+    for (size_t i = 0; i < 6; i++) {
+        stats.responses[i] = g_responses[i].value();
+    }
+    return stats;
+}
+
+void append_response_head(std::string& out, const api::APIResponse& api_resp, bool keep_alive) {
+    char digits[24];
+    out += "HTTP/1.1 ";
+    out.append(digits, std::to_chars(digits, digits + sizeof(digits), api_resp.status_code).ptr);
+    out += ' ';
+    out += status_reason(api_resp.status_code);
+    out += "\r\nContent-Type: ";
+    out += api_resp.content_type;
+    if (!api_resp.stream) {
+        out += "\r\nContent-Length: ";
+        out.append(digits, std::to_chars(digits, digits + sizeof(digits), api_resp.body.size()).ptr);
+    } else if (keep_alive) {
+        out += "\r\nTransfer-Encoding: chunked";
+    }
+    out += "\r\nAccess-Control-Allow-Origin: *\r\nConnection: ";
+    out += keep_alive ? "keep-alive\r\n\r\n" : "close\r\n\r\n";
+}
+
+std::string build_response(const api::APIResponse& api_resp, bool keep_alive) {
+    std::string http;
+    http.reserve(160 + api_resp.body.size());
+    append_response_head(http, api_resp, keep_alive);
+    http += api_resp.body;
+    return http;
+}
+
+} // namespace net
+
+namespace api {
+
+bool ResponseStream::write(std::string_view data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cancelled_) {
+        return false;
+    }
+    if (!closed_ && !data.empty()) {
+        pending_.append(data);
+        wake();
+    }
+    return true;
+}
+
+void ResponseStream::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!closed_) {
+        closed_ = true;
+        wake();
+    }
+}
+
+void ResponseStream::attach(std::function<void()> notify) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    notify_ = std::move(notify);
+    // The producer may have written before the server got the response
+    if (!pending_.empty() || closed_) {
+        wake();
+    }
+}
+
+std::string ResponseStream::take(bool& done) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    notified_ = false;
+    std::string data = std::move(pending_);
+    pending_.clear();
+    done = closed_;
+    return data;
+}
+
+void ResponseStream::cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    notify_ = nullptr;
+    pending_.clear();
+}
+
+void ResponseStream::wake() {
+    // Held under mutex_, so cancel() cannot return while the worker is being woken
+    if (notified_ || cancelled_ || !notify_) {
+        return;
+    }
+    notified_ = true;
+    notify_();
+}
+
+bool DeferredResponse::complete(APIResponse response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (completed_) {
+        return !cancelled_;
+    }
+    completed_ = true;
+    response_ = std::move(response);
+    for (auto& hook : hooks_) {
+        hook(response_);
+    }
+    hooks_.clear();
+    if (cancelled_) {
+        response_ = APIResponse();
+        return false;
+    }
+    // Under mutex_, as in ResponseStream::wake()
+    if (notify_) {
+        notify_();
+    }
+    return true;
+}
+
+void DeferredResponse::then(std::function<void(APIResponse&)> hook) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (completed_) {
+        if (!taken_) {
+            hook(response_);
+        }
+        return;
+    }
+    hooks_.push_back(std::move(hook));
+}
+
+bool DeferredResponse::cancelled() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cancelled_;
+}
+
+void DeferredResponse::attach(std::function<void()> notify) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    notify_ = std::move(notify);
+    // May have completed before the server got it
+    if (completed_ && !cancelled_) {
+        notify_();
+    }
+}
+
+bool DeferredResponse::take(APIResponse& response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!completed_ || taken_) {
+        return false;
+    }
+    taken_ = true;
+    response = std::move(response_);
+    return true;
+}
+
+void DeferredResponse::cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    notify_ = nullptr;
+    response_ = APIResponse();
+}
+
+} // namespace api
+} // namespace nymph
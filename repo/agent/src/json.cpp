@@ -0,0 +1,624 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 JSON Reader and Writer Implementation
+ */
+
+#include "json.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace nymph {
+namespace json {
+
+namespace {
+
+const int kMaxDepth = 64;
+
+inline bool is_whitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool read_hex4(std::string_view text, size_t pos, uint32_t& value) {
+    if (pos + 4 > text.size()) return false;
+    value = 0;
+    for (size_t i = 0; i < 4; i++) {
+        int digit = hex_value(text[pos + i]);
+        if (digit < 0) return false;
+        value = (value << 4) | static_cast<uint32_t>(digit);
+    }
+    return true;
+}
+
+void append_utf8(std::string& out, uint32_t code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+} // namespace
+
+namespace detail {
+
+size_t find_string_special_scalar(const char* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c == '"' || c == '\\' || c < 0x20) {
+            return i;
+        }
+    }
+    return size;
+}
+
+size_t find_string_special(const char* data, size_t size) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control_max = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        // Unsigned c <= 0x1F  <=>  max(c, 0x1F) == 0x1F
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmpeq_epi8(_mm_max_epu8(chunk, control_max), control_max));
+        int mask = _mm_movemask_epi8(special);
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control_end = vdupq_n_u8(0x20);
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+        uint8x16_t special = vorrq_u8(vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)),
+                                      vcltq_u8(chunk, control_end));
+        // Narrow each 0x00/0xFF byte to a nibble: 64-bit mask, 4 bits per byte
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+            vshrn_n_u16(vreinterpretq_u16_u8(special), 4)), 0);
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctzll(mask) >> 2);
+        }
+    }
+#endif
+    return i + find_string_special_scalar(data + i, size - i);
+}
+
+bool unescape(std::string_view body, std::string& out) {
+    out.reserve(out.size() + body.size());
+    size_t i = 0;
+    while (i < body.size()) {
+        size_t run = body.find('\\', i);
+        if (run == std::string_view::npos) {
+            out.append(body.data() + i, body.size() - i);
+            break;
+        }
+        out.append(body.data() + i, run - i);
+        i = run + 1;
+        if (i >= body.size()) return false;
+        char c = body[i++];
+        switch (c) {
+            case '"':  out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/':  out += '/'; break;
+            case 'b':  out += '\b'; break;
+            case 'f':  out += '\f'; break;
+            case 'n':  out += '\n'; break;
+            case 'r':  out += '\r'; break;
+            case 't':  out += '\t'; break;
+            case 'u': {
+                uint32_t code;
+                if (!read_hex4(body, i, code)) return false;
+                i += 4;
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    // High surrogate must be followed by \uDC00..\uDFFF
+                    uint32_t low;
+                    if (i + 2 > body.size() || body[i] != '\\' || body[i + 1] != 'u' ||
+                        !read_hex4(body, i + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+                        return false;
+                    }
+                    i += 6;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    return false;
+                }
+                append_utf8(out, code);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+std::string Value::as_string() const {
+    if (type != Type::STRING) {
+        return std::string();
+    }
+    std::string_view body = raw.substr(1, raw.size() - 2);
+    if (!escaped) {
+        return std::string(body);
+    }
+    std::string out;
+    detail::unescape(body, out);  // Validated while scanning
+    return out;
+}
+
+std::string_view Value::as_view() const {
+    if (type != Type::STRING || escaped) {
+        return std::string_view();
+    }
+    return raw.substr(1, raw.size() - 2);
+}
+
+bool Value::as_bool(bool fallback) const {
+    if (type != Type::BOOL) {
+        return fallback;
+    }
+    return raw[0] == 't';
+}
+
+double Value::as_double(double fallback) const {
+    if (type != Type::NUMBER) {
+        return fallback;
+    }
+    double value = 0.0;
+    auto result = std::from_chars(raw.data(), raw.data() + raw.size(), value);
+    return (result.ec == std::errc()) ? value : fallback;
+}
+
+int64_t Value::as_int(int64_t fallback) const {
+    if (type != Type::NUMBER) {
+        return fallback;
+    }
+    int64_t value = 0;
+    auto result = std::from_chars(raw.data(), raw.data() + raw.size(), value);
+    if (result.ec != std::errc() || result.ptr != raw.data() + raw.size()) {
+        // Fractions and exponents: accept when the value is integral
+        double real = as_double(static_cast<double>(fallback));
+        if (real >= -9.2e18 && real <= 9.2e18 && real == static_cast<double>(static_cast<int64_t>(real))) {
+            return static_cast<int64_t>(real);
+        }
+        return fallback;
+    }
+    return value;
+}
+
+uint64_t Value::as_uint(uint64_t fallback) const {
+    if (type != Type::NUMBER || raw[0] == '-') {
+        return fallback;
+    }
+    uint64_t value = 0;
+    auto result = std::from_chars(raw.data(), raw.data() + raw.size(), value);
+    if (result.ec != std::errc() || result.ptr != raw.data() + raw.size()) {
+        double real = as_double(static_cast<double>(fallback));
+        if (real >= 0 && real <= 1.8e19 && real == static_cast<double>(static_cast<uint64_t>(real))) {
+            return static_cast<uint64_t>(real);
+        }
+        return fallback;
+    }
+    return value;
+}
+
+bool Value::as_uint_array(std::vector<uint64_t>& out) const {
+    if (type != Type::ARRAY) {
+        return false;
+    }
+    std::vector<uint64_t> values;
+    ArrayReader elements(*this);
+    Value element;
+    while (elements.next(element)) {
+        // as_uint accepts integral fractions and exponents; a sentinel
+        // pair tells a genuine zero from a rejected element
+        uint64_t value = element.as_uint(0);
+        if (value == 0 && element.as_uint(1) != 0) {
+            return false;
+        }
+        values.push_back(value);
+    }
+    out = std::move(values);
+    return true;
+}
+
+Reader::Reader(std::string_view document)
+    : doc_(document), pos_(0), first_(true), done_(false) {
+    skip_whitespace();
+    if (pos_ == doc_.size()) {
+        done_ = true;       // Empty body reads as {}
+        return;
+    }
+    if (doc_[pos_] != '{') {
+        fail("expected object");
+    }
+    pos_++;
+}
+
+Reader::Reader(std::string_view document, char open)
+    : doc_(document), pos_(0), first_(true), done_(false) {
+    skip_whitespace();
+    if (pos_ >= doc_.size() || doc_[pos_] != open) {
+        fail(open == '[' ? "expected array" : "expected object");
+    }
+    pos_++;
+}
+
+void Reader::fail(const char* message) const {
+    throw ParseError(message, pos_);
+}
+
+void Reader::skip_whitespace() {
+    while (pos_ < doc_.size() && is_whitespace(doc_[pos_])) {
+        pos_++;
+    }
+}
+
+bool Reader::next(std::string_view& key, Value& value) {
+    if (done_) {
+        return false;
+    }
+
+    skip_whitespace();
+    if (pos_ < doc_.size() && doc_[pos_] == '}') {
+        pos_++;
+    } else {
+        if (!first_) {
+            if (pos_ >= doc_.size() || doc_[pos_] != ',') fail("expected ',' or '}'");
+            pos_++;
+            skip_whitespace();
+        }
+        if (pos_ >= doc_.size() || doc_[pos_] != '"') fail("expected member name");
+        Value name = parse_string();
+        if (name.escaped) {
+            key_scratch_ = name.as_string();
+            key = key_scratch_;
+        } else {
+            key = name.as_view();
+        }
+
+        skip_whitespace();
+        if (pos_ >= doc_.size() || doc_[pos_] != ':') fail("expected ':'");
+        pos_++;
+        value = parse_value(1);
+        first_ = false;
+        return true;
+    }
+
+    // Closing brace: only whitespace may follow
+    done_ = true;
+    skip_whitespace();
+    if (pos_ != doc_.size()) fail("unexpected data after object");
+    return false;
+}
+
+Value Reader::parse_value(int depth) {
+    skip_whitespace();
+    if (pos_ >= doc_.size()) fail("unexpected end of input");
+    char c = doc_[pos_];
+    switch (c) {
+        case '"': return parse_string();
+        case '{':
+        case '[': return parse_container(depth);
+        case 't': return parse_literal("true", Type::BOOL);
+        case 'f': return parse_literal("false", Type::BOOL);
+        case 'n': return parse_literal("null", Type::NUL);
+        default:
+            if (c == '-' || is_digit(c)) return parse_number();
+            fail("unexpected character");
+    }
+}
+
+Value Reader::parse_string() {
+    size_t start = pos_;
+    pos_++;  // Opening quote
+    bool escaped = false;
+    while (true) {
+        pos_ += detail::find_string_special(doc_.data() + pos_, doc_.size() - pos_);
+        if (pos_ >= doc_.size()) fail("unterminated string");
+        char c = doc_[pos_];
+        if (c == '"') {
+            break;
+        }
+        if (c != '\\') fail("control character in string");
+
+        // Validate the escape here so as_string() cannot fail later
+        escaped = true;
+        if (pos_ + 1 >= doc_.size()) fail("unterminated string");
+        char e = doc_[pos_ + 1];
+        if (e == 'u') {
+            uint32_t code;
+            if (!read_hex4(doc_, pos_ + 2, code)) fail("bad \\u escape");
+            pos_ += 6;
+            if (code >= 0xD800 && code <= 0xDBFF) {
+                uint32_t low;
+                if (pos_ + 2 > doc_.size() || doc_[pos_] != '\\' || doc_[pos_ + 1] != 'u' ||
+                    !read_hex4(doc_, pos_ + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+                    fail("unpaired surrogate");
+                }
+                pos_ += 6;
+            } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                fail("unpaired surrogate");
+            }
+        } else if (std::strchr("\"\\/bfnrt", e) != nullptr && e != '\0') {
+            pos_ += 2;
+        } else {
+            fail("bad escape");
+        }
+    }
+    pos_++;  // Closing quote
+
+    Value value;
+    value.type = Type::STRING;
+    value.raw = doc_.substr(start, pos_ - start);
+    value.escaped = escaped;
+    return value;
+}
+
+Value Reader::parse_number() {
+    size_t start = pos_;
+    if (doc_[pos_] == '-') pos_++;
+    if (pos_ >= doc_.size() || !is_digit(doc_[pos_])) fail("bad number");
+    if (doc_[pos_] == '0') {
+        pos_++;
+    } else {
+        while (pos_ < doc_.size() && is_digit(doc_[pos_])) pos_++;
+    }
+    if (pos_ < doc_.size() && doc_[pos_] == '.') {
+        pos_++;
+        if (pos_ >= doc_.size() || !is_digit(doc_[pos_])) fail("bad number");
+        while (pos_ < doc_.size() && is_digit(doc_[pos_])) pos_++;
+    }
+    if (pos_ < doc_.size() && (doc_[pos_] == 'e' || doc_[pos_] == 'E')) {
+        pos_++;
+        if (pos_ < doc_.size() && (doc_[pos_] == '+' || doc_[pos_] == '-')) pos_++;
+        if (pos_ >= doc_.size() || !is_digit(doc_[pos_])) fail("bad number");
+        while (pos_ < doc_.size() && is_digit(doc_[pos_])) pos_++;
+    }
+
+    Value value;
+    value.type = Type::NUMBER;
+    value.raw = doc_.substr(start, pos_ - start);
+    return value;
+}
+
+Value Reader::parse_literal(const char* text, Type type) {
+    size_t length = std::strlen(text);
+    if (doc_.compare(pos_, length, text) != 0) fail("bad literal");
+    Value value;
+    value.type = type;
+    value.raw = doc_.substr(pos_, length);
+    pos_ += length;
+    return value;
+}
+
+Value Reader::parse_container(int depth) {
+    if (depth >= kMaxDepth) fail("nesting too deep");
+    size_t start = pos_;
+    bool is_object = doc_[pos_] == '{';
+    char close = is_object ? '}' : ']';
+    pos_++;
+
+    skip_whitespace();
+    if (pos_ < doc_.size() && doc_[pos_] == close) {
+        pos_++;
+    } else {
+        while (true) {
+            if (is_object) {
+                skip_whitespace();
+                if (pos_ >= doc_.size() || doc_[pos_] != '"') fail("expected member name");
+                parse_string();
+                skip_whitespace();
+                if (pos_ >= doc_.size() || doc_[pos_] != ':') fail("expected ':'");
+                pos_++;
+            }
+            parse_value(depth + 1);
+            skip_whitespace();
+            if (pos_ >= doc_.size()) fail("unexpected end of input");
+            if (doc_[pos_] == ',') {
+                pos_++;
+                continue;
+            }
+            if (doc_[pos_] != close) fail(is_object ? "expected ',' or '}'" : "expected ',' or ']'");
+            pos_++;
+            break;
+        }
+    }
+
+    Value value;
+    value.type = is_object ? Type::OBJECT : Type::ARRAY;
+    value.raw = doc_.substr(start, pos_ - start);
+    return value;
+}
+
+ArrayReader::ArrayReader(const Value& array)
+    : reader_(array.type == Type::ARRAY ? array.raw : std::string_view("[]"), '[') {
+}
+
+bool ArrayReader::next(Value& element) {
+    Reader& r = reader_;
+    if (r.done_) {
+        return false;
+    }
+    r.skip_whitespace();
+    if (r.pos_ < r.doc_.size() && r.doc_[r.pos_] == ']') {
+        r.done_ = true;
+        return false;
+    }
+    if (!r.first_) {
+        if (r.pos_ >= r.doc_.size() || r.doc_[r.pos_] != ',') r.fail("expected ',' or ']'");
+        r.pos_++;
+    }
+    element = r.parse_value(1);
+    r.first_ = false;
+    return true;
+}
+
+void append_escaped(std::string& out, std::string_view text) {
+    static const char kHex[] = "0123456789abcdef";
+    out += '"';
+    size_t i = 0;
+    while (i < text.size()) {
+        size_t run = detail::find_string_special(text.data() + i, text.size() - i);
+        out.append(text.data() + i, run);
+        i += run;
+        if (i == text.size()) {
+            break;
+        }
+        unsigned char c = static_cast<unsigned char>(text[i++]);
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                char escape[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+                out.append(escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    out += '"';
+}
+
+void Writer::separate() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (depth_ > 0) {
+        uint64_t bit = uint64_t(1) << (depth_ - 1);
+        if (has_member_ & bit) {
+            out_ += ',';
+        } else {
+            has_member_ |= bit;
+        }
+    }
+}
+
+Writer& Writer::begin_object() {
+    separate();
+    out_ += '{';
+    has_member_ &= ~(uint64_t(1) << depth_);
+    depth_++;
+    return *this;
+}
+
+Writer& Writer::end_object() {
+    depth_--;
+    out_ += '}';
+    return *this;
+}
+
+Writer& Writer::begin_array() {
+    separate();
+    out_ += '[';
+    has_member_ &= ~(uint64_t(1) << depth_);
+    depth_++;
+    return *this;
+}
+
+Writer& Writer::end_array() {
+    depth_--;
+    out_ += ']';
+    return *this;
+}
+
+Writer& Writer::key(std::string_view name) {
+    separate();
+    append_escaped(out_, name);
+    out_ += ':';
+    after_key_ = true;
+    return *this;
+}
+
+Writer& Writer::string(std::string_view text) {
+    separate();
+    append_escaped(out_, text);
+    return *this;
+}
+
+Writer& Writer::boolean(bool flag) {
+    separate();
+    out_ += flag ? "true" : "false";
+    return *this;
+}
+
+Writer& Writer::null() {
+    separate();
+    out_ += "null";
+    return *this;
+}
+
+void Writer::append_integer(int64_t number) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out_.append(digits, result.ptr);
+}
+
+void Writer::append_integer(uint64_t number) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out_.append(digits, result.ptr);
+}
+
+Writer& Writer::number(double number, int precision) {
+    separate();
+    if (!std::isfinite(number)) {
+        out_ += "null";
+        return *this;
+    }
+    // Fixed notation of DBL_MAX is 309 integer digits
+    char digits[384];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number,
+                                std::chars_format::fixed, precision);
+    if (result.ec != std::errc()) {
+        result = std::to_chars(digits, digits + sizeof(digits), number);
+    }
+    out_.append(digits, result.ptr);
+    return *this;
+}
+
+Writer& Writer::raw(std::string_view json) {
+    separate();
+    out_.append(json.data(), json.size());
+    return *this;
+}
+
+} // namespace json
+} // namespace nymph
@@ -0,0 +1,127 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Paged KV Block Allocator Implementation
+ */
+
+#include "kv_blocks.hpp"
+
+namespace nymph {
+namespace kv {
+
+BlockAllocator::BlockAllocator()
+    : total_blocks_(0), free_blocks_(0), base_address_(0), first_free_word_(0) {
+}
+
+void BlockAllocator::reset(uint64_t total_blocks, uint64_t base_address) {
+    total_blocks_ = total_blocks;
+    free_blocks_ = total_blocks;
+    base_address_ = base_address;
+    first_free_word_ = 0;
+
+    free_bits_.assign((total_blocks + 63) / 64, ~uint64_t(0));
+    if (total_blocks % 64 != 0) {
+        // Blocks past the end of the arena never become free
+        free_bits_.back() = (uint64_t(1) << (total_blocks % 64)) - 1;
+    }
+}
+
+bool BlockAllocator::allocate(uint64_t count, std::vector<uint32_t>& table) {
+    if (count > free_blocks_) {
+        return false;
+    }
+    table.reserve(table.size() + count);
+
+    uint64_t remaining = count;
+    size_t word = first_free_word_;
+    while (remaining > 0) {
+        // free_blocks_ >= count guarantees a free bit before the end
+        while (free_bits_[word] == 0) {
+            word++;
+        }
+        uint64_t bits = free_bits_[word];
+        while (bits != 0 && remaining > 0) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctzll(bits));
+            bits &= bits - 1;
+            table.push_back(static_cast<uint32_t>(word * 64 + bit));
+            remaining--;
+        }
+        free_bits_[word] = bits;
+    }
+
+    free_blocks_ -= count;
+    first_free_word_ = word;
+    return true;
+}
+
+bool BlockAllocator::claim(uint32_t block) {
+    if (block >= total_blocks_) {
+        return false;
+    }
+    uint64_t bit = uint64_t(1) << (block % 64);
+    uint64_t& word = free_bits_[block / 64];
+    if ((word & bit) == 0) {
+        return false;
+    }
+    word &= ~bit;
+    free_blocks_--;
+    return true;
+}
+
+void BlockAllocator::release(const std::vector<uint32_t>& table) {
+    for (uint32_t block : table) {
+        size_t word = block / 64;
+        free_bits_[word] |= uint64_t(1) << (block % 64);
+        if (word < first_free_word_) {
+            first_free_word_ = word;
+        }
+    }
+    free_blocks_ += table.size();
+}
+
+BlockFragmentation BlockAllocator::fragmentation() const {
+    BlockFragmentation result;
+    result.free_extents = 0;
+    result.largest_free_extent = 0;
+
+    uint64_t run = 0;
+    for (size_t word = 0; word < free_bits_.size(); word++) {
+        uint64_t bits = free_bits_[word];
+        if (bits == ~uint64_t(0)) {
+            if (run == 0) result.free_extents++;
+            run += 64;
+            continue;
+        }
+        for (unsigned bit = 0; bit < 64; bit++) {
+            if (bits & (uint64_t(1) << bit)) {
+                if (run == 0) result.free_extents++;
+                run++;
+            } else {
+                if (run > result.largest_free_extent) result.largest_free_extent = run;
+                run = 0;
+            }
+        }
+    }
+    if (run > result.largest_free_extent) result.largest_free_extent = run;
+
+    // The padding bits of the last word read as allocated, so runs never overshoot
+    result.external = (free_blocks_ > 0)
+        ? 1.0 - static_cast<double>(result.largest_free_extent) / free_blocks_
+        : 0.0;
+    return result;
+}
+
+uint64_t BlockAllocator::extent_count(const std::vector<uint32_t>& table) {
+    if (table.empty()) {
+        return 0;
+    }
+    uint64_t extents = 1;
+    for (size_t i = 1; i < table.size(); i++) {
+        if (table[i] != table[i - 1] + 1) {
+            extents++;
+        }
+    }
+    return extents;
+}
+
+} // namespace kv
+} // namespace nymph
@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Eviction Policies Implementation
+ */
+
+#include "kv_eviction.hpp"
+#include <algorithm>
+
+namespace nymph {
+namespace kv {
+
+std::string eviction_policy_to_string(EvictionPolicy policy) {
+    switch (policy) {
+        case EvictionPolicy::LRU: return "lru";
+        case EvictionPolicy::LFU: return "lfu";
+        case EvictionPolicy::PRIORITY_LRU: return "priority-lru";
+        case EvictionPolicy::GDSF: return "gdsf";
+        default: return "unknown";
+    }
+}
+
+bool eviction_policy_from_string(std::string_view name, EvictionPolicy& policy) {
+    if (name == "lru") policy = EvictionPolicy::LRU;
+    else if (name == "lfu") policy = EvictionPolicy::LFU;
+    else if (name == "priority-lru") policy = EvictionPolicy::PRIORITY_LRU;
+    else if (name == "gdsf") policy = EvictionPolicy::GDSF;
+    else return false;
+    return true;
+}
+
+EvictionQueue::EvictionQueue()
+    : policy_(EvictionPolicy::LRU), inflation_(0.0) {
+}
+
+void EvictionQueue::reset(EvictionPolicy policy) {
+    for (EvictionNode* node = list_.front(); node != nullptr; node = list_.next(*node)) {
+        node->queued = false;
+    }
+    list_.clear();
+    for (auto& pair : index_) {
+        pair.second->queued = false;
+    }
+    index_.clear();
+    policy_ = policy;
+    inflation_ = 0.0;
+}
+
+double EvictionQueue::score(const EvictionInput& input) const {
+    switch (policy_) {
+        case EvictionPolicy::LFU:
+            return static_cast<double>(input.hits);
+        case EvictionPolicy::PRIORITY_LRU:
+            return static_cast<double>(input.use) +
+                   static_cast<double>(input.priority) * static_cast<double>(kPriorityTicks);
+        case EvictionPolicy::GDSF: {
+            double weight = 1.0 + static_cast<double>(std::max(input.priority, 0));
+            double blocks = static_cast<double>(std::max<uint64_t>(input.blocks, 1));
+            return inflation_ + (static_cast<double>(input.hits) + 1.0) * weight / blocks;
+        }
+        case EvictionPolicy::LRU:
+        default:
+            return 0.0;
+    }
+}
+
+void EvictionQueue::insert(EvictionNode& node, const EvictionInput& input) {
+    node.queued = true;
+    node.queued_use = input.use;
+    if (policy_ == EvictionPolicy::LRU) {
+        list_.push_back(node);
+    } else {
+        node.position = index_.emplace(EvictionNode::Key(score(input), input.use), &node);
+    }
+}
+
+void EvictionQueue::touch(EvictionNode& node, const EvictionInput& input) {
+    if (!node.queued) {
+        return;
+    }
+    if (policy_ == EvictionPolicy::LRU) {
+        node.queued_use = input.use;
+        list_.move_to_back(node);
+        return;
+    }
+    index_.erase(node.position);
+    node.queued = false;
+    insert(node, input);
+}
+
+void EvictionQueue::remove(EvictionNode& node) {
+    if (!node.queued) {
+        return;
+    }
+    if (policy_ == EvictionPolicy::LRU) {
+        list_.remove(node);
+    } else {
+        index_.erase(node.position);
+    }
+    node.queued = false;
+}
+
+EvictionNode* EvictionQueue::victim() const {
+    if (policy_ == EvictionPolicy::LRU) {
+        return list_.front();
+    }
+    return index_.empty() ? nullptr : index_.begin()->second;
+}
+
+void EvictionQueue::on_evict(const EvictionNode& node) {
+    if (policy_ == EvictionPolicy::GDSF && node.queued) {
+        inflation_ = node.position->first.first;
+    }
+}
+
+size_t EvictionQueue::size() const {
+    return (policy_ == EvictionPolicy::LRU) ? list_.size() : index_.size();
+}
+
+} // namespace kv
+} // namespace nymph
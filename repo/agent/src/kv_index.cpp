@@ -0,0 +1,159 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Region Index Implementation
+ */
+
+#include "kv_index.hpp"
+
+namespace nymph {
+namespace kv {
+
+/*
+ * FNV-1a over the name, then the murmur3 finalizer: FNV-1a alone leaves
+ * its low bits, which pick the shard, poorly mixed. std::hash is only
+ * size_t wide, which would leave the tags all zero on 32-bit targets.
+ */
+uint64_t region_hash(std::string_view name) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : name) {
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+RegionIndex::RegionIndex() : mask_(0), size_(0) {
+}
+
+void RegionIndex::insert(uint64_t hash, uint32_t slot) {
+    if ((size_ + 1) * 10 > buckets_.size() * 7) {
+        grow();
+    }
+    uint32_t tag = tag_of(hash);
+    size_t i = tag & mask_;
+    while (buckets_[i].slot != kNoSlot) {
+        i = (i + 1) & mask_;
+    }
+    buckets_[i].tag = tag;
+    buckets_[i].slot = slot;
+    size_++;
+}
+
+void RegionIndex::erase(uint64_t hash, uint32_t slot) {
+    if (buckets_.empty()) {
+        return;
+    }
+    size_t i = tag_of(hash) & mask_;
+    while (buckets_[i].slot != slot) {
+        if (buckets_[i].slot == kNoSlot) {
+            return;
+        }
+        i = (i + 1) & mask_;
+    }
+
+    // Backward shift: pull later members of the probe run into the hole
+    // unless the hole lies before their home bucket
+    size_t hole = i;
+    for (size_t j = (i + 1) & mask_; buckets_[j].slot != kNoSlot; j = (j + 1) & mask_) {
+        size_t home = buckets_[j].tag & mask_;
+        if (((j - home) & mask_) >= ((j - hole) & mask_)) {
+            buckets_[hole] = buckets_[j];
+            hole = j;
+        }
+    }
+    buckets_[hole].slot = kNoSlot;
+    size_--;
+}
+
+void RegionIndex::clear() {
+    for (Bucket& bucket : buckets_) {
+        bucket.slot = kNoSlot;
+    }
+    size_ = 0;
+}
+
+void RegionIndex::grow() {
+    std::vector<Bucket> old;
+    old.swap(buckets_);
+    size_t capacity = old.empty() ? 64 : old.size() * 2;
+    buckets_.assign(capacity, Bucket{0, kNoSlot});
+    mask_ = capacity - 1;
+    for (const Bucket& bucket : old) {
+        if (bucket.slot == kNoSlot) {
+            continue;
+        }
+        size_t i = bucket.tag & mask_;
+        while (buckets_[i].slot != kNoSlot) {
+            i = (i + 1) & mask_;
+        }
+        buckets_[i] = bucket;
+    }
+}
+
+RegionCounters::RegionCounters() : capacity_(0) {
+}
+
+void RegionCounters::reserve(size_t slots) {
+    if (slots <= capacity_) {
+        return;
+    }
+    size_t capacity = capacity_ ? capacity_ : 64;
+    while (capacity < slots) {
+        capacity *= 2;
+    }
+    for (auto& column : columns_) {
+        std::unique_ptr<std::atomic<uint64_t>[]> grown(new std::atomic<uint64_t>[capacity]);
+        for (size_t i = 0; i < capacity; i++) {
+            uint64_t value = (i < capacity_) ? column[i].load(std::memory_order_relaxed) : 0;
+            grown[i].store(value, std::memory_order_relaxed);
+        }
+        column = std::move(grown);
+    }
+    capacity_ = capacity;
+}
+
+void RegionCounters::reset(uint32_t slot) {
+    for (auto& column : columns_) {
+        column[slot].store(0, std::memory_order_relaxed);
+    }
+}
+
+void RegionCounters::record(uint32_t slot, bool hit, uint64_t now) {
+    columns_[ACCESSES][slot].fetch_add(1, std::memory_order_relaxed);
+    columns_[hit ? HITS : MISSES][slot].fetch_add(1, std::memory_order_relaxed);
+    columns_[LAST_ACCESS_TIME][slot].store(now, std::memory_order_relaxed);
+    std::atomic<uint64_t>& history = columns_[HISTORY][slot];
+    uint64_t old = history.load(std::memory_order_relaxed);
+    while (!history.compare_exchange_weak(old, (old << 1) | (hit ? 1 : 0),
+                                          std::memory_order_relaxed)) {
+    }
+}
+
+double RegionCounters::window_hit_rate(uint32_t slot) const {
+    uint64_t accesses = load(ACCESSES, slot);
+    if (accesses == 0) {
+        return 0.0;
+    }
+    uint64_t history = load(HISTORY, slot);
+    if (accesses < kWindow) {
+        history &= (uint64_t(1) << accesses) - 1;
+    } else {
+        accesses = kWindow;
+    }
+    return static_cast<double>(__builtin_popcountll(history)) / accesses;
+}
+
+uint64_t RegionCounters::sum(Column column, size_t slots) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < slots; i++) {
+        total += columns_[column][i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+} // namespace kv
+} // namespace nymph
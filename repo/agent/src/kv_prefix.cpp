@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Prefix Tree Implementation
+ */
+
+#include "kv_prefix.hpp"
+
+namespace nymph {
+namespace kv {
+
+PrefixTree::PrefixTree() : nodes_(0), references_(0) {
+}
+
+size_t PrefixTree::match(const std::vector<uint64_t>& keys, size_t count) const {
+    const Node* node = &root_;
+    size_t depth = 0;
+    while (depth < count) {
+        auto it = node->children.find(keys[depth]);
+        if (it == node->children.end()) {
+            break;
+        }
+        node = it->second.get();
+        depth++;
+    }
+    return depth;
+}
+
+PrefixTree::Node* PrefixTree::acquire(const std::vector<uint64_t>& keys, size_t count,
+                                      std::vector<uint32_t>& spare, std::vector<uint32_t>& blocks,
+                                      size_t& acquired) {
+    Node* node = &root_;
+    acquired = 0;
+    while (acquired < count) {
+        auto it = node->children.find(keys[acquired]);
+        Node* child;
+        if (it != node->children.end()) {
+            child = it->second.get();
+        } else {
+            if (spare.empty()) {
+                break;
+            }
+            std::unique_ptr<Node> created(new Node());
+            created->key = keys[acquired];
+            created->block = spare.back();
+            created->parent = node;
+            spare.pop_back();
+            child = created.get();
+            node->children.emplace(child->key, std::move(created));
+            nodes_++;
+        }
+        child->refs++;
+        references_++;
+        blocks.push_back(child->block);
+        node = child;
+        acquired++;
+    }
+    return acquired ? node : nullptr;
+}
+
+PrefixTree::Node* PrefixTree::release(Node* node, size_t levels, std::vector<uint32_t>& freed) {
+    for (; levels > 0 && node != nullptr && node != &root_; levels--) {
+        Node* parent = node->parent;
+        node->refs--;
+        references_--;
+        if (node->refs == 0) {
+            // Children hold a subset of this node's references, so none are left
+            freed.push_back(node->block);
+            parent->children.erase(node->key);
+            nodes_--;
+        }
+        node = parent;
+    }
+    return node == &root_ ? nullptr : node;
+}
+
+void PrefixTree::clear() {
+    root_.children.clear();
+    nodes_ = 0;
+    references_ = 0;
+}
+
+} // namespace kv
+} // namespace nymph
@@ -0,0 +1,289 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Snapshot File Implementation
+ */
+
+#include "kv_snapshot.hpp"
+#include "logger.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nymph {
+namespace kv {
+
+static const uint64_t kSnapshotMagic = 0x4e594d50484b5331ULL;    // "NYMPHKS1"
+static const uint32_t kSnapshotVersion = 1;
+
+struct FileHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_bytes;
+    uint64_t block_size_kb;
+    uint64_t total_blocks;
+    uint64_t spill_slots;
+    uint64_t region_count;
+    uint64_t records_bytes;
+    uint64_t checksum;          // Of the fields above
+};
+
+/* Followed by the name, prefix keys, block table and spill slots */
+struct RecordHeader {
+    uint64_t checksum;          // Of the record from record_bytes on
+    uint32_t record_bytes;      // Whole record, a multiple of 8
+    uint32_t name_bytes;
+    uint64_t size_kb;
+    uint64_t pages;
+    uint64_t accesses;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t history;
+    uint32_t prefix_count;
+    uint32_t block_count;
+    uint32_t spill_count;
+    int32_t priority;
+    uint32_t pinned;
+    uint32_t reserved;
+};
+
+static size_t pad8(size_t bytes) {
+    return (bytes + 7) & ~size_t(7);
+}
+
+/* FNV-1a; records are small and read once, so bytewise is enough */
+static uint64_t checksum(const unsigned char* data, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/* memcpy that tolerates the null data() of an empty vector */
+static void copy_bytes(void* to, const void* from, size_t bytes) {
+    if (bytes > 0) {
+        std::memcpy(to, from, bytes);
+    }
+}
+
+static size_t record_bytes(size_t name_bytes, size_t prefix_count, size_t block_count,
+                           size_t spill_count) {
+    return sizeof(RecordHeader) + pad8(name_bytes) + prefix_count * sizeof(uint64_t) +
+           pad8((block_count + spill_count) * sizeof(uint32_t));
+}
+
+static size_t record_bytes(const SnapshotRegion& region) {
+    return record_bytes(region.name.size(), region.prefix_keys.size(), region.blocks.size(),
+                        region.spill_slots.size());
+}
+
+static void put_record(unsigned char* out, const SnapshotRegion& region) {
+    RecordHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.record_bytes = static_cast<uint32_t>(record_bytes(region));
+    header.name_bytes = static_cast<uint32_t>(region.name.size());
+    header.size_kb = region.size_kb;
+    header.pages = region.pages;
+    header.accesses = region.accesses;
+    header.hits = region.hits;
+    header.misses = region.misses;
+    header.history = region.history;
+    header.prefix_count = static_cast<uint32_t>(region.prefix_keys.size());
+    header.block_count = static_cast<uint32_t>(region.blocks.size());
+    header.spill_count = static_cast<uint32_t>(region.spill_slots.size());
+    header.priority = region.priority;
+    header.pinned = region.pinned ? 1 : 0;
+
+    // The file was sized with ftruncate, so padding is already zero
+    unsigned char* at = out + sizeof(header);
+    copy_bytes(at, region.name.data(), region.name.size());
+    at += pad8(region.name.size());
+    copy_bytes(at, region.prefix_keys.data(), region.prefix_keys.size() * sizeof(uint64_t));
+    at += region.prefix_keys.size() * sizeof(uint64_t);
+    copy_bytes(at, region.blocks.data(), region.blocks.size() * sizeof(uint32_t));
+    at += region.blocks.size() * sizeof(uint32_t);
+    copy_bytes(at, region.spill_slots.data(), region.spill_slots.size() * sizeof(uint32_t));
+
+    std::memcpy(out, &header, sizeof(header));
+    header.checksum = checksum(out + sizeof(uint64_t), header.record_bytes - sizeof(uint64_t));
+    std::memcpy(out, &header.checksum, sizeof(uint64_t));
+}
+
+bool write_snapshot(const std::string& path, const SnapshotLayout& layout,
+                    const std::vector<SnapshotRegion>& regions) {
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = kSnapshotMagic;
+    header.version = kSnapshotVersion;
+    header.header_bytes = sizeof(FileHeader);
+    header.block_size_kb = layout.block_size_kb;
+    header.total_blocks = layout.total_blocks;
+    header.spill_slots = layout.spill_slots;
+    header.region_count = regions.size();
+    for (const SnapshotRegion& region : regions) {
+        header.records_bytes += record_bytes(region);
+    }
+    header.checksum = checksum(reinterpret_cast<const unsigned char*>(&header),
+                               offsetof(FileHeader, checksum));
+    size_t length = sizeof(header) + header.records_bytes;
+
+    // Written beside the old snapshot and renamed over it when complete
+    std::string temp = path + ".tmp";
+    int fd = ::open(temp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        NYMPH_LOG_ERROR("Failed to create KV snapshot {}: {}", temp, std::strerror(errno));
+        return false;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(length)) != 0) {
+        NYMPH_LOG_ERROR("Failed to size KV snapshot {}: {}", temp, std::strerror(errno));
+        ::close(fd);
+        ::unlink(temp.c_str());
+        return false;
+    }
+    void* mapped = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        NYMPH_LOG_ERROR("Failed to map KV snapshot {}: {}", temp, std::strerror(errno));
+        ::close(fd);
+        ::unlink(temp.c_str());
+        return false;
+    }
+
+    unsigned char* base = static_cast<unsigned char*>(mapped);
+    std::memcpy(base, &header, sizeof(header));
+    size_t offset = sizeof(header);
+    for (const SnapshotRegion& region : regions) {
+        put_record(base + offset, region);
+        offset += record_bytes(region);
+    }
+    bool synced = ::msync(mapped, length, MS_SYNC) == 0;
+    ::munmap(mapped, length);
+    ::close(fd);
+    if (!synced || std::rename(temp.c_str(), path.c_str()) != 0) {
+        NYMPH_LOG_ERROR("Failed to write KV snapshot {}: {}", path, std::strerror(errno));
+        ::unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+SnapshotReader::SnapshotReader()
+    : fd_(-1), base_(nullptr), length_(0), end_(0), offset_(0), remaining_(0), region_count_(0) {
+}
+
+SnapshotReader::~SnapshotReader() {
+    close();
+}
+
+bool SnapshotReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            NYMPH_LOG_ERROR("Failed to open KV snapshot {}: {}", path, std::strerror(errno));
+        }
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(FileHeader)) {
+        NYMPH_LOG_WARN("KV snapshot {} is too short", path);
+        ::close(fd);
+        return false;
+    }
+    size_t length = static_cast<size_t>(info.st_size);
+    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        NYMPH_LOG_ERROR("Failed to map KV snapshot {}: {}", path, std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    fd_ = fd;
+    base_ = static_cast<const unsigned char*>(mapped);
+    length_ = length;
+
+    FileHeader header;
+    std::memcpy(&header, base_, sizeof(header));
+    if (header.magic != kSnapshotMagic || header.version != kSnapshotVersion ||
+        header.header_bytes != sizeof(FileHeader) ||
+        header.checksum != checksum(base_, offsetof(FileHeader, checksum)) ||
+        header.records_bytes > length_ - sizeof(FileHeader)) {
+        NYMPH_LOG_WARN("KV snapshot {} is not a valid snapshot", path);
+        close();
+        return false;
+    }
+    // Records are decoded front to back
+    ::madvise(const_cast<unsigned char*>(base_), length_, MADV_SEQUENTIAL);
+    layout_.block_size_kb = header.block_size_kb;
+    layout_.total_blocks = header.total_blocks;
+    layout_.spill_slots = header.spill_slots;
+    region_count_ = header.region_count;
+    remaining_ = header.region_count;
+    offset_ = sizeof(FileHeader);
+    end_ = sizeof(FileHeader) + header.records_bytes;
+    return true;
+}
+
+void SnapshotReader::close() {
+    if (base_ != nullptr) {
+        ::munmap(const_cast<unsigned char*>(base_), length_);
+        base_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    length_ = 0;
+    end_ = 0;
+    offset_ = 0;
+    remaining_ = 0;
+    region_count_ = 0;
+    layout_ = SnapshotLayout();
+}
+
+bool SnapshotReader::next(SnapshotRegion& region) {
+    if (remaining_ == 0 || end_ - offset_ < sizeof(RecordHeader)) {
+        return false;
+    }
+    RecordHeader header;
+    const unsigned char* record = base_ + offset_;
+    std::memcpy(&header, record, sizeof(header));
+    if (header.record_bytes > end_ - offset_ ||
+        header.record_bytes != record_bytes(header.name_bytes, header.prefix_count,
+                                            header.block_count, header.spill_count) ||
+        header.checksum != checksum(record + sizeof(uint64_t), header.record_bytes - sizeof(uint64_t))) {
+        NYMPH_LOG_WARN("KV snapshot record at offset {} is damaged; {} regions not restored",
+                       offset_, remaining_);
+        remaining_ = 0;
+        return false;
+    }
+
+    const unsigned char* at = record + sizeof(header);
+    region.name.assign(reinterpret_cast<const char*>(at), header.name_bytes);
+    at += pad8(header.name_bytes);
+    region.prefix_keys.resize(header.prefix_count);
+    copy_bytes(region.prefix_keys.data(), at, header.prefix_count * sizeof(uint64_t));
+    at += header.prefix_count * sizeof(uint64_t);
+    region.blocks.resize(header.block_count);
+    copy_bytes(region.blocks.data(), at, header.block_count * sizeof(uint32_t));
+    at += header.block_count * sizeof(uint32_t);
+    region.spill_slots.resize(header.spill_count);
+    copy_bytes(region.spill_slots.data(), at, header.spill_count * sizeof(uint32_t));
+    region.size_kb = header.size_kb;
+    region.pages = header.pages;
+    region.pinned = header.pinned != 0;
+    region.priority = header.priority;
+    region.accesses = header.accesses;
+    region.hits = header.hits;
+    region.misses = header.misses;
+    region.history = header.history;
+
+    offset_ += header.record_bytes;
+    remaining_--;
+    return true;
+}
+
+} // namespace kv
+} // namespace nymph
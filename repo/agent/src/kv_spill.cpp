@@ -0,0 +1,108 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Spill File Implementation
+ */
+
+#include "kv_spill.hpp"
+#include "logger.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace nymph {
+namespace kv {
+
+static const uint64_t kPageMagic = 0x4e594d50484b5631ULL;    // "NYMPHKV1"
+
+SpillFile::SpillFile() : fd_(-1), base_(nullptr), length_(0) {
+}
+
+SpillFile::~SpillFile() {
+    close();
+}
+
+bool SpillFile::open(const std::string& path, uint64_t capacity_kb, bool keep_contents) {
+    close();
+    uint64_t total_slots = capacity_kb / kSlotSizeKB;
+    if (total_slots == 0) {
+        NYMPH_LOG_ERROR("KV spill file {} is smaller than one slot", path);
+        return false;
+    }
+
+    int flags = O_RDWR | O_CREAT | O_CLOEXEC | (keep_contents ? 0 : O_TRUNC);
+    int fd = ::open(path.c_str(), flags, 0600);
+    if (fd < 0) {
+        NYMPH_LOG_ERROR("Failed to open KV spill file {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    size_t length = static_cast<size_t>(total_slots * BlockAllocator::kBlockSizeBytes);
+    if (::ftruncate(fd, static_cast<off_t>(length)) != 0) {
+        NYMPH_LOG_ERROR("Failed to size KV spill file {}: {}", path, std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    void* base = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        NYMPH_LOG_ERROR("Failed to map KV spill file {}: {}", path, std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    path_ = path;
+    fd_ = fd;
+    base_ = static_cast<unsigned char*>(base);
+    length_ = length;
+    slots_.reset(total_slots, 0);
+    return true;
+}
+
+void SpillFile::close() {
+    if (base_ != nullptr) {
+        ::munmap(base_, length_);
+        base_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    length_ = 0;
+    slots_.reset(0, 0);
+}
+
+bool SpillFile::allocate(uint64_t count, std::vector<uint32_t>& slots) {
+    return is_open() && slots_.allocate(count, slots);
+}
+
+bool SpillFile::claim(uint32_t slot) {
+    return is_open() && slots_.claim(slot);
+}
+
+void SpillFile::release(const std::vector<uint32_t>& slots) {
+    slots_.release(slots);
+}
+
+void SpillFile::reset() {
+    slots_.reset(slots_.total_blocks(), 0);
+}
+
+void SpillFile::write_page(uint32_t slot, uint64_t region_hash, uint64_t page) {
+    PageHeader header = {kPageMagic, region_hash, page};
+    std::memcpy(slot_data(slot), &header, sizeof(header));
+}
+
+bool SpillFile::read_page(uint32_t slot, uint64_t region_hash, uint64_t page) const {
+    PageHeader header;
+    std::memcpy(&header, slot_data(slot), sizeof(header));
+    return header.magic == kPageMagic && header.region_hash == region_hash && header.page == page;
+}
+
+void SpillFile::will_need(const std::vector<uint32_t>& slots) const {
+    for (uint32_t slot : slots) {
+        ::madvise(slot_data(slot), BlockAllocator::kBlockSizeBytes, MADV_WILLNEED);
+    }
+}
+
+} // namespace kv
+} // namespace nymph
@@ -3,42 +3,181 @@
  * NYMPH 1.1 KV-Pinning Implementation
  * 
  * KV Cache Region Manager for LLM inference optimization
- * Stub implementation - simulates KV cache behavior
+ * Hits and misses are measured against page residency
+ *
+ * Lock order: policy_mutex_, then shard locks in index order, then
+ * arena_mutex_ or readback_mutex_. Only initialize(), enable_spill() and
+ * clear() wait for more than one shard; reserve_spill() only try-locks a
+ * second one.
  */
 
 #include "kvpin.hpp"
+#include "json.hpp"
 #include "logger.hpp"
-#include <sstream>
+#include "trace.hpp"
 #include <chrono>
 #include <algorithm>
-#include <iomanip>
-#include <random>
-#include <cstdio>
 
 namespace nymph {
 namespace kv {
 
+/* Address of block 0 in KV cache memory */
+static const uint64_t kArenaBaseAddress = 0x100000;
+
+/* Part of a region's requested size its private resident pages cover */
+static uint64_t resident_kb(const KVRegion& region) {
+    return std::min(region.size_kb, region.blocks.size() * BlockAllocator::kBlockSizeKB) -
+           region.shared_pages * BlockAllocator::kBlockSizeKB;
+}
+
+/* Every private page of the region sits in the spill file */
+static bool all_in_spill(const KVRegion& region) {
+    return region.blocks.size() == region.shared_pages && !region.spill_slots.empty();
+}
+
 /* Global KV Cache Manager instance */
 static std::unique_ptr<KVCacheManager> g_kv_manager = nullptr;
+static std::once_flag g_kv_manager_once;
 
 KVCacheManager& get_kv_cache_manager() {
-    if (!g_kv_manager) {
+    // Request workers and the metrics scrape may race to create it
+    std::call_once(g_kv_manager_once, [] {
         g_kv_manager = std::make_unique<KVCacheManager>();
         g_kv_manager->initialize();
-    }
+    });
     return *g_kv_manager;
 }
 
 KVCacheManager::KVCacheManager()
     : initialized_(false)
     , total_size_kb_(0)
-    , used_size_kb_(0)
-    , next_base_address_(0x100000)  // Start at 1MB
+    , evict_cursor_(0)
+    , policy_(EvictionPolicy::LRU)
+    , requested_kb_(0)
+    , arena_generation_(0)
+    , spill_enabled_(false)
+    , readback_stop_(false)
+    , restore_stop_(false)
 {
 }
 
 KVCacheManager::~KVCacheManager() {
-    // Cleanup if needed
+    restore_stop_.store(true, std::memory_order_relaxed);
+    wait_restore();
+    {
+        std::lock_guard<std::mutex> lock(readback_mutex_);
+        readback_stop_ = true;
+    }
+    readback_cv_.notify_all();
+    for (std::thread& thread : readback_threads_) {
+        thread.join();
+    }
+}
+
+uint32_t KVCacheManager::Shard::find(std::string_view name, uint64_t hash) const {
+    return index.find(name, hash, [this](uint32_t slot) -> std::string_view {
+        return entries[slot].region.name;
+    });
+}
+
+uint32_t KVCacheManager::Shard::add(const std::string& name, uint64_t hash) {
+    uint32_t slot;
+    if (!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(entries.size());
+        entries.emplace_back();
+        counters.reserve(entries.size());
+    }
+    RegionEntry& entry = entries[slot];
+    entry.region = KVRegion();
+    entry.region.name = name;
+    entry.hash = hash;
+    entry.prefix = nullptr;
+    entry.slot = slot;
+    entry.live = true;
+    index.insert(hash, slot);
+    return slot;
+}
+
+void KVCacheManager::Shard::remove(uint32_t slot) {
+    RegionEntry& entry = entries[slot];
+    eviction.remove(entry);
+    if (entry.ListHook<ColdTag>::linked()) {
+        cold.remove(entry);
+    }
+    index.erase(entry.hash, slot);
+    counters.reset(slot);
+    entry.region = KVRegion();
+    entry.prefix = nullptr;
+    entry.live = false;
+    free_slots.push_back(slot);
+}
+
+void KVCacheManager::Shard::clear() {
+    eviction.reset(eviction.policy());
+    cold.clear();
+    index.clear();
+    for (uint32_t slot = 0; slot < entries.size(); slot++) {
+        counters.reset(slot);
+    }
+    entries.clear();
+    free_slots.clear();
+}
+
+void KVCacheManager::Shard::stamp_use(uint32_t slot) {
+    counters.at(RegionCounters::LAST_USE, slot).store(
+        use_clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void KVCacheManager::Shard::settle(uint32_t slot) {
+    RegionEntry& entry = entries[slot];
+    const KVRegion& region = entry.region;
+    bool parked = all_in_spill(region);
+    bool evictable = !region.is_pinned && !parked;
+    if (evictable && !entry.queued) {
+        eviction.insert(entry, eviction_input(slot));
+    } else if (!evictable && entry.queued) {
+        eviction.remove(entry);
+    }
+    bool is_cold = !region.is_pinned && parked;
+    if (is_cold != entry.ListHook<ColdTag>::linked()) {
+        if (is_cold) {
+            cold.push_back(entry);
+        } else {
+            cold.remove(entry);
+        }
+    }
+}
+
+KVRegion KVCacheManager::Shard::snapshot(uint32_t slot) const {
+    KVRegion copy = entries[slot].region;
+    copy.access_count = counters.load(RegionCounters::ACCESSES, slot);
+    copy.hit_count = counters.load(RegionCounters::HITS, slot);
+    copy.miss_count = counters.load(RegionCounters::MISSES, slot);
+    copy.last_access_time = counters.load(RegionCounters::LAST_ACCESS_TIME, slot);
+    copy.window_hit_rate = counters.window_hit_rate(slot);
+    return copy;
+}
+
+EvictionInput KVCacheManager::Shard::eviction_input(uint32_t slot) const {
+    const KVRegion& region = entries[slot].region;
+    EvictionInput input;
+    input.use = counters.load(RegionCounters::LAST_USE, slot);
+    input.hits = counters.load(RegionCounters::HITS, slot);
+    input.blocks = region.blocks.size();
+    input.priority = region.priority;
+    return input;
+}
+
+void KVCacheManager::count_access(bool is_hit) {
+    gauges_.accesses.add();
+    if (is_hit) {
+        gauges_.hits.add();
+    } else {
+        gauges_.misses.add();
+    }
 }
 
 uint64_t KVCacheManager::get_current_time() const {
@@ -47,425 +186,1778 @@ uint64_t KVCacheManager::get_current_time() const {
         now.time_since_epoch()).count();
 }
 
-bool KVCacheManager::initialize(uint64_t total_cache_size_kb) {
-    std::lock_guard<std::mutex> lock(mutex_);
+bool KVCacheManager::initialize(uint64_t total_cache_size_kb, EvictionPolicy policy) {
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(kShards);
+    for (Shard& shard : shards_) {
+        locks.emplace_back(shard.mutex);
+    }
+    std::lock_guard<std::mutex> arena(arena_mutex_);
     
-    if (initialized_) {
+    if (initialized_.load(std::memory_order_relaxed)) {
         return true;
     }
 
-    log::info("Initializing KV Cache Manager with " + 
-              std::to_string(total_cache_size_kb / 1024) + " MB");
+    NYMPH_LOG_INFO("Initializing KV Cache Manager with {} MB", total_cache_size_kb / 1024);
     
-    total_size_kb_ = total_cache_size_kb;
-    used_size_kb_ = 0;
-    next_base_address_ = 0x100000;
-    regions_.clear();
+    // A partial trailing block is not usable
+    uint64_t total_blocks = total_cache_size_kb / BlockAllocator::kBlockSizeKB;
+    blocks_.reset(total_blocks, kArenaBaseAddress);
+    total_size_kb_ = total_blocks * BlockAllocator::kBlockSizeKB;
+    requested_kb_ = 0;
+    prefixes_.clear();
+    gauges_.dedup_saved_kb.store(0, std::memory_order_relaxed);
+    for (Shard& shard : shards_) {
+        shard.clear();
+        shard.eviction.reset(policy);
+    }
+    policy_.store(policy, std::memory_order_relaxed);
+    gauges_.total_size_kb.store(total_size_kb_, std::memory_order_relaxed);
+    gauges_.used_size_kb.store(0, std::memory_order_relaxed);
+    gauges_.regions.store(0, std::memory_order_relaxed);
+    gauges_.pinned_regions.store(0, std::memory_order_relaxed);
     
-    initialized_ = true;
-    log::info("KV Cache Manager initialized (stub mode)");
+    initialized_.store(true, std::memory_order_release);
+    NYMPH_LOG_INFO("KV Cache Manager initialized (stub mode), eviction: {}",
+                   eviction_policy_to_string(policy));
     return true;
 }
 
-bool KVCacheManager::allocate_space(uint64_t size_kb, uint64_t& base_address) {
-    // Check if we have enough space
-    if (used_size_kb_ + size_kb > total_size_kb_) {
+bool KVCacheManager::enable_spill(const std::string& path, uint64_t capacity_kb, bool keep_contents) {
+    {
+        std::vector<std::unique_lock<std::shared_mutex>> locks;
+        locks.reserve(kShards);
+        for (Shard& shard : shards_) {
+            locks.emplace_back(shard.mutex);
+        }
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        if (spill_enabled_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (!spill_.open(path, capacity_kb, keep_contents)) {
+            return false;
+        }
+        spill_enabled_.store(true, std::memory_order_release);
+    }
+    for (size_t i = 0; i < kReadbackThreads; i++) {
+        readback_threads_.emplace_back(&KVCacheManager::readback_loop, this);
+    }
+    NYMPH_LOG_INFO("KV spill tier: {} ({} MB)", path,
+                   spill_.total_slots() * SpillFile::kSlotSizeKB / 1024);
+    return true;
+}
+
+void KVCacheManager::set_eviction_policy(EvictionPolicy policy) {
+    std::lock_guard<std::mutex> switching(policy_mutex_);
+    if (policy_.load(std::memory_order_relaxed) == policy) {
+        return;
+    }
+    policy_.store(policy, std::memory_order_relaxed);
+    for (Shard& shard : shards_) {
+        auto lock = trace::timed_lock(shard.mutex, "kv.lock_wait");
+        apply_eviction_policy(shard, policy);
+    }
+    NYMPH_LOG_INFO("KV eviction policy: {}", eviction_policy_to_string(policy));
+}
+
+EvictionPolicy KVCacheManager::get_eviction_policy() const {
+    return policy_.load(std::memory_order_relaxed);
+}
+
+void KVCacheManager::apply_eviction_policy(Shard& shard, EvictionPolicy policy) {
+    if (policy == shard.eviction.policy()) {
+        return;
+    }
+    // Recency order is not kept across a switch; slot order seeds the new queue
+    shard.eviction.reset(policy);
+    for (RegionEntry& entry : shard.entries) {
+        if (entry.live && !entry.region.is_pinned && !all_in_spill(entry.region)) {
+            shard.eviction.insert(entry, shard.eviction_input(entry.slot));
+        }
+    }
+}
+
+bool KVCacheManager::allocate_space(uint64_t block_count, std::vector<uint32_t>& blocks,
+                                    uint64_t& generation) {
+    std::lock_guard<std::mutex> arena(arena_mutex_);
+    if (!blocks_.allocate(block_count, blocks)) {
         return false;
     }
-    
-    base_address = next_base_address_;
-    next_base_address_ += size_kb * 1024;  // Convert to bytes for address
-    used_size_kb_ += size_kb;
-    
+    generation = arena_generation_;
+    gauges_.used_size_kb.store(blocks_.used_blocks() * BlockAllocator::kBlockSizeKB,
+                               std::memory_order_relaxed);
     return true;
 }
 
+bool KVCacheManager::make_room(uint64_t block_count, bool allow_drop, std::vector<uint32_t>& blocks,
+                               uint64_t& generation, std::string& error) {
+    if (allocate_space(block_count, blocks, generation)) {
+        return true;
+    }
+    // Spilling to the file loses nothing, so it needs no force; only the
+    // shortfall needs freeing
+    if (!allow_drop && !spill_enabled()) {
+        error = "Insufficient cache space";
+        return false;
+    }
+    uint64_t needed_kb = block_count * BlockAllocator::kBlockSizeKB;
+    uint64_t shortfall_kb = needed_kb - std::min(needed_kb, free_size_kb());
+    if (evict(shortfall_kb, allow_drop) < shortfall_kb) {
+        error = "Insufficient space after eviction";
+        return false;
+    }
+    if (!allocate_space(block_count, blocks, generation)) {
+        error = "Failed to allocate space after eviction";
+        return false;
+    }
+    return true;
+}
+
+uint64_t KVCacheManager::attach_blocks(Shard& shard, uint32_t slot, std::vector<uint32_t>& blocks) {
+    RegionEntry& entry = shard.entries[slot];
+    KVRegion& region = entry.region;
+
+    // Pages may have been faulted in or spilled meanwhile; keep what the
+    // region is missing and return the rest. Pages in the spill file come
+    // first and are read back; the others were dropped and start empty.
+    // The region's slots are its own under the shard lock, so the reads
+    // run before the arena lock is taken.
+    uint64_t faulted = std::min<uint64_t>(blocks.size(), region.pages - region.blocks.size());
+    uint64_t from_spill = std::min<uint64_t>(faulted, region.spill_slots.size());
+    std::vector<uint32_t> slots(region.spill_slots.begin(), region.spill_slots.begin() + from_spill);
+    for (uint64_t i = 0; i < from_spill; i++) {
+        uint64_t page = region.blocks.size() + i;
+        if (!spill_.read_page(slots[i], entry.hash, page)) {
+            NYMPH_LOG_WARN("Spill slot {} does not hold page {} of region {}",
+                           slots[i], page, region.name);
+        }
+    }
+
+    std::lock_guard<std::mutex> arena(arena_mutex_);
+    if (from_spill > 0) {
+        spill_.release(slots);
+        region.spill_slots.erase(region.spill_slots.begin(), region.spill_slots.begin() + from_spill);
+        gauges_.spill_used_kb.store(spill_.used_slots() * SpillFile::kSlotSizeKB,
+                                    std::memory_order_relaxed);
+        gauges_.readback_blocks.fetch_add(from_spill, std::memory_order_relaxed);
+    }
+
+    uint64_t before_kb = resident_kb(region);
+    region.blocks.insert(region.blocks.end(), blocks.begin(), blocks.begin() + faulted);
+    blocks.erase(blocks.begin(), blocks.begin() + faulted);
+    blocks_.release(blocks);
+    requested_kb_ += resident_kb(region) - before_kb;
+    gauges_.used_size_kb.store(blocks_.used_blocks() * BlockAllocator::kBlockSizeKB,
+                               std::memory_order_relaxed);
+    region.base_address = region.blocks.empty() ? 0 : blocks_.block_address(region.blocks.front());
+    shard.settle(slot);
+    return faulted;
+}
+
+uint64_t KVCacheManager::free_size_kb() {
+    std::lock_guard<std::mutex> arena(arena_mutex_);
+    return blocks_.free_blocks() * BlockAllocator::kBlockSizeKB;
+}
+
+void KVCacheManager::pin_existing(Shard& shard, uint32_t slot, const KVPinRequest& request,
+                                  bool hit, KVPinResult& result) {
+    RegionEntry& entry = shard.entries[slot];
+    KVRegion& region = entry.region;
+    region.priority = request.priority;
+    RegionCounters& counters = shard.counters;
+    counters.record(slot, hit, get_current_time());
+    shard.stamp_use(slot);
+    count_access(hit);
+
+    uint64_t access_count = counters.load(RegionCounters::ACCESSES, slot);
+    result.success = true;
+    result.hit_rate = static_cast<double>(counters.load(RegionCounters::HITS, slot)) / access_count;
+    result.stats["window_hit_rate"] = counters.window_hit_rate(slot);
+    result.stats["spilled_blocks"] = static_cast<double>(region.pages - region.blocks.size());
+
+    if (region.is_pinned) {
+        // Already pinned, just update stats
+        result.stats["existing_region"] = 1.0;
+        result.stats["access_count"] = static_cast<double>(access_count);
+        NYMPH_LOG_DEBUG("Region already pinned, hit_rate: {:.4f}", result.hit_rate);
+        return;
+    }
+
+    // Re-pin the region; pinned regions are not eviction candidates
+    region.is_pinned = true;
+    shard.settle(slot);
+    region.pin_time = get_current_time();
+    gauges_.pinned_regions.fetch_add(1, std::memory_order_relaxed);
+    result.stats["repinned"] = 1.0;
+}
+
+/* Leading pages of the request that can be shared; only whole pages are */
+static size_t shareable_pages(const KVPinRequest& request) {
+    return static_cast<size_t>(std::min<uint64_t>(request.prefix_pages.size(),
+                                                  request.size_kb / BlockAllocator::kBlockSizeKB));
+}
+
+uint64_t KVCacheManager::pin_fault_blocks(const Shard& shard, uint32_t slot,
+                                          const KVPinRequest& request) {
+    // A region's missing pages have to be faulted in; for a new region,
+    // all of them less those the prefix tree already holds
+    if (slot != RegionIndex::kNoSlot) {
+        const KVRegion& region = shard.entries[slot].region;
+        return region.pages - region.blocks.size();
+    }
+    uint64_t pages = BlockAllocator::blocks_for(request.size_kb);
+    size_t shareable = shareable_pages(request);
+    if (shareable == 0) {
+        return pages;
+    }
+    std::lock_guard<std::mutex> arena(arena_mutex_);
+    return pages - prefixes_.match(request.prefix_pages, shareable);
+}
+
+void KVCacheManager::commit_pin(Shard& shard, uint64_t hash, const KVPinRequest& request,
+                                std::vector<uint32_t>& blocks, KVPinResult& result) {
+    uint32_t slot = shard.find(request.region, hash);
+    if (slot != RegionIndex::kNoSlot) {
+        uint64_t faulted = attach_blocks(shard, slot, blocks);
+        result.stats["faulted_blocks"] = static_cast<double>(faulted);
+        pin_existing(shard, slot, request, faulted == 0, result);
+        return;
+    }
+
+    slot = shard.add(request.region, hash);
+    KVRegion& region = shard.entries[slot].region;
+    region.size_kb = request.size_kb;
+    region.pages = BlockAllocator::blocks_for(request.size_kb);
+    region.is_pinned = true;
+    region.pin_time = get_current_time();
+    region.priority = request.priority;
+    size_t shareable = shareable_pages(request);
+    if (shareable > 0) {
+        // The tree may have changed since the match; pages it lost take
+        // blocks from ours, and past those the rest start lost
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        size_t acquired = 0;
+        shard.entries[slot].prefix = prefixes_.acquire(request.prefix_pages, shareable, blocks,
+                                                       region.blocks, acquired);
+        region.shared_pages = acquired;
+        gauges_.dedup_saved_kb.store(prefixes_.shared_savings() * BlockAllocator::kBlockSizeKB,
+                                     std::memory_order_relaxed);
+    }
+    uint64_t faulted = attach_blocks(shard, slot, blocks);
+
+    // A new region's first pin is a compulsory miss
+    shard.counters.record(slot, false, region.pin_time);
+    shard.stamp_use(slot);
+    gauges_.regions.fetch_add(1, std::memory_order_relaxed);
+    gauges_.pinned_regions.fetch_add(1, std::memory_order_relaxed);
+    count_access(false);
+
+    uint64_t used_kb = gauges_.used_size_kb.load(std::memory_order_relaxed);
+    result.success = true;
+    result.hit_rate = 0.0;
+    result.stats["new_region"] = 1.0;
+    result.stats["base_address"] = static_cast<double>(region.base_address);
+    result.stats["blocks"] = static_cast<double>(region.blocks.size());
+    result.stats["shared_blocks"] = static_cast<double>(region.shared_pages);
+    result.stats["extents"] = static_cast<double>(BlockAllocator::extent_count(region.blocks));
+    result.stats["total_used_kb"] = static_cast<double>(used_kb);
+    result.stats["total_free_kb"] = static_cast<double>(total_size_kb_ - std::min(used_kb, total_size_kb_));
+
+    NYMPH_LOG_DEBUG("Region pinned successfully, {} blocks faulted in", faulted);
+}
+
 KVPinResult KVCacheManager::pin_region(const KVPinRequest& request) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    NYMPH_TRACE_SCOPE("kv.pin_region", "kv");
     
     KVPinResult result;
     result.success = false;
     result.region_name = request.region;
     result.region_size_kb = request.size_kb;
     
-    if (!initialized_) {
+    if (!is_initialized()) {
         result.error_message = "KV Cache Manager not initialized";
         return result;
     }
 
-    log::info("Pinning KV region: " + request.region + 
-              " (" + std::to_string(request.size_kb) + " KB)");
-
-    // Check if region already exists
-    auto it = regions_.find(request.region);
-    if (it != regions_.end()) {
-        // Region exists, update it
-        KVRegion& region = it->second;
-        
-        if (region.is_pinned) {
-            // Already pinned, just update stats
-            region.access_count++;
-            region.hit_count++;
-            region.last_access_time = get_current_time();
-            
-            result.success = true;
-            result.hit_rate = (region.access_count > 0) 
-                ? static_cast<double>(region.hit_count) / region.access_count 
-                : 0.0;
-            result.stats["existing_region"] = 1.0;
-            result.stats["access_count"] = static_cast<double>(region.access_count);
-            
-            log::info("Region already pinned, hit_rate: " + 
-                      std::to_string(result.hit_rate));
+    NYMPH_LOG_DEBUG("Pinning KV region: {} ({} KB)", request.region, request.size_kb);
+
+    if (!request.eviction_policy.empty()) {
+        EvictionPolicy policy;
+        if (!eviction_policy_from_string(request.eviction_policy, policy)) {
+            result.error_message = "Unknown eviction policy: " + request.eviction_policy;
             return result;
         }
-        
-        // Re-pin the region
-        region.is_pinned = true;
-        region.pin_time = get_current_time();
-        region.access_count++;
-        region.hit_count++;
-        region.last_access_time = get_current_time();
-        
-        result.success = true;
-        result.hit_rate = (region.access_count > 0) 
-            ? static_cast<double>(region.hit_count) / region.access_count 
-            : 0.0;
-        result.stats["repinned"] = 1.0;
-        
-        return result;
+        set_eviction_policy(policy);
     }
-    
-    // New region - allocate space
-    uint64_t base_address;
-    if (!allocate_space(request.size_kb, base_address)) {
-        // Try to evict if force is set
-        if (request.force) {
-            uint64_t freed = evict_lru(request.size_kb);
-            if (freed >= request.size_kb) {
-                if (!allocate_space(request.size_kb, base_address)) {
-                    result.error_message = "Failed to allocate space after eviction";
-                    return result;
-                }
-            } else {
-                result.error_message = "Insufficient space after eviction";
-                return result;
-            }
-        } else {
-            result.error_message = "Insufficient cache space";
+
+    uint64_t hash = region_hash(request.region);
+    Shard& shard = shard_of(hash);
+
+    // A fully resident region is a hit
+    uint64_t fault_blocks;
+    {
+        auto lock = trace::timed_lock(shard.mutex, "kv.lock_wait");
+        uint32_t slot = shard.find(request.region, hash);
+        fault_blocks = pin_fault_blocks(shard, slot, request);
+        if (slot != RegionIndex::kNoSlot && fault_blocks == 0) {
+            pin_existing(shard, slot, request, true, result);
             return result;
         }
     }
     
-    // Create new region
-    KVRegion region;
-    region.name = request.region;
-    region.size_kb = request.size_kb;
-    region.base_address = base_address;
-    region.is_pinned = true;
-    region.access_count = 1;
-    region.hit_count = 1;
-    region.miss_count = 0;
-    region.last_access_time = get_current_time();
-    region.pin_time = get_current_time();
-    
-    regions_[request.region] = region;
-    
-    // Simulate realistic hit rate based on region characteristics
-    // New regions start with high hit rate (warm cache)
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.75, 0.95);  // 75-95% hit rate
-    
-    result.success = true;
-    result.hit_rate = dis(gen);
-    result.stats["new_region"] = 1.0;
-    result.stats["base_address"] = static_cast<double>(base_address);
-    result.stats["total_used_kb"] = static_cast<double>(used_size_kb_);
-    result.stats["total_free_kb"] = static_cast<double>(total_size_kb_ - used_size_kb_);
-    
-    log::info("Region pinned successfully, hit_rate: " + 
-              std::to_string(result.hit_rate));
+    // Allocate the faulted pages. No shard lock is held: eviction locks
+    // the other shards one by one.
+    std::vector<uint32_t> blocks;
+    uint64_t generation = 0;
+    if (!make_room(fault_blocks, request.force, blocks, generation, result.error_message)) {
+        return result;
+    }
     
+    auto lock = trace::timed_lock(shard.mutex, "kv.lock_wait");
+    {
+        // clear() needs every shard lock, so this holds until we unlock
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        if (generation != arena_generation_) {
+            result.error_message = "KV cache was cleared during the pin";
+            return result;
+        }
+    }
+    commit_pin(shard, hash, request, blocks, result);
     return result;
 }
 
+void KVCacheManager::unpin_slot(Shard& shard, uint32_t slot) {
+    RegionEntry& entry = shard.entries[slot];
+    if (entry.region.is_pinned) {
+        entry.region.is_pinned = false;
+        shard.stamp_use(slot);
+        shard.settle(slot);
+        gauges_.pinned_regions.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
 bool KVCacheManager::unpin_region(const std::string& region_name) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto it = regions_.find(region_name);
-    if (it == regions_.end()) {
-        return false;
+    uint64_t hash = region_hash(region_name);
+    Shard& shard = shard_of(hash);
+    {
+        auto lock = trace::timed_lock(shard.mutex, "kv.lock_wait");
+
+        uint32_t slot = shard.find(region_name, hash);
+        if (slot == RegionIndex::kNoSlot) {
+            return false;
+        }
+        unpin_slot(shard, slot);
     }
-    
-    it->second.is_pinned = false;
-    log::info("Region unpinned: " + region_name);
+    NYMPH_LOG_INFO("Region unpinned: {}", region_name);
     return true;
 }
 
-bool KVCacheManager::access_region(const std::string& region_name, bool is_read) {
-    (void)is_read;  // Could be used for write-through cache logic
-    
-    std::lock_guard<std::mutex> lock(mutex_);
+/* record_access copy_from when the access needs no copy */
+static const uint64_t kNoCopy = UINT64_MAX;
+
+bool KVCacheManager::record_access(Shard& shard, uint32_t slot, bool is_read, uint64_t offset_kb,
+                                   uint64_t& copy_from) {
+    // Everything an access changes is atomic, so a read lock will do
+    const KVRegion& region = shard.entries[slot].region;
+    uint64_t resident = region.blocks.size();
+    uint64_t first_page = 0;
+    bool hit;
+    copy_from = kNoCopy;
+    if (offset_kb == kWholeRegion) {
+        hit = resident == region.pages;
+    } else {
+        first_page = offset_kb / BlockAllocator::kBlockSizeKB;
+        if (first_page >= region.pages) {
+            return false;
+        }
+        hit = first_page < resident;
+    }
+    shard.counters.record(slot, hit, get_current_time());
+    count_access(hit);
+    if (!region.is_pinned) {
+        // Queue order is fixed up lazily when this region comes up as a victim
+        shard.stamp_use(slot);
+    }
+    if (!hit && !region.spill_slots.empty()) {
+        queue_readback(region.name);
+    }
+    if (!is_read && first_page < region.shared_pages) {
+        copy_from = first_page;
+    }
+    return hit;
+}
+
+bool KVCacheManager::access_region(const std::string& region_name, bool is_read,
+                                   uint64_t offset_kb, bool force) {
+    // Read lock only: the block table only changes under the write lock
+    uint64_t hash = region_hash(region_name);
+    Shard& shard = shard_of(hash);
+    auto lock = trace::timed_shared_lock(shard.mutex, "kv.lock_wait");
     
-    auto it = regions_.find(region_name);
-    if (it == regions_.end()) {
+    uint32_t slot = shard.find(region_name, hash);
+    if (slot == RegionIndex::kNoSlot) {
+        count_access(false);    // Never pinned, or dropped by eviction
         return false;
     }
     
-    KVRegion& region = it->second;
-    region.access_count++;
-    region.last_access_time = get_current_time();
+    uint64_t copy_from;
+    bool hit = record_access(shard, slot, is_read, offset_kb, copy_from);
+    if (copy_from != kNoCopy) {
+        lock.unlock();
+        std::string error;
+        if (!copy_on_write(region_name, hash, copy_from, force, error)) {
+            NYMPH_LOG_WARN("Copy-on-write of region {} failed: {}", region_name, error);
+            return false;
+        }
+    }
     
-    // Simulate hit/miss based on pinned status
-    if (region.is_pinned) {
-        // Pinned regions have high hit rate (90-99%)
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(0.0, 1.0);
-        
-        if (dis(gen) < 0.95) {  // 95% hit rate for pinned regions
-            region.hit_count++;
-        } else {
-            region.miss_count++;
+    return hit;
+}
+
+void KVCacheManager::unshare_pages(Shard& shard, uint32_t slot, uint64_t first_page,
+                                   std::vector<uint32_t>& blocks) {
+    RegionEntry& entry = shard.entries[slot];
+    KVRegion& region = entry.region;
+    if (region.shared_pages <= first_page) {
+        return;
+    }
+    // Later pages were computed from the written one, so they diverge
+    // too: the region leaves the tree from first_page down
+    uint64_t copies = region.shared_pages - first_page;
+    std::vector<uint32_t> freed;
+    entry.prefix = prefixes_.release(entry.prefix, copies, freed);
+    blocks_.release(freed);
+    std::copy(blocks.end() - copies, blocks.end(), region.blocks.begin() + first_page);
+    blocks.resize(blocks.size() - copies);
+    uint64_t before_kb = resident_kb(region);
+    region.shared_pages = first_page;
+    requested_kb_ += resident_kb(region) - before_kb;
+    region.base_address = blocks_.block_address(region.blocks.front());
+    gauges_.cow_blocks.fetch_add(copies, std::memory_order_relaxed);
+    gauges_.dedup_saved_kb.store(prefixes_.shared_savings() * BlockAllocator::kBlockSizeKB,
+                                 std::memory_order_relaxed);
+    gauges_.used_size_kb.store(blocks_.used_blocks() * BlockAllocator::kBlockSizeKB,
+                               std::memory_order_relaxed);
+}
+
+bool KVCacheManager::copy_on_write(const std::string& region_name, uint64_t hash,
+                                   uint64_t first_page, bool allow_drop, std::string& error) {
+    NYMPH_TRACE_SCOPE("kv.copy_on_write", "kv");
+    Shard& shard = shard_of(hash);
+    uint64_t wanted = 0;
+    {
+        auto lock = trace::timed_shared_lock(shard.mutex, "kv.lock_wait");
+        uint32_t slot = shard.find(region_name, hash);
+        if (slot == RegionIndex::kNoSlot) {
+            return true;
         }
-    } else {
-        // Unpinned regions have lower hit rate (50-70%)
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(0.0, 1.0);
-        
-        if (dis(gen) < 0.60) {  // 60% hit rate for unpinned regions
-            region.hit_count++;
-        } else {
-            region.miss_count++;
+        uint64_t shared = shard.entries[slot].region.shared_pages;
+        wanted = shared > first_page ? shared - first_page : 0;
+    }
+
+    while (wanted > 0) {
+        // Room comes from spilling colder pages, as for a pin; only a
+        // forced write may drop other regions
+        std::vector<uint32_t> blocks;
+        uint64_t generation = 0;
+        if (!make_room(wanted, allow_drop, blocks, generation, error)) {
+            return false;
+        }
+
+        auto lock = trace::timed_lock(shard.mutex, "kv.lock_wait");
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        if (generation != arena_generation_) {
+            return true;    // Cleared meanwhile, the region with it
+        }
+        uint32_t slot = shard.find(region_name, hash);
+        uint64_t copies = 0;
+        if (slot != RegionIndex::kNoSlot) {
+            RegionEntry& entry = shard.entries[slot];
+            KVRegion& region = entry.region;
+            // Another writer may have copied some of them meanwhile, or the
+            // region was dropped and pinned again with more shared pages
+            if (region.shared_pages > first_page) {
+                copies = region.shared_pages - first_page;
+            }
+            if (copies > blocks.size()) {
+                // Too few blocks to unshare all of them: size again
+                wanted = copies;
+                blocks_.release(blocks);
+                gauges_.used_size_kb.store(blocks_.used_blocks() * BlockAllocator::kBlockSizeKB,
+                                           std::memory_order_relaxed);
+                continue;
+            }
+            unshare_pages(shard, slot, first_page, blocks);
         }
+        blocks_.release(blocks);
+        gauges_.used_size_kb.store(blocks_.used_blocks() * BlockAllocator::kBlockSizeKB,
+                                   std::memory_order_relaxed);
+        if (copies > 0) {
+            NYMPH_LOG_DEBUG("Copied {} shared blocks of region: {}", copies, region_name);
+        }
+        return true;
     }
-    
     return true;
 }
 
+/* Per-batch state shared by its shard groups */
+struct KVCacheManager::BatchWork {
+    const std::vector<KVOp>& ops;
+    KVBatchResult& batch;
+    bool atomic;
+    bool allow_drop;                        // Some pin or write has force
+    std::vector<uint64_t> hashes;           // region_hash of each op's region
+    std::vector<uint32_t> alias;            // First op naming the same region
+    std::vector<bool> skipped;              // Refused before any lock was taken
+    std::vector<std::pair<uint32_t, uint64_t>> copies;  // Op and first page of shared writes, copied later
+
+    /* A region's state as the group's ops leave it, by alias */
+    struct Planned {
+        bool known;
+        bool exists;
+        bool pinned;
+        uint64_t missing;   // Pages to fault in
+        uint64_t pages;     // Region size in pages
+        uint64_t shared;    // Shared pages; at most this many for a region the batch pins
+    };
+    std::vector<Planned> planned;
+
+    BatchWork(const std::vector<KVOp>& batch_ops, KVBatchResult& result, bool all_or_nothing)
+        : ops(batch_ops), batch(result), atomic(all_or_nothing), allow_drop(false)
+        , hashes(batch_ops.size()), alias(batch_ops.size()), skipped(batch_ops.size(), false)
+        , planned(batch_ops.size()) {}
+
+    void refuse(size_t i, const std::string& error) {
+        skipped[i] = true;
+        batch.results[i].error_message = error;
+        if (atomic && batch.error_message.empty()) {
+            batch.error_message = "Op " + std::to_string(i) + ": " + error;
+        }
+    }
+};
+
+KVBatchResult KVCacheManager::apply_batch(const std::vector<KVOp>& ops, bool atomic) {
+    NYMPH_TRACE_SCOPE("kv.apply_batch", "kv");
+
+    KVBatchResult batch;
+    batch.success = false;
+    batch.results.resize(ops.size());
+    for (KVOpResult& result : batch.results) {
+        result.success = false;
+        result.hit = false;
+        result.pin.success = false;
+        result.pin.hit_rate = 0.0;
+        result.pin.region_size_kb = 0;
+    }
+
+    if (!is_initialized()) {
+        batch.error_message = "KV Cache Manager not initialized";
+        return batch;
+    }
+    if (ops.size() > kMaxBatchOps) {
+        batch.error_message = "Batch exceeds " + std::to_string(kMaxBatchOps) + " ops";
+        return batch;
+    }
+
+    BatchWork work(ops, batch, atomic);
+    uint32_t touched = 0;
+    for (size_t i = 0; i < ops.size(); i++) {
+        const KVOp& op = ops[i];
+        work.hashes[i] = region_hash(op.pin.region);
+        touched |= 1u << (work.hashes[i] & (kShards - 1));
+        EvictionPolicy policy;
+        if (op.type == KVOpType::ACCESS && !op.is_read) {
+            work.allow_drop = work.allow_drop || op.pin.force;
+        }
+        if (op.type == KVOpType::PIN) {
+            work.allow_drop = work.allow_drop || op.pin.force;
+            if (!op.pin.eviction_policy.empty() &&
+                !eviction_policy_from_string(op.pin.eviction_policy, policy)) {
+                work.refuse(i, "Unknown eviction policy: " + op.pin.eviction_policy);
+            }
+        }
+    }
+    if (!batch.error_message.empty()) {
+        return batch;
+    }
+
+    // Alias each op to the first naming its region, through a small
+    // open-addressing table of op indices (at most half full)
+    size_t buckets = 16;
+    while (buckets < ops.size() * 2) {
+        buckets *= 2;
+    }
+    std::vector<uint32_t> first(buckets, RegionIndex::kNoSlot);
+    for (uint32_t i = 0; i < ops.size(); i++) {
+        size_t bucket = (work.hashes[i] >> 4) & (buckets - 1);
+        while (first[bucket] != RegionIndex::kNoSlot &&
+               (work.hashes[first[bucket]] != work.hashes[i] ||
+                ops[first[bucket]].pin.region != ops[i].pin.region)) {
+            bucket = (bucket + 1) & (buckets - 1);
+        }
+        if (first[bucket] == RegionIndex::kNoSlot) {
+            first[bucket] = i;
+        }
+        work.alias[i] = first[bucket];
+    }
+
+    // Policy switches take policy_mutex_, which comes before any shard
+    // lock. An all or nothing batch switches only once it has applied, as
+    // a refused one must leave the policy as it was.
+    bool switch_policy = false;
+    EvictionPolicy requested = EvictionPolicy::LRU;
+    for (size_t i = 0; i < ops.size(); i++) {
+        EvictionPolicy policy;
+        if (!work.skipped[i] && ops[i].type == KVOpType::PIN && !ops[i].pin.eviction_policy.empty() &&
+            eviction_policy_from_string(ops[i].pin.eviction_policy, policy)) {
+            if (atomic) {
+                switch_policy = true;
+                requested = policy;
+            } else {
+                set_eviction_policy(policy);
+            }
+        }
+    }
+
+    // All or nothing needs every shard at once. Otherwise each shard is
+    // locked on its own, so batches on other threads only wait for the
+    // shards they share; a region's ops stay in one group, in order.
+    std::vector<uint32_t> group;
+    group.reserve(ops.size());
+    if (atomic) {
+        for (uint32_t i = 0; i < ops.size(); i++) {
+            group.push_back(i);
+        }
+        if (apply_group(work, group, touched) && switch_policy) {
+            set_eviction_policy(requested);
+        }
+    } else {
+        // Bucket the ops by shard, keeping batch order within each
+        size_t starts[kShards + 1] = {};
+        for (uint64_t hash : work.hashes) {
+            starts[(hash & (kShards - 1)) + 1]++;
+        }
+        for (size_t index = 0; index < kShards; index++) {
+            starts[index + 1] += starts[index];
+        }
+        std::vector<uint32_t> by_shard(ops.size());
+        size_t fill[kShards];
+        std::copy(starts, starts + kShards, fill);
+        for (uint32_t i = 0; i < ops.size(); i++) {
+            by_shard[fill[work.hashes[i] & (kShards - 1)]++] = i;
+        }
+        for (size_t index = 0; index < kShards; index++) {
+            if (starts[index] == starts[index + 1]) {
+                continue;
+            }
+            group.assign(by_shard.begin() + starts[index], by_shard.begin() + starts[index + 1]);
+            apply_group(work, group, 1u << index);
+        }
+    }
+
+    for (const auto& copy : work.copies) {
+        const KVOp& op = ops[copy.first];
+        std::string error;
+        if (!copy_on_write(op.pin.region, work.hashes[copy.first], copy.second, op.pin.force, error)) {
+            KVOpResult& result = batch.results[copy.first];
+            result.success = false;
+            result.error_message = "Copy-on-write failed: " + error;
+        }
+    }
+    batch.success = batch.error_message.empty();
+    for (const KVOpResult& result : batch.results) {
+        batch.success = batch.success && result.success;
+    }
+    return batch;
+}
+
+bool KVCacheManager::apply_group(BatchWork& work, const std::vector<uint32_t>& group, uint32_t shard_mask) {
+    const std::vector<KVOp>& ops = work.ops;
+    KVBatchResult& batch = work.batch;
+
+    // Blocks for the pins. Usually the arena has them and the shards are
+    // locked once; otherwise the locks are dropped while make_room evicts,
+    // as eviction locks shards one by one, and the plan is redone.
+    std::vector<uint32_t> reserved;
+    uint64_t reserved_generation = 0;
+    bool have_reserve = false;
+    auto release_reserved = [this, &reserved] {
+        if (reserved.empty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        blocks_.release(reserved);
+        reserved.clear();
+        gauges_.used_size_kb.store(blocks_.used_blocks() * BlockAllocator::kBlockSizeKB,
+                                   std::memory_order_relaxed);
+    };
+
+    for (int attempt = 0;; attempt++) {
+        std::vector<std::unique_lock<std::shared_mutex>> locks;
+        for (size_t index = 0; index < kShards; index++) {
+            if (shard_mask & (1u << index)) {
+                locks.push_back(trace::timed_lock(shards_[index].mutex, "kv.lock_wait"));
+            }
+        }
+        if (have_reserve) {
+            std::lock_guard<std::mutex> arena(arena_mutex_);
+            if (reserved_generation != arena_generation_) {
+                // The reserve went with the old arena
+                batch.error_message = "KV cache was cleared during the batch";
+                for (uint32_t i : group) {
+                    batch.results[i].error_message = batch.error_message;
+                }
+                return false;
+            }
+        }
+
+        // Plan against the locked state, as the ops will leave it in turn
+        uint64_t wanted = 0;
+        for (uint32_t i : group) {
+            work.planned[work.alias[i]].known = false;
+        }
+        for (uint32_t i : group) {
+            if (work.skipped[i]) {
+                continue;
+            }
+            const KVOp& op = ops[i];
+            Shard& shard = shard_of(work.hashes[i]);
+            BatchWork::Planned& state = work.planned[work.alias[i]];
+            if (!state.known) {
+                uint32_t slot = shard.find(op.pin.region, work.hashes[i]);
+                state = {true, false, false, 0, 0, 0};
+                if (slot != RegionIndex::kNoSlot) {
+                    const KVRegion& region = shard.entries[slot].region;
+                    state = {true, true, region.is_pinned, region.pages - region.blocks.size(),
+                             region.pages, region.shared_pages};
+                }
+            }
+            switch (op.type) {
+                case KVOpType::PIN:
+                    // Prefix pages matched now may be released by other
+                    // shards before the pin, so all or nothing reserves
+                    // every page of a new region
+                    if (state.exists) {
+                        wanted += state.missing;
+                    } else {
+                        state.pages = BlockAllocator::blocks_for(op.pin.size_kb);
+                        state.shared = shareable_pages(op.pin);
+                        wanted += work.atomic
+                            ? state.pages : pin_fault_blocks(shard, RegionIndex::kNoSlot, op.pin);
+                    }
+                    state = {true, true, true, 0, state.pages, state.shared};
+                    break;
+                case KVOpType::UNPIN:
+                    if (work.atomic && !state.exists) {
+                        work.refuse(i, "Region not found");
+                    }
+                    state.pinned = false;
+                    break;
+                case KVOpType::ACCESS:
+                    if (work.atomic && state.exists && op.offset_kb != kWholeRegion &&
+                        op.offset_kb / BlockAllocator::kBlockSizeKB >= state.pages) {
+                        work.refuse(i, "Offset out of range");
+                    } else if (work.atomic && state.exists && !op.is_read) {
+                        // The copies of shared pages written come from the reserve too
+                        uint64_t first_page = op.offset_kb == kWholeRegion
+                            ? 0 : op.offset_kb / BlockAllocator::kBlockSizeKB;
+                        if (first_page < state.shared) {
+                            wanted += state.shared - first_page;
+                            state.shared = first_page;
+                        }
+                    }
+                    break;
+                case KVOpType::EVICT:
+                    if (work.atomic && !state.exists) {
+                        work.refuse(i, "Region not found");
+                    } else if (work.atomic && state.pinned) {
+                        work.refuse(i, "Region is pinned");
+                    }
+                    state = {true, false, false, 0, 0, 0};
+                    break;
+            }
+        }
+        if (!batch.error_message.empty()) {
+            release_reserved();
+            return false;
+        }
+
+        if (reserved.size() < wanted) {
+            uint64_t generation = 0;
+            if (allocate_space(wanted - reserved.size(), reserved, generation)) {
+                reserved_generation = generation;
+                have_reserve = true;
+            } else if (attempt == 0) {
+                locks.clear();
+                std::string error;
+                if (make_room(wanted - reserved.size(), work.allow_drop, reserved, generation, error)) {
+                    reserved_generation = generation;
+                    have_reserve = true;
+                }
+                continue;
+            } else if (work.atomic) {
+                batch.error_message = "Insufficient cache space";
+                release_reserved();
+                return false;
+            }
+        }
+
+        // Apply in batch order; the plan above guarantees an atomic batch succeeds
+        for (uint32_t i : group) {
+            if (work.skipped[i]) {
+                continue;
+            }
+            const KVOp& op = ops[i];
+            KVOpResult& result = batch.results[i];
+            Shard& shard = shard_of(work.hashes[i]);
+            if (op.type == KVOpType::PIN) {
+                // The plan sized the reserve; the blocks taken follow the
+                // live state, which differs when an earlier op failed. A
+                // new region in an all or nothing batch takes every page
+                // it reserved, and commit_pin returns those it shares.
+                result.pin.region_name = op.pin.region;
+                result.pin.region_size_kb = op.pin.size_kb;
+                uint32_t slot = shard.find(op.pin.region, work.hashes[i]);
+                uint64_t need = (work.atomic && slot == RegionIndex::kNoSlot)
+                    ? BlockAllocator::blocks_for(op.pin.size_kb) : pin_fault_blocks(shard, slot, op.pin);
+                if (slot != RegionIndex::kNoSlot && need == 0) {
+                    pin_existing(shard, slot, op.pin, true, result.pin);
+                    result.hit = true;
+                    result.success = true;
+                    continue;
+                }
+                uint64_t generation = 0;
+                if (need > reserved.size() &&
+                    !allocate_space(need - reserved.size(), reserved, generation)) {
+                    result.error_message = "Insufficient cache space";
+                    continue;
+                }
+                std::vector<uint32_t> blocks(reserved.end() - need, reserved.end());
+                reserved.resize(reserved.size() - need);
+                // Returns the blocks it does not attach to the arena
+                commit_pin(shard, work.hashes[i], op.pin, blocks, result.pin);
+                auto faulted = result.pin.stats.find("faulted_blocks");
+                result.hit = faulted != result.pin.stats.end() && faulted->second == 0.0;
+                result.success = result.pin.success;
+                continue;
+            }
+
+            uint32_t slot = shard.find(op.pin.region, work.hashes[i]);
+            if (slot == RegionIndex::kNoSlot) {
+                if (op.type == KVOpType::ACCESS) {
+                    count_access(false);
+                    result.success = true;
+                } else {
+                    result.error_message = "Region not found";
+                }
+                continue;
+            }
+            switch (op.type) {
+                case KVOpType::UNPIN:
+                    unpin_slot(shard, slot);
+                    result.success = true;
+                    break;
+                case KVOpType::ACCESS: {
+                    if (op.offset_kb != kWholeRegion &&
+                        op.offset_kb / BlockAllocator::kBlockSizeKB >= shard.entries[slot].region.pages) {
+                        result.error_message = "Offset out of range";
+                        break;
+                    }
+                    uint64_t copy_from;
+                    result.hit = record_access(shard, slot, op.is_read, op.offset_kb, copy_from);
+                    result.success = true;
+                    if (copy_from == kNoCopy) {
+                        break;
+                    }
+                    if (work.atomic &&
+                        reserved.size() >= shard.entries[slot].region.shared_pages - copy_from) {
+                        // The plan reserved a block for every page copied
+                        std::lock_guard<std::mutex> arena(arena_mutex_);
+                        unshare_pages(shard, slot, copy_from, reserved);
+                    } else {
+                        work.copies.emplace_back(i, copy_from);
+                    }
+                    break;
+                }
+                case KVOpType::EVICT:
+                    if (shard.entries[slot].region.is_pinned) {
+                        result.error_message = "Region is pinned";
+                        break;
+                    }
+                    drop_region(shard, slot);
+                    result.success = true;
+                    break;
+                case KVOpType::PIN:
+                    break;
+            }
+        }
+        release_reserved();
+        return true;
+    }
+}
+
 bool KVCacheManager::get_region(const std::string& region_name, KVRegion& region) const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t hash = region_hash(region_name);
+    const Shard& shard = shard_of(hash);
+    auto lock = trace::timed_shared_lock(shard.mutex, "kv.lock_wait");
     
-    auto it = regions_.find(region_name);
-    if (it == regions_.end()) {
+    uint32_t slot = shard.find(region_name, hash);
+    if (slot == RegionIndex::kNoSlot) {
         return false;
     }
     
-    region = it->second;
+    region = shard.snapshot(slot);
     return true;
 }
 
 KVCacheStats KVCacheManager::get_stats() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
     KVCacheStats stats;
-    stats.total_size_kb = total_size_kb_;
-    stats.used_size_kb = used_size_kb_;
-    stats.free_size_kb = total_size_kb_ - used_size_kb_;
     stats.pinned_regions = 0;
     stats.total_accesses = 0;
     stats.total_hits = 0;
     stats.total_misses = 0;
+    stats.split_regions = 0;
+    stats.spilled_regions = 0;
+    stats.spilled_kb = 0;
+    stats.evictable_regions = 0;
     
-    for (const auto& pair : regions_) {
-        const KVRegion& region = pair.second;
-        if (region.is_pinned) {
-            stats.pinned_regions++;
-            stats.pinned_region_names.push_back(region.name);
+    for (const Shard& shard : shards_) {
+        auto lock = trace::timed_shared_lock(shard.mutex, "kv.lock_wait");
+        // Free slots hold zero counters, so the columns sum without a liveness check
+        size_t slots = shard.entries.size();
+        stats.total_accesses += shard.counters.sum(RegionCounters::ACCESSES, slots);
+        stats.total_hits += shard.counters.sum(RegionCounters::HITS, slots);
+        stats.total_misses += shard.counters.sum(RegionCounters::MISSES, slots);
+        for (const RegionEntry& entry : shard.entries) {
+            if (!entry.live) {
+                continue;
+            }
+            if (entry.region.is_pinned) {
+                stats.pinned_regions++;
+                stats.pinned_region_names.push_back(entry.region.name);
+            }
+            if (BlockAllocator::extent_count(entry.region.blocks) > 1) {
+                stats.split_regions++;
+            }
+            uint64_t spilled = entry.region.pages - entry.region.blocks.size();
+            if (spilled > 0) {
+                stats.spilled_regions++;
+                stats.spilled_kb += spilled * BlockAllocator::kBlockSizeKB;
+            }
         }
-        stats.total_accesses += region.access_count;
-        stats.total_hits += region.hit_count;
-        stats.total_misses += region.miss_count;
+        stats.evictable_regions += shard.eviction.size();
     }
+    std::sort(stats.pinned_region_names.begin(), stats.pinned_region_names.end());
     
     stats.overall_hit_rate = (stats.total_accesses > 0) 
         ? static_cast<double>(stats.total_hits) / stats.total_accesses 
         : 0.0;
+
+    {
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        BlockFragmentation layout = blocks_.fragmentation();
+        stats.total_size_kb = total_size_kb_;
+        stats.used_size_kb = blocks_.used_blocks() * BlockAllocator::kBlockSizeKB;
+        stats.free_size_kb = stats.total_size_kb - stats.used_size_kb;
+        stats.block_size_kb = BlockAllocator::kBlockSizeKB;
+        stats.total_blocks = blocks_.total_blocks();
+        stats.free_blocks = blocks_.free_blocks();
+        stats.free_extents = layout.free_extents;
+        stats.largest_free_extent_kb = layout.largest_free_extent * BlockAllocator::kBlockSizeKB;
+        stats.fragmentation = layout.external;
+        // Shared blocks are whole pages, so none of their space is waste
+        stats.shared_blocks = prefixes_.blocks();
+        stats.dedup_saved_kb = prefixes_.shared_savings() * BlockAllocator::kBlockSizeKB;
+        stats.internal_waste_kb = stats.used_size_kb - requested_kb_ -
+                                  stats.shared_blocks * BlockAllocator::kBlockSizeKB;
+        stats.spill_total_kb = spill_.total_slots() * SpillFile::kSlotSizeKB;
+        stats.spill_used_kb = spill_.used_slots() * SpillFile::kSlotSizeKB;
+    }
+    stats.eviction_policy = get_eviction_policy();
     
     return stats;
 }
 
+KVCacheGauges KVCacheManager::get_gauges() const {
+    KVCacheGauges gauges;
+    gauges.total_size_kb = gauges_.total_size_kb.load(std::memory_order_relaxed);
+    gauges.used_size_kb = gauges_.used_size_kb.load(std::memory_order_relaxed);
+    gauges.regions = gauges_.regions.load(std::memory_order_relaxed);
+    gauges.pinned_regions = gauges_.pinned_regions.load(std::memory_order_relaxed);
+    gauges.accesses = gauges_.accesses.value();
+    gauges.hits = gauges_.hits.value();
+    gauges.misses = gauges_.misses.value();
+    gauges.evictions = gauges_.evictions.load(std::memory_order_relaxed);
+    gauges.spilled_blocks = gauges_.spilled_blocks.load(std::memory_order_relaxed);
+    gauges.spill_used_kb = gauges_.spill_used_kb.load(std::memory_order_relaxed);
+    gauges.readback_blocks = gauges_.readback_blocks.load(std::memory_order_relaxed);
+    gauges.dedup_saved_kb = gauges_.dedup_saved_kb.load(std::memory_order_relaxed);
+    gauges.cow_blocks = gauges_.cow_blocks.load(std::memory_order_relaxed);
+    return gauges;
+}
+
 std::vector<KVRegion> KVCacheManager::list_regions() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
     std::vector<KVRegion> result;
-    for (const auto& pair : regions_) {
-        result.push_back(pair.second);
+    result.reserve(gauges_.regions.load(std::memory_order_relaxed));
+    for (const Shard& shard : shards_) {
+        auto lock = trace::timed_shared_lock(shard.mutex, "kv.lock_wait");
+        for (const RegionEntry& entry : shard.entries) {
+            if (entry.live) {
+                result.push_back(shard.snapshot(entry.slot));
+            }
+        }
     }
+    std::sort(result.begin(), result.end(),
+              [](const KVRegion& a, const KVRegion& b) { return a.name < b.name; });
     return result;
 }
 
-uint64_t KVCacheManager::evict_lru(uint64_t required_kb) {
-    // Already holding lock from caller
-    
-    // Sort regions by last access time (oldest first)
-    std::vector<std::pair<std::string, uint64_t>> candidates;
-    for (const auto& pair : regions_) {
-        if (!pair.second.is_pinned) {  // Only evict unpinned regions
-            candidates.push_back({pair.first, pair.second.last_access_time});
+uint64_t KVCacheManager::drop_region(Shard& shard, uint32_t slot) {
+    RegionEntry& entry = shard.entries[slot];
+    KVRegion& region = entry.region;
+    uint64_t freed_blocks;
+    {
+        // Shared pages are only freed with their last region
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        std::vector<uint32_t> freed(region.blocks.begin() + region.shared_pages, region.blocks.end());
+        prefixes_.release(entry.prefix, region.shared_pages, freed);
+        freed_blocks = freed.size();
+        blocks_.release(freed);
+        spill_.release(region.spill_slots);
+        requested_kb_ -= resident_kb(region);
+        gauges_.used_size_kb.store(blocks_.used_blocks() * BlockAllocator::kBlockSizeKB,
+                                   std::memory_order_relaxed);
+        gauges_.spill_used_kb.store(spill_.used_slots() * SpillFile::kSlotSizeKB,
+                                    std::memory_order_relaxed);
+        gauges_.dedup_saved_kb.store(prefixes_.shared_savings() * BlockAllocator::kBlockSizeKB,
+                                     std::memory_order_relaxed);
+    }
+    NYMPH_LOG_INFO("Evicting region: {}", region.name);
+    if (region.is_pinned) {
+        gauges_.pinned_regions.fetch_sub(1, std::memory_order_relaxed);
+    }
+    shard.remove(slot);
+    gauges_.regions.fetch_sub(1, std::memory_order_relaxed);
+    gauges_.evictions.fetch_add(1, std::memory_order_relaxed);
+    return freed_blocks;
+}
+
+bool KVCacheManager::reserve_spill(Shard& shard, uint64_t count, std::vector<uint32_t>& slots) {
+    // Make room by dropping the oldest regions wholly in the file, from
+    // this shard and then from any other shard whose lock is free; waiting
+    // for one could deadlock against a thread evicting there
+    auto allocate = [&] {
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        return spill_.allocate(count, slots);
+    };
+    while (!allocate()) {
+        RegionEntry* oldest = shard.cold.front();
+        if (oldest != nullptr) {
+            drop_region(shard, oldest->slot);
+            continue;
+        }
+        bool dropped = false;
+        for (Shard& other : shards_) {
+            if (&other == &shard) {
+                continue;
+            }
+            std::unique_lock<std::shared_mutex> lock(other.mutex, std::try_to_lock);
+            if (lock.owns_lock() && other.cold.front() != nullptr) {
+                drop_region(other, other.cold.front()->slot);
+                dropped = true;
+                break;
+            }
+        }
+        if (!dropped) {
+            return false;
         }
     }
-    
-    std::sort(candidates.begin(), candidates.end(),
-              [](const auto& a, const auto& b) { return a.second < b.second; });
-    
+    return true;
+}
+
+bool KVCacheManager::evict_one(Shard& shard, uint64_t wanted_kb, bool allow_drop,
+                               uint64_t& freed_kb) {
+    // Victims that free nothing without a drop are set aside, so the ones
+    // queued behind them get their turn, then queued again on the way out
+    std::vector<RegionEntry*> skipped;
+    auto requeue_skipped = [&shard, &skipped] {
+        for (RegionEntry* entry : skipped) {
+            shard.eviction.insert(*entry, shard.eviction_input(entry->slot));
+        }
+    };
+    for (;;) {
+        EvictionNode* node = shard.eviction.victim();
+        if (node == nullptr) {
+            requeue_skipped();
+            return false;
+        }
+        RegionEntry* victim = static_cast<RegionEntry*>(node);
+
+        // Used since it was queued: re-queue with fresh stats and look again
+        if (shard.counters.load(RegionCounters::LAST_USE, victim->slot) != node->queued_use) {
+            shard.eviction.touch(*node, shard.eviction_input(victim->slot));
+            continue;
+        }
+
+        // Spill only the pages asked for, from the tail; a victim left
+        // with resident pages stays at the head of the queue. Shared pages
+        // are never spilled, only released when the region is dropped.
+        KVRegion& region = victim->region;
+        size_t resident = region.blocks.size();
+        size_t private_pages = resident - region.shared_pages;
+        if (private_pages == 0 && !allow_drop) {
+            shard.eviction.remove(*node);
+            skipped.push_back(victim);
+            continue;
+        }
+        size_t spill = std::min<size_t>(private_pages,
+                                        std::max<uint64_t>(BlockAllocator::blocks_for(wanted_kb), 1));
+
+        // Pages go to the spill file when it can take them. Otherwise they
+        // are dropped, and with them the region if any of its pages are in
+        // the file, as pages must stay in region order across the tiers.
+        std::vector<uint32_t> slots;
+        bool to_file = spill_enabled() && spill > 0 && reserve_spill(shard, spill, slots);
+        if (!to_file && !allow_drop) {
+            // The spill file is out of room and dropping is not allowed
+            requeue_skipped();
+            return false;
+        }
+        if (!to_file && (spill == private_pages || !region.spill_slots.empty())) {
+            shard.eviction.on_evict(*node);
+            gauges_.spilled_blocks.fetch_add(resident, std::memory_order_relaxed);
+            freed_kb = drop_region(shard, victim->slot) * BlockAllocator::kBlockSizeKB;
+            requeue_skipped();
+            return true;
+        }
+
+        // The reserved slots are this call's alone, so the writes run
+        // before the arena lock is taken
+        freed_kb = spill * BlockAllocator::kBlockSizeKB;
+        if (to_file) {
+            for (size_t i = 0; i < spill; i++) {
+                spill_.write_page(slots[i], victim->hash, resident - spill + i);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> arena(arena_mutex_);
+            std::vector<uint32_t> spilled(region.blocks.end() - spill, region.blocks.end());
+            if (to_file) {
+                region.spill_slots.insert(region.spill_slots.begin(), slots.begin(), slots.end());
+                gauges_.spill_used_kb.store(spill_.used_slots() * SpillFile::kSlotSizeKB,
+                                            std::memory_order_relaxed);
+            }
+            uint64_t before_kb = resident_kb(region);
+            blocks_.release(spilled);
+            region.blocks.resize(resident - spill);
+            requested_kb_ -= before_kb - resident_kb(region);
+            gauges_.used_size_kb.store(blocks_.used_blocks() * BlockAllocator::kBlockSizeKB,
+                                       std::memory_order_relaxed);
+        }
+        gauges_.spilled_blocks.fetch_add(spill, std::memory_order_relaxed);
+        NYMPH_LOG_DEBUG("Spilled {} blocks of region: {}", spill, region.name);
+        shard.settle(victim->slot);
+        requeue_skipped();
+        return true;
+    }
+}
+
+uint64_t KVCacheManager::evict(uint64_t required_kb, bool allow_drop) {
+    // Round-robin keeps any one shard from being drained while others hold
+    // colder regions
     uint64_t freed = 0;
-    for (const auto& candidate : candidates) {
-        if (freed >= required_kb) break;
-        
-        auto it = regions_.find(candidate.first);
-        if (it != regions_.end()) {
-            freed += it->second.size_kb;
-            used_size_kb_ -= it->second.size_kb;
-            log::info("Evicting region: " + candidate.first);
-            regions_.erase(it);
+    size_t index = evict_cursor_.load(std::memory_order_relaxed) & (kShards - 1);
+    size_t empty_in_a_row = 0;
+    while (freed < required_kb && empty_in_a_row < kShards) {
+        Shard& shard = shards_[index];
+        uint64_t freed_kb = 0;
+        bool evicted;
+        {
+            auto lock = trace::timed_lock(shard.mutex, "kv.lock_wait");
+            evicted = evict_one(shard, required_kb - freed, allow_drop, freed_kb);
         }
+        empty_in_a_row = evicted ? 0 : empty_in_a_row + 1;
+        freed += freed_kb;
+        index = (index + 1) & (kShards - 1);
     }
-    
+    evict_cursor_.store(index, std::memory_order_relaxed);
     return freed;
 }
 
+bool KVCacheManager::prefetch_region(const std::string& region_name) {
+    if (!spill_enabled()) {
+        return false;
+    }
+    uint64_t hash = region_hash(region_name);
+    const Shard& shard = shard_of(hash);
+    auto lock = trace::timed_shared_lock(shard.mutex, "kv.lock_wait");
+    uint32_t slot = shard.find(region_name, hash);
+    if (slot == RegionIndex::kNoSlot) {
+        return false;
+    }
+    const KVRegion& region = shard.entries[slot].region;
+    if (!region.spill_slots.empty()) {
+        queue_readback(region.name);
+    }
+    return true;
+}
+
+void KVCacheManager::queue_readback(const std::string& region_name) {
+    {
+        std::lock_guard<std::mutex> lock(readback_mutex_);
+        if (!readback_pending_.insert(region_name).second) {
+            return;
+        }
+        readback_queue_.push_back(region_name);
+    }
+    readback_cv_.notify_one();
+}
+
+void KVCacheManager::readback_loop() {
+    for (;;) {
+        std::string name;
+        {
+            std::unique_lock<std::mutex> lock(readback_mutex_);
+            readback_cv_.wait(lock, [this] { return readback_stop_ || !readback_queue_.empty(); });
+            if (readback_stop_) {
+                return;
+            }
+            name = std::move(readback_queue_.front());
+            readback_queue_.pop_front();
+        }
+        read_back(name);
+        std::lock_guard<std::mutex> lock(readback_mutex_);
+        readback_pending_.erase(name);
+    }
+}
+
+void KVCacheManager::read_back(const std::string& region_name) {
+    NYMPH_TRACE_SCOPE("kv.readback", "kv");
+    uint64_t hash = region_hash(region_name);
+    Shard& shard = shard_of(hash);
+
+    // Start the drive reads before anything is locked for writing
+    uint64_t wanted = 0;
+    {
+        auto lock = trace::timed_shared_lock(shard.mutex, "kv.lock_wait");
+        uint32_t slot = shard.find(region_name, hash);
+        if (slot == RegionIndex::kNoSlot) {
+            return;
+        }
+        const KVRegion& region = shard.entries[slot].region;
+        wanted = region.spill_slots.size();
+        spill_.will_need(region.spill_slots);
+    }
+    if (wanted == 0) {
+        return;
+    }
+
+    // Room comes from spilling colder pages to the file, never dropping;
+    // readback is a hint and gives up when that is not enough
+    std::vector<uint32_t> blocks;
+    uint64_t generation = 0;
+    std::string error;
+    if (!make_room(wanted, false, blocks, generation, error)) {
+        NYMPH_LOG_DEBUG("Readback of region {} skipped: {}", region_name, error);
+        return;
+    }
+
+    auto lock = trace::timed_lock(shard.mutex, "kv.lock_wait");
+    {
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        if (generation != arena_generation_) {
+            return;
+        }
+    }
+    uint32_t slot = shard.find(region_name, hash);
+    if (slot == RegionIndex::kNoSlot) {
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        blocks_.release(blocks);
+        gauges_.used_size_kb.store(blocks_.used_blocks() * BlockAllocator::kBlockSizeKB,
+                                   std::memory_order_relaxed);
+        return;
+    }
+    // Only file pages are read back; dropped pages wait for the next pin
+    const KVRegion& region = shard.entries[slot].region;
+    if (blocks.size() > region.spill_slots.size()) {
+        std::vector<uint32_t> extra(blocks.begin() + region.spill_slots.size(), blocks.end());
+        blocks.resize(region.spill_slots.size());
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        blocks_.release(extra);
+    }
+    uint64_t faulted = attach_blocks(shard, slot, blocks);
+    NYMPH_LOG_DEBUG("Read back {} blocks of region: {}", faulted, region_name);
+}
+
 void KVCacheManager::clear() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(kShards);
+    for (Shard& shard : shards_) {
+        locks.emplace_back(shard.mutex);
+    }
+    std::lock_guard<std::mutex> arena(arena_mutex_);
     
-    regions_.clear();
-    used_size_kb_ = 0;
-    next_base_address_ = 0x100000;
-    log::info("KV Cache cleared");
+    for (Shard& shard : shards_) {
+        shard.clear();
+    }
+    blocks_.reset(blocks_.total_blocks(), kArenaBaseAddress);
+    prefixes_.clear();
+    gauges_.dedup_saved_kb.store(0, std::memory_order_relaxed);
+    spill_.reset();
+    gauges_.spill_used_kb.store(0, std::memory_order_relaxed);
+    arena_generation_++;
+    requested_kb_ = 0;
+    gauges_.used_size_kb.store(0, std::memory_order_relaxed);
+    gauges_.regions.store(0, std::memory_order_relaxed);
+    gauges_.pinned_regions.store(0, std::memory_order_relaxed);
+    NYMPH_LOG_INFO("KV Cache cleared");
 }
 
-/* Helper function to parse KV pin request from JSON */
-KVPinRequest parse_kvpin_request(const std::string& json_body) {
-    KVPinRequest request;
-    request.force = false;
-    request.priority = 0;
-    
-    // Simple JSON parsing
-    auto find_string_field = [&json_body](const std::string& field) -> std::string {
-        std::string search = "\"" + field + "\"";
-        size_t pos = json_body.find(search);
-        if (pos == std::string::npos) return "";
-        
-        pos = json_body.find(":", pos);
-        if (pos == std::string::npos) return "";
-        pos++;
-        
-        while (pos < json_body.length() && (json_body[pos] == ' ' || json_body[pos] == '\t')) {
-            pos++;
-        }
-        
-        if (pos >= json_body.length()) return "";
-        
-        if (json_body[pos] == '"') {
-            pos++;
-            size_t end = pos;
-            while (end < json_body.length() && json_body[end] != '"') {
-                end++;
-            }
-            return json_body.substr(pos, end - pos);
-        }
-        
-        return "";
-    };
-    
-    auto find_number_field = [&json_body](const std::string& field) -> uint64_t {
-        std::string search = "\"" + field + "\"";
-        size_t pos = json_body.find(search);
-        if (pos == std::string::npos) return 0;
-        
-        pos = json_body.find(":", pos);
-        if (pos == std::string::npos) return 0;
-        pos++;
-        
-        while (pos < json_body.length() && (json_body[pos] == ' ' || json_body[pos] == '\t')) {
-            pos++;
-        }
-        
-        if (pos >= json_body.length()) return 0;
-        
-        size_t end = pos;
-        while (end < json_body.length() && 
-               (json_body[end] >= '0' && json_body[end] <= '9')) {
-            end++;
-        }
-        
-        if (end > pos) {
-            return std::stoull(json_body.substr(pos, end - pos));
-        }
-        
-        return 0;
-    };
-    
-    auto find_bool_field = [&json_body](const std::string& field) -> bool {
-        std::string search = "\"" + field + "\"";
-        size_t pos = json_body.find(search);
-        if (pos == std::string::npos) return false;
-        
-        pos = json_body.find(":", pos);
-        if (pos == std::string::npos) return false;
-        pos++;
-        
-        while (pos < json_body.length() && (json_body[pos] == ' ' || json_body[pos] == '\t')) {
-            pos++;
-        }
-        
-        if (pos >= json_body.length()) return false;
-        
-        return (json_body.substr(pos, 4) == "true");
+bool KVCacheManager::save_snapshot(const std::string& path) const {
+    NYMPH_TRACE_SCOPE("kv.save_snapshot", "kv");
+    uint64_t start = get_current_time();
+
+    struct Ranked {
+        bool pinned;
+        uint64_t last_access;
+        SnapshotRegion region;
     };
-    
-    request.region = find_string_field("region");
-    request.size_kb = find_number_field("size_kb");
-    request.force = find_bool_field("force");
-    request.priority = static_cast<int>(find_number_field("priority"));
-    
-    // Defaults
+    std::vector<Ranked> ranked;
+    ranked.reserve(gauges_.regions.load(std::memory_order_relaxed));
+    for (const Shard& shard : shards_) {
+        auto lock = trace::timed_shared_lock(shard.mutex, "kv.lock_wait");
+        for (const RegionEntry& entry : shard.entries) {
+            if (!entry.live) {
+                continue;
+            }
+            const KVRegion& region = entry.region;
+            Ranked saved;
+            saved.pinned = region.is_pinned;
+            saved.last_access = shard.counters.load(RegionCounters::LAST_ACCESS_TIME, entry.slot);
+            saved.region.name = region.name;
+            saved.region.size_kb = region.size_kb;
+            saved.region.pages = region.pages;
+            saved.region.pinned = region.is_pinned;
+            saved.region.priority = region.priority;
+            saved.region.accesses = shard.counters.load(RegionCounters::ACCESSES, entry.slot);
+            saved.region.hits = shard.counters.load(RegionCounters::HITS, entry.slot);
+            saved.region.misses = shard.counters.load(RegionCounters::MISSES, entry.slot);
+            saved.region.history = shard.counters.load(RegionCounters::HISTORY, entry.slot);
+            saved.region.blocks = region.blocks;
+            saved.region.spill_slots = region.spill_slots;
+            if (region.shared_pages > 0) {
+                // The path up from the deepest shared page names the pages
+                std::lock_guard<std::mutex> arena(arena_mutex_);
+                saved.region.prefix_keys.resize(region.shared_pages);
+                const PrefixTree::Node* node = entry.prefix;
+                for (size_t page = region.shared_pages; page > 0; page--) {
+                    saved.region.prefix_keys[page - 1] = node->key;
+                    node = node->parent;
+                }
+            }
+            ranked.push_back(std::move(saved));
+        }
+    }
+
+    // A restore cut short by its budget keeps the regions most likely reused
+    std::sort(ranked.begin(), ranked.end(), [](const Ranked& a, const Ranked& b) {
+        if (a.pinned != b.pinned) {
+            return a.pinned;
+        }
+        return a.last_access > b.last_access;
+    });
+    std::vector<SnapshotRegion> regions;
+    regions.reserve(ranked.size());
+    for (Ranked& saved : ranked) {
+        regions.push_back(std::move(saved.region));
+    }
+    SnapshotLayout layout;
+    layout.block_size_kb = BlockAllocator::kBlockSizeKB;
+    {
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        layout.total_blocks = blocks_.total_blocks();
+        layout.spill_slots = spill_.total_slots();
+    }
+
+    if (!write_snapshot(path, layout, regions)) {
+        return false;
+    }
+    NYMPH_LOG_INFO("KV snapshot: {} regions saved to {} in {} ms", regions.size(), path,
+                   get_current_time() - start);
+    return true;
+}
+
+bool KVCacheManager::restore_snapshot(const std::string& path, uint64_t budget_ms) {
+    if (restore_thread_.joinable()) {
+        return false;
+    }
+    std::unique_ptr<SnapshotReader> reader(new SnapshotReader());
+    if (!reader->open(path)) {
+        return false;
+    }
+    if (reader->layout().block_size_kb != BlockAllocator::kBlockSizeKB) {
+        NYMPH_LOG_WARN("KV snapshot {} uses {} KB blocks; not restored", path,
+                       reader->layout().block_size_kb);
+        return false;
+    }
+    NYMPH_LOG_INFO("KV snapshot: restoring {} regions from {} (budget {} ms)",
+                   reader->region_count(), path, budget_ms);
+    restore_stop_.store(false, std::memory_order_relaxed);
+    restore_thread_ = std::thread(&KVCacheManager::restore_loop, this, std::move(reader), budget_ms);
+    return true;
+}
+
+void KVCacheManager::wait_restore() {
+    if (restore_thread_.joinable()) {
+        restore_thread_.join();
+    }
+}
+
+void KVCacheManager::restore_loop(std::unique_ptr<SnapshotReader> reader, uint64_t budget_ms) {
+    NYMPH_TRACE_SCOPE("kv.restore_snapshot", "kv");
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(budget_ms);
+
+    // Spilled pages are only back if the file is the one the snapshot saw
+    bool with_spill = spill_enabled() && reader->layout().spill_slots == spill_.total_slots();
+
+    // Records come hottest first, so their use stamps count down from the
+    // top of a band above every stamp handed out so far
+    uint64_t count = reader->region_count();
+    uint64_t band[kShards];
+    for (size_t index = 0; index < kShards; index++) {
+        band[index] = shards_[index].use_clock.fetch_add(count + 1, std::memory_order_relaxed) + count;
+    }
+
+    SnapshotRegion saved;
+    uint64_t read = 0;
+    uint64_t restored = 0;
+    while (!restore_stop_.load(std::memory_order_relaxed) &&
+           std::chrono::steady_clock::now() < deadline && reader->next(saved)) {
+        uint64_t hash = region_hash(saved.name);
+        if (restore_region(saved, hash, with_spill, band[hash & (kShards - 1)] - read)) {
+            restored++;
+        }
+        read++;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    NYMPH_LOG_INFO("KV snapshot: restored {} of {} regions in {} ms", restored, count, elapsed);
+}
+
+bool KVCacheManager::restore_region(const SnapshotRegion& saved, uint64_t hash, bool with_spill,
+                                    uint64_t use) {
+    if (saved.pages == 0 || saved.blocks.size() > saved.pages ||
+        saved.prefix_keys.size() > saved.blocks.size()) {
+        return false;
+    }
+    Shard& shard = shard_of(hash);
+    auto lock = trace::timed_lock(shard.mutex, "kv.lock_wait");
+    if (shard.find(saved.name, hash) != RegionIndex::kNoSlot) {
+        return false;
+    }
+
+    uint32_t slot = shard.add(saved.name, hash);
+    RegionEntry& entry = shard.entries[slot];
+    KVRegion& region = entry.region;
+    region.size_kb = saved.size_kb;
+    region.pages = saved.pages;
+    region.priority = saved.priority;
+    region.is_pinned = saved.pinned;
+    region.pin_time = get_current_time();
+    std::vector<uint32_t> claimed;
+    {
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+
+        // Shared pages first. Nodes restored with an earlier region already
+        // hold theirs; the rest take back this region's blocks.
+        size_t shared = saved.prefix_keys.size();
+        std::vector<uint32_t> spare;
+        for (size_t page = prefixes_.match(saved.prefix_keys, shared); page < shared; page++) {
+            if (!blocks_.claim(saved.blocks[page])) {
+                shared = page;
+                break;
+            }
+            spare.push_back(saved.blocks[page]);
+        }
+        std::reverse(spare.begin(), spare.end());   // acquire takes from the back
+        size_t acquired = 0;
+        entry.prefix = prefixes_.acquire(saved.prefix_keys, shared, spare, region.blocks, acquired);
+        region.shared_pages = acquired;
+
+        // Then private pages, up to the first block someone else took
+        while (region.blocks.size() < saved.blocks.size() &&
+               blocks_.claim(saved.blocks[region.blocks.size()])) {
+            region.blocks.push_back(saved.blocks[region.blocks.size()]);
+        }
+
+        // Pages in the file must follow the resident ones directly
+        if (with_spill && region.blocks.size() == saved.blocks.size()) {
+            for (uint32_t spill_slot : saved.spill_slots) {
+                if (!spill_.claim(spill_slot)) {
+                    break;
+                }
+                claimed.push_back(spill_slot);
+            }
+        }
+    }
+
+    // The claimed slots are checked without the arena lock; those from the
+    // first that does not hold its page on are given back
+    size_t kept = 0;
+    while (kept < claimed.size() &&
+           spill_.read_page(claimed[kept], hash, region.blocks.size() + kept)) {
+        kept++;
+    }
+    region.spill_slots.assign(claimed.begin(), claimed.begin() + kept);
+    {
+        std::lock_guard<std::mutex> arena(arena_mutex_);
+        if (kept < claimed.size()) {
+            spill_.release(std::vector<uint32_t>(claimed.begin() + kept, claimed.end()));
+        }
+
+        if (region.blocks.empty() && region.spill_slots.empty()) {
+            // Nothing came back; a region with no pages is dropped
+            shard.remove(slot);
+            return false;
+        }
+        requested_kb_ += resident_kb(region);
+        region.base_address = region.blocks.empty() ? 0 : blocks_.block_address(region.blocks.front());
+        gauges_.used_size_kb.store(blocks_.used_blocks() * BlockAllocator::kBlockSizeKB,
+                                   std::memory_order_relaxed);
+        gauges_.spill_used_kb.store(spill_.used_slots() * SpillFile::kSlotSizeKB,
+                                    std::memory_order_relaxed);
+        gauges_.dedup_saved_kb.store(prefixes_.shared_savings() * BlockAllocator::kBlockSizeKB,
+                                     std::memory_order_relaxed);
+    }
+
+    RegionCounters& counters = shard.counters;
+    counters.at(RegionCounters::ACCESSES, slot).store(saved.accesses, std::memory_order_relaxed);
+    counters.at(RegionCounters::HITS, slot).store(saved.hits, std::memory_order_relaxed);
+    counters.at(RegionCounters::MISSES, slot).store(saved.misses, std::memory_order_relaxed);
+    counters.at(RegionCounters::HISTORY, slot).store(saved.history, std::memory_order_relaxed);
+    counters.at(RegionCounters::LAST_ACCESS_TIME, slot).store(region.pin_time, std::memory_order_relaxed);
+    counters.at(RegionCounters::LAST_USE, slot).store(use, std::memory_order_relaxed);
+    shard.settle(slot);
+    gauges_.regions.fetch_add(1, std::memory_order_relaxed);
+    if (region.is_pinned) {
+        gauges_.pinned_regions.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+/* Reads one /kv/pin member into the request; false for other keys */
+static bool read_kvpin_member(std::string_view key, const json::Value& value, KVPinRequest& request) {
+    if (key == "region") {
+        request.region = value.as_string();
+    } else if (key == "size_kb") {
+        request.size_kb = value.as_uint(0);
+    } else if (key == "force") {
+        request.force = value.as_bool(false);
+    } else if (key == "priority") {
+        request.priority = static_cast<int>(value.as_int(0));
+    } else if (key == "eviction_policy") {
+        request.eviction_policy = value.as_string();
+    } else if (key == "prefix_pages") {
+        if (!value.as_uint_array(request.prefix_pages)) {
+            request.prefix_pages.clear();
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/* Defaults for members a /kv/pin body left out */
+static void default_kvpin_request(KVPinRequest& request) {
     if (request.region.empty()) {
         request.region = "default";
     }
     if (request.size_kb == 0) {
         request.size_kb = 256;  // Default 256 KB
     }
+}
+
+/* Helper function to parse KV pin request from JSON */
+KVPinRequest parse_kvpin_request(std::string_view json_body) {
+    NYMPH_TRACE_SCOPE("json.parse", "json");
+    KVPinRequest request;
+    request.size_kb = 0;
+    request.force = false;
+    request.priority = 0;
     
+    json::Reader reader(json_body);
+    std::string_view key;
+    json::Value value;
+    while (reader.next(key, value)) {
+        read_kvpin_member(key, value, request);
+    }
+    default_kvpin_request(request);
     return request;
 }
 
 /* Helper function to format KV pin result as JSON */
 std::string format_kvpin_result(const KVPinResult& result) {
-    std::stringstream json;
-    json << std::fixed << std::setprecision(4);
-    
-    json << "{";
-    json << "\"hit_rate\":" << result.hit_rate;
-    
+    NYMPH_TRACE_SCOPE("json.format", "json");
+    std::string body;
+    body.reserve(256);
+    json::Writer json(body);
+
+    json.begin_object();
+    json.member("hit_rate", result.hit_rate, 4);
+
     if (result.success) {
-        json << ",\"region\":\"" << result.region_name << "\"";
-        json << ",\"size_kb\":" << result.region_size_kb;
-        
+        json.member("region", result.region_name);
+        json.member("size_kb", result.region_size_kb);
+
         if (!result.stats.empty()) {
-            json << ",\"stats\":{";
-            bool first = true;
+            json.key("stats").begin_object();
             for (const auto& pair : result.stats) {
-                if (!first) json << ",";
-                json << "\"" << pair.first << "\":" << pair.second;
-                first = false;
+                json.member(pair.first, pair.second, 4);
             }
-            json << "}";
+            json.end_object();
         }
     } else {
-        json << ",\"success\":false";
+        json.member("success", false);
         if (!result.error_message.empty()) {
-            json << ",\"error\":\"" << result.error_message << "\"";
+            json.member("error", result.error_message);
         }
     }
-    
-    json << "}";
-    
-    return json.str();
+
+    json.end_object();
+    return body;
+}
+
+/* Batch op names on the wire */
+static const char* kv_op_name(KVOpType type) {
+    switch (type) {
+        case KVOpType::PIN: return "pin";
+        case KVOpType::UNPIN: return "unpin";
+        case KVOpType::ACCESS: return "access";
+        case KVOpType::EVICT: return "evict";
+    }
+    return "unknown";
+}
+
+static bool kv_op_from_name(std::string_view name, KVOpType& type) {
+    for (KVOpType candidate : {KVOpType::PIN, KVOpType::UNPIN, KVOpType::ACCESS, KVOpType::EVICT}) {
+        if (name == kv_op_name(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Helper function to parse a KV batch request from JSON */
+bool parse_kv_batch_request(std::string_view json_body, KVBatchRequest& request, std::string& error) {
+    NYMPH_TRACE_SCOPE("json.parse", "json");
+    request.ops.clear();
+    request.atomic = false;
+
+    json::Reader reader(json_body);
+    std::string_view key;
+    json::Value value;
+    while (reader.next(key, value)) {
+        if (key == "atomic") {
+            request.atomic = value.as_bool(false);
+        } else if (key == "ops") {
+            if (value.type != json::Type::ARRAY) {
+                error = "ops must be an array";
+                return false;
+            }
+            json::ArrayReader elements(value);
+            json::Value element;
+            while (elements.next(element)) {
+                if (element.type != json::Type::OBJECT) {
+                    error = "Each op must be an object";
+                    return false;
+                }
+                if (request.ops.size() == KVCacheManager::kMaxBatchOps) {
+                    error = "Batch exceeds " + std::to_string(KVCacheManager::kMaxBatchOps) + " ops";
+                    return false;
+                }
+
+                KVOp op;
+                op.pin.size_kb = 0;
+                op.pin.force = false;
+                op.pin.priority = 0;
+                op.is_read = true;
+                op.offset_kb = KVCacheManager::kWholeRegion;
+                std::string name;
+                json::Reader fields(element.raw);
+                std::string_view field;
+                json::Value member;
+                // Pin ops carry the /kv/pin members; the others read region
+                while (fields.next(field, member)) {
+                    if (field == "op") {
+                        name = member.as_string();
+                    } else if (read_kvpin_member(field, member, op.pin)) {
+                        continue;
+                    } else if (field == "write") {
+                        op.is_read = !member.as_bool(false);
+                    } else if (field == "offset_kb") {
+                        op.offset_kb = member.as_uint(KVCacheManager::kWholeRegion);
+                    }
+                }
+                if (!kv_op_from_name(name, op.type)) {
+                    error = "Unknown op: " + name;
+                    return false;
+                }
+                if (op.type == KVOpType::PIN) {
+                    default_kvpin_request(op.pin);
+                }
+                request.ops.push_back(std::move(op));
+            }
+        }
+    }
+    return true;
+}
+
+/* Helper function to format a KV batch result as JSON */
+std::string format_kv_batch_result(const KVBatchRequest& request, const KVBatchResult& result) {
+    NYMPH_TRACE_SCOPE("json.format", "json");
+    std::string body;
+    body.reserve(64 + 96 * result.results.size());
+    json::Writer json(body);
+
+    json.begin_object();
+    json.member("success", result.success);
+    if (!result.error_message.empty()) {
+        json.member("error", result.error_message);
+    }
+    json.key("results").begin_array();
+    for (size_t i = 0; i < result.results.size(); i++) {
+        const KVOp& op = request.ops[i];
+        const KVOpResult& outcome = result.results[i];
+        json.begin_object();
+        json.member("op", kv_op_name(op.type));
+        json.member("region", op.pin.region);
+        json.member("success", outcome.success);
+        if (outcome.success && (op.type == KVOpType::PIN || op.type == KVOpType::ACCESS)) {
+            json.member("hit", outcome.hit);
+        }
+        if (outcome.success && op.type == KVOpType::PIN) {
+            json.member("hit_rate", outcome.pin.hit_rate, 4);
+            if (!outcome.pin.stats.empty()) {
+                json.key("stats").begin_object();
+                for (const auto& pair : outcome.pin.stats) {
+                    json.member(pair.first, pair.second, 4);
+                }
+                json.end_object();
+            }
+        }
+        const std::string& error = op.type == KVOpType::PIN && outcome.error_message.empty()
+            ? outcome.pin.error_message : outcome.error_message;
+        if (!error.empty()) {
+            json.member("error", error);
+        }
+        json.end_object();
+    }
+    json.end_array();
+    json.end_object();
+    return body;
 }
 
 } // namespace kv
 } // namespace nymph
-
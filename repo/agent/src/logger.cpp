@@ -0,0 +1,276 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Logging Implementation
+ *
+ * The ring is a bounded MPSC queue: every slot carries a sequence number,
+ * producers claim a slot with one CAS on head_ and publish it by bumping
+ * the slot's sequence; the single writer thread consumes slots in order.
+ */
+
+#include "logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+namespace nymph {
+namespace log {
+
+namespace {
+
+const size_t kBatchRecords = 256;
+const auto kWriterIdle = std::chrono::milliseconds(10);
+
+const char* level_tag(Level level) {
+    switch (level) {
+        case Level::DEBUG: return "DEBUG";
+        case Level::INFO:  return "INFO ";
+        case Level::WARN:  return "WARN ";
+        case Level::ERROR: return "ERROR";
+    }
+    return "INFO ";
+}
+
+/* "[YYYY-MM-DD HH:MM:SS.mmm] " rendered at most once per millisecond */
+class TimestampCache {
+public:
+    TimestampCache() : second_(-1), millis_(-1) {
+        std::memset(text_, 0, sizeof(text_));
+    }
+
+    const char* format(int64_t timestamp_ms) {
+        if (timestamp_ms == millis_) {
+            return text_;
+        }
+        int64_t second = timestamp_ms / 1000;
+        if (second != second_) {
+            std::time_t t = static_cast<std::time_t>(second);
+            std::tm local;
+            localtime_r(&t, &local);
+            std::strftime(text_, sizeof(text_), "[%Y-%m-%d %H:%M:%S", &local);
+            second_ = second;
+        }
+        int ms = static_cast<int>(timestamp_ms % 1000);
+        text_[20] = '.';
+        text_[21] = static_cast<char>('0' + ms / 100);
+        text_[22] = static_cast<char>('0' + (ms / 10) % 10);
+        text_[23] = static_cast<char>('0' + ms % 10);
+        text_[24] = ']';
+        text_[25] = '\0';
+        millis_ = timestamp_ms;
+        return text_;
+    }
+
+private:
+    int64_t second_;
+    int64_t millis_;
+    char text_[32];
+};
+
+} // namespace
+
+namespace detail {
+
+void format_double(FormatBuffer& out, double value, int precision) {
+    char digits[64];
+    int length = (precision >= 0)
+        ? std::snprintf(digits, sizeof(digits), "%.*f", precision > 17 ? 17 : precision, value)
+        : std::snprintf(digits, sizeof(digits), "%g", value);
+    if (length > 0) {
+        out.append(digits, std::min(static_cast<size_t>(length), sizeof(digits) - 1));
+    }
+}
+
+} // namespace detail
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : level_(Level::INFO),
+      slots_(new Slot[kQueueSlots]),
+      head_(0),
+      tail_(0),
+      written_(0),
+      dropped_(0),
+      truncated_(0),
+      writer_waiting_(false),
+      running_(true),
+      log_file_(nullptr) {
+    for (size_t i = 0; i < kQueueSlots; i++) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    writer_ = std::thread(&Logger::writer_loop, this);
+}
+
+Logger::~Logger() {
+    running_.store(false);
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_cv_.notify_one();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    if (log_file_ != nullptr) {
+        std::fclose(log_file_);
+    }
+}
+
+void Logger::set_log_file(const std::string& filename) {
+    std::FILE* file = std::fopen(filename.c_str(), "a");
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    if (log_file_ != nullptr) {
+        std::fclose(log_file_);
+    }
+    log_file_ = file;
+}
+
+Logger::Slot* Logger::claim() {
+    // Free slots carry sequence == position
+    uint64_t pos = head_.load(std::memory_order_relaxed);
+    while (true) {
+        Slot* slot = &slots_[pos & (kQueueSlots - 1)];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot->position = pos;
+                return slot;
+            }
+        } else if (diff < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        } else {
+            pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void Logger::publish(Slot* slot, Level level, size_t length, bool truncated) {
+    if (truncated) {
+        std::memcpy(slot->text + length - 3, "...", 3);
+        truncated_.fetch_add(1, std::memory_order_relaxed);
+    }
+    slot->length = static_cast<uint32_t>(length);
+    slot->level = level;
+    slot->timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    slot->sequence.store(slot->position + 1, std::memory_order_release);
+
+    if (writer_waiting_.load(std::memory_order_relaxed)) {
+        wake_cv_.notify_one();
+    }
+}
+
+void Logger::log(Level level, const std::string& message) {
+    if (!enabled(level)) {
+        return;
+    }
+    Slot* slot = claim();
+    if (slot == nullptr) {
+        return;
+    }
+    size_t length = std::min(message.size(), kMaxMessageBytes);
+    std::memcpy(slot->text, message.data(), length);
+    publish(slot, level, length, length < message.size());
+}
+
+void Logger::flush() {
+    uint64_t target = head_.load(std::memory_order_acquire);
+    while (written_.load(std::memory_order_acquire) < target &&
+           running_.load(std::memory_order_relaxed)) {
+        wake_cv_.notify_one();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+LoggerStats Logger::get_stats() const {
+    LoggerStats stats;
+    stats.enqueued = head_.load(std::memory_order_relaxed);
+    stats.written = written_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.truncated = truncated_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+size_t Logger::drain(std::string& batch) {
+    static thread_local TimestampCache timestamps;
+    size_t count = 0;
+    while (count < kBatchRecords) {
+        Slot& slot = slots_[tail_ & (kQueueSlots - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != tail_ + 1) {
+            break;
+        }
+
+        batch += timestamps.format(slot.timestamp_ms);
+        batch += " [";
+        batch += level_tag(slot.level);
+        batch += "] ";
+        batch.append(slot.text, slot.length);
+        batch += '\n';
+
+        // Hand the slot back to producers one lap ahead
+        slot.sequence.store(tail_ + kQueueSlots, std::memory_order_release);
+        tail_++;
+        count++;
+    }
+    return count;
+}
+
+void Logger::write_batch(const std::string& batch) {
+    std::fwrite(batch.data(), 1, batch.size(), stdout);
+    std::fflush(stdout);
+
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    if (log_file_ != nullptr) {
+        std::fwrite(batch.data(), 1, batch.size(), log_file_);
+        std::fflush(log_file_);
+    }
+}
+
+void Logger::writer_loop() {
+    std::string batch;
+    batch.reserve(kBatchRecords * 128);
+    uint64_t reported_drops = 0;
+
+    while (true) {
+        batch.clear();
+        size_t count = drain(batch);
+
+        uint64_t drops = dropped_.load(std::memory_order_relaxed);
+        if (drops != reported_drops) {
+            TimestampCache now;
+            batch += now.format(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+            batch += " [WARN ] Log queue full, dropped ";
+            batch += std::to_string(drops - reported_drops);
+            batch += " records\n";
+            reported_drops = drops;
+        }
+
+        if (!batch.empty()) {
+            write_batch(batch);
+            written_.fetch_add(count, std::memory_order_release);
+            continue;
+        }
+
+        if (!running_.load()) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        writer_waiting_.store(true);
+        wake_cv_.wait_for(lock, kWriterIdle, [this] {
+            const Slot& slot = slots_[tail_ & (kQueueSlots - 1)];
+            return !running_.load() ||
+                   slot.sequence.load(std::memory_order_acquire) == tail_ + 1;
+        });
+        writer_waiting_.store(false);
+    }
+}
+
+} // namespace log
+} // namespace nymph
@@ -6,32 +6,34 @@
  */
 
 #include "nymph_api.hpp"
+#include "http_server.hpp"
+#include "router.hpp"
+#include "handler_pool.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include "kvpin.hpp"
+#include "ai_batch.hpp"
+#include "thermal_stdio.hpp"
+#include "fabric_zlta.hpp"
+#include "sair_vault.hpp"
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 #include <thread>
+#include <chrono>
 #include <atomic>
-#include <signal.h>
+#include <cstdlib>
 #include <cstring>
-
-// Simple HTTP server implementation (stub - will use cpp-httplib or similar)
-// For now, we'll create a minimal HTTP server
-
-#ifdef _WIN32
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#define close closesocket
-#else
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <unistd.h>
-#endif
+#include <signal.h>
 
 namespace {
     std::atomic<bool> g_running{true};
     const int PORT = 8443;
     const std::string HOST = "0.0.0.0";
+    const auto TELEMETRY_INTERVAL = std::chrono::seconds(1);
 }
 
 void signal_handler(int sig) {
@@ -39,213 +41,224 @@ void signal_handler(int sig) {
     g_running = false;
 }
 
-std::string parse_json_field(const std::string& json, const std::string& field) {
-    size_t pos = json.find("\"" + field + "\"");
-    if (pos == std::string::npos) return "";
-    pos = json.find(":", pos);
-    if (pos == std::string::npos) return "";
-    pos++;
-    while (pos < json.length() && (json[pos] == ' ' || json[pos] == '\t')) pos++;
-    if (pos >= json.length()) return "";
-    
-    if (json[pos] == '"') {
-        pos++;
-        size_t end = json.find("\"", pos);
-        if (end != std::string::npos) {
-            return json.substr(pos, end - pos);
-        }
-    } else {
-        size_t end = pos;
-        while (end < json.length() && json[end] != ',' && json[end] != '}' && json[end] != '\n') end++;
-        std::string val = json.substr(pos, end - pos);
-        // Trim whitespace
-        while (!val.empty() && (val.back() == ' ' || val.back() == '\t')) val.pop_back();
-        return val;
-    }
-    return "";
-}
-
-nymph::api::APIRequest parse_request(const std::string& http_request) {
-    nymph::api::APIRequest req;
-    
-    // Parse method and path
-    size_t first_line_end = http_request.find("\r\n");
-    if (first_line_end == std::string::npos) first_line_end = http_request.find("\n");
-    
-    if (first_line_end != std::string::npos) {
-        std::string first_line = http_request.substr(0, first_line_end);
-        size_t space1 = first_line.find(' ');
-        size_t space2 = first_line.find(' ', space1 + 1);
-        
-        if (space1 != std::string::npos && space2 != std::string::npos) {
-            req.method = first_line.substr(0, space1);
-            req.path = first_line.substr(space1 + 1, space2 - space1 - 1);
-        }
-    }
-    
-    // Parse body (if POST)
-    size_t body_start = http_request.find("\r\n\r\n");
-    if (body_start == std::string::npos) body_start = http_request.find("\n\n");
-    if (body_start != std::string::npos) {
-        req.body = http_request.substr(body_start + 4);
-    }
-    
-    return req;
-}
-
-std::string build_response(const nymph::api::APIResponse& api_resp) {
-    std::stringstream http;
-    http << "HTTP/1.1 " << api_resp.status_code << " OK\r\n";
-    http << "Content-Type: " << api_resp.content_type << "\r\n";
-    http << "Content-Length: " << api_resp.body.length() << "\r\n";
-    http << "Access-Control-Allow-Origin: *\r\n";
-    http << "\r\n";
-    http << api_resp.body;
-    return http.str();
-}
-
-nymph::api::APIResponse route_request(const nymph::api::APIRequest& req) {
-    if (req.path == "/status" && req.method == "GET") {
-        return nymph::api::api_status(req);
-    } else if (req.path == "/fabric/verify" && req.method == "GET") {
-        return nymph::api::api_fabric_verify(req);
-    } else if (req.path == "/infer" && req.method == "POST") {
-        return nymph::api::api_infer(req);
-    } else if (req.path == "/kv/pin" && req.method == "POST") {
-        return nymph::api::api_kvpin(req);
-    } else if (req.path == "/squantum/run" && req.method == "POST") {
-        return nymph::api::api_squantum_run(req);
-    } else if (req.path == "/thermal/schedule" && req.method == "POST") {
-        return nymph::api::api_thermal_schedule(req);
-    } else if (req.path == "/capsule/run" && req.method == "POST") {
-        return nymph::api::api_capsule_run(req);
-    } else if (req.path == "/vault/update" && req.method == "POST") {
-        return nymph::api::api_vault_update(req);
-    } else if (req.path == "/ota/rollback" && req.method == "POST") {
-        return nymph::api::api_ota_rollback(req);
-    } else {
-        std::stringstream json;
-        json << "{\"error\": \"Not found\", \"path\": \"" << req.path << "\"}";
-        return nymph::api::APIResponse(404, "application/json", json.str());
-    }
-}
-
-void handle_client(int client_fd) {
-    char buffer[4096];
-#ifdef _WIN32
-    int bytes_read = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-#else
-    ssize_t bytes_read = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-#endif
-    
-    if (bytes_read <= 0) {
-        close(client_fd);
-        return;
-    }
-    
-    buffer[bytes_read] = '\0';
-    std::string request_str(buffer);
-    
-    nymph::api::APIRequest req = parse_request(request_str);
-    nymph::api::APIResponse resp = route_request(req);
-    std::string http_response = build_response(resp);
-    
-    send(client_fd, http_response.c_str(), http_response.length(), 0);
-    close(client_fd);
+void print_usage(const char* prog) {
+    std::cout << "Usage: " << prog << " [--port N] [--workers N] [--handler-threads N] [--idle-timeout-ms N] [--max-requests N]"
+              << " [--api-token TOKEN] [--trace] [--kv-eviction POLICY] [--kv-spill PATH] [--kv-spill-mb N]"
+              << " [--kv-snapshot PATH] [--kv-snapshot-interval-s N] [--kv-restore-ms N]"
+              << " [--infer-batch N] [--infer-batch-delay-us N] [--infer-batching MODE]"
+              << " [--onnx-model NAME=PATH] [--onnx-intra-threads N] [--onnx-inter-threads N]"
+              << " [--model-budget-mb N]" << std::endl;
+    std::cout << "  --port N      Listen port (default " << PORT << ")" << std::endl;
+    std::cout << "  --workers N   Worker event loops, 0 = one per core (default 0)" << std::endl;
+    std::cout << "  --handler-threads N   Threads for handlers that may block, 0 = one per core (default 4)" << std::endl;
+    std::cout << "  --idle-timeout-ms N   Close idle keep-alive connections after N ms (default 5000)" << std::endl;
+    std::cout << "  --max-requests N      Requests served per connection before closing (default 1000)" << std::endl;
+    std::cout << "  --api-token TOKEN     Require \"Authorization: Bearer TOKEN\" on capsule/vault/OTA/trace routes" << std::endl;
+    std::cout << "  --trace               Record request spans from startup (see GET /debug/trace)" << std::endl;
+    std::cout << "  --kv-eviction POLICY  KV eviction policy: lru, lfu, priority-lru, gdsf (default lru)" << std::endl;
+    std::cout << "  --kv-spill PATH       Spill cold KV pages to a file on NVMe (default off)" << std::endl;
+    std::cout << "  --kv-spill-mb N       Spill file size (default 4096)" << std::endl;
+    std::cout << "  --kv-snapshot PATH    Save KV regions to PATH and restore them at startup (default off)" << std::endl;
+    std::cout << "  --kv-snapshot-interval-s N  Also save every N seconds, 0 = only at shutdown (default 60)" << std::endl;
+    std::cout << "  --kv-restore-ms N     Time the startup restore may take (default 2000)" << std::endl;
+    std::cout << "  --infer-batch N       Most /infer requests run as one batch per model, 1 = no batching (default 8)" << std::endl;
+    std::cout << "  --infer-batch-delay-us N  Longest a request waits for its batch to fill (default 2000)" << std::endl;
+    std::cout << "  --infer-batching MODE Batch whole requests or decode steps: request, iteration (default request)" << std::endl;
+    std::cout << "  --onnx-model NAME=PATH  Serve model NAME from the ONNX file PATH, loaded on first use; repeatable (default: stub only)" << std::endl;
+    std::cout << "  --onnx-intra-threads N  ONNX Runtime threads within an operator, 0 = one per core (default 0)" << std::endl;
+    std::cout << "  --onnx-inter-threads N  ONNX Runtime operators run in parallel when > 1 (default 0)" << std::endl;
+    std::cout << "  --model-budget-mb N   Unload least recently used models past N MB resident, 0 = unlimited (default 0)" << std::endl;
 }
 
 int main(int argc, char* argv[]) {
-#ifdef _WIN32
-    WSADATA wsaData;
-    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
-        std::cerr << "WSAStartup failed" << std::endl;
-        return 1;
+    nymph::net::ServerConfig config;
+    config.host = HOST;
+    config.port = PORT;
+    unsigned handler_threads = 4;
+    std::string api_token;
+    nymph::kv::EvictionPolicy kv_eviction = nymph::kv::EvictionPolicy::LRU;
+    std::string kv_spill_path;
+    uint64_t kv_spill_mb = 4096;
+    std::string kv_snapshot_path;
+    uint64_t kv_snapshot_interval_s = 60;
+    uint64_t kv_restore_ms = 2000;
+    nymph::ai::BatchConfig infer_batch;
+    nymph::ai::RuntimeConfig onnx_config;
+    std::vector<std::pair<std::string, std::string>> onnx_models;
+    uint64_t model_budget_mb = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--workers" && i + 1 < argc) {
+            config.workers = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--handler-threads" && i + 1 < argc) {
+            handler_threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--idle-timeout-ms" && i + 1 < argc) {
+            config.idle_timeout_ms = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--max-requests" && i + 1 < argc) {
+            config.max_requests_per_connection = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--api-token" && i + 1 < argc) {
+            api_token = argv[++i];
+        } else if (arg == "--trace") {
+            nymph::trace::set_enabled(true);
+        } else if (arg == "--kv-eviction" && i + 1 < argc) {
+            if (!nymph::kv::eviction_policy_from_string(argv[++i], kv_eviction)) {
+                std::cerr << "Unknown KV eviction policy: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--kv-spill" && i + 1 < argc) {
+            kv_spill_path = argv[++i];
+        } else if (arg == "--kv-spill-mb" && i + 1 < argc) {
+            kv_spill_mb = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--kv-snapshot" && i + 1 < argc) {
+            kv_snapshot_path = argv[++i];
+        } else if (arg == "--kv-snapshot-interval-s" && i + 1 < argc) {
+            kv_snapshot_interval_s = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--kv-restore-ms" && i + 1 < argc) {
+            kv_restore_ms = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--infer-batch" && i + 1 < argc) {
+            infer_batch.max_batch = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--infer-batch-delay-us" && i + 1 < argc) {
+            infer_batch.max_delay_us = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--infer-batching" && i + 1 < argc) {
+            if (!nymph::ai::batch_mode_from_string(argv[++i], infer_batch.mode)) {
+                std::cerr << "Unknown inference batching mode: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--onnx-model" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t equals = spec.find('=');
+            if (equals == 0 || equals == std::string::npos || equals + 1 == spec.size()) {
+                std::cerr << "Expected --onnx-model NAME=PATH: " << spec << std::endl;
+                return 1;
+            }
+            onnx_models.emplace_back(spec.substr(0, equals), spec.substr(equals + 1));
+        } else if (arg == "--onnx-intra-threads" && i + 1 < argc) {
+            onnx_config.intra_op_threads = static_cast<int>(std::strtol(argv[++i], nullptr, 10));
+        } else if (arg == "--onnx-inter-threads" && i + 1 < argc) {
+            onnx_config.inter_op_threads = static_cast<int>(std::strtol(argv[++i], nullptr, 10));
+        } else if (arg == "--model-budget-mb" && i + 1 < argc) {
+            model_budget_mb = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--port" && i + 1 < argc) {
+            config.port = static_cast<uint16_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
     }
-#endif
 
     std::cout << "NYMPH 1.1 Acceleration Daemon (nymph-acceld)" << std::endl;
     std::cout << "Version: 0.1.0-stub" << std::endl;
-    std::cout << "Starting server on " << HOST << ":" << PORT << std::endl;
+    std::cout << "Starting server on " << config.host << ":" << config.port << std::endl;
     
     // Setup signal handlers
-#ifndef _WIN32
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
-#endif
+    signal(SIGPIPE, SIG_IGN);
     
     // Initialize logger
     nymph::log::Logger::instance().set_level(nymph::log::Level::INFO);
     nymph::log::info("NYMPH daemon starting...");
     
-    // Create socket
-    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd < 0) {
-        nymph::log::error("Failed to create socket");
+    // Create subsystems before any worker can race to do it
+    nymph::kv::KVCacheManager& kv_cache = nymph::kv::get_kv_cache_manager();
+    kv_cache.set_eviction_policy(kv_eviction);
+    // A snapshot's spilled pages live on in the spill file, so keep it
+    if (!kv_spill_path.empty() &&
+        !kv_cache.enable_spill(kv_spill_path, kv_spill_mb * 1024, !kv_snapshot_path.empty())) {
+        nymph::log::error("Failed to set up KV spill file " + kv_spill_path);
         return 1;
     }
+    // Restores in the background while requests are served
+    if (!kv_snapshot_path.empty() && !kv_cache.restore_snapshot(kv_snapshot_path, kv_restore_ms)) {
+        nymph::log::info("No KV snapshot to restore at " + kv_snapshot_path);
+    }
+    nymph::ai::ONNXRuntime& onnx_runtime = nymph::ai::get_onnx_runtime();
+    onnx_runtime.configure(onnx_config);
+    onnx_runtime.models().set_budget(model_budget_mb * 1024 * 1024);
+    for (const auto& model : onnx_models) {
+        if (!onnx_runtime.load_model(model.first, model.second)) {
+            return 1;
+        }
+    }
+    nymph::ai::get_inference_scheduler().configure(infer_batch);
+    nymph::thermal::get_thermal_manager();
+    nymph::security::get_sair_manager();
+    nymph::security::get_vault_manager();
     
-    // Set socket options
-    int opt = 1;
-    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-    
-    // Bind socket
-    struct sockaddr_in address;
-    memset(&address, 0, sizeof(address));
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(PORT);
-    
-    if (bind(server_fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
-        nymph::log::error("Failed to bind socket to port " + std::to_string(PORT));
-        close(server_fd);
-        return 1;
+    // Build route table
+    nymph::net::Router router;
+    nymph::api::register_routes(router);
+    router.use(nymph::net::timing_middleware());
+    for (const nymph::net::Route* route : router.routes()) {
+        // Attached before auth so rejected requests are counted too
+        nymph::metrics::RouteMetrics& metrics = nymph::metrics::get_metrics_registry().route(route->label);
+        router.attach(route->method, route->pattern, nymph::net::metrics_middleware(metrics));
+    }
+    if (!api_token.empty()) {
+        auto auth = nymph::net::bearer_auth_middleware(api_token);
+        router.attach(nymph::net::Method::POST, "/capsule/run", auth);
+        router.attach(nymph::net::Method::POST, "/vault/update", auth);
+        router.attach(nymph::net::Method::POST, "/ota/rollback", auth);
+        router.attach(nymph::net::Method::GET, "/debug/trace", auth);
     }
+    // Blocking routes run here, off the worker loops
+    nymph::net::HandlerPool handler_pool(handler_threads);
+    router.set_pool(&handler_pool);
     
-    // Listen
-    if (listen(server_fd, 10) < 0) {
-        nymph::log::error("Failed to listen on socket");
-        close(server_fd);
+    // Start worker loops
+    nymph::net::HttpServer server(config, [&router](nymph::api::APIRequest& req) {
+        return router.dispatch(req);
+    });
+    if (!server.start()) {
+        nymph::log::error("Failed to start HTTP server");
         return 1;
     }
     
-    nymph::log::info("Server listening on http://" + HOST + ":" + std::to_string(PORT));
+    nymph::log::info("Server listening on http://" + config.host + ":" + std::to_string(config.port));
     nymph::log::info("API endpoints available:");
-    nymph::log::info("  GET  /status");
-    nymph::log::info("  GET  /fabric/verify");
-    nymph::log::info("  POST /infer");
-    nymph::log::info("  POST /kv/pin");
-    nymph::log::info("  POST /squantum/run");
-    nymph::log::info("  POST /thermal/schedule");
-    nymph::log::info("  POST /capsule/run");
-    nymph::log::info("  POST /vault/update");
-    nymph::log::info("  POST /ota/rollback");
+    for (const nymph::net::Route* route : router.routes()) {
+        std::string method = nymph::net::method_to_string(route->method);
+        method.resize(4, ' ');
+        nymph::log::info("  " + method + " " + route->pattern);
+    }
     
-    // Main loop
+    // Main loop - requests are served by the worker loops; this thread
+    // samples the sensors that /status and /metrics read back, and saves
+    // the KV snapshot
+    auto next_sample = std::chrono::steady_clock::now();
+    auto snapshot_interval = std::chrono::seconds(kv_snapshot_interval_s);
+    auto next_snapshot = next_sample + snapshot_interval;
     while (g_running) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        
-        int client_fd = accept(server_fd, (struct sockaddr*)&client_addr, &client_len);
-        if (client_fd < 0) {
-            if (g_running) {
-                nymph::log::warn("Failed to accept client connection");
-            }
-            continue;
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_sample) {
+            nymph::thermal::get_thermal_manager().update_readings();
+            nymph::fabric::get_fabric_verify_status();
+            next_sample = now + TELEMETRY_INTERVAL;
+        }
+        if (!kv_snapshot_path.empty() && kv_snapshot_interval_s > 0 && now >= next_snapshot) {
+            kv_cache.save_snapshot(kv_snapshot_path);
+            next_snapshot = std::chrono::steady_clock::now() + snapshot_interval;
         }
-        
-        // Handle client in thread
-        std::thread(handle_client, client_fd).detach();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
     }
     
     nymph::log::info("Shutting down server...");
-    close(server_fd);
-    
-#ifdef _WIN32
-    WSACleanup();
-#endif
+    server.stop();
+    handler_pool.stop();
+    nymph::ai::get_inference_scheduler().shutdown();
     
     nymph::log::info("Server stopped");
+
+    // Saved after the last request, for the next daemon (e.g. after OTA)
+    if (!kv_snapshot_path.empty()) {
+        kv_cache.wait_restore();
+        kv_cache.save_snapshot(kv_snapshot_path);
+    }
     
     return 0;
 }
-
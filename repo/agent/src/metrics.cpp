@@ -0,0 +1,242 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Metrics Implementation
+ */
+
+#include "metrics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace nymph {
+namespace metrics {
+
+namespace {
+
+/* Exported histogram bounds, in seconds */
+const double kLatencyBounds[] = {
+    0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01,
+    0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+};
+
+const double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+std::atomic<size_t> g_next_shard(0);
+
+void append_double(std::ostringstream& out, double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", value);
+    out << text;
+}
+
+} // namespace
+
+size_t thread_shard() {
+    thread_local size_t shard = g_next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shard;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < kShards; i++) {
+        total += cells_[i].value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Histogram::Shard::Shard() : sum(0), max(0) {
+    for (size_t i = 0; i < kBuckets; i++) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+Histogram::Histogram() : shards_(new Shard[kShards]) {}
+
+size_t Histogram::bucket_index(uint64_t value) {
+    if (value < kSubBuckets) {
+        return static_cast<size_t>(value);
+    }
+    unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(value));
+    if (exponent > kMaxExponent) {
+        return kBuckets - 1;
+    }
+    uint64_t sub = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    return static_cast<size_t>((exponent - kSubBucketBits + 1) * kSubBuckets + sub);
+}
+
+uint64_t Histogram::bucket_lowest(size_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    unsigned exponent = static_cast<unsigned>(index / kSubBuckets) + kSubBucketBits - 1;
+    uint64_t sub = index % kSubBuckets;
+    return (kSubBuckets + sub) << (exponent - kSubBucketBits);
+}
+
+uint64_t Histogram::bucket_highest(size_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    if (index == kBuckets - 1) {
+        return UINT64_MAX;
+    }
+    unsigned exponent = static_cast<unsigned>(index / kSubBuckets) + kSubBucketBits - 1;
+    return bucket_lowest(index) + (uint64_t(1) << (exponent - kSubBucketBits)) - 1;
+}
+
+void Histogram::record(uint64_t value) {
+    Shard& shard = shards_[thread_shard()];
+    shard.counts[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t seen = shard.max.load(std::memory_order_relaxed);
+    while (value > seen &&
+           !shard.max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snap;
+    snap.counts.assign(kBuckets, 0);
+    snap.count = 0;
+    snap.sum = 0;
+    snap.max = 0;
+    for (size_t s = 0; s < kShards; s++) {
+        const Shard& shard = shards_[s];
+        for (size_t i = 0; i < kBuckets; i++) {
+            snap.counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+        }
+        snap.sum += shard.sum.load(std::memory_order_relaxed);
+        snap.max = std::max(snap.max, shard.max.load(std::memory_order_relaxed));
+    }
+    // Count from the buckets so count and buckets always agree
+    for (uint64_t c : snap.counts) {
+        snap.count += c;
+    }
+    return snap;
+}
+
+uint64_t Histogram::Snapshot::quantile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count)));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(bucket_highest(i), max);
+        }
+    }
+    return max;
+}
+
+uint64_t Histogram::Snapshot::count_at_most(uint64_t bound) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < counts.size() && bucket_highest(i) <= bound; i++) {
+        total += counts[i];
+    }
+    return total;
+}
+
+RouteMetrics& Registry::route(const std::string& label) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : routes_) {
+        if (entry.route == label) {
+            return entry;
+        }
+    }
+    routes_.emplace_back();
+    routes_.back().route = label;
+    return routes_.back();
+}
+
+std::vector<const RouteMetrics*> Registry::routes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<const RouteMetrics*> result;
+    for (const auto& entry : routes_) {
+        result.push_back(&entry);
+    }
+    return result;
+}
+
+Registry& get_metrics_registry() {
+    static Registry registry;
+    return registry;
+}
+
+std::string label_value(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size() + 2);
+    escaped += '"';
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    escaped += '"';
+    return escaped;
+}
+
+void TextWriter::family(const std::string& name, const char* type, const char* help) {
+    out_ << "# HELP " << name << ' ' << help << '\n'
+         << "# TYPE " << name << ' ' << type << '\n';
+}
+
+void TextWriter::sample(const std::string& name, const std::string& labels, double value) {
+    out_ << name;
+    if (!labels.empty()) {
+        out_ << '{' << labels << '}';
+    }
+    out_ << ' ';
+    if (std::isnan(value)) {
+        out_ << "NaN";
+    } else {
+        append_double(out_, value);
+    }
+    out_ << '\n';
+}
+
+void TextWriter::sample(const std::string& name, const std::string& labels, uint64_t value) {
+    out_ << name;
+    if (!labels.empty()) {
+        out_ << '{' << labels << '}';
+    }
+    out_ << ' ' << value << '\n';
+}
+
+void TextWriter::latency(const std::string& name, const std::string& labels,
+                         const Histogram::Snapshot& snapshot) {
+    std::string prefix = labels.empty() ? "" : labels + ",";
+    for (double bound : kLatencyBounds) {
+        std::ostringstream le;
+        append_double(le, bound);
+        uint64_t bound_ns = static_cast<uint64_t>(bound * 1e9);
+        sample(name + "_bucket", prefix + "le=\"" + le.str() + "\"",
+               snapshot.count_at_most(bound_ns));
+    }
+    sample(name + "_bucket", prefix + "le=\"+Inf\"", snapshot.count);
+    sample(name + "_sum", labels, static_cast<double>(snapshot.sum) / 1e9);
+    sample(name + "_count", labels, snapshot.count);
+}
+
+void TextWriter::quantiles(const std::string& name, const std::string& labels,
+                           const Histogram::Snapshot& snapshot) {
+    std::string prefix = labels.empty() ? "" : labels + ",";
+    for (double q : kQuantiles) {
+        std::ostringstream label;
+        append_double(label, q);
+        double value = snapshot.count == 0
+            ? std::nan("")
+            : static_cast<double>(snapshot.quantile(q)) / 1e9;
+        sample(name, prefix + "quantile=\"" + label.str() + "\"", value);
+    }
+}
+
+} // namespace metrics
+} // namespace nymph
@@ -6,15 +6,21 @@
 #include "nymph_api.hpp"
 #include "fabric_zlta.hpp"
 #include "ai_onnx.hpp"
+#include "ai_batch.hpp"
 #include "kvpin.hpp"
 #include "thermal_stdio.hpp"
 #include "sair_vault.hpp"
+#include "http_server.hpp"
+#include "json.hpp"
+#include "router.hpp"
 #include "logger.hpp"
-#include <sstream>
+#include "metrics.hpp"
+#include "trace.hpp"
 #include <ctime>
-#include <iomanip>
 #include <random>
 #include <chrono>
+#include <cstdlib>
+#include <vector>
 
 namespace nymph {
 namespace api {
@@ -22,121 +28,275 @@ namespace api {
 /* System uptime tracking */
 static std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
 
+/* 400 response for a request body that is not valid JSON */
+static APIResponse malformed_json(const json::ParseError& e) {
+    NYMPH_LOG_DEBUG("Malformed JSON body: {}", e.what());
+    std::string body;
+    json::Writer json(body);
+    json.begin_object()
+        .member("error", "Malformed JSON")
+        .member("offset", e.offset())
+        .end_object();
+    return APIResponse(400, "application/json", std::move(body));
+}
+
+/* 500 response: {"error": error, "message": message} */
+static APIResponse internal_error(const char* error, const char* message) {
+    std::string body;
+    json::Writer json(body);
+    json.begin_object()
+        .member("error", error)
+        .member("message", message)
+        .end_object();
+    return APIResponse(500, "application/json", std::move(body));
+}
+
+/* 500 response in the shape of a handler's own result: {flag: false, "error": message} */
+static APIResponse failed_result(const char* flag, const char* message) {
+    std::string body;
+    json::Writer json(body);
+    json.begin_object()
+        .member(flag, false)
+        .member("error", message)
+        .end_object();
+    return APIResponse(500, "application/json", std::move(body));
+}
+
 /* GET /status - System status and telemetry */
 APIResponse api_status(const APIRequest& req) {
     (void)req;  // Unused for GET requests
-    log::info("GET /status");
+    NYMPH_LOG_DEBUG("GET /status");
 
     auto now = std::chrono::steady_clock::now();
     auto uptime = std::chrono::duration_cast<std::chrono::seconds>(
         now - start_time).count();
 
-    // Stub values
-    double temp_c = 55.0;
+    // Published by the thermal sampler; no manager lock taken here
+    thermal::ThermalGauges thermal = thermal::get_thermal_manager().get_gauges();
     std::string board_id = "aa:bb:cc:dd:ee:ff:00:11";  // Stub board ID
 
-    std::stringstream json;
-    json << "{\n"
-         << "  \"uptime_s\": " << uptime << ",\n"
-         << "  \"temp_c\": " << std::fixed << std::setprecision(1) << temp_c << ",\n"
-         << "  \"board_id\": \"" << board_id << "\"\n"
-         << "}";
-
-    return APIResponse(200, "application/json", json.str());
+    NYMPH_TRACE_SCOPE("json.format", "json");
+    net::ServerStats server = net::get_server_stats();
+    log::LoggerStats logging = log::Logger::instance().get_stats();
+
+    std::string body;
+    body.reserve(256);
+    json::Writer json(body);
+    json.begin_object();
+    json.member("uptime_s", uptime);
+    json.key("temp_c");
+    if (thermal.valid) {
+        json.number(thermal.hottest_temp_c, 1);
+    } else {
+        json.null();
+    }
+    json.member("board_id", board_id);
+    json.key("connections").begin_object()
+        .member("accepted", server.accepted_connections)
+        .member("active", server.active_connections)
+        .member("workers", server.workers)
+        .end_object();
+    json.key("logging").begin_object()
+        .member("written", logging.written)
+        .member("dropped", logging.dropped)
+        .end_object();
+    json.end_object();
+
+    return APIResponse(200, "application/json", std::move(body));
 }
 
 /* GET /fabric/verify - DMA fabric verification status */
 APIResponse api_fabric_verify(const APIRequest& req) {
     (void)req;  // Unused for GET requests
-    log::info("GET /fabric/verify");
+    NYMPH_LOG_DEBUG("GET /fabric/verify");
 
     try {
         fabric::FabricStatus status = fabric::get_fabric_verify_status();
 
         // Convert hash to hex string
-        std::stringstream hash_hex;
+        static const char kHex[] = "0123456789abcdef";
+        std::string hash_hex(2 * status.ring_hash.size(), '0');
         for (size_t i = 0; i < status.ring_hash.size(); i++) {
-            hash_hex << std::hex << std::setfill('0') << std::setw(2)
-                     << static_cast<int>(status.ring_hash[i]);
+            hash_hex[2 * i] = kHex[status.ring_hash[i] >> 4];
+            hash_hex[2 * i + 1] = kHex[status.ring_hash[i] & 0xF];
         }
 
-        std::stringstream json;
-        json << "{\n"
-             << "  \"ring_hash\": \"" << hash_hex.str() << "\",\n"
-             << "  \"dma_bytes\": " << status.dma_bytes << "\n"
-             << "}";
+        std::string body;
+        json::Writer json(body);
+        json.begin_object()
+            .member("ring_hash", hash_hex)
+            .member("dma_bytes", status.dma_bytes)
+            .end_object();
 
-        return APIResponse(200, "application/json", json.str());
+        return APIResponse(200, "application/json", std::move(body));
     } catch (const std::exception& e) {
-        log::error("Failed to get fabric status: " + std::string(e.what()));
-        std::stringstream json;
-        json << "{\n"
-             << "  \"error\": \"Failed to get fabric status\",\n"
-             << "  \"message\": \"" << e.what() << "\"\n"
-             << "}";
-        return APIResponse(500, "application/json", json.str());
+        NYMPH_LOG_ERROR("Failed to get fabric status: {}", e.what());
+        return internal_error("Failed to get fabric status", e.what());
     }
 }
 
-/* Global ONNX Runtime instance */
-static std::unique_ptr<nymph::ai::ONNXRuntime> g_onnx_runtime = nullptr;
+/* POST /infer - AI inference */
+/*
+ * Server-Sent Events for a streamed /infer: a "token" event per token,
+ * then "done" with the usual result object, or "error". Runs on the
+ * scheduler's dispatcher thread and only queues bytes on the stream.
+ */
+namespace {
+
+class SseTokenSink : public nymph::ai::TokenSink {
+public:
+    explicit SseTokenSink(std::shared_ptr<ResponseStream> stream) : stream_(std::move(stream)) {}
+
+    bool on_token(const std::string& text, uint32_t index, double since_enqueue_ms) override {
+        std::string event = "event: token\ndata: ";
+        json::Writer json(event);
+        json.begin_object()
+            .member("index", index)
+            .member("text", text)
+            .member("t_ms", since_enqueue_ms, 2)
+            .end_object();
+        event += "\n\n";
+        return stream_->write(event);
+    }
 
-static nymph::ai::ONNXRuntime& get_onnx_runtime() {
-    if (!g_onnx_runtime) {
-        g_onnx_runtime = std::make_unique<nymph::ai::ONNXRuntime>();
-        g_onnx_runtime->initialize();
+    void on_done(const nymph::ai::InferenceResult& result) override {
+        std::string event;
+        if (result.success) {
+            event = "event: done\ndata: ";
+            event += nymph::ai::format_inference_result(result);
+        } else {
+            event = "event: error\ndata: ";
+            json::Writer json(event);
+            json.begin_object().member("error", result.error_message).end_object();
+        }
+        event += "\n\n";
+        stream_->write(event);
+        stream_->close();
     }
-    return *g_onnx_runtime;
-}
 
-/* POST /infer - AI inference */
+private:
+    std::shared_ptr<ResponseStream> stream_;
+};
+
+/*
+ * Plain /infer: the result completes the deferred response on the
+ * scheduler's dispatcher thread, so no worker loop waits for the batch.
+ */
+class DeferredResultSink : public nymph::ai::TokenSink {
+public:
+    explicit DeferredResultSink(std::shared_ptr<DeferredResponse> response) : response_(std::move(response)) {}
+
+    bool on_token(const std::string& text, uint32_t index, double since_enqueue_ms) override {
+        (void)text;
+        (void)index;
+        (void)since_enqueue_ms;
+        return !response_->cancelled();     // Stop generating for a client that left
+    }
+
+    void on_done(const nymph::ai::InferenceResult& result) override {
+        if (!result.success) {
+            std::string body;
+            json::Writer json(body);
+            json.begin_object().member("error", result.error_message).end_object();
+            response_->complete(APIResponse(500, "application/json", std::move(body)));
+            return;
+        }
+        response_->complete(APIResponse(200, "application/json", nymph::ai::format_inference_result(result)));
+    }
+
+private:
+    std::shared_ptr<DeferredResponse> response_;
+};
+
+} // namespace
+
 APIResponse api_infer(const APIRequest& req) {
-    log::info("POST /infer");
+    NYMPH_LOG_DEBUG("POST /infer");
 
     try {
         // Parse inference request from JSON body
         nymph::ai::InferenceRequest inference_req = nymph::ai::parse_inference_request(req.body);
         
-        log::info("Inference request - model: " + inference_req.model_name + 
-                  ", profile: " + inference_req.profile);
-
-        // Get ONNX runtime and run inference
-        nymph::ai::ONNXRuntime& runtime = get_onnx_runtime();
-        nymph::ai::InferenceResult result = runtime.run_inference(inference_req);
-
-        if (!result.success) {
-            std::stringstream json;
-            json << "{\n"
-                 << "  \"error\": \"" << result.error_message << "\"\n"
-                 << "}";
-            return APIResponse(500, "application/json", json.str());
+        NYMPH_LOG_INFO("Inference request - model: {}, profile: {}",
+                       inference_req.model_name, inference_req.profile);
+
+        if (!nymph::ai::get_onnx_runtime().has_model(inference_req.model_name)) {
+            std::string body;
+            json::Writer json(body);
+            json.begin_object()
+                .member("error", "Unknown model")
+                .member("model", inference_req.model_name)
+                .end_object();
+            return APIResponse(404, "application/json", std::move(body));
         }
 
-        // Format result as JSON
-        std::string json_result = nymph::ai::format_inference_result(result);
-        return APIResponse(200, "application/json", json_result);
+        // The handler returns at once; the scheduler's dispatcher delivers the output
+        APIResponse response;
+        std::shared_ptr<nymph::ai::TokenSink> sink;
+        if (inference_req.stream) {
+            response = APIResponse(200, "text/event-stream");
+            response.stream = std::make_shared<ResponseStream>();
+            sink = std::make_shared<SseTokenSink>(response.stream);
+        } else {
+            response.deferred = std::make_shared<DeferredResponse>();
+            sink = std::make_shared<DeferredResultSink>(response.deferred);
+        }
+        nymph::ai::get_inference_scheduler().stream(std::move(inference_req), std::move(sink));
+        return response;
 
+    } catch (const json::ParseError& e) {
+        return malformed_json(e);
     } catch (const std::exception& e) {
-        log::error("Inference failed: " + std::string(e.what()));
-        std::stringstream json;
-        json << "{\n"
-             << "  \"error\": \"Inference failed\",\n"
-             << "  \"message\": \"" << e.what() << "\"\n"
-             << "}";
-        return APIResponse(500, "application/json", json.str());
+        NYMPH_LOG_ERROR("Inference failed: {}", e.what());
+        return internal_error("Inference failed", e.what());
     }
 }
 
+/* GET /models - Registered models, their load state and memory */
+APIResponse api_models(const APIRequest& req) {
+    (void)req;  // Unused for GET requests
+    NYMPH_LOG_DEBUG("GET /models");
+
+    const ai::ModelRegistry& registry = ai::get_onnx_runtime().models();
+    std::vector<ai::ModelInfo> models = registry.list();
+    ai::ModelRegistryStats stats = registry.get_stats();
+
+    NYMPH_TRACE_SCOPE("json.format", "json");
+    std::string body;
+    body.reserve(128 + models.size() * 192);
+    json::Writer json(body);
+    json.begin_object();
+    json.member("budget_bytes", stats.budget_bytes);
+    json.member("resident_bytes", stats.resident_bytes);
+    json.member("loaded", stats.loaded);
+    json.key("models").begin_array();
+    for (const ai::ModelInfo& model : models) {
+        json.begin_object()
+            .member("name", model.name)
+            .member("path", model.path)
+            .member("state", ai::model_state_to_string(model.state))
+            .member("file_bytes", model.file_bytes)
+            .member("resident_bytes", model.resident_bytes)
+            .member("loads", model.loads)
+            .member("unloads", model.unloads)
+            .member("uses", model.uses)
+            .member("idle_s", model.idle_s, 1)
+            .end_object();
+    }
+    json.end_array();
+    json.end_object();
+    return APIResponse(200, "application/json", std::move(body));
+}
+
 /* POST /kv/pin - KV cache pinning */
 APIResponse api_kvpin(const APIRequest& req) {
-    log::info("POST /kv/pin");
+    NYMPH_LOG_DEBUG("POST /kv/pin");
 
     try {
         // Parse KV pin request from JSON body
         nymph::kv::KVPinRequest kvpin_req = nymph::kv::parse_kvpin_request(req.body);
         
-        log::info("KV pin request - region: " + kvpin_req.region + 
-                  ", size_kb: " + std::to_string(kvpin_req.size_kb));
+        NYMPH_LOG_INFO("KV pin request - region: {}, size_kb: {}", kvpin_req.region, kvpin_req.size_kb);
 
         // Get KV cache manager and pin region
         nymph::kv::KVCacheManager& manager = nymph::kv::get_kv_cache_manager();
@@ -151,41 +311,144 @@ APIResponse api_kvpin(const APIRequest& req) {
         
         return APIResponse(200, "application/json", json_result);
 
+    } catch (const json::ParseError& e) {
+        return malformed_json(e);
+    } catch (const std::exception& e) {
+        NYMPH_LOG_ERROR("KV pin failed: {}", e.what());
+        return internal_error("KV pin failed", e.what());
+    }
+}
+
+/* POST /kv/batch - Several KV pins, unpins, accesses and evictions at once */
+APIResponse api_kv_batch(const APIRequest& req) {
+    NYMPH_LOG_DEBUG("POST /kv/batch");
+
+    try {
+        nymph::kv::KVBatchRequest batch;
+        std::string error;
+        if (!nymph::kv::parse_kv_batch_request(req.body, batch, error)) {
+            std::string body;
+            json::Writer json(body);
+            json.begin_object()
+                .member("success", false)
+                .member("error", error)
+                .end_object();
+            return APIResponse(400, "application/json", std::move(body));
+        }
+
+        nymph::kv::KVCacheManager& manager = nymph::kv::get_kv_cache_manager();
+        nymph::kv::KVBatchResult result = manager.apply_batch(batch.ops, batch.atomic);
+
+        // Per-op failures are reported in the results; a batch refused as
+        // a whole applied nothing
+        int status = result.error_message.empty() ? 200 : 409;
+        return APIResponse(status, "application/json", nymph::kv::format_kv_batch_result(batch, result));
+
+    } catch (const json::ParseError& e) {
+        return malformed_json(e);
     } catch (const std::exception& e) {
-        log::error("KV pin failed: " + std::string(e.what()));
-        std::stringstream json;
-        json << "{\"error\":\"KV pin failed\",\"message\":\"" << e.what() << "\"}";
-        return APIResponse(500, "application/json", json.str());
+        NYMPH_LOG_ERROR("KV batch failed: {}", e.what());
+        return internal_error("KV batch failed", e.what());
     }
 }
 
+/* GET /kv/region/{name} - KV region info */
+APIResponse api_kv_region(const APIRequest& req) {
+    auto it = req.params.find("name");
+    std::string name = (it != req.params.end()) ? std::string(it->second) : "";
+    NYMPH_LOG_DEBUG("GET /kv/region/{}", name);
+
+    nymph::kv::KVRegion region;
+    if (!nymph::kv::get_kv_cache_manager().get_region(name, region)) {
+        std::string body;
+        json::Writer json(body);
+        json.begin_object()
+            .member("error", "Region not found")
+            .member("region", name)
+            .end_object();
+        return APIResponse(404, "application/json", std::move(body));
+    }
+
+    std::string body;
+    body.reserve(256);
+    json::Writer json(body);
+    json.begin_object();
+    json.member("region", region.name);
+    json.member("size_kb", region.size_kb);
+    json.member("base_address", region.base_address);
+    json.member("blocks", region.blocks.size());
+    json.member("spilled_blocks", region.pages - region.blocks.size());
+    json.member("shared_blocks", region.shared_pages);
+    json.member("extents", kv::BlockAllocator::extent_count(region.blocks));
+    json.member("pinned", region.is_pinned);
+    json.member("access_count", region.access_count);
+    json.member("hit_count", region.hit_count);
+    json.member("miss_count", region.miss_count);
+    json.member("hit_rate", (region.access_count > 0)
+        ? static_cast<double>(region.hit_count) / region.access_count : 0.0, 4);
+    json.member("window_hit_rate", region.window_hit_rate, 4);
+    json.end_object();
+    return APIResponse(200, "application/json", std::move(body));
+}
+
+/* POST /kv/region/{name}/prefetch - Read a spilled region back ahead of use */
+APIResponse api_kv_prefetch(const APIRequest& req) {
+    auto it = req.params.find("name");
+    std::string name = (it != req.params.end()) ? std::string(it->second) : "";
+    NYMPH_LOG_DEBUG("POST /kv/region/{}/prefetch", name);
+
+    nymph::kv::KVCacheManager& manager = nymph::kv::get_kv_cache_manager();
+    std::string body;
+    json::Writer json(body);
+    if (!manager.spill_enabled()) {
+        json.begin_object()
+            .member("error", "KV spill tier is disabled")
+            .member("region", name)
+            .end_object();
+        return APIResponse(409, "application/json", std::move(body));
+    }
+    if (!manager.prefetch_region(name)) {
+        json.begin_object()
+            .member("error", "Region not found")
+            .member("region", name)
+            .end_object();
+        return APIResponse(404, "application/json", std::move(body));
+    }
+    json.begin_object()
+        .member("region", name)
+        .member("queued", true)
+        .end_object();
+    return APIResponse(202, "application/json", std::move(body));
+}
+
 /* POST /squantum/run - Quantum-inspired optimization (stub) */
 APIResponse api_squantum_run(const APIRequest& req) {
     (void)req;  // Unused in stub mode
-    log::info("POST /squantum/run");
+    NYMPH_LOG_DEBUG("POST /squantum/run");
 
     // Stub response
-    std::stringstream json;
-    json << "{\n"
-         << "  \"best_score\": 0.95,\n"
-         << "  \"trace\": []\n"
-         << "}";
-
-    return APIResponse(200, "application/json", json.str());
+    std::string body;
+    json::Writer json(body);
+    json.begin_object();
+    json.member("best_score", 0.95, 2);
+    json.key("trace").begin_array().end_array();
+    json.end_object();
+
+    return APIResponse(200, "application/json", std::move(body));
 }
 
 /* POST /thermal/schedule - Thermal policy (TAITO/TAPIM) */
 APIResponse api_thermal_schedule(const APIRequest& req) {
-    log::info("POST /thermal/schedule");
+    NYMPH_LOG_DEBUG("POST /thermal/schedule");
 
     try {
         // Parse thermal schedule request from JSON body
         nymph::thermal::ThermalScheduleRequest thermal_req = 
             nymph::thermal::parse_thermal_request(req.body);
         
-        log::info("Thermal schedule request - policy: " + 
-                  nymph::thermal::policy_to_string(thermal_req.policy) + 
-                  ", target: " + std::to_string(thermal_req.target_temp_c) + "°C");
+        NYMPH_LOG_INFO("Thermal schedule request - policy: {}, target: {:.1f}°C",
+                       nymph::thermal::policy_to_string(thermal_req.policy),
+                       thermal_req.target_temp_c);
 
         // Get thermal manager and set schedule
         nymph::thermal::ThermalManager& manager = nymph::thermal::get_thermal_manager();
@@ -205,24 +468,24 @@ APIResponse api_thermal_schedule(const APIRequest& req) {
         
         return APIResponse(200, "application/json", json_result);
 
+    } catch (const json::ParseError& e) {
+        return malformed_json(e);
     } catch (const std::exception& e) {
-        log::error("Thermal schedule failed: " + std::string(e.what()));
-        std::stringstream json;
-        json << "{\"ok\":false,\"error\":\"" << e.what() << "\"}";
-        return APIResponse(500, "application/json", json.str());
+        NYMPH_LOG_ERROR("Thermal schedule failed: {}", e.what());
+        return failed_result("ok", e.what());
     }
 }
 
 /* POST /capsule/run - Attested capsule execution (SAIR) */
 APIResponse api_capsule_run(const APIRequest& req) {
-    log::info("POST /capsule/run");
+    NYMPH_LOG_DEBUG("POST /capsule/run");
 
     try {
         // Parse capsule run request from JSON body
         nymph::security::CapsuleRunRequest capsule_req = 
             nymph::security::parse_capsule_request(req.body);
         
-        log::info("Capsule run request - id: " + capsule_req.id);
+        NYMPH_LOG_INFO("Capsule run request - id: {}", capsule_req.id);
 
         // Get SAIR manager and run capsule
         nymph::security::SAIRManager& sair = nymph::security::get_sair_manager();
@@ -237,24 +500,24 @@ APIResponse api_capsule_run(const APIRequest& req) {
         
         return APIResponse(200, "application/json", json_result);
 
+    } catch (const json::ParseError& e) {
+        return malformed_json(e);
     } catch (const std::exception& e) {
-        log::error("Capsule run failed: " + std::string(e.what()));
-        std::stringstream json;
-        json << "{\"verified\":false,\"error\":\"" << e.what() << "\"}";
-        return APIResponse(500, "application/json", json.str());
+        NYMPH_LOG_ERROR("Capsule run failed: {}", e.what());
+        return failed_result("verified", e.what());
     }
 }
 
 /* POST /vault/update - Firmware update (OTA) */
 APIResponse api_vault_update(const APIRequest& req) {
-    log::info("POST /vault/update");
+    NYMPH_LOG_DEBUG("POST /vault/update");
 
     try {
         // Parse update request
         nymph::security::OTAUpdateRequest update_req = 
             nymph::security::parse_update_request(req.body);
         
-        log::info("OTA update request - version: " + update_req.version);
+        NYMPH_LOG_INFO("OTA update request - version: {}", update_req.version);
 
         // Get Vault manager and apply update
         nymph::security::VaultManager& vault = nymph::security::get_vault_manager();
@@ -269,18 +532,18 @@ APIResponse api_vault_update(const APIRequest& req) {
         
         return APIResponse(200, "application/json", json_result);
 
+    } catch (const json::ParseError& e) {
+        return malformed_json(e);
     } catch (const std::exception& e) {
-        log::error("OTA update failed: " + std::string(e.what()));
-        std::stringstream json;
-        json << "{\"applied\":false,\"error\":\"" << e.what() << "\"}";
-        return APIResponse(500, "application/json", json.str());
+        NYMPH_LOG_ERROR("OTA update failed: {}", e.what());
+        return failed_result("applied", e.what());
     }
 }
 
 /* POST /ota/rollback - OTA rollback */
 APIResponse api_ota_rollback(const APIRequest& req) {
     (void)req;  // No body needed for rollback
-    log::info("POST /ota/rollback");
+    NYMPH_LOG_DEBUG("POST /ota/rollback");
 
     try {
         // Get Vault manager and rollback
@@ -297,10 +560,301 @@ APIResponse api_ota_rollback(const APIRequest& req) {
         return APIResponse(200, "application/json", json_result);
 
     } catch (const std::exception& e) {
-        log::error("OTA rollback failed: " + std::string(e.what()));
-        std::stringstream json;
-        json << "{\"rolled_back\":false,\"error\":\"" << e.what() << "\"}";
-        return APIResponse(500, "application/json", json.str());
+        NYMPH_LOG_ERROR("OTA rollback failed: {}", e.what());
+        return failed_result("rolled_back", e.what());
+    }
+}
+
+/* GET /debug/trace - In-process span trace */
+APIResponse api_debug_trace(const APIRequest& req) {
+    std::string_view enable = query_param(req.query, "enable");
+    if (!enable.empty()) {
+        trace::set_enabled(enable == "1" || enable == "true" || enable == "on");
+        trace::TraceStats stats = trace::get_trace_stats();
+        NYMPH_LOG_INFO("Tracing {}", stats.enabled ? "enabled" : "disabled");
+
+        std::string body;
+        json::Writer json(body);
+        json.begin_object()
+            .member("enabled", stats.enabled)
+            .member("recorded", stats.recorded)
+            .member("threads", stats.threads)
+            .member("rings", stats.rings)
+            .end_object();
+        return APIResponse(200, "application/json", std::move(body));
+    }
+
+    // Retrospective window over what the per-thread rings still hold
+    uint64_t seconds = 5;
+    std::string_view value = query_param(req.query, "seconds");
+    if (!value.empty()) {
+        seconds = std::strtoull(std::string(value).c_str(), nullptr, 10);
+        if (seconds > 3600) seconds = 3600;
+    }
+    return APIResponse(200, "application/json", trace::export_chrome_json(seconds * 1000));
+}
+
+/* GET /metrics - Prometheus text exposition */
+APIResponse api_metrics(const APIRequest& req) {
+    (void)req;  // Unused for GET requests
+    NYMPH_TRACE_SCOPE("metrics.render", "metrics");
+
+    // Every source below is atomics only; no subsystem mutex is taken
+    metrics::TextWriter out;
+
+    auto routes = metrics::get_metrics_registry().routes();
+    std::vector<std::string> route_labels;
+    std::vector<metrics::Histogram::Snapshot> latencies;
+    for (const metrics::RouteMetrics* route : routes) {
+        route_labels.push_back("route=" + metrics::label_value(route->route));
+        latencies.push_back(route->latency_ns.snapshot());
+    }
+
+    out.family("nymph_http_request_duration_seconds", "histogram",
+               "Handler latency by route, including middleware.");
+    for (size_t i = 0; i < routes.size(); i++) {
+        out.latency("nymph_http_request_duration_seconds", route_labels[i], latencies[i]);
+    }
+
+    out.family("nymph_http_request_latency_seconds", "summary",
+               "Handler latency quantiles by route, from log-linear buckets (~6% resolution).");
+    for (size_t i = 0; i < routes.size(); i++) {
+        out.quantiles("nymph_http_request_latency_seconds", route_labels[i], latencies[i]);
+        out.sample("nymph_http_request_latency_seconds_sum", route_labels[i],
+                   static_cast<double>(latencies[i].sum) / 1e9);
+        out.sample("nymph_http_request_latency_seconds_count", route_labels[i], latencies[i].count);
+    }
+
+    static const char* const kClasses[6] = {"other", "1xx", "2xx", "3xx", "4xx", "5xx"};
+    out.family("nymph_http_route_responses_total", "counter", "Responses by route and status class.");
+    for (size_t i = 0; i < routes.size(); i++) {
+        for (size_t c = 0; c < 6; c++) {
+            uint64_t value = routes[i]->responses[c].value();
+            if (value > 0) {
+                out.sample("nymph_http_route_responses_total",
+                           route_labels[i] + ",code=\"" + kClasses[c] + "\"", value);
+            }
+        }
+    }
+
+    net::ServerStats server = net::get_server_stats();
+    out.family("nymph_http_requests_total", "counter", "Requests parsed, matched or not.");
+    out.sample("nymph_http_requests_total", "", server.requests);
+    out.family("nymph_http_responses_total", "counter", "All responses by status class, including 404/405 and parse errors.");
+    for (size_t c = 0; c < 6; c++) {
+        out.sample("nymph_http_responses_total", std::string("code=\"") + kClasses[c] + "\"",
+                   server.responses[c]);
+    }
+    out.family("nymph_http_parse_errors_total", "counter", "Requests rejected by the parser.");
+    out.sample("nymph_http_parse_errors_total", "", server.parse_errors);
+    out.family("nymph_http_connections_accepted_total", "counter", "Connections accepted.");
+    out.sample("nymph_http_connections_accepted_total", "", server.accepted_connections);
+    out.family("nymph_http_connections_active", "gauge", "Connections currently open.");
+    out.sample("nymph_http_connections_active", "", server.active_connections);
+
+    kv::KVCacheGauges kv_gauges = kv::get_kv_cache_manager().get_gauges();
+    out.family("nymph_kv_cache_size_bytes", "gauge", "KV cache capacity.");
+    out.sample("nymph_kv_cache_size_bytes", "", kv_gauges.total_size_kb * 1024);
+    out.family("nymph_kv_cache_used_bytes", "gauge", "KV cache bytes allocated to regions.");
+    out.sample("nymph_kv_cache_used_bytes", "", kv_gauges.used_size_kb * 1024);
+    out.family("nymph_kv_regions", "gauge", "KV regions resident.");
+    out.sample("nymph_kv_regions", "", kv_gauges.regions);
+    out.family("nymph_kv_pinned_regions", "gauge", "KV regions currently pinned.");
+    out.sample("nymph_kv_pinned_regions", "", kv_gauges.pinned_regions);
+    out.family("nymph_kv_accesses_total", "counter", "KV region accesses.");
+    out.sample("nymph_kv_accesses_total", "", kv_gauges.accesses);
+    out.family("nymph_kv_hits_total", "counter", "KV region hits.");
+    out.sample("nymph_kv_hits_total", "", kv_gauges.hits);
+    out.family("nymph_kv_misses_total", "counter", "KV region misses.");
+    out.sample("nymph_kv_misses_total", "", kv_gauges.misses);
+    out.family("nymph_kv_evictions_total", "counter", "KV regions evicted.");
+    out.sample("nymph_kv_evictions_total", "", kv_gauges.evictions);
+    out.family("nymph_kv_spilled_bytes_total", "counter", "KV region pages spilled from the pinned pool.");
+    out.sample("nymph_kv_spilled_bytes_total", "", kv_gauges.spilled_blocks * kv::BlockAllocator::kBlockSizeKB * 1024);
+    out.family("nymph_kv_spill_file_used_bytes", "gauge", "KV pages held in the NVMe spill file.");
+    out.sample("nymph_kv_spill_file_used_bytes", "", kv_gauges.spill_used_kb * 1024);
+    out.family("nymph_kv_readback_bytes_total", "counter", "KV pages read back from the spill file.");
+    out.sample("nymph_kv_readback_bytes_total", "", kv_gauges.readback_blocks * kv::BlockAllocator::kBlockSizeKB * 1024);
+    out.family("nymph_kv_dedup_saved_bytes", "gauge", "KV region pages served by a shared prefix block.");
+    out.sample("nymph_kv_dedup_saved_bytes", "", kv_gauges.dedup_saved_kb * 1024);
+    out.family("nymph_kv_cow_copies_bytes_total", "counter", "KV shared prefix pages copied on write.");
+    out.sample("nymph_kv_cow_copies_bytes_total", "", kv_gauges.cow_blocks * kv::BlockAllocator::kBlockSizeKB * 1024);
+
+    ai::InferenceScheduler& scheduler = ai::get_inference_scheduler();
+    std::vector<ai::BatchQueueStats> batching = scheduler.get_stats();
+    std::vector<std::string> model_labels;
+    for (const ai::BatchQueueStats& queue : batching) {
+        model_labels.push_back("model=" + metrics::label_value(queue.model));
+    }
+    out.family("nymph_infer_batches_total", "counter", "Inference batches (iteration mode: decode steps) dispatched by model.");
+    for (size_t i = 0; i < batching.size(); i++) {
+        out.sample("nymph_infer_batches_total", model_labels[i], batching[i].batches);
+    }
+    out.family("nymph_infer_batched_requests_total", "counter", "Inference requests run in a batch, by model.");
+    for (size_t i = 0; i < batching.size(); i++) {
+        out.sample("nymph_infer_batched_requests_total", model_labels[i], batching[i].requests);
+    }
+    out.family("nymph_infer_batch_size", "histogram", "Requests per inference batch, by model.");
+    static const uint64_t kBatchBounds[] = {1, 2, 4, 8, 16, 32, 64};
+    for (size_t i = 0; i < batching.size(); i++) {
+        // Small sizes fall in exact buckets, so count_at_most is exact
+        const metrics::Histogram::Snapshot& sizes = batching[i].batch_size;
+        for (uint64_t bound : kBatchBounds) {
+            out.sample("nymph_infer_batch_size_bucket",
+                       model_labels[i] + ",le=\"" + std::to_string(bound) + "\"", sizes.count_at_most(bound));
+        }
+        out.sample("nymph_infer_batch_size_bucket", model_labels[i] + ",le=\"+Inf\"", sizes.count);
+        out.sample("nymph_infer_batch_size_sum", model_labels[i], sizes.sum);
+        out.sample("nymph_infer_batch_size_count", model_labels[i], sizes.count);
+    }
+    out.family("nymph_infer_batch_occupancy", "gauge",
+               "Mean batch size as a share of the configured maximum, by model.");
+    for (size_t i = 0; i < batching.size(); i++) {
+        const metrics::Histogram::Snapshot& sizes = batching[i].batch_size;
+        uint64_t slots = sizes.count * scheduler.config().max_batch;
+        out.sample("nymph_infer_batch_occupancy", model_labels[i],
+                   slots > 0 ? static_cast<double>(sizes.sum) / slots : 0.0);
+    }
+    out.family("nymph_infer_queue_depth", "gauge", "Inference requests waiting for a batch, by model.");
+    for (size_t i = 0; i < batching.size(); i++) {
+        out.sample("nymph_infer_queue_depth", model_labels[i], batching[i].depth);
+    }
+    out.family("nymph_infer_running_sequences", "gauge", "Sequences in the running decode batch (iteration mode), by model.");
+    for (size_t i = 0; i < batching.size(); i++) {
+        out.sample("nymph_infer_running_sequences", model_labels[i], batching[i].running);
+    }
+    out.family("nymph_infer_generated_tokens_total", "counter", "Tokens generated by decode steps (iteration mode), by model.");
+    for (size_t i = 0; i < batching.size(); i++) {
+        out.sample("nymph_infer_generated_tokens_total", model_labels[i], batching[i].tokens);
+    }
+    out.family("nymph_infer_queue_delay_seconds", "histogram",
+               "Time from queueing to dispatch of an inference request, by model.");
+    for (size_t i = 0; i < batching.size(); i++) {
+        out.latency("nymph_infer_queue_delay_seconds", model_labels[i], batching[i].queue_delay_ns);
+    }
+    out.family("nymph_infer_first_token_seconds", "histogram",
+               "Time from queueing to the first generated token (request mode: the whole output), by model.");
+    for (size_t i = 0; i < batching.size(); i++) {
+        out.latency("nymph_infer_first_token_seconds", model_labels[i], batching[i].first_token_ns);
+    }
+
+    ai::ModelRegistryGauges model_gauges = ai::get_onnx_runtime().models().get_gauges();
+    out.family("nymph_model_memory_budget_bytes", "gauge", "Resident bytes loaded models may take, 0 = unlimited.");
+    out.sample("nymph_model_memory_budget_bytes", "", model_gauges.budget_bytes);
+    out.family("nymph_model_resident_bytes", "gauge", "Resident bytes charged to each loaded model.");
+    for (const ai::ModelGauge& model : model_gauges.models) {
+        out.sample("nymph_model_resident_bytes", "model=" + metrics::label_value(model.name), model.resident_bytes);
+    }
+    out.family("nymph_model_loaded", "gauge", "1 if the model is loaded.");
+    for (const ai::ModelGauge& model : model_gauges.models) {
+        out.sample("nymph_model_loaded", "model=" + metrics::label_value(model.name),
+                   static_cast<uint64_t>(model.loaded ? 1 : 0));
+    }
+    out.family("nymph_model_loads_total", "counter", "Model loads, by model.");
+    for (const ai::ModelGauge& model : model_gauges.models) {
+        out.sample("nymph_model_loads_total", "model=" + metrics::label_value(model.name), model.loads);
+    }
+    out.family("nymph_model_unloads_total", "counter", "Model unloads to stay within the budget or on request, by model.");
+    for (const ai::ModelGauge& model : model_gauges.models) {
+        out.sample("nymph_model_unloads_total", "model=" + metrics::label_value(model.name), model.unloads);
+    }
+    out.family("nymph_model_load_failures_total", "counter", "Model loads that failed.");
+    out.sample("nymph_model_load_failures_total", "", model_gauges.load_failures);
+
+    thermal::ThermalGauges thermal = thermal::get_thermal_manager().get_gauges();
+    if (thermal.valid) {
+        out.family("nymph_thermal_zone_celsius", "gauge", "Latest NTC reading per thermal zone.");
+        for (size_t z = 0; z < thermal::kThermalZoneCount; z++) {
+            out.sample("nymph_thermal_zone_celsius",
+                       std::string("zone=\"") + thermal::zone_to_string(static_cast<thermal::ThermalZone>(z)) + "\"",
+                       thermal.zone_temp_c[z]);
+        }
+        out.family("nymph_thermal_hottest_celsius", "gauge", "Hottest zone temperature.");
+        out.sample("nymph_thermal_hottest_celsius", "", thermal.hottest_temp_c);
+        out.family("nymph_thermal_target_celsius", "gauge", "Thermal policy target temperature.");
+        out.sample("nymph_thermal_target_celsius", "", thermal.target_temp_c);
+        out.family("nymph_thermal_max_celsius", "gauge", "Throttle threshold temperature.");
+        out.sample("nymph_thermal_max_celsius", "", thermal.max_temp_c);
+        out.family("nymph_power_watts", "gauge", "Total PMBus rail power.");
+        out.sample("nymph_power_watts", "", thermal.power_w);
+        out.family("nymph_fan_pwm_duty", "gauge", "Fan PWM duty (0-255).");
+        out.sample("nymph_fan_pwm_duty", "", static_cast<uint64_t>(thermal.fan_pwm));
+        out.family("nymph_fan_rpm", "gauge", "Fan speed.");
+        out.sample("nymph_fan_rpm", "", static_cast<uint64_t>(thermal.fan_rpm));
+        out.family("nymph_thermal_throttle_total", "counter", "Thermal samples above the throttle threshold.");
+        out.sample("nymph_thermal_throttle_total", "", thermal.throttle_count);
+        out.family("nymph_thermal_samples_total", "counter", "Thermal samples taken.");
+        out.sample("nymph_thermal_samples_total", "", thermal.sample_count);
+    }
+
+    fabric::FabricCounters fabric_counters = fabric::get_fabric_counters();
+    out.family("nymph_fabric_dma_submitted_bytes_total", "counter", "Bytes in DMA descriptors accepted.");
+    out.sample("nymph_fabric_dma_submitted_bytes_total", "", fabric_counters.submitted_bytes);
+    out.family("nymph_fabric_dma_descriptors_total", "counter", "DMA descriptors accepted.");
+    out.sample("nymph_fabric_dma_descriptors_total", "", fabric_counters.submitted_descriptors);
+    out.family("nymph_fabric_dma_failures_total", "counter", "DMA descriptors rejected by the driver.");
+    out.sample("nymph_fabric_dma_failures_total", "", fabric_counters.failed_submissions);
+    out.family("nymph_fabric_device_dma_bytes", "gauge", "dma_bytes reported by the driver at the last status read.");
+    out.sample("nymph_fabric_device_dma_bytes", "", fabric_counters.device_dma_bytes);
+    out.family("nymph_fabric_device_present", "gauge", "1 when the last status came from /dev/pcie_nymph.");
+    out.sample("nymph_fabric_device_present", "", static_cast<uint64_t>(fabric_counters.device_present));
+
+    log::LoggerStats logging = log::Logger::instance().get_stats();
+    out.family("nymph_log_records_written_total", "counter", "Log records written.");
+    out.sample("nymph_log_records_written_total", "", logging.written);
+    out.family("nymph_log_records_dropped_total", "counter", "Log records dropped on a full queue.");
+    out.sample("nymph_log_records_dropped_total", "", logging.dropped);
+
+    auto uptime = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+    out.family("nymph_uptime_seconds", "gauge", "Seconds since the daemon started.");
+    out.sample("nymph_uptime_seconds", "", static_cast<uint64_t>(uptime));
+
+    return APIResponse(200, "text/plain; version=0.0.4; charset=utf-8", out.str());
+}
+
+std::string_view query_param(std::string_view query, std::string_view key) {
+    while (!query.empty()) {
+        size_t amp = query.find('&');
+        std::string_view pair = query.substr(0, amp);
+        size_t eq = pair.find('=');
+        if (pair.substr(0, eq) == key) {
+            return (eq == std::string_view::npos) ? std::string_view() : pair.substr(eq + 1);
+        }
+        if (amp == std::string_view::npos) break;
+        query.remove_prefix(amp + 1);
+    }
+    return std::string_view();
+}
+
+/* Route table */
+void register_routes(net::Router& router) {
+    using net::Method;
+    router.add(Method::GET,  "/status",            api_status);
+    router.add(Method::GET,  "/fabric/verify",     api_fabric_verify);
+    router.add(Method::POST, "/infer",             api_infer);
+    router.add(Method::GET,  "/models",            api_models);
+    router.add(Method::POST, "/kv/pin",            api_kvpin);
+    router.add(Method::POST, "/kv/batch",          api_kv_batch);
+    router.add(Method::GET,  "/kv/region/{name}",  api_kv_region);
+    router.add(Method::POST, "/kv/region/{name}/prefetch", api_kv_prefetch);
+    router.add(Method::POST, "/squantum/run",      api_squantum_run);
+    router.add(Method::POST, "/thermal/schedule",  api_thermal_schedule);
+    router.add(Method::POST, "/capsule/run",       api_capsule_run);
+    router.add(Method::POST, "/vault/update",      api_vault_update);
+    router.add(Method::POST, "/ota/rollback",      api_ota_rollback);
+    router.add(Method::GET,  "/debug/trace",       api_debug_trace);
+    router.add(Method::GET,  "/metrics",           api_metrics);
+
+    // File reads, attestation and firmware writes; a long trace export
+    router.set_blocking(Method::POST, "/capsule/run");
+    router.set_blocking(Method::POST, "/vault/update");
+    router.set_blocking(Method::POST, "/ota/rollback");
+    router.set_blocking(Method::GET,  "/debug/trace");
+    // Eviction writes pages to the spill file and faults read them back
+    if (kv::get_kv_cache_manager().spill_enabled()) {
+        router.set_blocking(Method::POST, "/kv/pin");
+        router.set_blocking(Method::POST, "/kv/batch");
     }
 }
 
@@ -0,0 +1,397 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Request Router Implementation
+ */
+
+#include "router.hpp"
+#include "json.hpp"
+#include "logger.hpp"
+#include "trace.hpp"
+#include <chrono>
+#include <stdexcept>
+
+namespace nymph {
+namespace net {
+
+Router::Node::Node() : param_child(kNoChild) {
+    for (size_t i = 0; i < kMethodCount; i++) {
+        routes[i] = -1;
+    }
+}
+
+Method method_from_string(std::string_view name) {
+    if (name == "GET") return Method::GET;
+    if (name == "POST") return Method::POST;
+    if (name == "PUT") return Method::PUT;
+    if (name == "DELETE") return Method::DELETE;
+    if (name == "PATCH") return Method::PATCH;
+    if (name == "HEAD") return Method::HEAD;
+    if (name == "OPTIONS") return Method::OPTIONS;
+    return Method::UNKNOWN;
+}
+
+const char* method_to_string(Method method) {
+    switch (method) {
+        case Method::GET: return "GET";
+        case Method::POST: return "POST";
+        case Method::PUT: return "PUT";
+        case Method::DELETE: return "DELETE";
+        case Method::PATCH: return "PATCH";
+        case Method::HEAD: return "HEAD";
+        case Method::OPTIONS: return "OPTIONS";
+        default: return "UNKNOWN";
+    }
+}
+
+Router::Router() {
+    nodes_.emplace_back();  // Root
+}
+
+void Router::compose(Route& route) const {
+    // Middleware runs on the worker either way; only the handler goes to the pool
+    Handler chain = route.handler;
+    if (route.blocking) {
+        const Route* target = &route;
+        chain = [this, target](const api::APIRequest& req) { return offload(*target, req); };
+    }
+    for (auto it = route.middleware.rbegin(); it != route.middleware.rend(); ++it) {
+        Middleware middleware = *it;
+        chain = [middleware, chain](const api::APIRequest& req) { return middleware(req, chain); };
+    }
+    for (auto it = global_middleware_.rbegin(); it != global_middleware_.rend(); ++it) {
+        Middleware middleware = *it;
+        chain = [middleware, chain](const api::APIRequest& req) { return middleware(req, chain); };
+    }
+    route.chain = std::move(chain);
+}
+
+Router& Router::add(Method method, std::string_view pattern, Handler handler,
+                    std::vector<Middleware> middleware) {
+    if (method == Method::UNKNOWN) {
+        throw std::invalid_argument("Cannot register route for unknown method");
+    }
+
+    auto route = std::make_unique<Route>();
+    route->method = method;
+    route->pattern = std::string(pattern);
+    route->label = std::string(method_to_string(method)) + " " + route->pattern;
+    route->handler = std::move(handler);
+    route->middleware = std::move(middleware);
+
+    // Walk/extend the trie one segment at a time
+    uint32_t node = 0;
+    size_t pos = (!pattern.empty() && pattern[0] == '/') ? 1 : 0;
+    while (pos < pattern.size()) {
+        size_t slash = pattern.find('/', pos);
+        if (slash == std::string_view::npos) slash = pattern.size();
+        std::string_view segment = pattern.substr(pos, slash - pos);
+        pos = slash + 1;
+
+        if (segment.size() >= 2 && segment.front() == '{' && segment.back() == '}') {
+            route->param_names.emplace_back(segment.substr(1, segment.size() - 2));
+            if (nodes_[node].param_child == kNoChild) {
+                nodes_[node].param_child = static_cast<uint32_t>(nodes_.size());
+                nodes_.emplace_back();
+            }
+            node = nodes_[node].param_child;
+            continue;
+        }
+
+        uint32_t next = kNoChild;
+        for (const auto& child : nodes_[node].children) {
+            if (child.first == segment) {
+                next = child.second;
+                break;
+            }
+        }
+        if (next == kNoChild) {
+            next = static_cast<uint32_t>(nodes_.size());
+            nodes_[node].children.emplace_back(std::string(segment), next);
+            nodes_.emplace_back();
+        }
+        node = next;
+    }
+
+    size_t slot = static_cast<size_t>(method);
+    if (nodes_[node].routes[slot] >= 0) {
+        throw std::invalid_argument("Duplicate route: " + std::string(method_to_string(method)) +
+                                    " " + route->pattern);
+    }
+
+    compose(*route);
+    nodes_[node].routes[slot] = static_cast<int32_t>(routes_.size());
+    routes_.push_back(std::move(route));
+    return *this;
+}
+
+Router& Router::use(Middleware middleware) {
+    global_middleware_.push_back(std::move(middleware));
+    for (auto& route : routes_) {
+        compose(*route);
+    }
+    return *this;
+}
+
+bool Router::attach(Method method, std::string_view pattern, Middleware middleware) {
+    for (auto& route : routes_) {
+        if (route->method == method && route->pattern == pattern) {
+            route->middleware.push_back(std::move(middleware));
+            compose(*route);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Router::set_blocking(Method method, std::string_view pattern) {
+    for (auto& route : routes_) {
+        if (route->method == method && route->pattern == pattern) {
+            route->blocking = true;
+            compose(*route);
+            return true;
+        }
+    }
+    return false;
+}
+
+const Route* Router::find(Method method, std::string_view path,
+                          std::vector<std::pair<std::string_view, std::string_view>>& params,
+                          bool& path_matched) const {
+    params.clear();
+    path_matched = false;
+
+    if (path.size() > 1 && path.back() == '/') {
+        path.remove_suffix(1);
+    }
+
+    uint32_t node = 0;
+    size_t pos = (!path.empty() && path[0] == '/') ? 1 : 0;
+    while (pos < path.size()) {
+        size_t slash = path.find('/', pos);
+        if (slash == std::string_view::npos) slash = path.size();
+        std::string_view segment = path.substr(pos, slash - pos);
+        pos = slash + 1;
+
+        const Node& current = nodes_[node];
+        uint32_t next = kNoChild;
+        for (const auto& child : current.children) {
+            if (child.first == segment) {
+                next = child.second;
+                break;
+            }
+        }
+        if (next == kNoChild && current.param_child != kNoChild && !segment.empty()) {
+            params.emplace_back(std::string_view(), segment);
+            next = current.param_child;
+        }
+        if (next == kNoChild) {
+            return nullptr;
+        }
+        node = next;
+    }
+
+    const Node& target = nodes_[node];
+    for (size_t i = 0; i < kMethodCount; i++) {
+        if (target.routes[i] >= 0) {
+            path_matched = true;
+            break;
+        }
+    }
+    if (method == Method::UNKNOWN) {
+        return nullptr;
+    }
+
+    int32_t index = target.routes[static_cast<size_t>(method)];
+    if (index < 0) {
+        return nullptr;
+    }
+
+    const Route* route = routes_[static_cast<size_t>(index)].get();
+    for (size_t i = 0; i < params.size() && i < route->param_names.size(); i++) {
+        params[i].first = route->param_names[i];
+    }
+    return route;
+}
+
+api::APIResponse Router::dispatch(api::APIRequest& req) const {
+    std::vector<std::pair<std::string_view, std::string_view>> params;
+    bool path_matched = false;
+    const Route* route;
+    {
+        NYMPH_TRACE_SCOPE("route", "http");
+        route = find(method_from_string(req.method), req.path, params, path_matched);
+    }
+
+    if (route == nullptr) {
+        // The method and path come from the client, so they are escaped
+        std::string body;
+        json::Writer json(body);
+        if (path_matched) {
+            json.begin_object()
+                .member("error", "Method not allowed")
+                .member("method", req.method)
+                .end_object();
+            return api::APIResponse(405, "application/json", std::move(body));
+        }
+        json.begin_object()
+            .member("error", "Not found")
+            .member("path", req.path)
+            .end_object();
+        return api::APIResponse(404, "application/json", std::move(body));
+    }
+
+    req.params.clear();
+    for (const auto& param : params) {
+        req.params[param.first] = param.second;
+    }
+    NYMPH_TRACE_SCOPE(route->label.c_str(), "handler");
+    return route->chain(req);
+}
+
+namespace {
+
+/* Request whose views point into its own copy of the bytes, for another thread */
+struct OwnedRequest {
+    std::string bytes;
+    api::APIRequest request;
+
+    explicit OwnedRequest(const api::APIRequest& req) {
+        size_t total = req.method.size() + req.path.size() + req.query.size() +
+                       req.version.size() + req.body.size();
+        for (const auto& header : req.headers) {
+            total += header.first.size() + header.second.size();
+        }
+        for (const auto& param : req.params) {
+            total += param.first.size() + param.second.size();
+        }
+        bytes.reserve(total);   // No reallocation below, so the views stay valid
+
+        auto copy = [this](std::string_view view) {
+            size_t offset = bytes.size();
+            bytes.append(view.data(), view.size());
+            return std::string_view(bytes.data() + offset, view.size());
+        };
+        request.method = copy(req.method);
+        request.path = copy(req.path);
+        request.query = copy(req.query);
+        request.version = copy(req.version);
+        request.body = copy(req.body);
+        for (const auto& header : req.headers) {
+            std::string_view name = copy(header.first);
+            request.headers[name] = copy(header.second);
+        }
+        for (const auto& param : req.params) {
+            std::string_view name = copy(param.first);
+            request.params[name] = copy(param.second);
+        }
+    }
+};
+
+} // namespace
+
+api::APIResponse Router::offload(const Route& route, const api::APIRequest& req) const {
+    if (pool_ == nullptr) {
+        return route.handler(req);
+    }
+    auto owned = std::make_shared<OwnedRequest>(req);
+    auto deferred = std::make_shared<api::DeferredResponse>();
+    const Route* target = &route;
+    bool queued = pool_->submit([target, owned, deferred]() {
+        if (deferred->cancelled()) {
+            return;     // Client left while the job was queued
+        }
+        api::APIResponse resp;
+        try {
+            NYMPH_TRACE_SCOPE(target->label.c_str(), "handler");
+            resp = target->handler(owned->request);
+        } catch (const std::exception& e) {
+            NYMPH_LOG_ERROR("Request handler failed: {}", e.what());
+            resp = api::APIResponse(500, "application/json", "{\"error\": \"Internal server error\"}");
+        }
+        deferred->complete(std::move(resp));
+    });
+    if (!queued) {
+        NYMPH_LOG_WARN("Handler pool full, refusing {}", route.label);
+        return api::APIResponse(503, "application/json", "{\"error\": \"Server busy\"}");
+    }
+    api::APIResponse resp(202);
+    resp.deferred = std::move(deferred);
+    return resp;
+}
+
+std::vector<const Route*> Router::routes() const {
+    std::vector<const Route*> result;
+    result.reserve(routes_.size());
+    for (const auto& route : routes_) {
+        result.push_back(route.get());
+    }
+    return result;
+}
+
+Middleware timing_middleware() {
+    return [](const api::APIRequest& req, const Handler& next) {
+        auto start = std::chrono::steady_clock::now();
+        api::APIResponse resp = next(req);
+        if (resp.deferred) {
+            // Logged on completion; the request's views are gone by then
+            std::string request = std::string(req.method) + " " + std::string(req.path);
+            resp.deferred->then([request, start](api::APIResponse& done) {
+                auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+                NYMPH_LOG_DEBUG("{} -> {} in {} us (deferred)", request, done.status_code, elapsed_us);
+            });
+            return resp;
+        }
+        auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        NYMPH_LOG_DEBUG("{} {} -> {} in {} us", req.method, req.path, resp.status_code, elapsed_us);
+        return resp;
+    };
+}
+
+Middleware metrics_middleware(metrics::RouteMetrics& metrics) {
+    metrics::RouteMetrics* target = &metrics;
+    return [target](const api::APIRequest& req, const Handler& next) {
+        auto start = std::chrono::steady_clock::now();
+        api::APIResponse resp = next(req);
+        auto record = [target, start](const api::APIResponse& done) {
+            target->latency_ns.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count()));
+            target->responses[metrics::status_class(done.status_code)].add();
+        };
+        if (resp.deferred) {
+            // Latency and status are those of the completed response
+            resp.deferred->then(record);
+        } else {
+            record(resp);
+        }
+        return resp;
+    };
+}
+
+Middleware bearer_auth_middleware(const std::string& token) {
+    return [token](const api::APIRequest& req, const Handler& next) {
+        auto it = req.headers.find("authorization");
+        std::string_view presented;
+        if (it != req.headers.end() && it->second.substr(0, 7) == "Bearer ") {
+            presented = it->second.substr(7);
+        }
+
+        // Compare without early exit so timing does not leak the token
+        unsigned char diff = (presented.size() == token.size()) ? 0 : 1;
+        for (size_t i = 0; i < token.size(); i++) {
+            char c = (i < presented.size()) ? presented[i] : 0;
+            diff |= static_cast<unsigned char>(c ^ token[i]);
+        }
+
+        if (token.empty() || diff != 0) {
+            NYMPH_LOG_WARN("Unauthorized request: {} {}", req.method, req.path);
+            return api::APIResponse(401, "application/json", "{\"error\": \"Unauthorized\"}");
+        }
+        return next(req);
+    };
+}
+
+} // namespace net
+} // namespace nymph
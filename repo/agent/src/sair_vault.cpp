@@ -7,7 +7,9 @@
  */
 
 #include "sair_vault.hpp"
+#include "json.hpp"
 #include "logger.hpp"
+#include "trace.hpp"
 #include <sstream>
 #include <fstream>
 #include <iomanip>
@@ -110,7 +112,12 @@ AttestationResult SAIRManager::attest_artifact(const std::string& artifact_path,
                                                ArtifactType type,
                                                const std::string& expected_hash) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
+    return attest_locked(artifact_path, type, expected_hash);
+}
+
+AttestationResult SAIRManager::attest_locked(const std::string& artifact_path,
+                                             ArtifactType type,
+                                             const std::string& expected_hash) {
     AttestationResult result;
     result.verified = false;
     result.artifact_id = artifact_path;
@@ -193,9 +200,11 @@ CapsuleRunResult SAIRManager::run_capsule(const CapsuleRunRequest& request) {
 
     // Attest artifact if required
     if (request.require_verification) {
-        AttestationResult attest = attest_artifact(
+        // mutex_ is already held
+        AttestationResult attest = attest_locked(
             request.artifact_path, 
-            request.artifact_type
+            request.artifact_type,
+            ""
         );
         
         if (!attest.verified) {
@@ -214,14 +223,14 @@ CapsuleRunResult SAIRManager::run_capsule(const CapsuleRunRequest& request) {
     log::info("Executing capsule: " + request.id);
     
     // Simulate execution result
-    std::stringstream exec_result;
-    exec_result << "{\"capsule_id\":\"" << request.id << "\"";
-    exec_result << ",\"status\":\"completed\"";
-    exec_result << ",\"execution_time_ms\":42.5";
-    exec_result << "}";
+    json::Writer exec_result(result.result_data);
+    exec_result.begin_object();
+    exec_result.member("capsule_id", request.id);
+    exec_result.member("status", "completed");
+    exec_result.member("execution_time_ms", 42.5, 1);
+    exec_result.end_object();
     
     result.executed = true;
-    result.result_data = exec_result.str();
     result.metadata["capsule_id"] = request.id;
     result.metadata["verified"] = result.verified ? "true" : "false";
     
@@ -421,41 +430,22 @@ bool VaultManager::is_update_available(const std::string& version) const {
 }
 
 /* Helper functions for API integration */
-CapsuleRunRequest parse_capsule_request(const std::string& json_body) {
+CapsuleRunRequest parse_capsule_request(std::string_view json_body) {
+    NYMPH_TRACE_SCOPE("json.parse", "json");
     CapsuleRunRequest request;
     request.require_verification = true;
     request.artifact_type = ArtifactType::BINARY;
     
-    // Simple JSON parsing
-    auto find_string_field = [&json_body](const std::string& field) -> std::string {
-        std::string search = "\"" + field + "\"";
-        size_t pos = json_body.find(search);
-        if (pos == std::string::npos) return "";
-        
-        pos = json_body.find(":", pos);
-        if (pos == std::string::npos) return "";
-        pos++;
-        
-        while (pos < json_body.length() && (json_body[pos] == ' ' || json_body[pos] == '\t')) {
-            pos++;
-        }
-        
-        if (pos >= json_body.length()) return "";
-        
-        if (json_body[pos] == '"') {
-            pos++;
-            size_t end = pos;
-            while (end < json_body.length() && json_body[end] != '"') {
-                end++;
-            }
-            return json_body.substr(pos, end - pos);
+    json::Reader reader(json_body);
+    std::string_view key;
+    json::Value value;
+    while (reader.next(key, value)) {
+        if (key == "id") {
+            request.id = value.as_string();
+        } else if (key == "artifact_path") {
+            request.artifact_path = value.as_string();
         }
-        
-        return "";
-    };
-    
-    request.id = find_string_field("id");
-    request.artifact_path = find_string_field("artifact_path");
+    }
     
     // Defaults
     if (request.id.empty()) {
@@ -466,64 +456,52 @@ CapsuleRunRequest parse_capsule_request(const std::string& json_body) {
 }
 
 std::string format_capsule_result(const CapsuleRunResult& result) {
-    std::stringstream json;
-    
-    json << "{";
-    json << "\"verified\":" << (result.verified ? "true" : "false");
-    json << ",\"executed\":" << (result.executed ? "true" : "false");
-    
+    NYMPH_TRACE_SCOPE("json.format", "json");
+    std::string body;
+    body.reserve(128 + result.result_data.size());
+    json::Writer json(body);
+
+    json.begin_object();
+    json.member("verified", result.verified);
+    json.member("executed", result.executed);
+
+    // result_data is JSON produced by the capsule runner
+    json.key("result");
     if (result.executed && !result.result_data.empty()) {
-        // Parse and include result_data
-        json << ",\"result\":" << result.result_data;
+        json.raw(result.result_data);
     } else {
-        json << ",\"result\":{}";
+        json.begin_object().end_object();
     }
-    
+
     if (!result.error_message.empty()) {
-        json << ",\"error\":\"" << result.error_message << "\"";
+        json.member("error", result.error_message);
     }
-    
-    json << "}";
-    
-    return json.str();
+
+    json.end_object();
+    return body;
 }
 
-OTAUpdateRequest parse_update_request(const std::string& json_body) {
+OTAUpdateRequest parse_update_request(std::string_view json_body) {
+    NYMPH_TRACE_SCOPE("json.parse", "json");
     OTAUpdateRequest request;
     request.force = false;
     
-    // Simple JSON parsing
-    auto find_string_field = [&json_body](const std::string& field) -> std::string {
-        std::string search = "\"" + field + "\"";
-        size_t pos = json_body.find(search);
-        if (pos == std::string::npos) return "";
-        
-        pos = json_body.find(":", pos);
-        if (pos == std::string::npos) return "";
-        pos++;
-        
-        while (pos < json_body.length() && (json_body[pos] == ' ' || json_body[pos] == '\t')) {
-            pos++;
-        }
-        
-        if (pos >= json_body.length()) return "";
-        
-        if (json_body[pos] == '"') {
-            pos++;
-            size_t end = pos;
-            while (end < json_body.length() && json_body[end] != '"') {
-                end++;
-            }
-            return json_body.substr(pos, end - pos);
+    json::Reader reader(json_body);
+    std::string_view key;
+    json::Value value;
+    while (reader.next(key, value)) {
+        if (key == "version") {
+            request.version = value.as_string();
+        } else if (key == "update_path") {
+            request.update_path = value.as_string();
+        } else if (key == "signature_path") {
+            request.signature_path = value.as_string();
+        } else if (key == "board_id") {
+            request.board_id = value.as_string();
+        } else if (key == "force") {
+            request.force = value.as_bool(false);
         }
-        
-        return "";
-    };
-    
-    request.version = find_string_field("version");
-    request.update_path = find_string_field("update_path");
-    request.signature_path = find_string_field("signature_path");
-    request.board_id = find_string_field("board_id");
+    }
     
     // Defaults
     if (request.version.empty()) {
@@ -534,44 +512,48 @@ OTAUpdateRequest parse_update_request(const std::string& json_body) {
 }
 
 std::string format_update_result(const OTAUpdateResult& result) {
-    std::stringstream json;
-    
-    json << "{";
-    json << "\"applied\":" << (result.applied ? "true" : "false");
-    json << ",\"verified\":" << (result.verified ? "true" : "false");
-    json << ",\"version\":\"" << result.version << "\"";
-    
+    NYMPH_TRACE_SCOPE("json.format", "json");
+    std::string body;
+    body.reserve(128);
+    json::Writer json(body);
+
+    json.begin_object();
+    json.member("applied", result.applied);
+    json.member("verified", result.verified);
+    json.member("version", result.version);
+
     if (!result.previous_version.empty()) {
-        json << ",\"previous_version\":\"" << result.previous_version << "\"";
+        json.member("previous_version", result.previous_version);
     }
-    
+
     if (!result.error_message.empty()) {
-        json << ",\"error\":\"" << result.error_message << "\"";
+        json.member("error", result.error_message);
     }
-    
-    json << "}";
-    
-    return json.str();
+
+    json.end_object();
+    return body;
 }
 
 std::string format_rollback_result(const OTARollbackResult& result) {
-    std::stringstream json;
-    
-    json << "{";
-    json << "\"rolled_back\":" << (result.rolled_back ? "true" : "false");
-    json << ",\"version\":\"" << result.version << "\"";
-    
+    NYMPH_TRACE_SCOPE("json.format", "json");
+    std::string body;
+    body.reserve(128);
+    json::Writer json(body);
+
+    json.begin_object();
+    json.member("rolled_back", result.rolled_back);
+    json.member("version", result.version);
+
     if (!result.previous_version.empty()) {
-        json << ",\"previous_version\":\"" << result.previous_version << "\"";
+        json.member("previous_version", result.previous_version);
     }
-    
+
     if (!result.error_message.empty()) {
-        json << ",\"error\":\"" << result.error_message << "\"";
+        json.member("error", result.error_message);
     }
-    
-    json << "}";
-    
-    return json.str();
+
+    json.end_object();
+    return body;
 }
 
 } // namespace security
@@ -7,8 +7,9 @@
  */
 
 #include "thermal_stdio.hpp"
+#include "json.hpp"
 #include "logger.hpp"
-#include <sstream>
+#include "trace.hpp"
 #include <chrono>
 #include <algorithm>
 #include <iomanip>
@@ -21,15 +22,28 @@ namespace thermal {
 
 /* Global Thermal Manager instance */
 static std::unique_ptr<ThermalManager> g_thermal_manager = nullptr;
+static std::once_flag g_thermal_manager_once;
 
 ThermalManager& get_thermal_manager() {
-    if (!g_thermal_manager) {
+    // Request workers and the sampling loop may race to create it
+    std::call_once(g_thermal_manager_once, [] {
         g_thermal_manager = std::make_unique<ThermalManager>();
         g_thermal_manager->initialize();
-    }
+    });
     return *g_thermal_manager;
 }
 
+const char* zone_to_string(ThermalZone zone) {
+    switch (zone) {
+        case ThermalZone::SOC: return "SoC";
+        case ThermalZone::VRM: return "VRM";
+        case ThermalZone::NPU: return "NPU";
+        case ThermalZone::NVME: return "NVMe";
+        case ThermalZone::AMBIENT: return "Ambient";
+        default: return "Unknown";
+    }
+}
+
 ThermalManager::ThermalManager()
     : initialized_(false)
     , current_policy_(ThermalPolicy::PREDICTIVE)
@@ -58,6 +72,10 @@ ThermalManager::ThermalManager()
     stats_.throttle_time_ms = 0;
     stats_.power_total_w = 0.0;
     stats_.sample_count = 0;
+
+    for (size_t i = 0; i < kThermalZoneCount; i++) {
+        gauges_.zone_temp_c[i].store(0.0, std::memory_order_relaxed);
+    }
 }
 
 ThermalManager::~ThermalManager() {
@@ -71,14 +89,7 @@ uint64_t ThermalManager::get_current_time() const {
 }
 
 std::string ThermalManager::thermal_zone_name(ThermalZone zone) const {
-    switch (zone) {
-        case ThermalZone::SOC: return "SoC";
-        case ThermalZone::VRM: return "VRM";
-        case ThermalZone::NPU: return "NPU";
-        case ThermalZone::NVME: return "NVMe";
-        case ThermalZone::AMBIENT: return "Ambient";
-        default: return "Unknown";
-    }
+    return zone_to_string(zone);
 }
 
 ThermalZone ThermalManager::thermal_zone_from_name(const std::string& name) const {
@@ -140,14 +151,65 @@ void ThermalManager::update_stats(double temp) {
     }
 }
 
+double ThermalManager::hottest_temp() const {
+    double hottest = 0.0;
+    for (const auto& pair : zone_readings_) {
+        if (pair.second.temp_c > hottest) {
+            hottest = pair.second.temp_c;
+        }
+    }
+    return hottest;
+}
+
+void ThermalManager::publish_gauges() {
+    gauges_.hottest_temp_c.store(hottest_temp(), std::memory_order_relaxed);
+    gauges_.target_temp_c.store(target_temp_c_, std::memory_order_relaxed);
+    gauges_.max_temp_c.store(max_temp_c_, std::memory_order_relaxed);
+    for (const auto& pair : zone_readings_) {
+        size_t index = static_cast<size_t>(pair.first);
+        if (index < kThermalZoneCount) {
+            gauges_.zone_temp_c[index].store(pair.second.temp_c, std::memory_order_relaxed);
+        }
+    }
+    double power = 0.0;
+    for (const auto& rail : pmbus_rails_) {
+        power += rail.power_w;
+    }
+    gauges_.power_w.store(power, std::memory_order_relaxed);
+    gauges_.fan_pwm.store(fan_status_.pwm_duty, std::memory_order_relaxed);
+    gauges_.fan_rpm.store(fan_status_.rpm, std::memory_order_relaxed);
+    gauges_.throttle_count.store(stats_.throttle_count, std::memory_order_relaxed);
+    gauges_.throttle_time_ms.store(stats_.throttle_time_ms, std::memory_order_relaxed);
+    gauges_.sample_count.store(stats_.sample_count, std::memory_order_relaxed);
+    gauges_.valid.store(initialized_, std::memory_order_release);
+}
+
+ThermalGauges ThermalManager::get_gauges() const {
+    ThermalGauges gauges;
+    gauges.valid = gauges_.valid.load(std::memory_order_acquire);
+    gauges.hottest_temp_c = gauges_.hottest_temp_c.load(std::memory_order_relaxed);
+    gauges.target_temp_c = gauges_.target_temp_c.load(std::memory_order_relaxed);
+    gauges.max_temp_c = gauges_.max_temp_c.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kThermalZoneCount; i++) {
+        gauges.zone_temp_c[i] = gauges_.zone_temp_c[i].load(std::memory_order_relaxed);
+    }
+    gauges.power_w = gauges_.power_w.load(std::memory_order_relaxed);
+    gauges.fan_pwm = gauges_.fan_pwm.load(std::memory_order_relaxed);
+    gauges.fan_rpm = gauges_.fan_rpm.load(std::memory_order_relaxed);
+    gauges.throttle_count = gauges_.throttle_count.load(std::memory_order_relaxed);
+    gauges.throttle_time_ms = gauges_.throttle_time_ms.load(std::memory_order_relaxed);
+    gauges.sample_count = gauges_.sample_count.load(std::memory_order_relaxed);
+    return gauges;
+}
+
 bool ThermalManager::initialize() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = trace::timed_lock(mutex_, "thermal.lock_wait");
     
     if (initialized_) {
         return true;
     }
 
-    log::info("Initializing Thermal Manager (TAITO/TAPIM)");
+    NYMPH_LOG_INFO("Initializing Thermal Manager (TAITO/TAPIM)");
     
     // Initialize zone readings with simulated values
     uint64_t now = get_current_time();
@@ -232,12 +294,13 @@ bool ThermalManager::initialize() {
     pmbus_rails_.push_back(rail_1v0);
     
     initialized_ = true;
-    log::info("Thermal Manager initialized (stub mode)");
+    publish_gauges();
+    NYMPH_LOG_INFO("Thermal Manager initialized (stub mode)");
     return true;
 }
 
 void ThermalManager::update_readings() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = trace::timed_lock(mutex_, "thermal.lock_wait");
     
     if (!initialized_) return;
     
@@ -303,12 +366,7 @@ void ThermalManager::update_readings() {
     }
     
     // Get hottest zone and update stats
-    double hottest = 0.0;
-    for (const auto& pair : zone_readings_) {
-        if (pair.second.temp_c > hottest) {
-            hottest = pair.second.temp_c;
-        }
-    }
+    double hottest = hottest_temp();
     update_stats(hottest);
     
     // Check for throttling
@@ -316,10 +374,13 @@ void ThermalManager::update_readings() {
         stats_.throttle_count++;
         stats_.throttle_time_ms += 1000;  // Assume 1s update interval
     }
+
+    publish_gauges();
 }
 
 ThermalScheduleResult ThermalManager::set_schedule(const ThermalScheduleRequest& request) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    NYMPH_TRACE_SCOPE("thermal.set_schedule", "thermal");
+    auto lock = trace::timed_lock(mutex_, "thermal.lock_wait");
     
     ThermalScheduleResult result;
     result.ok = false;
@@ -329,8 +390,8 @@ ThermalScheduleResult ThermalManager::set_schedule(const ThermalScheduleRequest&
         return result;
     }
 
-    log::info("Setting thermal policy: " + policy_to_string(request.policy) + 
-              ", target: " + std::to_string(request.target_temp_c) + "°C");
+    NYMPH_LOG_DEBUG("Setting thermal policy: {}, target: {:.1f}°C",
+                    policy_to_string(request.policy), request.target_temp_c);
 
     // Update policy
     current_policy_ = request.policy;
@@ -338,12 +399,7 @@ ThermalScheduleResult ThermalManager::set_schedule(const ThermalScheduleRequest&
     max_temp_c_ = request.max_temp_c;
     
     // Get current hottest temperature
-    double hottest = 0.0;
-    for (const auto& pair : zone_readings_) {
-        if (pair.second.temp_c > hottest) {
-            hottest = pair.second.temp_c;
-        }
-    }
+    double hottest = hottest_temp();
     
     // Calculate new fan PWM based on policy
     uint8_t new_pwm;
@@ -375,6 +431,7 @@ ThermalScheduleResult ThermalManager::set_schedule(const ThermalScheduleRequest&
     fan_status_.pwm_duty = new_pwm;
     fan_status_.target_rpm = (new_pwm * 5000) / 255;  // 0-5000 RPM range
     fan_status_.rpm = fan_status_.target_rpm;  // Instant in stub mode
+    publish_gauges();
     
     // Build result
     result.ok = true;
@@ -388,13 +445,13 @@ ThermalScheduleResult ThermalManager::set_schedule(const ThermalScheduleRequest&
         result.zone_temps[thermal_zone_name(pair.first)] = pair.second.temp_c;
     }
     
-    log::info("Thermal schedule applied, fan PWM: " + std::to_string(fan_status_.pwm_duty));
+    NYMPH_LOG_INFO("Thermal schedule applied, fan PWM: {}", static_cast<int>(fan_status_.pwm_duty));
     
     return result;
 }
 
 ThermalScheduleResult ThermalManager::get_status() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = trace::timed_lock(mutex_, "thermal.lock_wait");
     
     ThermalScheduleResult result;
     result.ok = initialized_;
@@ -418,12 +475,12 @@ ThermalScheduleResult ThermalManager::get_status() const {
 }
 
 std::vector<PMBusRail> ThermalManager::read_pmbus_rails() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = trace::timed_lock(mutex_, "thermal.lock_wait");
     return pmbus_rails_;
 }
 
 std::vector<NTCReading> ThermalManager::read_ntc_sensors() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = trace::timed_lock(mutex_, "thermal.lock_wait");
     
     std::vector<NTCReading> readings;
     for (const auto& pair : zone_readings_) {
@@ -433,30 +490,31 @@ std::vector<NTCReading> ThermalManager::read_ntc_sensors() const {
 }
 
 FanStatus ThermalManager::get_fan_status() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = trace::timed_lock(mutex_, "thermal.lock_wait");
     return fan_status_;
 }
 
 bool ThermalManager::set_fan_pwm(uint8_t pwm_duty) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = trace::timed_lock(mutex_, "thermal.lock_wait");
     
     if (!initialized_) return false;
     
     fan_status_.pwm_duty = pwm_duty;
     fan_status_.target_rpm = (pwm_duty * 5000) / 255;
     fan_status_.rpm = fan_status_.target_rpm;
+    publish_gauges();
     
-    log::info("Fan PWM set to: " + std::to_string(pwm_duty));
+    NYMPH_LOG_INFO("Fan PWM set to: {}", static_cast<int>(pwm_duty));
     return true;
 }
 
 MCUStatus ThermalManager::get_mcu_status() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = trace::timed_lock(mutex_, "thermal.lock_wait");
     return mcu_status_;
 }
 
 ThermalStats ThermalManager::get_stats() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = trace::timed_lock(mutex_, "thermal.lock_wait");
     return stats_;
 }
 
@@ -496,7 +554,7 @@ double ThermalManager::predict_temperature(uint64_t time_ahead_ms) const {
 }
 
 bool ThermalManager::is_throttling() const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = trace::timed_lock(mutex_, "thermal.lock_wait");
     
     for (const auto& pair : zone_readings_) {
         if (pair.second.temp_c > max_temp_c_) {
@@ -507,7 +565,7 @@ bool ThermalManager::is_throttling() const {
 }
 
 bool ThermalManager::log_thermal_data(const std::string& filepath) const {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = trace::timed_lock(mutex_, "thermal.lock_wait");
     
     std::ofstream file(filepath, std::ios::app);
     if (!file.is_open()) {
@@ -543,7 +601,8 @@ bool ThermalManager::log_thermal_data(const std::string& filepath) const {
 }
 
 /* Helper functions for API integration */
-ThermalScheduleRequest parse_thermal_request(const std::string& json_body) {
+ThermalScheduleRequest parse_thermal_request(std::string_view json_body) {
+    NYMPH_TRACE_SCOPE("json.parse", "json");
     ThermalScheduleRequest request;
     request.policy = ThermalPolicy::PREDICTIVE;
     request.target_temp_c = 72.0;
@@ -553,109 +612,58 @@ ThermalScheduleRequest parse_thermal_request(const std::string& json_body) {
     request.enable_dvfs = true;
     request.enable_throttle = true;
     
-    // Simple JSON parsing
-    auto find_string_field = [&json_body](const std::string& field) -> std::string {
-        std::string search = "\"" + field + "\"";
-        size_t pos = json_body.find(search);
-        if (pos == std::string::npos) return "";
-        
-        pos = json_body.find(":", pos);
-        if (pos == std::string::npos) return "";
-        pos++;
-        
-        while (pos < json_body.length() && (json_body[pos] == ' ' || json_body[pos] == '\t')) {
-            pos++;
-        }
-        
-        if (pos >= json_body.length()) return "";
-        
-        if (json_body[pos] == '"') {
-            pos++;
-            size_t end = pos;
-            while (end < json_body.length() && json_body[end] != '"') {
-                end++;
+    json::Reader reader(json_body);
+    std::string_view key;
+    json::Value value;
+    while (reader.next(key, value)) {
+        if (key == "policy") {
+            std::string policy = value.as_string();
+            if (!policy.empty()) {
+                request.policy = policy_from_string(policy);
+            }
+        } else if (key == "target_temp_c") {
+            double target = value.as_double(-1.0);
+            if (target > 0) {
+                request.target_temp_c = target;
+            }
+        } else if (key == "max_temp_c") {
+            double max_temp = value.as_double(-1.0);
+            if (max_temp > 0) {
+                request.max_temp_c = max_temp;
             }
-            return json_body.substr(pos, end - pos);
-        }
-        
-        return "";
-    };
-    
-    auto find_number_field = [&json_body](const std::string& field) -> double {
-        std::string search = "\"" + field + "\"";
-        size_t pos = json_body.find(search);
-        if (pos == std::string::npos) return -1.0;
-        
-        pos = json_body.find(":", pos);
-        if (pos == std::string::npos) return -1.0;
-        pos++;
-        
-        while (pos < json_body.length() && (json_body[pos] == ' ' || json_body[pos] == '\t')) {
-            pos++;
-        }
-        
-        if (pos >= json_body.length()) return -1.0;
-        
-        size_t end = pos;
-        while (end < json_body.length() && 
-               ((json_body[end] >= '0' && json_body[end] <= '9') || json_body[end] == '.')) {
-            end++;
-        }
-        
-        if (end > pos) {
-            return std::stod(json_body.substr(pos, end - pos));
         }
-        
-        return -1.0;
-    };
-    
-    std::string policy_str = find_string_field("policy");
-    if (!policy_str.empty()) {
-        request.policy = policy_from_string(policy_str);
-    }
-    
-    double target = find_number_field("target_temp_c");
-    if (target > 0) {
-        request.target_temp_c = target;
-    }
-    
-    double max_temp = find_number_field("max_temp_c");
-    if (max_temp > 0) {
-        request.max_temp_c = max_temp;
     }
     
     return request;
 }
 
 std::string format_thermal_result(const ThermalScheduleResult& result) {
-    std::stringstream json;
-    json << std::fixed << std::setprecision(1);
-    
-    json << "{";
-    json << "\"ok\":" << (result.ok ? "true" : "false");
-    json << ",\"policy\":\"" << policy_to_string(result.active_policy) << "\"";
-    json << ",\"current_temp_c\":" << result.current_temp_c;
-    json << ",\"target_temp_c\":" << result.target_temp_c;
-    json << ",\"fan_pwm\":" << static_cast<int>(result.fan_pwm);
-    
+    NYMPH_TRACE_SCOPE("json.format", "json");
+    std::string body;
+    body.reserve(256);
+    json::Writer json(body);
+
+    json.begin_object();
+    json.member("ok", result.ok);
+    json.member("policy", policy_to_string(result.active_policy));
+    json.member("current_temp_c", result.current_temp_c, 1);
+    json.member("target_temp_c", result.target_temp_c, 1);
+    json.member("fan_pwm", static_cast<int>(result.fan_pwm));
+
     if (!result.zone_temps.empty()) {
-        json << ",\"zones\":{";
-        bool first = true;
+        json.key("zones").begin_object();
         for (const auto& pair : result.zone_temps) {
-            if (!first) json << ",";
-            json << "\"" << pair.first << "\":" << pair.second;
-            first = false;
+            json.member(pair.first, pair.second, 1);
         }
-        json << "}";
+        json.end_object();
     }
-    
+
     if (!result.message.empty()) {
-        json << ",\"message\":\"" << result.message << "\"";
+        json.member("message", result.message);
     }
-    
-    json << "}";
-    
-    return json.str();
+
+    json.end_object();
+    return body;
 }
 
 std::string policy_to_string(ThermalPolicy policy) {
@@ -0,0 +1,257 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 In-Process Request Tracing Implementation
+ *
+ * Each thread owns one ring and is its only writer. Event fields are
+ * relaxed atomics so the exporter can read a ring while it is being
+ * written; events the writer may have lapped during the copy are dropped.
+ *
+ * A thread returns its ring to a free list when it exits, so short-lived
+ * threads (retiring inference dispatchers, handler pools) reuse rings
+ * instead of adding one each. A released ring stays exportable under its
+ * old thread until a new thread takes it over.
+ */
+
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace nymph {
+namespace trace {
+
+namespace detail {
+std::atomic<bool> g_enabled(false);
+} // namespace detail
+
+namespace {
+
+struct Event {
+    std::atomic<const char*> name;
+    std::atomic<const char*> category;
+    std::atomic<uint64_t> start_ns;
+    std::atomic<uint64_t> end_ns;
+};
+
+struct ThreadRing {
+    uint32_t tid;                           // Guarded by registry mutex
+    std::string thread_name;                // Guarded by registry mutex
+    uint64_t base;                          // Head when tid took the ring; guarded by registry mutex
+    bool in_use;                            // Guarded by registry mutex
+    std::atomic<uint64_t> head;             // Events written so far
+    std::unique_ptr<Event[]> events;
+
+    ThreadRing() : tid(0), base(0), in_use(false), head(0), events(new Event[kEventsPerThread]) {}
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;     // Never freed; bounded by peak live threads
+    std::vector<ThreadRing*> free;                      // Released by exited threads
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+/* Puts the thread's ring on the free list when the thread exits */
+struct RingOwner {
+    ThreadRing* ring = nullptr;
+
+    ~RingOwner() {
+        if (ring != nullptr) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            ring->in_use = false;
+            reg.free.push_back(ring);
+        }
+    }
+};
+
+thread_local RingOwner t_owner;
+thread_local std::string t_thread_name;
+
+/* Calling thread's ring, taken from the free list or allocated on its first span */
+ThreadRing& local_ring() {
+    if (t_owner.ring == nullptr) {
+        uint32_t tid = static_cast<uint32_t>(syscall(SYS_gettid));
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        ThreadRing* ring;
+        if (!reg.free.empty()) {
+            ring = reg.free.back();
+            reg.free.pop_back();
+        } else {
+            reg.rings.push_back(std::make_unique<ThreadRing>());
+            ring = reg.rings.back().get();
+        }
+        // The previous owner's events are no longer exported under the new tid
+        ring->tid = tid;
+        ring->thread_name = t_thread_name;
+        ring->base = ring->head.load(std::memory_order_relaxed);
+        ring->in_use = true;
+        t_owner.ring = ring;
+    }
+    return *t_owner.ring;
+}
+
+void append_escaped(std::ostringstream& out, const char* text) {
+    for (const char* p = text; *p != '\0'; p++) {
+        char c = *p;
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            out << c;
+        }
+    }
+}
+
+/* A ring and its owner as of the export's registry lock */
+struct RingView {
+    const ThreadRing* ring;
+    uint32_t tid;
+    std::string thread_name;
+    uint64_t base;
+    uint64_t head;
+};
+
+struct Snapshot {
+    const char* name;
+    const char* category;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+} // namespace
+
+namespace detail {
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void record(const char* name, const char* category, uint64_t start_ns, uint64_t end_ns) {
+    ThreadRing& ring = local_ring();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    Event& event = ring.events[head % kEventsPerThread];
+    event.name.store(name, std::memory_order_relaxed);
+    event.category.store(category, std::memory_order_relaxed);
+    event.start_ns.store(start_ns, std::memory_order_relaxed);
+    event.end_ns.store(end_ns, std::memory_order_relaxed);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+} // namespace detail
+
+void set_enabled(bool enabled) {
+    detail::g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void set_thread_name(const std::string& name) {
+    t_thread_name = name;
+    if (t_owner.ring != nullptr) {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        t_owner.ring->thread_name = name;
+    }
+}
+
+std::string export_chrome_json(uint64_t window_ms) {
+    uint64_t now = detail::now_ns();
+    uint64_t cutoff = (window_ms > 0 && window_ms * 1000000 < now) ? now - window_ms * 1000000 : 0;
+    int pid = static_cast<int>(getpid());
+
+    // Events past the captured head may belong to a thread that took the ring later
+    std::vector<RingView> views;
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        views.reserve(reg.rings.size());
+        for (const auto& ring : reg.rings) {
+            views.push_back(RingView{ring.get(), ring->tid, ring->thread_name, ring->base,
+                                     ring->head.load(std::memory_order_acquire)});
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    json << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+         << ",\"tid\":0,\"args\":{\"name\":\"nymph-acceld\"}}";
+
+    std::vector<Snapshot> events;
+    events.reserve(kEventsPerThread);
+    for (const RingView& view : views) {
+        const ThreadRing& ring = *view.ring;
+        if (view.head == view.base) {
+            continue;
+        }
+
+        if (!view.thread_name.empty()) {
+            json << ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+                 << ",\"tid\":" << view.tid << ",\"args\":{\"name\":\"";
+            append_escaped(json, view.thread_name.c_str());
+            json << "\"}}";
+        }
+
+        uint64_t head = view.head;
+        uint64_t first = std::max(view.base, (head > kEventsPerThread) ? head - kEventsPerThread : 0);
+        events.clear();
+        for (uint64_t i = first; i < head; i++) {
+            const Event& event = ring.events[i % kEventsPerThread];
+            events.push_back(Snapshot{event.name.load(std::memory_order_relaxed),
+                                      event.category.load(std::memory_order_relaxed),
+                                      event.start_ns.load(std::memory_order_relaxed),
+                                      event.end_ns.load(std::memory_order_relaxed)});
+        }
+
+        // Slots below the writer's new lap may have been overwritten mid-copy
+        uint64_t head_after = ring.head.load(std::memory_order_acquire);
+        uint64_t valid_from = (head_after > kEventsPerThread) ? head_after - kEventsPerThread : 0;
+        for (uint64_t i = std::max(first, valid_from); i < head; i++) {
+            const Snapshot& event = events[i - first];
+            if (event.name == nullptr || event.end_ns < cutoff) {
+                continue;
+            }
+            uint64_t duration = event.end_ns - event.start_ns;
+            json << ",{\"name\":\"";
+            append_escaped(json, event.name);
+            json << "\",\"cat\":\"";
+            append_escaped(json, event.category);
+            json << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << view.tid
+                 << ",\"ts\":" << event.start_ns / 1000 << '.'
+                 << static_cast<char>('0' + (event.start_ns / 100) % 10)
+                 << static_cast<char>('0' + (event.start_ns / 10) % 10)
+                 << static_cast<char>('0' + event.start_ns % 10)
+                 << ",\"dur\":" << duration / 1000 << '.'
+                 << static_cast<char>('0' + (duration / 100) % 10)
+                 << static_cast<char>('0' + (duration / 10) % 10)
+                 << static_cast<char>('0' + duration % 10) << '}';
+        }
+    }
+
+    json << "]}";
+    return json.str();
+}
+
+TraceStats get_trace_stats() {
+    TraceStats stats;
+    stats.enabled = enabled();
+    stats.recorded = 0;
+    stats.threads = 0;
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto& ring : reg.rings) {
+        stats.recorded += ring->head.load(std::memory_order_relaxed);
+        stats.threads += ring->in_use ? 1 : 0;
+    }
+    stats.rings = reg.rings.size();
+    return stats;
+}
+
+} // namespace trace
+} // namespace nymph
@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Test Helpers
+ *
+ * Each test is a standalone executable: NYMPH_CHECK records failed
+ * conditions and finish() turns them into the exit status ctest reads.
+ */
+
+#ifndef NYMPH_TEST_COMMON_HPP
+#define NYMPH_TEST_COMMON_HPP
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace nymph {
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+#define NYMPH_CHECK(condition)                                                              \
+    do {                                                                                    \
+        if (!(condition)) {                                                                 \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            nymph::test::failures()++;                                                      \
+        }                                                                                   \
+    } while (0)
+
+/* Exit status for main: 0 when every check passed */
+inline int finish(const char* name) {
+    if (failures() > 0) {
+        std::printf("%s: %d checks failed\n", name, failures());
+        return 1;
+    }
+    std::printf("%s: OK\n", name);
+    return 0;
+}
+
+/* Connection to 127.0.0.1:port with a receive timeout; -1 on failure */
+inline int connect_to(uint16_t port, int timeout_s = 5) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    timeval timeout{timeout_s, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* One POST with a Content-Length body, as sent by a client */
+inline std::string post(const std::string& path, const std::string& body) {
+    return "POST " + path + " HTTP/1.1\r\nHost: test\r\nContent-Length: " + std::to_string(body.size()) +
+           "\r\n\r\n" + body;
+}
+
+/* Read one Content-Length response; empty if the connection ended or timed out first */
+inline std::string read_response(int fd) {
+    std::string in;
+    char chunk[16384];
+    while (true) {
+        size_t head_end = in.find("\r\n\r\n");
+        if (head_end != std::string::npos) {
+            size_t length_at = in.find("Content-Length: ");
+            if (length_at != std::string::npos && length_at < head_end &&
+                in.size() >= head_end + 4 + std::strtoull(in.c_str() + length_at + 16, nullptr, 10)) {
+                return in;
+            }
+        }
+        ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+        if (got <= 0) {
+            return std::string();
+        }
+        in.append(chunk, static_cast<size_t>(got));
+    }
+}
+
+/* Send request on a fresh connection and return the response */
+inline std::string round_trip(uint16_t port, const std::string& request) {
+    int fd = connect_to(port);
+    if (fd < 0) {
+        return std::string();
+    }
+    std::string response;
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(request.size())) {
+        response = read_response(fd);
+    }
+    close(fd);
+    return response;
+}
+
+/* Status code of a response, 0 if there is none */
+inline int status_of(const std::string& response) {
+    return response.size() >= 12 ? std::atoi(response.c_str() + 9) : 0;
+}
+
+} // namespace test
+} // namespace nymph
+
+#endif // NYMPH_TEST_COMMON_HPP
@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 HTTP Server Half-Close Test
+ *
+ * A client may shut down its write side once the request is sent. The
+ * server must still send the responses to what it received, deferred and
+ * streamed ones included, and only then close the connection.
+ */
+
+#include "http_server.hpp"
+#include "logger.hpp"
+#include "nymph_api.hpp"
+#include "test_common.hpp"
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nymph::test;
+using nymph::api::APIRequest;
+using nymph::api::APIResponse;
+
+namespace {
+
+const uint16_t kPort = 18482;
+
+/* Producers of the deferred and streamed responses; joined at the end */
+std::mutex g_producers_mutex;
+std::vector<std::thread> g_producers;
+
+void produce(std::function<void()> job) {
+    std::lock_guard<std::mutex> lock(g_producers_mutex);
+    g_producers.emplace_back([job]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        job();
+    });
+}
+
+APIResponse handle(APIRequest& req) {
+    if (req.path == "/deferred") {
+        APIResponse resp(202);
+        resp.deferred = std::make_shared<nymph::api::DeferredResponse>();
+        std::shared_ptr<nymph::api::DeferredResponse> deferred = resp.deferred;
+        produce([deferred]() { deferred->complete(APIResponse(200, "application/json", "{\"deferred\":true}")); });
+        return resp;
+    }
+    if (req.path == "/stream") {
+        APIResponse resp(200, "text/event-stream");
+        resp.stream = std::make_shared<nymph::api::ResponseStream>();
+        std::shared_ptr<nymph::api::ResponseStream> stream = resp.stream;
+        produce([stream]() {
+            stream->write("data: one\n\n");
+            stream->write("data: two\n\n");
+            stream->close();
+        });
+        return resp;
+    }
+    return APIResponse(200, "application/json", "{\"plain\":true}");
+}
+
+/* Send requests, shut down the write side and read until the server closes; empty on timeout */
+std::string half_close(const std::string& requests, bool& closed) {
+    closed = false;
+    int fd = connect_to(kPort);
+    if (fd < 0) {
+        return std::string();
+    }
+    std::string in;
+    if (send(fd, requests.data(), requests.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(requests.size()) &&
+        shutdown(fd, SHUT_WR) == 0) {
+        char chunk[4096];
+        while (true) {
+            ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+            if (got == 0) {
+                closed = true;
+                break;
+            }
+            if (got < 0) {
+                break;      // Timed out or reset
+            }
+            in.append(chunk, static_cast<size_t>(got));
+        }
+    }
+    close(fd);
+    return in;
+}
+
+} // namespace
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    nymph::net::ServerConfig config;
+    config.host = "127.0.0.1";
+    config.port = kPort;
+    config.workers = 1;
+    nymph::net::HttpServer server(config, handle);
+    NYMPH_CHECK(server.start());
+
+    bool closed = false;
+    std::string response = half_close(post("/deferred", "{}"), closed);
+    NYMPH_CHECK(status_of(response) == 200);
+    NYMPH_CHECK(response.find("{\"deferred\":true}") != std::string::npos);
+    NYMPH_CHECK(closed);
+
+    response = half_close("GET /stream HTTP/1.1\r\nHost: test\r\n\r\n", closed);
+    NYMPH_CHECK(status_of(response) == 200);
+    NYMPH_CHECK(response.find("data: one") != std::string::npos);
+    NYMPH_CHECK(response.find("data: two") != std::string::npos);
+    NYMPH_CHECK(response.find("\r\n0\r\n\r\n") != std::string::npos);
+    NYMPH_CHECK(closed);
+
+    // Pipelined behind a deferred response: both answered, in order
+    response = half_close(post("/deferred", "{}") + post("/plain", "{}"), closed);
+    size_t deferred_at = response.find("{\"deferred\":true}");
+    size_t plain_at = response.find("{\"plain\":true}");
+    NYMPH_CHECK(deferred_at != std::string::npos);
+    NYMPH_CHECK(plain_at != std::string::npos && plain_at > deferred_at);
+    NYMPH_CHECK(closed);
+
+    // Nothing pending: the half-close ends the connection at once
+    response = half_close("", closed);
+    NYMPH_CHECK(response.empty());
+    NYMPH_CHECK(closed);
+
+    server.stop();
+    for (std::thread& producer : g_producers) {
+        producer.join();
+    }
+    return finish("test_http_server");
+}
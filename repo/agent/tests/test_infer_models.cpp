@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Inference Model Names Test
+ *
+ * With a model registered, the stub catalogue stays servable: /infer
+ * without "model" gets the default stub model, a registered name is
+ * served, and an unknown name gets 404.
+ */
+
+#include "ai_batch.hpp"
+#include "ai_onnx.hpp"
+#include "http_server.hpp"
+#include "logger.hpp"
+#include "nymph_api.hpp"
+#include "test_common.hpp"
+#include <csignal>
+#include <string>
+
+using namespace nymph::test;
+namespace ai = nymph::ai;
+
+namespace {
+
+const uint16_t kPort = 18481;
+
+} // namespace
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    ai::ONNXRuntime& runtime = ai::get_onnx_runtime();
+    NYMPH_CHECK(runtime.load_model("tiny", NYMPH_SOURCE_DIR "/models/tiny-next-byte.onnx"));
+    NYMPH_CHECK(runtime.has_model("tiny"));
+    NYMPH_CHECK(runtime.has_model("llm-7b-int4"));
+    NYMPH_CHECK(runtime.has_model("vision-resnet50"));
+    NYMPH_CHECK(!runtime.has_model("no-such-model"));
+
+    ai::InferenceRequest defaulted = ai::parse_inference_request("{\"input\":\"hello\"}");
+    NYMPH_CHECK(runtime.has_model(defaulted.model_name));
+
+    nymph::net::ServerConfig config;
+    config.host = "127.0.0.1";
+    config.port = kPort;
+    config.workers = 1;
+    nymph::net::HttpServer server(config, [](nymph::api::APIRequest& req) {
+        return nymph::api::api_infer(req);
+    });
+    NYMPH_CHECK(server.start());
+
+    std::string response = round_trip(kPort, post("/infer", "{\"input\":\"hello\",\"max_tokens\":4}"));
+    NYMPH_CHECK(status_of(response) == 200);
+    NYMPH_CHECK(response.find("\"output\"") != std::string::npos);
+
+    response = round_trip(kPort, post("/infer", "{\"model\":\"tiny\",\"input\":\"a\",\"max_tokens\":4}"));
+    NYMPH_CHECK(status_of(response) == 200);
+
+    response = round_trip(kPort, post("/infer", "{\"model\":\"no-such-model\",\"input\":\"a\"}"));
+    NYMPH_CHECK(status_of(response) == 404);
+    NYMPH_CHECK(response.find("Unknown model") != std::string::npos);
+
+    server.stop();
+    ai::get_inference_scheduler().shutdown();
+    return finish("test_infer_models");
+}
@@ -0,0 +1,241 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Batch Test
+ *
+ * An access past a region's end fails in a batch, and refuses an atomic
+ * one. A refused atomic batch leaves the eviction policy as it was, and an
+ * explicit evict is not counted as spilled. A write to shared pages drops
+ * other regions for its copies only with force, and in an atomic batch
+ * the copies are planned with the pins. An atomic batch that passed
+ * validation is applied in full even while another thread releases the
+ * shared prefix its pin planned on.
+ */
+
+#include "kvpin.hpp"
+#include "logger.hpp"
+#include "test_common.hpp"
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nymph::test;
+namespace kv = nymph::kv;
+
+namespace {
+
+const uint64_t kPageKB = kv::BlockAllocator::kBlockSizeKB;
+
+kv::KVOp pin_op(const std::string& region, uint64_t size_kb, const std::vector<uint64_t>& prefix = {}) {
+    kv::KVOp op{};
+    op.type = kv::KVOpType::PIN;
+    op.pin.region = region;
+    op.pin.size_kb = size_kb;
+    op.pin.force = false;
+    op.pin.priority = 0;
+    op.pin.prefix_pages = prefix;
+    return op;
+}
+
+kv::KVOp region_op(kv::KVOpType type, const std::string& region,
+                   uint64_t offset_kb = kv::KVCacheManager::kWholeRegion) {
+    kv::KVOp op{};
+    op.type = type;
+    op.pin.region = region;
+    op.is_read = true;
+    op.offset_kb = offset_kb;
+    return op;
+}
+
+} // namespace
+
+int main() {
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    // Offsets past the end of a four-page region
+    {
+        kv::KVCacheManager manager;
+        NYMPH_CHECK(manager.initialize(64 * kPageKB));
+        kv::KVBatchResult batch = manager.apply_batch({pin_op("ctx", 4 * kPageKB),
+                                                       region_op(kv::KVOpType::ACCESS, "ctx", 3 * kPageKB),
+                                                       region_op(kv::KVOpType::ACCESS, "ctx", 4 * kPageKB)},
+                                                      false);
+        NYMPH_CHECK(!batch.success);
+        NYMPH_CHECK(batch.results[0].success && batch.results[1].success);
+        NYMPH_CHECK(!batch.results[2].success);
+        NYMPH_CHECK(batch.results[2].error_message == "Offset out of range");
+
+        batch = manager.apply_batch({pin_op("new", 2 * kPageKB),
+                                     region_op(kv::KVOpType::ACCESS, "new", 2 * kPageKB)},
+                                    true);
+        NYMPH_CHECK(!batch.success);
+        NYMPH_CHECK(batch.error_message == "Op 1: Offset out of range");
+        kv::KVRegion region;
+        NYMPH_CHECK(!manager.get_region("new", region));
+
+        batch = manager.apply_batch({region_op(kv::KVOpType::ACCESS, "ctx", 5 * kPageKB)}, true);
+        NYMPH_CHECK(!batch.success && !batch.error_message.empty());
+    }
+
+    // A policy switch in a refused atomic batch does not take effect
+    {
+        kv::KVCacheManager manager;
+        NYMPH_CHECK(manager.initialize(64 * kPageKB, kv::EvictionPolicy::LRU));
+        kv::KVOp pin = pin_op("ctx", 2 * kPageKB);
+        pin.pin.eviction_policy = "gdsf";
+        kv::KVBatchResult batch = manager.apply_batch({pin, region_op(kv::KVOpType::EVICT, "missing")}, true);
+        NYMPH_CHECK(!batch.success && !batch.error_message.empty());
+        NYMPH_CHECK(manager.get_eviction_policy() == kv::EvictionPolicy::LRU);
+        kv::KVRegion region;
+        NYMPH_CHECK(!manager.get_region("ctx", region));
+
+        batch = manager.apply_batch({pin, region_op(kv::KVOpType::UNPIN, "ctx")}, true);
+        NYMPH_CHECK(batch.success);
+        NYMPH_CHECK(manager.get_eviction_policy() == kv::EvictionPolicy::GDSF);
+
+        // Dropping it on request frees its pages without spilling them
+        batch = manager.apply_batch({region_op(kv::KVOpType::EVICT, "ctx")}, false);
+        NYMPH_CHECK(batch.success);
+        NYMPH_CHECK(manager.get_gauges().spilled_blocks == 0);
+    }
+
+    // A full arena without a spill tier: copying the shared pages written
+    // needs the unpinned filler's blocks
+    {
+        const uint64_t prefix_pages = 4;
+        std::vector<uint64_t> prefix(prefix_pages);
+        for (size_t page = 0; page < prefix.size(); page++) {
+            prefix[page] = 0x51afd7ed558ccd1dULL * (page + 1);
+        }
+        kv::KVCacheManager manager;
+        NYMPH_CHECK(manager.initialize(2 * prefix_pages * kPageKB));
+        kv::KVBatchResult batch = manager.apply_batch({pin_op("holder", prefix_pages * kPageKB, prefix),
+                                                       pin_op("session", prefix_pages * kPageKB, prefix),
+                                                       pin_op("filler", prefix_pages * kPageKB),
+                                                       region_op(kv::KVOpType::UNPIN, "filler")},
+                                                      false);
+        NYMPH_CHECK(batch.success);
+
+        kv::KVOp write = region_op(kv::KVOpType::ACCESS, "session", 0);
+        write.is_read = false;
+        batch = manager.apply_batch({write}, false);
+        NYMPH_CHECK(!batch.success);
+        NYMPH_CHECK(batch.results[0].error_message.rfind("Copy-on-write failed", 0) == 0);
+        kv::KVRegion region;
+        NYMPH_CHECK(manager.get_region("filler", region));
+        NYMPH_CHECK(manager.get_region("session", region) && region.shared_pages == prefix_pages);
+        NYMPH_CHECK(!manager.access_region("session", false, 0));
+
+        write.pin.force = true;
+        batch = manager.apply_batch({write}, false);
+        NYMPH_CHECK(batch.success);
+        NYMPH_CHECK(!manager.get_region("filler", region));
+        NYMPH_CHECK(manager.get_region("session", region) && region.shared_pages == 0);
+        NYMPH_CHECK(manager.get_gauges().used_size_kb == 2 * prefix_pages * kPageKB);
+    }
+
+    // The same in one atomic batch with another pin: the copies are planned
+    // with the pin, so without room for both neither applies
+    {
+        const uint64_t prefix_pages = 4;
+        std::vector<uint64_t> prefix(prefix_pages);
+        for (size_t page = 0; page < prefix.size(); page++) {
+            prefix[page] = 0x51afd7ed558ccd1dULL * (page + 1);
+        }
+        kv::KVCacheManager manager;
+        NYMPH_CHECK(manager.initialize(3 * prefix_pages * kPageKB));
+        kv::KVBatchResult batch = manager.apply_batch({pin_op("holder", prefix_pages * kPageKB, prefix),
+                                                       pin_op("session", prefix_pages * kPageKB, prefix),
+                                                       pin_op("filler", prefix_pages * kPageKB),
+                                                       region_op(kv::KVOpType::UNPIN, "filler")},
+                                                      false);
+        NYMPH_CHECK(batch.success);
+
+        kv::KVOp write = region_op(kv::KVOpType::ACCESS, "session", 0);
+        write.is_read = false;
+        batch = manager.apply_batch({pin_op("other", prefix_pages * kPageKB), write}, true);
+        NYMPH_CHECK(!batch.success && !batch.error_message.empty());
+        NYMPH_CHECK(!batch.results[0].success && !batch.results[1].success);
+        kv::KVRegion region;
+        NYMPH_CHECK(!manager.get_region("other", region));
+        NYMPH_CHECK(manager.get_region("filler", region));
+        NYMPH_CHECK(manager.get_region("session", region) && region.shared_pages == prefix_pages);
+
+        write.pin.force = true;
+        batch = manager.apply_batch({pin_op("other", prefix_pages * kPageKB), write}, true);
+        NYMPH_CHECK(batch.success && batch.results[1].success);
+        NYMPH_CHECK(manager.get_region("other", region));
+        NYMPH_CHECK(!manager.get_region("filler", region));
+        NYMPH_CHECK(manager.get_region("session", region) && region.shared_pages == 0);
+        NYMPH_CHECK(manager.get_gauges().used_size_kb == 3 * prefix_pages * kPageKB);
+
+        // A region pinned on the prefix and written in the same batch; the
+        // plan counts every prefix page as shared, the pin shares them all
+        batch = manager.apply_batch({region_op(kv::KVOpType::UNPIN, "other"),
+                                     region_op(kv::KVOpType::EVICT, "other"),
+                                     region_op(kv::KVOpType::UNPIN, "session"),
+                                     region_op(kv::KVOpType::EVICT, "session")},
+                                    false);
+        NYMPH_CHECK(batch.success);
+        write = region_op(kv::KVOpType::ACCESS, "fresh", 2 * kPageKB);
+        write.is_read = false;
+        batch = manager.apply_batch({pin_op("fresh", prefix_pages * kPageKB, prefix), write}, true);
+        NYMPH_CHECK(batch.success);
+        NYMPH_CHECK(manager.get_region("fresh", region) && region.shared_pages == 2);
+        NYMPH_CHECK(manager.get_gauges().used_size_kb == (prefix_pages + 2) * kPageKB);
+    }
+
+    // The arena holds the prefix plus the pin's private tail, nothing more.
+    // Another thread keeps dropping the prefix holder and filling its space.
+    {
+        const uint64_t prefix_pages = 8;
+        const uint64_t tail_pages = 2;
+        std::vector<uint64_t> prefix(prefix_pages);
+        for (size_t page = 0; page < prefix.size(); page++) {
+            prefix[page] = 0x9e3779b97f4a7c15ULL * (page + 1);
+        }
+        kv::KVCacheManager manager;
+        NYMPH_CHECK(manager.initialize((prefix_pages + tail_pages) * kPageKB));
+
+        std::atomic<bool> done{false};
+        std::thread churn([&]() {
+            for (uint64_t round = 0; !done.load(); round++) {
+                std::string holder = "holder-" + std::to_string(round % 4);
+                std::string filler = "filler-" + std::to_string(round % 4);
+                manager.apply_batch({pin_op(holder, prefix_pages * kPageKB, prefix)}, false);
+                manager.apply_batch({region_op(kv::KVOpType::UNPIN, holder),
+                                     region_op(kv::KVOpType::EVICT, holder),
+                                     pin_op(filler, prefix_pages * kPageKB)}, false);
+                manager.apply_batch({region_op(kv::KVOpType::UNPIN, filler),
+                                     region_op(kv::KVOpType::EVICT, filler)}, false);
+            }
+        });
+
+        uint64_t applied = 0;
+        uint64_t torn = 0;
+        for (int round = 0; round < 100000; round++) {
+            std::string name = "session-" + std::to_string(round % 4);
+            kv::KVBatchResult batch = manager.apply_batch(
+                {pin_op(name, (prefix_pages + tail_pages) * kPageKB, prefix),
+                 region_op(kv::KVOpType::ACCESS, name, 0)},
+                true);
+            if (batch.success) {
+                applied++;
+                manager.apply_batch({region_op(kv::KVOpType::UNPIN, name),
+                                     region_op(kv::KVOpType::EVICT, name)}, false);
+            } else if (batch.error_message.empty()) {
+                // Validated, then an op failed while applying
+                torn++;
+                manager.apply_batch({region_op(kv::KVOpType::UNPIN, name),
+                                     region_op(kv::KVOpType::EVICT, name)}, false);
+            }
+        }
+        done = true;
+        churn.join();
+        NYMPH_CHECK(torn == 0);
+        std::printf("atomic pins applied: %llu of 100000\n", static_cast<unsigned long long>(applied));
+    }
+
+    return finish("test_kv_batch");
+}
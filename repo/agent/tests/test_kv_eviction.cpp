@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Eviction Test
+ *
+ * A region whose pages are all shared prefix pages frees nothing unless
+ * it is dropped. Without force, eviction passes over it to the regions
+ * queued behind it in the same shard, under every policy, and leaves it
+ * queued for a later forced eviction.
+ */
+
+#include "kvpin.hpp"
+#include "kv_index.hpp"
+#include "logger.hpp"
+#include "test_common.hpp"
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace nymph::test;
+namespace kv = nymph::kv;
+
+namespace {
+
+const uint64_t kPageKB = kv::BlockAllocator::kBlockSizeKB;
+const uint64_t kPrefixPages = 8;
+
+kv::KVPinRequest pin_request(const std::string& region, uint64_t pages, bool force,
+                             const std::vector<uint64_t>& prefix = {}) {
+    kv::KVPinRequest request;
+    request.region = region;
+    request.size_kb = pages * kPageKB;
+    request.force = force;
+    request.priority = 0;
+    request.prefix_pages = prefix;
+    return request;
+}
+
+/* A name starting with stem that lands in the same shard as other */
+std::string same_shard_name(const std::string& stem, const std::string& other) {
+    uint64_t shard = kv::region_hash(other) & (kv::KVCacheManager::kShards - 1);
+    for (int i = 0;; i++) {
+        std::string name = stem + std::to_string(i);
+        if ((kv::region_hash(name) & (kv::KVCacheManager::kShards - 1)) == shard) {
+            return name;
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    std::vector<uint64_t> prefix(kPrefixPages);
+    for (size_t page = 0; page < prefix.size(); page++) {
+        prefix[page] = 0x9e3779b97f4a7c15ULL * (page + 1);
+    }
+    std::string spill_path = "/tmp/nymph-test-spill-" + std::to_string(getpid());
+    const std::string shared = "shared-ctx";
+    const std::string cold = same_shard_name("private-ctx-", shared);
+
+    for (kv::EvictionPolicy policy : {kv::EvictionPolicy::LRU, kv::EvictionPolicy::LFU,
+                                      kv::EvictionPolicy::PRIORITY_LRU, kv::EvictionPolicy::GDSF}) {
+        kv::KVCacheManager manager;
+        NYMPH_CHECK(manager.initialize(2 * kPrefixPages * kPageKB, policy));
+        NYMPH_CHECK(manager.enable_spill(spill_path, 64 * kPageKB));
+
+        // The holder keeps the prefix pinned; the shared region is nothing but
+        // those pages, and is the oldest unpinned region of its shard
+        NYMPH_CHECK(manager.pin_region(pin_request("holder", kPrefixPages, false, prefix)).success);
+        NYMPH_CHECK(manager.pin_region(pin_request(shared, kPrefixPages, false, prefix)).success);
+        kv::KVRegion region;
+        NYMPH_CHECK(manager.get_region(shared, region) && region.shared_pages == kPrefixPages);
+        NYMPH_CHECK(manager.unpin_region(shared));
+        NYMPH_CHECK(manager.pin_region(pin_request(cold, kPrefixPages, false)).success);
+        NYMPH_CHECK(manager.unpin_region(cold));
+        NYMPH_CHECK(manager.get_stats().free_blocks == 0);
+
+        // Room comes from spilling the private region behind the shared one
+        kv::KVPinResult result = manager.pin_region(pin_request("incoming", 4, false));
+        NYMPH_CHECK(result.success);
+        NYMPH_CHECK(manager.get_region(cold, region) && region.spill_slots.size() == 4);
+        NYMPH_CHECK(manager.get_region(shared, region) && region.blocks.size() == kPrefixPages);
+
+        // Still queued: a second pin spills the rest, then only a forced pin
+        // drops the shared region (freeing nothing while the holder has the prefix)
+        NYMPH_CHECK(manager.get_stats().evictable_regions == 2);
+        NYMPH_CHECK(manager.pin_region(pin_request("incoming-2", 4, false)).success);
+        NYMPH_CHECK(manager.get_stats().evictable_regions == 1);
+        NYMPH_CHECK(!manager.pin_region(pin_request("incoming-3", 1, false)).success);
+        manager.pin_region(pin_request("incoming-3", 1, true));
+        NYMPH_CHECK(!manager.get_region(shared, region));
+    }
+
+    unlink(spill_path.c_str());
+    return finish("test_kv_eviction");
+}
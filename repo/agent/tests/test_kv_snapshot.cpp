@@ -0,0 +1,205 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 KV Snapshot Test
+ *
+ * Regions pinned, spilled and sharing a prefix are saved and restored
+ * into a fresh manager over the same spill file, which gets back their
+ * metadata, counters, block tables, shared pages and spilled pages. A
+ * truncated file, a snapshot of another block size and a file that is
+ * not a snapshot restore nothing; a damaged record restores the regions
+ * before it.
+ */
+
+#include "kvpin.hpp"
+#include "logger.hpp"
+#include "test_common.hpp"
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace nymph::test;
+namespace kv = nymph::kv;
+
+namespace {
+
+const uint64_t kPageKB = kv::BlockAllocator::kBlockSizeKB;
+const uint64_t kArenaPages = 16;
+const uint64_t kSpillPages = 32;
+const uint64_t kPrefixPages = 4;
+
+/* FileHeader offsets (kv_snapshot.cpp) */
+const size_t kBlockSizeOffset = 16;
+const size_t kChecksumOffset = 56;
+
+kv::KVPinRequest pin_request(const std::string& region, uint64_t pages, int priority = 0,
+                             const std::vector<uint64_t>& prefix = {}) {
+    kv::KVPinRequest request;
+    request.region = region;
+    request.size_kb = pages * kPageKB;
+    request.force = false;
+    request.priority = priority;
+    request.prefix_pages = prefix;
+    return request;
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write_file(const std::string& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+/* The header checksum, FNV-1a over the fields before it */
+void reseal_header(std::string& bytes) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < kChecksumOffset; i++) {
+        hash = (hash ^ static_cast<unsigned char>(bytes[i])) * 0x100000001b3ULL;
+    }
+    bytes.replace(kChecksumOffset, sizeof(hash), reinterpret_cast<const char*>(&hash), sizeof(hash));
+}
+
+bool same_region(const kv::KVRegion& a, const kv::KVRegion& b) {
+    return a.name == b.name && a.size_kb == b.size_kb && a.pages == b.pages && a.blocks == b.blocks &&
+           a.spill_slots == b.spill_slots && a.shared_pages == b.shared_pages &&
+           a.is_pinned == b.is_pinned && a.priority == b.priority && a.access_count == b.access_count &&
+           a.hit_count == b.hit_count && a.miss_count == b.miss_count &&
+           a.window_hit_rate == b.window_hit_rate;
+}
+
+/* A fresh manager restoring path; false if the restore did not start */
+bool restore(kv::KVCacheManager& manager, const std::string& path, const std::string& spill_path) {
+    NYMPH_CHECK(manager.initialize(kArenaPages * kPageKB));
+    if (!spill_path.empty()) {
+        NYMPH_CHECK(manager.enable_spill(spill_path, kSpillPages * kPageKB, true));
+    }
+    bool started = manager.restore_snapshot(path, 10000);
+    manager.wait_restore();
+    return started;
+}
+
+} // namespace
+
+int main() {
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    std::string stem = "/tmp/nymph-test-snapshot-" + std::to_string(getpid());
+    std::string spill_path = stem + ".spill";
+    std::string path = stem + ".snap";
+    std::string damaged = stem + "-damaged.snap";
+    std::vector<uint64_t> prefix(kPrefixPages);
+    for (size_t page = 0; page < prefix.size(); page++) {
+        prefix[page] = 0x2545f4914f6cdd1dULL * (page + 1);
+    }
+
+    // Two pinned regions share the prefix; the unpinned cold one fills the
+    // arena and has half its pages spilled by the last pin
+    std::vector<kv::KVRegion> saved;
+    kv::KVCacheGauges saved_gauges;
+    {
+        kv::KVCacheManager manager;
+        NYMPH_CHECK(manager.initialize(kArenaPages * kPageKB));
+        NYMPH_CHECK(manager.enable_spill(spill_path, kSpillPages * kPageKB));
+        NYMPH_CHECK(manager.pin_region(pin_request("holder", kPrefixPages + 2, 0, prefix)).success);
+        NYMPH_CHECK(manager.pin_region(pin_request("session", kPrefixPages + 2, 3, prefix)).success);
+        NYMPH_CHECK(manager.pin_region(pin_request("cold", 8)).success);
+        NYMPH_CHECK(manager.unpin_region("cold"));
+        for (int i = 0; i < 5; i++) {
+            manager.access_region("session", true, 0);
+        }
+        NYMPH_CHECK(manager.pin_region(pin_request("hot", 4)).success);
+
+        kv::KVRegion region;
+        NYMPH_CHECK(manager.get_region("session", region) && region.shared_pages == kPrefixPages);
+        NYMPH_CHECK(manager.get_region("cold", region) && region.blocks.size() == 4 &&
+                    region.spill_slots.size() == 4);
+        saved = manager.list_regions();
+        saved_gauges = manager.get_gauges();
+        NYMPH_CHECK(saved.size() == 4);
+        NYMPH_CHECK(manager.save_snapshot(path));
+    }
+
+    // Warm restart over the same spill file
+    {
+        kv::KVCacheManager manager;
+        NYMPH_CHECK(restore(manager, path, spill_path));
+        std::vector<kv::KVRegion> restored = manager.list_regions();
+        NYMPH_CHECK(restored.size() == saved.size());
+        for (size_t i = 0; i < saved.size() && i < restored.size(); i++) {
+            NYMPH_CHECK(same_region(saved[i], restored[i]));
+        }
+        kv::KVCacheGauges gauges = manager.get_gauges();
+        NYMPH_CHECK(gauges.used_size_kb == saved_gauges.used_size_kb);
+        NYMPH_CHECK(gauges.spill_used_kb == saved_gauges.spill_used_kb);
+        NYMPH_CHECK(gauges.dedup_saved_kb == saved_gauges.dedup_saved_kb);
+        NYMPH_CHECK(gauges.pinned_regions == 3);
+
+        // The spilled pages read back from the slots the snapshot named
+        NYMPH_CHECK(manager.unpin_region("hot"));
+        kv::KVOp evict{};
+        evict.type = kv::KVOpType::EVICT;
+        evict.pin.region = "hot";
+        NYMPH_CHECK(manager.apply_batch({evict}, false).success);
+        NYMPH_CHECK(manager.pin_region(pin_request("cold", 8)).success);
+        kv::KVRegion region;
+        NYMPH_CHECK(manager.get_region("cold", region) && region.blocks.size() == 8 &&
+                    region.spill_slots.empty());
+        NYMPH_CHECK(manager.get_gauges().readback_blocks == 4);
+    }
+
+    std::string bytes = read_file(path);
+    NYMPH_CHECK(bytes.size() > kChecksumOffset + sizeof(uint64_t));
+
+    // Cut short: the header promises more records than the file holds
+    {
+        write_file(damaged, bytes.substr(0, bytes.size() / 2));
+        kv::KVCacheManager manager;
+        NYMPH_CHECK(!restore(manager, damaged, ""));
+        NYMPH_CHECK(manager.list_regions().empty());
+    }
+
+    // The last record damaged: the regions before it come back. Records
+    // are pinned first, so it is the cold region's.
+    {
+        std::string flipped = bytes;
+        flipped.back() ^= 0x5a;
+        write_file(damaged, flipped);
+        kv::KVCacheManager manager;
+        NYMPH_CHECK(restore(manager, damaged, ""));
+        kv::KVRegion region;
+        NYMPH_CHECK(manager.list_regions().size() == saved.size() - 1);
+        NYMPH_CHECK(!manager.get_region("cold", region));
+        NYMPH_CHECK(manager.get_region("session", region) && region.shared_pages == kPrefixPages);
+    }
+
+    // Another block size: the block tables mean other memory
+    {
+        std::string other = bytes;
+        uint64_t block_size_kb = kPageKB * 2;
+        other.replace(kBlockSizeOffset, sizeof(block_size_kb),
+                      reinterpret_cast<const char*>(&block_size_kb), sizeof(block_size_kb));
+        reseal_header(other);
+        write_file(damaged, other);
+        kv::KVCacheManager manager;
+        NYMPH_CHECK(!restore(manager, damaged, ""));
+        NYMPH_CHECK(manager.list_regions().empty());
+    }
+
+    // Not a snapshot at all, or no file
+    {
+        write_file(damaged, std::string(bytes.size(), '\x42'));
+        kv::KVCacheManager manager;
+        NYMPH_CHECK(!restore(manager, damaged, ""));
+        NYMPH_CHECK(!manager.restore_snapshot(stem + "-missing.snap", 1000));
+        NYMPH_CHECK(manager.list_regions().empty());
+    }
+
+    unlink(path.c_str());
+    unlink(damaged.c_str());
+    unlink(spill_path.c_str());
+    return finish("test_kv_snapshot");
+}
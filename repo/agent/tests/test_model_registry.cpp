@@ -0,0 +1,151 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Model Registry Test
+ *
+ * The lock-free gauges /metrics reads follow loads, budget unloads and
+ * failed loads, and agree with list() and get_stats(). A reader polling
+ * them while another thread loads and unloads needs no lock.
+ */
+
+#include "ai_models.hpp"
+#include "logger.hpp"
+#include "test_common.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace nymph::test;
+namespace ai = nymph::ai;
+
+namespace {
+
+const uint64_t kModelBytes = 64 * 1024;
+
+std::string write_model(const std::string& dir, const std::string& name) {
+    std::string path = dir + "/" + name + ".onnx";
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return path;
+    }
+    std::vector<char> bytes(kModelBytes, 'x');
+    std::fwrite(bytes.data(), 1, bytes.size(), file);
+    std::fclose(file);
+    return path;
+}
+
+const ai::ModelGauge* find(const ai::ModelRegistryGauges& gauges, const std::string& name) {
+    for (const ai::ModelGauge& model : gauges.models) {
+        if (model.name == name) {
+            return &model;
+        }
+    }
+    return nullptr;
+}
+
+/* The gauges match what the registry reports under its lock */
+bool consistent(const ai::ModelRegistry& registry) {
+    ai::ModelRegistryGauges gauges = registry.get_gauges();
+    ai::ModelRegistryStats stats = registry.get_stats();
+    std::vector<ai::ModelInfo> models = registry.list();
+    if (gauges.budget_bytes != stats.budget_bytes || gauges.resident_bytes != stats.resident_bytes ||
+        gauges.load_failures != stats.load_failures || gauges.models.size() != models.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < models.size(); i++) {
+        const ai::ModelGauge& gauge = gauges.models[i];
+        if (gauge.name != models[i].name || gauge.resident_bytes != models[i].resident_bytes ||
+            gauge.loaded != (models[i].state == ai::ModelState::LOADED) ||
+            gauge.loads != models[i].loads || gauge.unloads != models[i].unloads) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    char dir_template[] = "/tmp/nymph-test-models-XXXXXX";
+    char* dir = mkdtemp(dir_template);
+    NYMPH_CHECK(dir != nullptr);
+    if (dir == nullptr) {
+        return finish("test_model_registry");
+    }
+    std::vector<std::string> paths;
+    for (const char* name : {"alpha", "beta", "gamma"}) {
+        paths.push_back(write_model(dir, name));
+    }
+
+    {
+        ai::ModelRegistry registry;
+        NYMPH_CHECK(registry.add("alpha", paths[0]));
+        NYMPH_CHECK(registry.add("beta", paths[1]));
+        NYMPH_CHECK(registry.add("gamma", paths[2]));
+        ai::ModelRegistryGauges gauges = registry.get_gauges();
+        NYMPH_CHECK(gauges.models.size() == 3);
+        NYMPH_CHECK(gauges.models[0].name == "alpha" && gauges.models[2].name == "gamma");
+        NYMPH_CHECK(gauges.resident_bytes == 0);
+
+        // Room for two models: the third load unloads the least recently used
+        registry.set_budget(2 * kModelBytes + kModelBytes / 2);
+        NYMPH_CHECK(registry.get_gauges().budget_bytes == 2 * kModelBytes + kModelBytes / 2);
+        NYMPH_CHECK(registry.acquire("alpha") != nullptr);
+        NYMPH_CHECK(registry.acquire("beta") != nullptr);
+        NYMPH_CHECK(registry.acquire("gamma") != nullptr);
+        gauges = registry.get_gauges();
+        NYMPH_CHECK(gauges.resident_bytes == 2 * kModelBytes);
+        NYMPH_CHECK(!find(gauges, "alpha")->loaded && find(gauges, "alpha")->unloads == 1);
+        NYMPH_CHECK(find(gauges, "gamma")->loaded && find(gauges, "gamma")->resident_bytes == kModelBytes);
+        NYMPH_CHECK(consistent(registry));
+
+        NYMPH_CHECK(registry.unload("beta"));
+        NYMPH_CHECK(registry.get_gauges().resident_bytes == kModelBytes);
+        NYMPH_CHECK(consistent(registry));
+
+        // A file gone since registration fails to load
+        std::remove(paths[0].c_str());
+        NYMPH_CHECK(registry.acquire("alpha") == nullptr);
+        NYMPH_CHECK(registry.get_gauges().load_failures == 1);
+        NYMPH_CHECK(consistent(registry));
+        paths[0] = write_model(dir, "alpha");
+    }
+
+    // Loads and unloads on one thread, gauges read on another
+    {
+        ai::ModelRegistry registry;
+        NYMPH_CHECK(registry.add("alpha", paths[0]));
+        NYMPH_CHECK(registry.add("beta", paths[1]));
+        registry.set_budget(kModelBytes);
+        std::atomic<bool> done{false};
+        std::thread churn([&]() {
+            for (int i = 0; i < 2000; i++) {
+                registry.acquire(i % 2 == 0 ? "alpha" : "beta");
+            }
+            done = true;
+        });
+        uint64_t reads = 0;
+        while (!done.load()) {
+            ai::ModelRegistryGauges gauges = registry.get_gauges();
+            NYMPH_CHECK(gauges.models.size() == 2);
+            NYMPH_CHECK(gauges.resident_bytes <= kModelBytes);
+            reads++;
+        }
+        churn.join();
+        NYMPH_CHECK(reads > 0);
+        ai::ModelRegistryGauges gauges = registry.get_gauges();
+        NYMPH_CHECK(find(gauges, "alpha")->loads + find(gauges, "beta")->loads == 2000);
+        NYMPH_CHECK(consistent(registry));
+    }
+
+    for (const std::string& path : paths) {
+        std::remove(path.c_str());
+    }
+    rmdir(dir);
+    return finish("test_model_registry");
+}
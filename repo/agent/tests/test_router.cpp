@@ -0,0 +1,156 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Router Test
+ *
+ * Blocking routes: auth and metrics middleware run on the dispatching
+ * thread, so rejected requests never reach the handler pool, and a 503
+ * from a full pool goes back through the middleware and is counted.
+ * 404 and 405 bodies escape the client's path and method.
+ */
+
+#include "router.hpp"
+#include "handler_pool.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "test_common.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace nymph::test;
+using nymph::api::APIRequest;
+using nymph::api::APIResponse;
+using nymph::net::Method;
+
+namespace {
+
+/* Holds blocking handlers until released */
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open = false;
+    int entered = 0;
+
+    void pass() {
+        std::unique_lock<std::mutex> lock(mutex);
+        entered++;
+        cv.notify_all();
+        cv.wait(lock, [this]() { return open; });
+    }
+
+    bool wait_entered(int count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(5), [this, count]() { return entered >= count; });
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = true;
+        cv.notify_all();
+    }
+};
+
+APIRequest request(std::string_view authorization) {
+    APIRequest req;
+    req.method = "POST";
+    req.path = "/slow";
+    req.version = "HTTP/1.1";
+    if (!authorization.empty()) {
+        req.headers["authorization"] = authorization;
+    }
+    return req;
+}
+
+/* The completed response of a deferred one; status 0 if it did not complete in time */
+APIResponse await(const APIResponse& resp) {
+    APIResponse done(0);
+    for (int i = 0; i < 5000 && resp.deferred; i++) {
+        if (resp.deferred->take(done)) {
+            return done;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return resp.deferred ? APIResponse(0) : resp;
+}
+
+} // namespace
+
+int main() {
+    nymph::log::Logger::instance().set_level(nymph::log::Level::ERROR);
+
+    Gate gate;
+    std::atomic<int> handled{0};
+    nymph::net::Router router;
+    router.add(Method::POST, "/slow", [&](const APIRequest&) {
+        handled++;
+        gate.pass();
+        return APIResponse(200, "application/json", "{}");
+    });
+    router.set_blocking(Method::POST, "/slow");
+    nymph::metrics::RouteMetrics metrics;
+    router.attach(Method::POST, "/slow", nymph::net::metrics_middleware(metrics));
+    router.attach(Method::POST, "/slow", nymph::net::bearer_auth_middleware("secret"));
+
+    // One thread and one queue slot
+    nymph::net::HandlerPool pool(1, 1);
+    router.set_pool(&pool);
+
+    // Unauthenticated requests are answered at once and never queued
+    for (int i = 0; i < 10; i++) {
+        APIRequest req = request("");
+        APIResponse resp = router.dispatch(req);
+        NYMPH_CHECK(resp.status_code == 401);
+        NYMPH_CHECK(!resp.deferred);
+    }
+    NYMPH_CHECK(metrics.responses[4].value() == 10);
+
+    // Fill the pool: one running, one queued, the next refused
+    APIRequest running_req = request("Bearer secret");
+    APIResponse running = router.dispatch(running_req);
+    NYMPH_CHECK(running.deferred != nullptr);
+    NYMPH_CHECK(gate.wait_entered(1));
+    APIRequest queued_req = request("Bearer secret");
+    APIResponse queued = router.dispatch(queued_req);
+    NYMPH_CHECK(queued.deferred != nullptr);
+    APIRequest refused_req = request("Bearer secret");
+    APIResponse refused = router.dispatch(refused_req);
+    NYMPH_CHECK(refused.status_code == 503);
+    NYMPH_CHECK(metrics.responses[5].value() == 1);
+
+    // A full pool still turns away unauthenticated requests with 401
+    APIRequest anonymous_req = request("Bearer wrong");
+    NYMPH_CHECK(router.dispatch(anonymous_req).status_code == 401);
+    NYMPH_CHECK(metrics.responses[4].value() == 11);
+
+    gate.release();
+    NYMPH_CHECK(await(running).status_code == 200);
+    NYMPH_CHECK(await(queued).status_code == 200);
+    NYMPH_CHECK(metrics.responses[2].value() == 2);
+    NYMPH_CHECK(handled.load() == 2);
+
+    // Without a pool the handler runs inline, behind the same middleware
+    router.set_pool(nullptr);
+    APIRequest inline_req = request("Bearer secret");
+    APIResponse inline_resp = router.dispatch(inline_req);
+    NYMPH_CHECK(inline_resp.status_code == 200 && !inline_resp.deferred);
+    NYMPH_CHECK(handled.load() == 3);
+
+    pool.stop();
+
+    // Unknown paths and methods are echoed back as JSON strings
+    APIRequest unknown_req = request("");
+    unknown_req.path = "/a\"b\\c";
+    APIResponse unknown = router.dispatch(unknown_req);
+    NYMPH_CHECK(unknown.status_code == 404);
+    NYMPH_CHECK(unknown.body == "{\"error\":\"Not found\",\"path\":\"/a\\\"b\\\\c\"}");
+    APIRequest method_req = request("");
+    method_req.method = "GE\"T";
+    APIResponse wrong_method = router.dispatch(method_req);
+    NYMPH_CHECK(wrong_method.status_code == 405);
+    NYMPH_CHECK(wrong_method.body == "{\"error\":\"Method not allowed\",\"method\":\"GE\\\"T\"}");
+
+    return finish("test_router");
+}
@@ -0,0 +1,75 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * NYMPH 1.1 Trace Test
+ *
+ * Short-lived recording threads reuse the rings of exited ones, so ring
+ * memory stays bounded by the peak number of live threads, and spans of
+ * an exited thread stay exportable until its ring is taken over.
+ */
+
+#include "trace.hpp"
+#include "test_common.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nymph::test;
+namespace trace = nymph::trace;
+
+namespace {
+
+void record_span(const char* name) {
+    trace::set_thread_name("test-worker");
+    NYMPH_TRACE_SCOPE(name);
+}
+
+} // namespace
+
+int main() {
+    trace::set_enabled(true);
+
+    // One thread at a time: every thread after the first takes the freed ring
+    std::thread first(record_span, "first.span");
+    first.join();
+    std::string exported = trace::export_chrome_json(0);
+    NYMPH_CHECK(exported.find("first.span") != std::string::npos);
+    NYMPH_CHECK(exported.find("test-worker") != std::string::npos);
+
+    for (int i = 0; i < 200; i++) {
+        std::thread worker(record_span, "churn.span");
+        worker.join();
+    }
+    trace::TraceStats stats = trace::get_trace_stats();
+    NYMPH_CHECK(stats.rings == 1);
+    NYMPH_CHECK(stats.threads == 0);
+    NYMPH_CHECK(stats.recorded == 201);
+
+    // The reused ring no longer exports the first thread's span under a new tid
+    exported = trace::export_chrome_json(0);
+    NYMPH_CHECK(exported.find("first.span") == std::string::npos);
+    NYMPH_CHECK(exported.find("churn.span") != std::string::npos);
+
+    // Concurrent threads each hold their own ring, then return it
+    for (int round = 0; round < 20; round++) {
+        std::vector<std::thread> workers;
+        for (int i = 0; i < 8; i++) {
+            workers.emplace_back(record_span, "burst.span");
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    stats = trace::get_trace_stats();
+    NYMPH_CHECK(stats.rings <= 8);
+    NYMPH_CHECK(stats.threads == 0);
+
+    // The main thread holds its ring for as long as it runs
+    {
+        NYMPH_TRACE_SCOPE("main.span");
+    }
+    stats = trace::get_trace_stats();
+    NYMPH_CHECK(stats.threads == 1);
+    NYMPH_CHECK(trace::export_chrome_json(0).find("main.span") != std::string::npos);
+
+    return finish("test_trace");
+}
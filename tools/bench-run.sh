@@ -383,6 +383,31 @@ generate_stub_results() {
 EOF
 }
 
+# Daemon trace endpoint (Chrome trace-event JSON, loads in ui.perfetto.dev)
+TRACE_AUTH=()
+if [[ -n "${NYMPH_API_TOKEN:-}" ]]; then
+    TRACE_AUTH=(-H "Authorization: Bearer ${NYMPH_API_TOKEN}")
+fi
+
+start_daemon_trace() {
+    command -v curl &> /dev/null || return 1
+    curl -s -f ${TRACE_AUTH[@]+"${TRACE_AUTH[@]}"} "${DAEMON_URL}/debug/trace?enable=1" > /dev/null 2>&1
+}
+
+# Fetch spans recorded during the run; falls back to the stub on failure
+fetch_daemon_trace() {
+    local seconds="$1"
+    if command -v curl &> /dev/null &&
+       curl -s -f ${TRACE_AUTH[@]+"${TRACE_AUTH[@]}"} "${DAEMON_URL}/debug/trace?seconds=${seconds}" \
+            -o dist/trace.perfetto 2>/dev/null &&
+       grep -q '"traceEvents"' dist/trace.perfetto; then
+        curl -s ${TRACE_AUTH[@]+"${TRACE_AUTH[@]}"} "${DAEMON_URL}/debug/trace?enable=0" > /dev/null 2>&1 || true
+        echo "[bench] ✓ Captured daemon trace (${seconds}s window)"
+        return 0
+    fi
+    return 1
+}
+
 # Generate perfetto trace stub
 generate_perfetto_trace() {
 cat > dist/trace.perfetto << 'EOF'
@@ -444,6 +469,12 @@ if check_daemon; then
     
     echo "[bench] Running live benchmark..."
     
+    TRACE_STARTED=0
+    BENCH_START_S=$(date +%s)
+    if start_daemon_trace; then
+        TRACE_STARTED=1
+    fi
+    
     if run_benchmark; then
         echo "[bench] ✓ Live benchmark completed"
     else
@@ -459,8 +490,11 @@ else
     generate_stub_results
 fi
 
-# Always generate perfetto trace
-generate_perfetto_trace
+# Prefer a real trace from the daemon, otherwise write the stub
+if [[ "${TRACE_STARTED:-0}" != "1" ]] || \
+   ! fetch_daemon_trace $(( $(date +%s) - BENCH_START_S + 1 )); then
+    generate_perfetto_trace
+fi
 
 echo "[bench] ✓ Benchmark results generated"
 echo "[bench]   - dist/bench.json"
@@ -0,0 +1,110 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# NYMPH 1.1 ONNX Runtime Backend Check
+# Checks repo/agent/models/tiny-next-byte.onnx against the model contract
+# with the onnxruntime Python package (stacked batch included) when it is
+# installed. Then serves the tiny model from a daemon built with
+# NYMPH_WITH_ONNXRUNTIME and checks /infer for one request, a stream and a
+# burst decoded in stacked steps. The daemon is NYMPH_ACCELD if set (the
+# onnx_backend ctest passes its own), else it is built from ONNXRUNTIME_ROOT.
+#
+# Usage: [ONNXRUNTIME_ROOT=/opt/onnxruntime-linux-x64-1.31.0] [NYMPH_ACCELD=path] [PYTHON=python3] tools/check_onnx_backend.sh
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+MODEL="$ROOT/repo/agent/models/tiny-next-byte.onnx"
+BUILD_DIR="${BUILD_DIR:-$ROOT/repo/agent/build-onnx}"
+PORT="${PORT:-18490}"
+PYTHON="${PYTHON:-python3}"
+
+if ! "$PYTHON" -c "import numpy, onnxruntime" 2> /dev/null; then
+    echo "[onnx] No onnxruntime Python package; skipping the model contract check"
+else
+echo "[onnx] Checking $MODEL against the model contract"
+"$PYTHON" - "$MODEL" <<'EOF'
+import sys
+
+import numpy as np
+import onnxruntime as ort
+
+session = ort.InferenceSession(sys.argv[1], providers=["CPUExecutionProvider"])
+inputs, outputs = session.get_inputs(), session.get_outputs()
+assert len(inputs) == 1 and inputs[0].type == "tensor(int64)", "expected one int64 input"
+assert len(outputs) == 1 and outputs[0].type == "tensor(float)", "expected one float output"
+assert len(outputs[0].shape) == 2 and outputs[0].shape[1] == 256, "expected [batch, 256] scores"
+
+def generate(prompts, max_tokens):
+    # Greedy, in lockstep: equally long prompts stack into one run, as the daemon does
+    ids = [[ord(c) for c in prompt] for prompt in prompts]
+    text = ["" for _ in prompts]
+    for _ in range(max_tokens):
+        scores = session.run(None, {inputs[0].name: np.array(ids, dtype=np.int64)})[0]
+        assert scores.shape == (len(prompts), 256)
+        for row, token in enumerate(scores.argmax(axis=1)):
+            ids[row].append(int(token))
+            text[row] += chr(token)
+    return text
+
+assert generate(["a"], 5) == ["bcdef"], generate(["a"], 5)
+assert generate(["a", "b", "Q"], 4) == ["bcde", "cdef", "RSTU"]
+assert generate(["xy", "pq"], 3) == ["z{|", "rst"]
+print("[onnx] Model contract OK (onnxruntime %s)" % ort.__version__)
+EOF
+fi
+
+DAEMON="${NYMPH_ACCELD:-}"
+if [ -z "$DAEMON" ]; then
+    if [ -z "${ONNXRUNTIME_ROOT:-}" ]; then
+        echo "[onnx] Neither NYMPH_ACCELD nor ONNXRUNTIME_ROOT set; skipping the daemon check"
+        exit 0
+    fi
+    echo "[onnx] Building nymph-acceld with ONNX Runtime from $ONNXRUNTIME_ROOT"
+    cmake -S "$ROOT/repo/agent" -B "$BUILD_DIR" -DNYMPH_WITH_ONNXRUNTIME=ON -DONNXRUNTIME_ROOT="$ONNXRUNTIME_ROOT" > /dev/null
+    cmake --build "$BUILD_DIR" -j"$(nproc)" --target nymph-acceld > /dev/null
+    DAEMON="$BUILD_DIR/nymph-acceld"
+fi
+
+LOG="$(dirname "$DAEMON")/check_onnx_backend.log"
+LD_LIBRARY_PATH="${ONNXRUNTIME_ROOT:+$ONNXRUNTIME_ROOT/lib:}${LD_LIBRARY_PATH:-}" "$DAEMON" --port "$PORT" \
+    --onnx-model tiny="$MODEL" --infer-batching iteration --infer-batch 8 > "$LOG" 2>&1 &
+DAEMON_PID=$!
+trap 'kill "$DAEMON_PID" 2> /dev/null || true' EXIT
+
+for _ in $(seq 50); do
+    curl -s -f "http://127.0.0.1:$PORT/status" > /dev/null 2>&1 && break
+    sleep 0.1
+done
+
+infer() {
+    curl -s -X POST "http://127.0.0.1:$PORT/infer" -d "{\"model\":\"tiny\",\"input\":\"$1\",\"max_tokens\":$2$3}"
+}
+
+expect() {
+    if ! grep -qF -- "$2" <<< "$3"; then
+        echo "[onnx] FAIL: $1: expected $2, got: $3"
+        echo "[onnx] Daemon log: $LOG"
+        exit 1
+    fi
+    echo "[onnx] $1 OK"
+}
+
+expect "Single request" '"output":"bcdef"' "$(infer a 5 "")"
+expect "Stream" '"output":"bcd"' "$(infer a 3 ',"stream":true')"
+expect "Loaded on ONNX Runtime" '"state":"loaded"' "$(curl -s "http://127.0.0.1:$PORT/models")"
+
+# Concurrent sequences share decode steps; equally long ones share a run
+BURST_DIR="$(mktemp -d)"
+PROMPTS=(a b c Q xy pq hello)
+CLIENTS=()
+for prompt in "${PROMPTS[@]}"; do
+    infer "$prompt" 4 "" > "$BURST_DIR/$prompt" &
+    CLIENTS+=($!)
+done
+wait "${CLIENTS[@]}"
+EXPECTED=(bcde cdef defg RSTU 'z{|}' rstu pqrs)
+for i in "${!PROMPTS[@]}"; do
+    expect "Burst \"${PROMPTS[$i]}\"" "\"output\":\"${EXPECTED[$i]}\"" "$(cat "$BURST_DIR/${PROMPTS[$i]}")"
+done
+rm -rf "$BURST_DIR"
+
+echo "[onnx] ONNX Runtime backend OK"